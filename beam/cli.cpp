@@ -193,6 +193,14 @@ int main_impl(int argc, char* argv[])
 
 			clean_old_logfiles(LOG_FILES_DIR, LOG_FILES_PREFIX, logCleanupPeriod);
 
+			if (vm[cli::LOG_ASYNC].as<bool>())
+			{
+				LoggerAsyncConfig cfg;
+				if (vm[cli::LOG_ASYNC_DROP].as<bool>())
+					cfg.overflow = LoggerAsyncConfig::Drop;
+				logger->set_async(&cfg);
+			}
+
 			Rules::get().UpdateChecksum();
             LOG_INFO() << "Beam Node " << PROJECT_VERSION << " (" << BRANCH_NAME << ")";
 			LOG_INFO() << "Rules signature: " << Rules::get().get_SignatureStr();
@@ -331,6 +339,9 @@ int main_impl(int argc, char* argv[])
 					if (!vm[cli::BBS_ENABLE].as<bool>())
 						ZeroObject(node.m_Cfg.m_Bbs.m_Limit);
 
+					node.m_Cfg.m_Bbs.m_InMemory = vm[cli::BBS_IN_MEMORY].as<bool>();
+					node.m_Cfg.m_Bbs.m_BucketDuration_s = vm[cli::BBS_BUCKET_DURATION].as<Positive<uint32_t>>().value;
+
 					auto var = vm[cli::FAST_SYNC];
 					if (!var.empty())
 					{
@@ -340,6 +351,9 @@ int main_impl(int argc, char* argv[])
 							node.m_Cfg.m_Horizon.SetInfinite();
 					}
 
+					if (vm.count(cli::SNAPSHOT_IMPORT))
+						node.m_Cfg.m_ProcessorParams.m_sSnapshot = vm[cli::SNAPSHOT_IMPORT].as<string>();
+
 					node.Initialize(stratumServer.get());
 
 					if (vm[cli::PRINT_TXO].as<bool>())
@@ -353,6 +367,16 @@ int main_impl(int argc, char* argv[])
 						LOG_INFO() << "Recovery info written";
 					}
 
+					if (vm.count(cli::SNAPSHOT_EXPORT))
+					{
+						string sPath = vm[cli::SNAPSHOT_EXPORT].as<string>();
+						LOG_INFO() << "Writing snapshot...";
+						node.ExportSnapshot(sPath.c_str());
+					}
+
+					if (vm.count(cli::BACKUP_PATH))
+						node.StartBackup(vm[cli::BACKUP_PATH].as<string>().c_str());
+
 					if (vm.count(cli::RECOVERY_AUTO_PATH))
 					{
 						node.m_Cfg.m_Recovery.m_sPathOutput = vm[cli::RECOVERY_AUTO_PATH].as<string>();
@@ -0,0 +1,119 @@
+// Copyright 2018 The Beam Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "arena.h"
+#include <cstddef>
+#include <cstdlib>
+#include <algorithm>
+#include <new>
+
+namespace beam
+{
+	namespace
+	{
+		thread_local Arena* g_pArena = nullptr;
+
+		// each object is prefixed by a header, that tells whether it should be returned to the heap
+		union Header
+		{
+			Arena* m_pArena;
+			std::max_align_t m_Align;
+		};
+	}
+
+	struct Arena::Chunk
+	{
+		Chunk* m_pNext;
+		std::max_align_t m_pData[1];
+	};
+
+	void* Arena::Allocate(size_t n)
+	{
+		const size_t nAlign = alignof(std::max_align_t);
+		n = (n + nAlign - 1) & ~(nAlign - 1);
+
+		if (n > m_nRemaining)
+		{
+			size_t nData = std::max(n, s_ChunkSize);
+			Chunk* pChunk = static_cast<Chunk*>(malloc(offsetof(Chunk, m_pData) + nData));
+			if (!pChunk)
+				throw std::bad_alloc();
+
+			pChunk->m_pNext = m_pHead;
+			m_pHead = pChunk;
+
+			m_pPos = reinterpret_cast<uint8_t*>(pChunk->m_pData);
+			m_nRemaining = nData;
+		}
+
+		void* p = m_pPos;
+		m_pPos += n;
+		m_nRemaining -= n;
+		m_nAllocated += n;
+		return p;
+	}
+
+	void Arena::Clear()
+	{
+		while (m_pHead)
+		{
+			Chunk* pChunk = m_pHead;
+			m_pHead = pChunk->m_pNext;
+			free(pChunk);
+		}
+
+		m_pPos = nullptr;
+		m_nRemaining = 0;
+		m_nAllocated = 0;
+	}
+
+	Arena::Scope::Scope(Arena* p)
+		:m_pPrev(g_pArena)
+	{
+		g_pArena = p;
+	}
+
+	Arena::Scope::~Scope()
+	{
+		g_pArena = m_pPrev;
+	}
+
+	void* Arena::New(size_t n)
+	{
+		n += sizeof(Header);
+
+		Header* pHdr;
+		if (g_pArena)
+			pHdr = static_cast<Header*>(g_pArena->Allocate(n));
+		else
+		{
+			pHdr = static_cast<Header*>(malloc(n));
+			if (!pHdr)
+				throw std::bad_alloc();
+		}
+
+		pHdr->m_pArena = g_pArena;
+		return pHdr + 1;
+	}
+
+	void Arena::Delete(void* p) noexcept
+	{
+		if (p)
+		{
+			Header* pHdr = static_cast<Header*>(p) - 1;
+			if (!pHdr->m_pArena)
+				free(pHdr);
+		}
+	}
+}
@@ -0,0 +1,59 @@
+// Copyright 2018 The Beam Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include "common.h"
+
+namespace beam
+{
+	// Bulk allocator for the transaction elements (inputs, outputs, kernels, rangeproofs).
+	// While an Arena::Scope is active on the current thread, objects of classes marked with BEAM_ARENA_OBJECT are carved from the arena.
+	// Their delete is a no-op, the memory is released at once when the arena is destroyed or cleared.
+	// The arena must outlive all the objects allocated within it. Objects created outside the scope use the regular heap.
+	class Arena
+	{
+		struct Chunk;
+		Chunk* m_pHead = nullptr;
+		uint8_t* m_pPos = nullptr;
+		size_t m_nRemaining = 0;
+		size_t m_nAllocated = 0;
+
+	public:
+		static const size_t s_ChunkSize = 0x10000;
+
+		Arena() = default;
+		Arena(const Arena&) = delete;
+		Arena& operator = (const Arena&) = delete;
+		~Arena() { Clear(); }
+
+		void* Allocate(size_t); // aligned to max_align_t
+		void Clear();
+
+		size_t get_Allocated() const { return m_nAllocated; }
+
+		class Scope {
+			Arena* const m_pPrev;
+		public:
+			Scope(Arena*); // nullptr suspends the arena usage
+			~Scope();
+		};
+
+		static void* New(size_t);
+		static void Delete(void*) noexcept;
+	};
+}
+
+#define BEAM_ARENA_OBJECT \
+	static void* operator new(size_t n) { return beam::Arena::New(n); } \
+	static void operator delete(void* p) noexcept { beam::Arena::Delete(p); }
@@ -2128,6 +2128,70 @@ namespace beam
 		return hver.Verify(*this, id.m_Height - Rules::HeightGenesis, m_Height - Rules::HeightGenesis);
 	}
 
+	bool Block::SystemState::Full::IsValidProofStates(const Full* pStates, size_t nCount, const Merkle::MultiProof& proof, const Merkle::Hash& hvRootLive) const
+	{
+		struct MyVerifier
+			:public Merkle::MultiProof::Verifier
+			,public Evaluator
+		{
+			const Merkle::Hash* m_pHist;
+			const Merkle::Hash* m_pLive;
+			const Merkle::Hash* m_pDefinition;
+
+			using Verifier::Verifier;
+
+			virtual bool get_History(Merkle::Hash& hv) override {
+				hv = *m_pHist;
+				return true;
+			}
+			virtual bool get_Live(Merkle::Hash& hv) override {
+				hv = *m_pLive;
+				return true;
+			}
+
+			virtual bool IsRootValid(const Merkle::Hash& hv) override
+			{
+				m_pHist = &hv;
+				Merkle::Hash hvDef;
+				return
+					get_Definition(hvDef) &&
+					!m_Failed &&
+					(hvDef == *m_pDefinition);
+			}
+		};
+
+		MyVerifier ver(proof, m_Height - Rules::HeightGenesis);
+		ver.m_Height = m_Height;
+		ver.m_pLive = &hvRootLive;
+		ver.m_pDefinition = &m_Definition;
+
+		for (size_t i = 0; i < nCount; i++)
+		{
+			const Full& s = pStates[i];
+			if ((s.m_Height < Rules::HeightGenesis) || (s.m_Height > m_Height))
+				return false;
+			if (i && (s.m_Height <= pStates[i - 1].m_Height))
+				return false;
+
+			if (s.m_Height == m_Height)
+			{
+				if (s != *this)
+					return false;
+				continue;
+			}
+
+			if (!s.IsValid())
+				return false;
+
+			s.get_Hash(ver.m_hvPos);
+			ver.Process(s.m_Height - Rules::HeightGenesis);
+			if (!ver.m_bVerify)
+				return false;
+		}
+
+		return (ver.get_Pos() == proof.m_vData.end()); // no trailing garbage
+	}
+
 	void Block::BodyBase::ZeroInit()
 	{
 		ZeroObject(m_Offset);
@@ -407,6 +407,8 @@ namespace beam
 
 	struct TxElement
 	{
+		BEAM_ARENA_OBJECT // inputs and outputs of the decoded blocks are allocated in bulk
+
 		ECC::Point m_Commitment;
 		int cmp(const TxElement&) const;
 	};
@@ -590,6 +592,8 @@ namespace beam
 
 	struct TxKernel
 	{
+		BEAM_ARENA_OBJECT
+
 		typedef std::unique_ptr<TxKernel> Ptr;
 
 		struct Subtype
@@ -1042,6 +1046,8 @@ namespace beam
 
 				// the most robust proof verification - verifies the whole proof structure
 				bool IsValidProofState(const ID&, const Merkle::HardProof&) const;
+				// multiple states at-once (ascending, the tip itself may be included), with the merged proof
+				bool IsValidProofStates(const Full* pStates, size_t nCount, const Merkle::MultiProof&, const Merkle::Hash& hvRootLive) const;
 
 				bool IsValidProofKernel(const TxKernel&, const TxKernel::LongProof&) const;
 				bool IsValidProofKernel(const Merkle::Hash& hvID, const TxKernel::LongProof&) const;
@@ -585,6 +585,212 @@ namespace beam
 		return true;
 	}
 
+	void RecoveryInfo::Delta::AddUtxo(Height h, Output::Ptr&& pOutp)
+	{
+		m_vAdded.emplace_back();
+		Utxo& x = m_vAdded.back();
+
+		UtxoTree::Key::Data d;
+		d.m_Commitment = pOutp->m_Commitment;
+		d.m_Maturity = pOutp->get_MinMaturity(h);
+
+		x.m_Height = h;
+		x.m_Key = d;
+		x.m_pOutput = std::move(pOutp);
+	}
+
+	void RecoveryInfo::Delta::AddSpent(const ECC::Point& comm, Height hMaturity)
+	{
+		UtxoTree::Key::Data d;
+		d.m_Commitment = comm;
+		d.m_Maturity = hMaturity;
+
+		m_vSpent.emplace_back();
+		m_vSpent.back() = d;
+	}
+
+	bool RecoveryInfo::Delta::Merge(const char* szBase, const char* szOut, const Block::ChainWorkProof& cwp)
+	{
+		typedef yas::binary_oarchive<std::FStream, SERIALIZE_OPTIONS> MySerializer;
+
+		auto fnLess = [](const UtxoTree::Key& k1, const UtxoTree::Key& k2) {
+			return k1.V.cmp(k2.V) < 0;
+		};
+
+		// the outputs created and spent within the delta cancel each other
+		std::sort(m_vSpent.begin(), m_vSpent.end(), fnLess);
+		std::stable_sort(m_vAdded.begin(), m_vAdded.end(), [&fnLess](const Utxo& a, const Utxo& b) { return fnLess(a.m_Key, b.m_Key); });
+
+		std::vector<Utxo> vAdded;
+		std::vector<UtxoTree::Key> vSpent;
+
+		for (size_t iA = 0, iS = 0; ; )
+		{
+			bool bA = (iA < m_vAdded.size());
+			bool bS = (iS < m_vSpent.size());
+			if (!bA && !bS)
+				break;
+
+			int nCmp = !bA ? 1 : !bS ? -1 : m_vAdded[iA].m_Key.V.cmp(m_vSpent[iS].V);
+			if (nCmp < 0)
+				vAdded.push_back(std::move(m_vAdded[iA++]));
+			else
+			{
+				if (nCmp > 0)
+					vSpent.push_back(m_vSpent[iS]);
+				else
+					iA++;
+				iS++;
+			}
+		}
+
+		IParser p; // only to read the base
+		IParser::Context ctx(p);
+		ctx.Open(szBase);
+
+		Writer w;
+		w.Open(szOut, cwp);
+		MySerializer ser(w.m_Stream);
+
+		Height hTip = cwp.m_Heading.m_Prefix.m_Height + cwp.m_Heading.m_vElements.size() - 1;
+
+		// Reads the base, keeping the raw bytes of the current record. The base UTXOs are copied as-is: re-serialized
+		// they'd lose the flags not kept in the recovery format (such as the asset proof presence).
+		struct RecordingStream
+		{
+			std::FStream& m_Src;
+			ByteBuffer m_Buf;
+
+			RecordingStream(std::FStream& s) :m_Src(s) {}
+
+			size_t read(void* p, size_t n)
+			{
+				m_Src.read(p, n);
+				const uint8_t* p8 = reinterpret_cast<const uint8_t*>(p);
+				m_Buf.insert(m_Buf.end(), p8, p8 + n);
+				return n;
+			}
+
+			char getch()
+			{
+				char ch;
+				read(&ch, 1);
+				return ch;
+			}
+
+			char peekch() const { return m_Src.peekch(); }
+			void ungetch(char ch) { m_Src.ungetch(ch); }
+
+		} rs(ctx.m_Stream);
+
+		yas::binary_iarchive<RecordingStream, SERIALIZE_OPTIONS> der(rs);
+
+		// UTXOs: both the base and the added are sorted, merge them
+		bool bBaseShielded = false;
+		size_t iA = 0, iS = 0;
+
+		while (true)
+		{
+			Height h = MaxHeight;
+			Output outp;
+			UtxoTree::Key key;
+
+			if (ctx.m_Stream.get_Remaining())
+			{
+				der & h;
+				if (MaxHeight == h)
+					bBaseShielded = true;
+				else
+				{
+					rs.m_Buf.clear();
+					der & outp;
+
+					UtxoTree::Key::Data d;
+					d.m_Commitment = outp.m_Commitment;
+					d.m_Maturity = outp.get_MinMaturity(h);
+					key = d;
+				}
+			}
+
+			for (; iA < vAdded.size(); iA++)
+			{
+				Utxo& x = vAdded[iA];
+				if ((MaxHeight != h) && (x.m_Key.V.cmp(key.V) >= 0))
+					break;
+
+				x.m_pOutput->m_RecoveryOnly = true;
+				ser & x.m_Height;
+				ser & *x.m_pOutput;
+			}
+
+			if (MaxHeight == h)
+				break;
+
+			for (; (iS < vSpent.size()) && (vSpent[iS].V.cmp(key.V) < 0); iS++)
+				;
+
+			if ((iS < vSpent.size()) && (vSpent[iS].V == key.V))
+				iS++; // spent
+			else
+			{
+				ser & h;
+				w.m_Stream.write(&rs.m_Buf.front(), rs.m_Buf.size());
+			}
+		}
+
+		if (iS < vSpent.size())
+			return false;
+
+		if (hTip >= Rules::get().pForks[2].m_Height)
+		{
+			ser & MaxHeight; // terminator
+
+			if (bBaseShielded)
+			{
+				while (true)
+				{
+					Height h;
+					ctx.m_Der & h;
+
+					if (MaxHeight == h)
+						break;
+
+					ser & h;
+
+					bool bIsOutp = true;
+					ctx.m_Der & bIsOutp;
+					ser & bIsOutp;
+
+					if (bIsOutp)
+					{
+						ShieldedTxo txo;
+						Merkle::Hash hv;
+						ctx.m_Der & txo;
+						ctx.m_Der & hv;
+						ser & txo;
+						ser & hv;
+					}
+					else
+					{
+						ECC::Point pk;
+						ctx.m_Der & pk;
+						ser & pk;
+					}
+				}
+			}
+
+			w.m_Stream.write(m_Shielded.empty() ? nullptr : &m_Shielded.front(), m_Shielded.size());
+			ser & MaxHeight; // terminator
+
+			for (size_t i = 0; i < m_vAssets.size(); i++)
+				ser & m_vAssets[i];
+
+			ser & (Asset::s_MaxCount + 1); // terminator
+		}
+
+		return true;
+	}
+
 	bool RecoveryInfo::IRecognizer::OnUtxo(Height h, const Output& outp)
 	{
 		if (m_pOwner)
@@ -49,6 +49,29 @@ namespace beam
 			void Open(const char*, const Block::ChainWorkProof&);
 		};
 
+		// Changes since the height of an existing recovery file. Merged with it to get the recovery for the newer tip,
+		// without re-reading the whole UTXO set. The result has the same format as the full one.
+		struct Delta
+		{
+			struct Utxo
+			{
+				Height m_Height; // create height
+				Output::Ptr m_pOutput;
+				UtxoTree::Key m_Key;
+			};
+
+			std::vector<Utxo> m_vAdded;
+			std::vector<UtxoTree::Key> m_vSpent;
+			ByteBuffer m_Shielded; // shielded ins/outs after the base height, already serialized in the recovery format
+			std::vector<Asset::Full> m_vAssets; // all the assets at the new tip
+
+			void AddUtxo(Height, Output::Ptr&&);
+			void AddSpent(const ECC::Point&, Height hMaturity);
+
+			// returns false if the base is incompatible (the UTXOs to be spent are missing). Throws on I/O errors
+			bool Merge(const char* szBase, const char* szOut, const Block::ChainWorkProof&);
+		};
+
 		struct IParser
 		{
 			// each of the following returns false to abort
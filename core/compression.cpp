@@ -0,0 +1,209 @@
+// Copyright 2018 The Beam Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "compression.h"
+
+namespace beam
+{
+	namespace
+	{
+		// Stream is a sequence of the following:
+		//	token: 4 bits of literals length, 4 bits of (match length - s_MinMatch). Value 0xf means the length continues in extra bytes
+		//	literals length extra bytes: added until the byte != 0xff
+		//	literals
+		//	match offset: 2 bytes, little-endian. Omitted for the last sequence, which consists of literals only
+		//	match length extra bytes
+
+		uint32_t ReadWord(const uint8_t* p)
+		{
+			uint32_t x;
+			memcpy(&x, p, sizeof(x));
+			return x;
+		}
+
+		uint32_t HashWord(uint32_t x)
+		{
+			return (x * 2654435761U) >> (32 - Compression::s_HashBits);
+		}
+
+		void WriteLenExtra(ByteBuffer& res, size_t n)
+		{
+			for (; n >= 0xff; n -= 0xff)
+				res.push_back(0xff);
+			res.push_back(static_cast<uint8_t>(n));
+		}
+
+		void WriteSequence(ByteBuffer& res, const uint8_t* pLit, size_t nLit, size_t nOffset, size_t nMatch)
+		{
+			// nMatch == 0 means literals only (the last sequence)
+			size_t nMatchCode = nMatch ? (nMatch - Compression::s_MinMatch) : 0;
+
+			uint8_t nToken =
+				(static_cast<uint8_t>(std::min<size_t>(nLit, 0xf)) << 4) |
+				static_cast<uint8_t>(std::min<size_t>(nMatchCode, 0xf));
+
+			res.push_back(nToken);
+
+			if (nLit >= 0xf)
+				WriteLenExtra(res, nLit - 0xf);
+
+			res.insert(res.end(), pLit, pLit + nLit);
+
+			if (nMatch)
+			{
+				res.push_back(static_cast<uint8_t>(nOffset));
+				res.push_back(static_cast<uint8_t>(nOffset >> 8));
+
+				if (nMatchCode >= 0xf)
+					WriteLenExtra(res, nMatchCode - 0xf);
+			}
+		}
+
+		bool ReadLen(size_t& n, const uint8_t*& p, const uint8_t* pEnd, size_t nMax)
+		{
+			if (n < 0xf)
+				return true;
+
+			while (true)
+			{
+				if (p == pEnd)
+					return false;
+
+				uint8_t x = *p++;
+				n += x;
+
+				if (n > nMax)
+					return false;
+
+				if (0xff != x)
+					return true;
+			}
+		}
+	}
+
+	void Compression::Compress(ByteBuffer& res, const void* p, size_t n)
+	{
+		res.clear();
+		res.reserve(n + n / 0xff + 0x10);
+
+		const uint8_t* pSrc = static_cast<const uint8_t*>(p);
+
+		size_t iLit = 0; // pending literals start
+		size_t i = 0;
+
+		if (n > s_MinMatch)
+		{
+			std::vector<uint32_t> vTbl(size_t(1) << s_HashBits, 0);
+
+			size_t iLimit = n - s_MinMatch;
+			uint32_t nMisses = 0;
+
+			while (i <= iLimit)
+			{
+				uint32_t x = ReadWord(pSrc + i);
+				uint32_t& nSlot = vTbl[HashWord(x)];
+
+				size_t iRef = nSlot;
+				nSlot = static_cast<uint32_t>(i);
+
+				if ((iRef >= i) || (i - iRef > s_MaxOffset) || (ReadWord(pSrc + iRef) != x))
+				{
+					// accelerate over the incompressible data
+					i += 1 + (nMisses++ >> 6);
+					continue;
+				}
+
+				nMisses = 0;
+
+				size_t nMatch = s_MinMatch;
+				while ((i + nMatch < n) && (pSrc[iRef + nMatch] == pSrc[i + nMatch]))
+					nMatch++;
+
+				WriteSequence(res, pSrc + iLit, i - iLit, i - iRef, nMatch);
+
+				i += nMatch;
+				iLit = i;
+			}
+		}
+
+		WriteSequence(res, pSrc + iLit, n - iLit, 0, 0);
+	}
+
+	bool Compression::Decompress(ByteBuffer& res, const void* p, size_t n, size_t nSizeRaw)
+	{
+		res.resize(nSizeRaw);
+
+		const uint8_t* pSrc = static_cast<const uint8_t*>(p);
+		const uint8_t* pEnd = pSrc + n;
+
+		uint8_t* pDst = nSizeRaw ? &res.front() : nullptr;
+		size_t iDst = 0;
+
+		while (true)
+		{
+			if (pSrc == pEnd)
+				return false; // the stream must end with the literals sequence
+
+			uint8_t nToken = *pSrc++;
+
+			size_t nLit = nToken >> 4;
+			if (!ReadLen(nLit, pSrc, pEnd, nSizeRaw))
+				return false;
+
+			if ((nLit > static_cast<size_t>(pEnd - pSrc)) || (nLit > nSizeRaw - iDst))
+				return false;
+
+			if (nLit)
+			{
+				memcpy(pDst + iDst, pSrc, nLit);
+				pSrc += nLit;
+				iDst += nLit;
+			}
+
+			if (pSrc == pEnd)
+				break;
+
+			if (pEnd - pSrc < 2)
+				return false;
+
+			size_t nOffset = pSrc[0] | (size_t(pSrc[1]) << 8);
+			pSrc += 2;
+
+			if (!nOffset || (nOffset > iDst))
+				return false;
+
+			size_t nMatch = nToken & 0xf;
+			if (!ReadLen(nMatch, pSrc, pEnd, nSizeRaw))
+				return false;
+
+			nMatch += s_MinMatch;
+			if (nMatch > nSizeRaw - iDst)
+				return false;
+
+			const uint8_t* pRef = pDst + iDst - nOffset;
+			if (nOffset >= nMatch)
+				memcpy(pDst + iDst, pRef, nMatch);
+			else
+			{
+				// overlapping, copy byte-by-byte
+				for (size_t j = 0; j < nMatch; j++)
+					pDst[iDst + j] = pRef[j];
+			}
+
+			iDst += nMatch;
+		}
+
+		return (iDst == nSizeRaw);
+	}
+}
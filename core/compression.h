@@ -0,0 +1,33 @@
+// Copyright 2018 The Beam Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include "common.h"
+
+namespace beam
+{
+	// Fast byte-oriented LZ77 codec (LZ4-like block format). Tuned for speed rather than ratio.
+	// Used for the transport-level compression of large messages.
+	struct Compression
+	{
+		static const uint32_t s_MinMatch = 4;
+		static const uint32_t s_MaxOffset = 0xffff;
+		static const uint32_t s_HashBits = 14;
+
+		static void Compress(ByteBuffer&, const void*, size_t);
+
+		// Fails if the data is malformed, or the decoded size differs from the expected
+		static bool Decompress(ByteBuffer&, const void*, size_t, size_t nSizeRaw);
+	};
+}
@@ -15,6 +15,7 @@
 #pragma once
 #include "common.h"
 #include "uintBig.h"
+#include "arena.h"
 
 namespace ECC
 {
@@ -378,6 +379,8 @@ namespace ECC
 
 		struct Confidential
 		{
+			BEAM_ARENA_OBJECT
+
 			// Bulletproof scheme
 			struct Part1 {
 				Point m_A;
@@ -452,6 +455,8 @@ namespace ECC
 
 		struct Public
 		{
+			BEAM_ARENA_OBJECT
+
 			Signature m_Signature;
 			Amount m_Value;
 
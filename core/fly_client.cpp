@@ -58,8 +58,23 @@ void FlyClient::NetworkStd::Disconnect()
         delete &m_Connections.front();
 }
 
+bool FlyClient::NetworkStd::IsProofsBatchSupported() const
+{
+    for (ConnectionList::const_iterator it = m_Connections.begin(); m_Connections.end() != it; ++it)
+    {
+        const Connection& c = *it;
+        if ((Connection::Flags::Node & c.m_Flags) && (LoginFlags::ProofsBatch & c.m_LoginFlags))
+            return true;
+    }
+
+    return false;
+}
+
 FlyClient::NetworkStd::Connection::Connection(NetworkStd& x)
     : m_This(x)
+    , m_Latency_ms(0)
+    , m_TimeLastDone_ms(0)
+    , m_RequestsDone(0)
 {
     m_This.m_Connections.push_back(*this);
     ResetVars();
@@ -67,9 +82,11 @@ FlyClient::NetworkStd::Connection::Connection(NetworkStd& x)
 
 FlyClient::NetworkStd::Connection::~Connection()
 {
-    ResetInternal();
     m_This.m_Connections.erase(ConnectionList::s_iterator_to(*this));
 
+    // Don't reassign the pending requests from within the teardown. Connections are deleted all at once (see Disconnect),
+    // the requests wait for the new ones
+    ResetInternal(false);
 }
 
 bool FlyClient::NetworkStd::Connection::ShouldSync() const
@@ -86,7 +103,7 @@ void FlyClient::NetworkStd::Connection::ResetVars()
     m_NodeID = Zero;
 }
 
-void FlyClient::NetworkStd::Connection::ResetInternal()
+void FlyClient::NetworkStd::Connection::ResetInternal(bool bFailOver)
 {
     m_pSync.reset();
 	KillTimer();
@@ -97,11 +114,17 @@ void FlyClient::NetworkStd::Connection::ResetInternal()
     if (Flags::ReportedConnected & m_Flags)
         m_This.OnNodeConnected(false);
 
-    while (!m_lst.empty())
+    if (!m_lst.empty())
     {
-        RequestNode& n = m_lst.front();
-        m_lst.pop_front();
-        m_This.m_lst.push_back(n);
+        while (!m_lst.empty())
+        {
+            RequestNode& n = m_lst.front();
+            m_lst.pop_front();
+            m_This.m_lst.push_back(n);
+        }
+
+        if (bFailOver)
+            m_This.OnNewRequests(); // to other connections (if any)
     }
 }
 
@@ -131,7 +154,7 @@ void FlyClient::NetworkStd::Connection::OnDisconnect(const DisconnectReason& dr)
 void FlyClient::NetworkStd::Connection::ResetAll()
 {
 	NodeConnection::Reset();
-	ResetInternal();
+	ResetInternal(true);
 	ResetVars();
 }
 
@@ -578,6 +601,12 @@ void FlyClient::NetworkStd::PostRequestInternal(Request& r)
 
 void FlyClient::NetworkStd::OnNewRequests()
 {
+    if (m_Cfg.m_Striping)
+    {
+        AssignStriped();
+        return;
+    }
+
     for (ConnectionList::iterator it = m_Connections.begin(); m_Connections.end() != it; ++it)
     {
         Connection& c = *it;
@@ -595,10 +624,85 @@ bool FlyClient::NetworkStd::Connection::IsAtTip() const
     return m_This.m_Client.get_History().get_Tip(sTip) && (sTip == m_Tip);
 }
 
+void FlyClient::NetworkStd::AssignStriped()
+{
+    uint32_t nLive = 0;
+    for (ConnectionList::iterator itC = m_Connections.begin(); m_Connections.end() != itC; ++itC)
+        if (itC->IsLive() && itC->IsSecureOut())
+            nLive++;
+
+    // a single connection is not limited, all the requests are pipelined as without striping
+    size_t nMaxInFlight = (nLive > 1) ? m_Cfg.m_MaxInFlight : static_cast<size_t>(-1);
+
+    for (RequestList::iterator it = m_lst.begin(); m_lst.end() != it; )
+    {
+        RequestNode& n = *it++;
+        assert(n.m_pRequest);
+
+        if (!n.m_pRequest->m_pTrg)
+        {
+            m_lst.Delete(n); // aborted
+            continue;
+        }
+
+        // pick the connection that is expected to complete it first
+        Connection* pBest = nullptr;
+        uint64_t nBestCost = 0;
+
+        for (ConnectionList::iterator itC = m_Connections.begin(); m_Connections.end() != itC; ++itC)
+        {
+            Connection& c = *itC;
+            if (!c.IsLive() || !c.IsSecureOut())
+                continue;
+            if (c.m_lst.size() >= nMaxInFlight)
+                continue;
+            if (!c.IsSupported(*n.m_pRequest))
+                continue;
+
+            uint64_t nCost = c.get_Cost();
+            if (!pBest || (nCost < nBestCost))
+            {
+                pBest = &c;
+                nBestCost = nCost;
+            }
+        }
+
+        if (pBest)
+            BEAM_VERIFY(pBest->AssignRequest(n));
+    }
+}
+
+uint64_t FlyClient::NetworkStd::Connection::get_Cost() const
+{
+    uint32_t nLatency_ms = m_Latency_ms ? m_Latency_ms : m_This.m_Cfg.m_DefaultLatency_ms;
+    return static_cast<uint64_t>(m_lst.size() + 1) * std::max(nLatency_ms, 1U);
+}
+
+bool FlyClient::NetworkStd::Connection::IsSupported(Request& r)
+{
+    switch (r.get_Type())
+    {
+#define THE_MACRO(type, msgOut, msgIn) \
+    case Request::Type::type: \
+        return IsSupported(Cast::Up<Request##type>(r));
+
+    REQUEST_TYPES_All(THE_MACRO)
+#undef THE_MACRO
+
+    default: // ?!
+        return true;
+    }
+}
+
 void FlyClient::NetworkStd::Connection::AssignRequests()
 {
-    for (RequestList::iterator it = m_This.m_lst.begin(); m_This.m_lst.end() != it; )
-        AssignRequest(*it++);
+    if (m_This.m_Cfg.m_Striping)
+        m_This.AssignStriped();
+    else
+    {
+        for (RequestList::iterator it = m_This.m_lst.begin(); m_This.m_lst.end() != it; )
+            AssignRequest(*it++);
+    }
 
     if (m_lst.empty() && m_This.m_Cfg.m_PollPeriod_ms)
         SetTimer(m_This.m_Cfg.m_CloseConnectionDelay_ms); // this should allow to get sbbs messages
@@ -606,13 +710,13 @@ void FlyClient::NetworkStd::Connection::AssignRequests()
         KillTimer();
 }
 
-void FlyClient::NetworkStd::Connection::AssignRequest(RequestNode& n)
+bool FlyClient::NetworkStd::Connection::AssignRequest(RequestNode& n)
 {
     assert(n.m_pRequest);
     if (!n.m_pRequest->m_pTrg)
     {
         m_This.m_lst.Delete(n);
-        return;
+        return true;
     }
 
     switch (n.m_pRequest->get_Type())
@@ -622,7 +726,7 @@ void FlyClient::NetworkStd::Connection::AssignRequest(RequestNode& n)
         { \
             Request##type& req = Cast::Up<Request##type>(*n.m_pRequest); \
             if (!IsSupported(req)) \
-                return; \
+                return false; \
             SendRequest(req); \
         } \
         break;
@@ -632,11 +736,15 @@ void FlyClient::NetworkStd::Connection::AssignRequest(RequestNode& n)
 
     default: // ?!
         m_This.m_lst.Finish(n);
-        return;
+        return true;
     }
 
     m_This.m_lst.erase(RequestList::s_iterator_to(n));
     m_lst.push_back(n);
+
+    n.m_TimeSent_ms = GetTime_ms();
+    KillTimer();
+    return true;
 }
 
 void FlyClient::NetworkStd::RequestList::Clear()
@@ -749,6 +857,87 @@ void FlyClient::NetworkStd::Connection::OnRequestData(RequestKernel2& req)
     }
 }
 
+bool FlyClient::NetworkStd::Connection::IsSupported(RequestKernels& req)
+{
+    return (Flags::Node & m_Flags) && (LoginFlags::ProofsBatch & m_LoginFlags) && IsAtTip();
+}
+
+void FlyClient::NetworkStd::Connection::OnRequestData(RequestKernels& req)
+{
+    const std::vector<Merkle::Hash>& vIDs = req.m_Msg.m_IDs;
+    ProofKernels& r = req.m_Res;
+
+    if (r.m_Heights.empty() && r.m_Proofs.empty() && r.m_States.empty())
+        return; // not available atm
+
+    if ((r.m_Heights.size() != vIDs.size()) || (r.m_Proofs.size() > vIDs.size()))
+        ThrowUnexpected();
+
+    if (!m_Tip.IsValidProofStates(r.m_States.empty() ? nullptr : &r.m_States.front(), r.m_States.size(), r.m_ProofStates, r.m_RootLive))
+        ThrowUnexpected();
+
+    size_t iProof = 0;
+    for (size_t i = 0; i < vIDs.size(); i++)
+    {
+        Height h = r.m_Heights[i];
+        if (!h)
+            continue;
+
+        if (iProof == r.m_Proofs.size())
+            ThrowUnexpected();
+
+        auto it = std::lower_bound(r.m_States.begin(), r.m_States.end(), h, [](const Block::SystemState::Full& s, Height h) { return s.m_Height < h; });
+        if ((r.m_States.end() == it) || (it->m_Height != h))
+            ThrowUnexpected();
+
+        Merkle::Hash hv = vIDs[i];
+        Merkle::Interpret(hv, r.m_Proofs[iProof++]);
+        if (hv != it->m_Kernels)
+            ThrowUnexpected();
+    }
+
+    if (iProof != r.m_Proofs.size())
+        ThrowUnexpected();
+}
+
+bool FlyClient::NetworkStd::Connection::IsSupported(RequestUtxos& req)
+{
+    return (LoginFlags::ProofsBatch & m_LoginFlags) && IsAtTip();
+}
+
+void FlyClient::NetworkStd::Connection::OnRequestData(RequestUtxos& req)
+{
+    const std::vector<ECC::Point>& vUtxos = req.m_Msg.m_Utxos;
+    ProofUtxos& r = req.m_Res;
+
+    if (r.m_Counts.empty() && r.m_Proofs.empty())
+        return; // not available atm
+
+    if (r.m_Counts.size() != vUtxos.size())
+        ThrowUnexpected();
+
+    size_t iProof = 0;
+    for (size_t i = 0; i < vUtxos.size(); i++)
+    {
+        uint32_t n = r.m_Counts[i];
+        if ((n > r.m_Proofs.size() - iProof) || (n > Input::Proof::s_EntriesMax))
+            ThrowUnexpected();
+
+        for (uint32_t j = 0; j < n; j++)
+        {
+            // restore the complete proof, so that it can be used the same way as the standalone one
+            Input::Proof& p = r.m_Proofs[iProof++];
+            p.m_Proof.insert(p.m_Proof.end(), r.m_ProofLive.begin(), r.m_ProofLive.end());
+
+            if (!m_Tip.IsValidProofUtxo(vUtxos[i], p))
+                ThrowUnexpected();
+        }
+    }
+
+    if (iProof != r.m_Proofs.size())
+        ThrowUnexpected();
+}
+
 bool FlyClient::NetworkStd::Connection::IsSupported(RequestEvents& req)
 {
     return (Flags::Owned & m_Flags) && IsAtTip();
@@ -789,6 +978,17 @@ void FlyClient::NetworkStd::Connection::OnFirstRequestDone(bool bStillSupported)
     RequestNode& n = m_lst.front();
     assert(n.m_pRequest);
 
+    // Responses come in order. The service time of this one is since it was sent, or since the previous response, whichever is later
+    uint32_t t_ms = GetTime_ms();
+    uint32_t t0_ms = n.m_TimeSent_ms;
+    if (m_RequestsDone && (static_cast<int32_t>(m_TimeLastDone_ms - t0_ms) > 0))
+        t0_ms = m_TimeLastDone_ms;
+
+    uint32_t dt_ms = t_ms - t0_ms;
+    m_Latency_ms = m_Latency_ms ? ((m_Latency_ms * 3 + dt_ms) / 4) : std::max(dt_ms, 1U);
+    m_TimeLastDone_ms = t_ms;
+    m_RequestsDone++;
+
     if (n.m_pRequest->m_pTrg)
     {
         if (!bStillSupported)
@@ -805,6 +1005,9 @@ void FlyClient::NetworkStd::Connection::OnFirstRequestDone(bool bStillSupported)
     else
         m_lst.Delete(n); // aborted already
 
+    if (m_This.m_Cfg.m_Striping && !m_This.m_lst.empty())
+        m_This.AssignStriped(); // there's a free slot now
+
     if (m_lst.empty() && m_This.m_Cfg.m_PollPeriod_ms)
     {
         SetTimer(0);
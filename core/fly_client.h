@@ -31,7 +31,9 @@ namespace proto {
 		macro(Events,		GetEvents,			Events) \
 		macro(Transaction,	NewTransaction,		Status) \
 		macro(BbsMsg,		BbsMsg,				Pong) \
-		macro(Asset,		GetProofAsset,		ProofAsset)
+		macro(Asset,		GetProofAsset,		ProofAsset) \
+		macro(Kernels,		GetProofKernels,	ProofKernels) \
+		macro(Utxos,		GetProofUtxos,		ProofUtxos)
 
 		class Request
 		{
@@ -98,6 +100,7 @@ namespace proto {
 			virtual void Disconnect() = 0;
 			virtual void PostRequestInternal(Request&) = 0;
 			virtual void BbsSubscribe(BbsChannel, Timestamp, IBbsReceiver*) {} // duplicates should be handled internally
+			virtual bool IsProofsBatchSupported() const { return false; } // RequestKernels and RequestUtxos would be served
 
 			void PostRequest(Request&, Request::IHandler&);
 		};
@@ -115,6 +118,7 @@ namespace proto {
 				:public boost::intrusive::list_base_hook<>
 			{
 				Request::Ptr m_pRequest;
+				uint32_t m_TimeSent_ms; // when assigned to the connection
 			};
 
 			struct RequestList
@@ -128,6 +132,7 @@ namespace proto {
 			
 			RequestList m_lst; // idle
 			void OnNewRequests();
+			void AssignStriped();
 
 			struct Config {
 				std::vector<io::Address> m_vNodes;
@@ -136,6 +141,11 @@ namespace proto {
                 uint32_t m_CloseConnectionDelay_ms = 1000;
 				bool m_UseProxy = false;
 				io::Address m_ProxyAddr;
+
+				// spread the requests over all the connected nodes, by their measured latency and queue depth. Otherwise all go to the most recently synced one
+				bool m_Striping = true;
+				uint32_t m_MaxInFlight = 64; // per connection, when striping over several ones. The rest wait, and go to whichever connection becomes free first. A single connection takes all
+				uint32_t m_DefaultLatency_ms = 200; // assumed for the nodes not measured yet
 			} m_Cfg;
 
 			class Connection
@@ -170,7 +180,7 @@ namespace proto {
 				void SetTimer(uint32_t);
 				void KillTimer();
 
-				void ResetInternal();
+				void ResetInternal(bool bFailOver);
 				void ResetVars();
 
 			public:
@@ -189,7 +199,14 @@ namespace proto {
 
 				RequestList m_lst; // in progress
 				void AssignRequests();
-				void AssignRequest(RequestNode&);
+				bool AssignRequest(RequestNode&); // returns false if not supported by this connection
+
+				bool IsSupported(Request&);
+				uint64_t get_Cost() const; // expected time to complete one more request
+
+				uint32_t m_Latency_ms; // moving average, 0 if not measured yet
+				uint32_t m_TimeLastDone_ms;
+				uint32_t m_RequestsDone; // stat
 
 				bool IsAtTip() const;
 				uint32_t m_LoginFlags;
@@ -234,6 +251,7 @@ namespace proto {
 			virtual void Disconnect() override;
 			virtual void PostRequestInternal(Request&) override;
 			virtual void BbsSubscribe(BbsChannel, Timestamp, IBbsReceiver*) override;
+			virtual bool IsProofsBatchSupported() const override;
 
 			// more events
 			virtual void OnNodeConnected(bool) {}
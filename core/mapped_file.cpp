@@ -54,6 +54,8 @@ namespace beam
 	uint32_t MappedFile::s_PageSize = 0;
 
 	MappedFile::MappedFile()
+		:m_nModified(0)
+		,m_bTrackModified(false)
 	{
 		ResetVarsFile();
 		ResetVarsMapping();
@@ -146,6 +148,24 @@ namespace beam
 		}
 
 #endif // WIN32
+
+		if (m_bTrackModified)
+		{
+			// grown, the former last chunk is no more partial
+			size_t nChunks = static_cast<size_t>((m_nMapping + s_ModifiedChunk - 1) / s_ModifiedChunk);
+			size_t nPrev = m_vModified.size();
+			if (nChunks > nPrev)
+			{
+				if (nPrev && !m_vModified[nPrev - 1])
+				{
+					m_vModified[nPrev - 1] = true;
+					m_nModified++;
+				}
+
+				m_vModified.resize(nChunks, true);
+				m_nModified += nChunks - nPrev;
+			}
+		}
 	}
 
 	uint32_t MappedFile::Defs::get_Bank0() const
@@ -244,6 +264,8 @@ namespace beam
 
 		m_nBank0 = d.get_Bank0();
 		m_nBanks = d.m_nBanks;
+
+		MarkModifiedAll();
 	}
 
 	void* MappedFile::get_FixedHdr() const
@@ -279,6 +301,10 @@ namespace beam
 			OpenMapping();
 
 			Bank& b = get_Bank(iBank);
+			MarkModified(&b, sizeof(b)); // the new elements are in the new chunks
+
+			Offset nTail = b.m_Tail; // not empty if nMinFree > 1
+			b.m_Tail = 0;
 			Offset* p = &b.m_Tail;
 
 			while (true)
@@ -296,6 +322,82 @@ namespace beam
 
 				n0 = n0_;
 			}
+
+			*p = nTail;
+		}
+	}
+
+	void MappedFile::EnsureSize(Offset nSize)
+	{
+		if (m_nMapping >= nSize)
+			return;
+
+		// grow geometrically, to avoid remapping on each append
+		Offset n1 = AlignUp(std::max(nSize, m_nMapping + (m_nMapping >> 1)), s_PageSize);
+
+		CloseMapping();
+		Resize(n1);
+		OpenMapping();
+	}
+
+	void MappedFile::Flush(Offset n0, Offset nSize)
+	{
+		assert(n0 + nSize <= m_nMapping);
+		if (!nSize)
+			return;
+
+		Offset n1 = n0 & ~Offset(s_PageSize - 1);
+		nSize += n0 - n1;
+
+#ifdef WIN32
+		test_SysRet(!FlushViewOfFile(m_pMapping + n1, (size_t) nSize), "FlushViewOfFile");
+		test_SysRet(!FlushFileBuffers(m_hFile), "FlushFileBuffers");
+#else // WIN32
+		test_SysRet(msync(m_pMapping + n1, (size_t) nSize, MS_SYNC) != 0, "msync");
+#endif // WIN32
+	}
+
+	void MappedFile::TrackModified(bool b)
+	{
+		m_bTrackModified = b;
+		if (b)
+			MarkModifiedAll();
+		else
+		{
+			m_vModified.clear();
+			m_nModified = 0;
+		}
+	}
+
+	void MappedFile::MarkModifiedAll()
+	{
+		if (!m_bTrackModified)
+			return;
+
+		size_t nChunks = static_cast<size_t>((m_nMapping + s_ModifiedChunk - 1) / s_ModifiedChunk);
+		if ((m_vModified.size() != nChunks) || (m_nModified != nChunks)) // may be called per element
+		{
+			m_vModified.assign(nChunks, true);
+			m_nModified = nChunks;
+		}
+	}
+
+	void MappedFile::MarkModified(const void* p, Offset nSize)
+	{
+		if (!m_bTrackModified)
+			return;
+
+		Offset n0 = get_Offset(p);
+		assert(nSize && (n0 + nSize <= m_nMapping));
+
+		for (Offset i = n0 / s_ModifiedChunk; i <= (n0 + nSize - 1) / s_ModifiedChunk; i++)
+		{
+			std::vector<bool>::reference x = m_vModified[static_cast<size_t>(i)];
+			if (!x)
+			{
+				x = true;
+				m_nModified++;
+			}
 		}
 	}
 
@@ -307,6 +409,9 @@ namespace beam
 		Bank& b = get_Bank(iBank);
 
 		Offset& ret = get_At<Offset>(b.m_Tail);
+		MarkModified(&b, sizeof(b));
+		MarkModified(&ret, nSize);
+
 		b.m_Tail = ret;
 		b.m_Free--;
 
@@ -317,6 +422,8 @@ namespace beam
 	{
 		assert(p);
 		Bank& b = get_Bank(iBank);
+		MarkModified(&b, sizeof(b));
+		MarkModified(p, sizeof(Offset));
 
 		*((Offset*) p) = b.m_Tail;
 
@@ -326,4 +433,72 @@ namespace beam
 		b.m_Free++;
 	}
 
+	MappedFile::Copier::Copier()
+		:m_pMapping(nullptr)
+		,m_iNext(0)
+	{
+	}
+
+	void MappedFile::Copier::Open(const char* sz, MappedFile& mf)
+	{
+		m_File.Open(sz, false, true);
+
+		m_pMapping = &mf;
+		m_iNext = 0;
+
+		mf.TrackModified(true); // nothing is copied yet
+	}
+
+	void MappedFile::Copier::Close()
+	{
+		m_File.Close();
+
+		if (m_pMapping)
+		{
+			m_pMapping->TrackModified(false);
+			m_pMapping = nullptr;
+		}
+	}
+
+	void MappedFile::Copier::CopyChunk(uint64_t iChunk, uint64_t nChunks)
+	{
+		MappedFile& mf = *m_pMapping;
+
+		Offset nOffs = iChunk * s_ChunkSize;
+		uint32_t nSize = (iChunk + 1 < nChunks) ? s_ChunkSize : static_cast<uint32_t>(mf.get_Size() - nOffs);
+
+		m_File.Seek(nOffs);
+		m_File.write(mf.get_Base() + nOffs, nSize);
+
+		mf.m_vModified[iChunk] = false;
+		mf.m_nModified--;
+	}
+
+	bool MappedFile::Copier::Step(uint32_t nMaxWrite, bool bFinalize)
+	{
+		assert(IsOpen() && nMaxWrite);
+		MappedFile& mf = *m_pMapping;
+
+		uint64_t nChunks = mf.m_vModified.size();
+		assert(nChunks == (mf.get_Size() + s_ChunkSize - 1) / s_ChunkSize);
+
+		// the copy is exact if the remaining modifications fit the limit
+		bool bExact = bFinalize && (mf.m_nModified <= nMaxWrite);
+
+		for (uint32_t nWritten = 0; mf.m_nModified && (nWritten < nMaxWrite); m_iNext++)
+		{
+			if (m_iNext >= nChunks)
+				m_iNext = 0;
+
+			if (mf.m_vModified[m_iNext])
+			{
+				CopyChunk(m_iNext, nChunks);
+				nWritten++;
+			}
+		}
+
+		m_File.Flush();
+		return bExact;
+	}
+
 } // namespace beam
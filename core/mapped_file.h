@@ -44,6 +44,11 @@ namespace beam
 		uint32_t m_nBank0;
 		uint32_t m_nBanks;
 
+		// chunks modified since they were last copied (see Copier), maintained only while tracked
+		std::vector<bool> m_vModified;
+		uint64_t m_nModified;
+		bool m_bTrackModified;
+
 		void ResetVarsFile();
 		void ResetVarsMapping();
 		void CloseMapping();
@@ -87,6 +92,46 @@ namespace beam
 		void Free(uint32_t iBank, void*);
 
 		void EnsureReserve(uint32_t iBank, uint32_t nSize, uint32_t nMinFree);
+
+		// grows the file (never shrinks), for flat data kept after the fixed header
+		void EnsureSize(Offset nSize);
+		Offset get_Size() const { return m_nMapping; }
+
+		// writes the modified pages of the range to the disk, returns when they're there
+		void Flush(Offset n0, Offset nSize);
+
+		// Tracking of the modified chunks, for the Copier. Allocate/Free/EnsureReserve mark their writes, the owner must mark the rest.
+		// Enabling it, as well as (re)opening the file, marks everything.
+		static const uint32_t s_ModifiedChunk = 0x10000;
+
+		void TrackModified(bool);
+		bool IsTrackingModified() const { return m_bTrackModified; }
+		void MarkModified(const void*, Offset nSize); // ignored unless tracked
+		void MarkModifiedAll();
+
+		// Incremental copy of a live mapping into a regular file, for hot backups. Tracks the modified chunks of the mapping while open.
+		// Each Step rewrites at most nMaxWrite of the chunks modified since they were last copied. A Step with bFinalize returns true
+		// if all the remaining ones fit the limit, i.e. the copy is brought into an exact match. Call it only when the mapping is consistent (i.e. flushed).
+		// The mapping is never scanned: a Step only visits the modified chunks, so the final one is bounded just as the others.
+		class Copier
+		{
+			std::FStream m_File;
+			MappedFile* m_pMapping;
+			uint64_t m_iNext;
+
+			void CopyChunk(uint64_t iChunk, uint64_t nChunks);
+
+		public:
+			static const uint32_t s_ChunkSize = s_ModifiedChunk;
+
+			Copier();
+
+			void Open(const char* sz, MappedFile&); // throws on error
+			void Close(); // stops the tracking
+			bool IsOpen() const { return m_File.IsOpen(); }
+
+			bool Step(uint32_t nMaxWrite, bool bFinalize);
+		};
 	};
 
 } // namespace beam
@@ -16,6 +16,7 @@
 #include "core/serialization_adapters.h"
 #include "core/ecc_native.h"
 #include "proto.h"
+#include "compression.h"
 #include "../utility/logger.h"
 
 namespace beam {
@@ -150,7 +151,7 @@ void InitCipherIV(AES::StreamCipher& c, const ECC::Hash::Value& hvSecret, const
     c.m_nBuf = 0;
 }
 
-bool InitViaDiffieHellman(const ECC::Scalar::Native& myPrivate, const PeerID& remotePublic, AES::Encoder& enc, ECC::Hash::Mac& hmac, AES::StreamCipher* pCipherOut, AES::StreamCipher* pCipherIn)
+bool InitViaDiffieHellman(const ECC::Scalar::Native& myPrivate, const PeerID& remotePublic, AES::Encoder& enc, ECC::Hash::Mac& hmac, AES::StreamCipher* pCipherOut, AES::StreamCipher* pCipherIn, const PeerID* pMyPublic = nullptr)
 {
     // Diffie-Hellman
     ECC::Point::Native p;
@@ -172,9 +173,14 @@ bool InitViaDiffieHellman(const ECC::Scalar::Native& myPrivate, const PeerID& re
 
     if (pCipherIn)
     {
-        PeerID myPublic;
-        myPublic.FromSk(Cast::NotConst(myPrivate)); // my private must have been already normalized. Should not be modified.
-        InitCipherIV(*pCipherIn, hvSecret.V, myPublic);
+        if (pMyPublic)
+            InitCipherIV(*pCipherIn, hvSecret.V, *pMyPublic);
+        else
+        {
+            PeerID myPublic;
+            myPublic.FromSk(Cast::NotConst(myPrivate)); // my private must have been already normalized. Should not be modified.
+            InitCipherIV(*pCipherIn, hvSecret.V, myPublic);
+        }
     }
 
     return true;
@@ -189,7 +195,47 @@ void ProtocolPlus::InitCipher()
 }
 
 
-bool Bbs::Encrypt(ByteBuffer& res, const PeerID& publicAddr, ECC::Scalar::Native& nonce, const void* p, uint32_t n)
+void Bbs::Tag::Get(Type& res, const PeerID& pkEphemeral, const PeerID& pkRecipient)
+{
+    ECC::Hash::Value hv;
+    ECC::Hash::Processor()
+        << "bbs.tag"
+        << pkEphemeral
+        << pkRecipient
+        >> hv;
+
+    static_assert(Type::nBytes <= ECC::Hash::Value::nBytes, "");
+    memcpy(res.m_pData, hv.m_pData, res.nBytes);
+}
+
+bool Bbs::Tag::IsPresent(const uint8_t* p, uint32_t n)
+{
+    if (n < PeerID::nBytes + ECC::Hash::Value::nBytes + s_TrailerSize)
+        return false;
+
+    uintBigFor<uint32_t>::Type magic;
+    memcpy(magic.m_pData, p + n - magic.nBytes, magic.nBytes);
+
+    uint32_t val;
+    magic.Export(val);
+    return (s_Magic == val);
+}
+
+bool Bbs::Tag::MaybeMatch(const uint8_t* p, uint32_t n, const PeerID& pkRecipient)
+{
+    if (!IsPresent(p, n))
+        return true;
+
+    PeerID pkEphemeral;
+    memcpy(pkEphemeral.m_pData, p, pkEphemeral.nBytes);
+
+    Type tag;
+    Get(tag, pkEphemeral, pkRecipient);
+
+    return !memcmp(tag.m_pData, p + n - s_TrailerSize, tag.nBytes);
+}
+
+bool Bbs::Encrypt(ByteBuffer& res, const PeerID& publicAddr, ECC::Scalar::Native& nonce, const void* p, uint32_t n, bool bTag)
 {
     PeerID myPublic;
     myPublic.FromSk(nonce);
@@ -200,49 +246,172 @@ bool Bbs::Encrypt(ByteBuffer& res, const PeerID& publicAddr, ECC::Scalar::Native
     if (!InitViaDiffieHellman(nonce, publicAddr, enc, hmac, &cOut, NULL))
         return false; // bad address
 
-    hmac.Write(p, n);
+    const uint32_t nTrailer = bTag ? Tag::s_TrailerSize : 0;
     ECC::Hash::Value hvMac;
-    hmac >> hvMac;
 
-    res.resize(myPublic.nBytes + hvMac.nBytes + n);
+    res.resize(myPublic.nBytes + hvMac.nBytes + n + nTrailer);
     uint8_t* pDst = &res.at(0);
 
     memcpy(pDst, myPublic.m_pData, myPublic.nBytes);
-    memcpy(pDst + myPublic.nBytes, hvMac.m_pData, hvMac.nBytes);
-    memcpy(pDst + myPublic.nBytes + hvMac.nBytes, p, n);
+    pDst += myPublic.nBytes;
+
+    if (n)
+        memcpy(pDst + hvMac.nBytes, p, n);
+
+    if (bTag)
+    {
+        // The trailer must remain in cleartext after the encryption. Means the plaintext trailer is the trailer XOR-ed with the cipherstream
+        uint8_t* pTrailer = pDst + hvMac.nBytes + n;
+
+        Tag::Type tag;
+        Tag::Get(tag, myPublic, publicAddr);
+        memcpy(pTrailer, tag.m_pData, tag.nBytes);
+
+        uintBigFor<uint32_t>::Type magic = Tag::s_Magic;
+        memcpy(pTrailer + tag.nBytes, magic.m_pData, magic.nBytes);
+
+        AES::StreamCipher cTmp = cOut;
+        uint8_t pStream[0x400];
+
+        for (uint32_t nSkip = hvMac.nBytes + n; nSkip; )
+        {
+            uint32_t nPortion = std::min<uint32_t>(nSkip, sizeof(pStream));
+            cTmp.XCrypt(enc, pStream, nPortion); // just advance
+            nSkip -= nPortion;
+        }
+
+        memset(pStream, 0, Tag::s_TrailerSize);
+        cTmp.XCrypt(enc, pStream, Tag::s_TrailerSize);
+
+        for (uint32_t i = 0; i < Tag::s_TrailerSize; i++)
+            pTrailer[i] ^= pStream[i];
+    }
+
+    hmac.Write(pDst + hvMac.nBytes, n + nTrailer);
+    hmac >> hvMac;
+
+    memcpy(pDst, hvMac.m_pData, hvMac.nBytes);
 
-    cOut.XCrypt(enc, pDst + myPublic.nBytes, hvMac.nBytes + n);
+    cOut.XCrypt(enc, pDst, hvMac.nBytes + n + nTrailer);
 
     return true;
 }
 
+namespace {
+
+    bool BbsDecrypt(uint8_t*& p, uint32_t& n, const ECC::Scalar::Native& privateAddr, const PeerID* pPublicAddr)
+    {
+        PeerID remotePublic;
+        ECC::Hash::Value hvMac, hvMac2;
+
+        if (n < remotePublic.nBytes + hvMac.nBytes)
+            return false;
+
+        memcpy(remotePublic.m_pData, p, remotePublic.nBytes);
+
+        AES::Encoder enc;
+        AES::StreamCipher cIn;
+        ECC::Hash::Mac hmac;
+        if (!InitViaDiffieHellman(privateAddr, remotePublic, enc, hmac, NULL, &cIn, pPublicAddr))
+            return false; // bad address
+
+        cIn.XCrypt(enc, p + remotePublic.nBytes, n - remotePublic.nBytes);
+
+        memcpy(hvMac.m_pData, p + remotePublic.nBytes, hvMac.nBytes);
+
+        p += remotePublic.nBytes + hvMac.nBytes;
+        n -= (remotePublic.nBytes + hvMac.nBytes);
+
+        hmac.Write(p, n);
+        hmac >> hvMac2;
+
+        // The tag trailer (if any) is left in the payload, the same as the older receivers see it.
+        // It can't be detected reliably w/o the sender's indication, and the payload deserialization ignores it anyway.
+        return (hvMac == hvMac2);
+    }
+}
+
 bool Bbs::Decrypt(uint8_t*& p, uint32_t& n, const ECC::Scalar::Native& privateAddr)
 {
-    PeerID remotePublic;
-    ECC::Hash::Value hvMac, hvMac2;
+    return BbsDecrypt(p, n, privateAddr, nullptr);
+}
+
+bool Bbs::Decrypt(uint8_t*& p, uint32_t& n, const ECC::Scalar::Native& privateAddr, const PeerID& publicAddr)
+{
+    return BbsDecrypt(p, n, privateAddr, &publicAddr);
+}
+
+bool Bbs::TrialDecryptor::TryKey(uint32_t iKey, ByteBuffer& res) const
+{
+    const Key& key = m_vKeys[iKey];
+
+    res = *m_pMsg; // decrypted in-place, hence the copy
+    uint8_t* p = &res.front();
+    uint32_t n = static_cast<uint32_t>(res.size());
 
-    if (n < remotePublic.nBytes + hvMac.nBytes)
+    if (!proto::Bbs::Decrypt(p, n, key.m_sk, key.m_Pk))
         return false;
 
-    memcpy(remotePublic.m_pData, p, remotePublic.nBytes);
+    size_t nOffs = p - &res.front();
+    res.erase(res.begin() + nOffs + n, res.end());
+    res.erase(res.begin(), res.begin() + nOffs);
+    return true;
+}
 
-    AES::Encoder enc;
-    AES::StreamCipher cIn;
-    ECC::Hash::Mac hmac;
-    if (!InitViaDiffieHellman(privateAddr, remotePublic, enc, hmac, NULL, &cIn))
-        return false; // bad address
+void Bbs::TrialDecryptor::Exec(Executor::Context& ctx)
+{
+    uint32_t i0, nCount;
+    ctx.get_Portion(i0, nCount, static_cast<uint32_t>(m_vCandidates.size()));
 
-    cIn.XCrypt(enc, p + remotePublic.nBytes, n - remotePublic.nBytes);
+    ByteBuffer buf;
+    for (uint32_t i = 0; i < nCount; i++)
+    {
+        uint32_t iKey = m_vCandidates[i0 + i];
+        if (m_iFound < iKey)
+            break; // lower one is already found by another thread
 
-    memcpy(hvMac.m_pData, p + remotePublic.nBytes, hvMac.nBytes);
+        if (TryKey(iKey, buf))
+        {
+            // keep the lowest, so that the result doesn't depend on the threads timing
+            for (uint32_t iPrev = m_iFound; (iPrev > iKey) && !m_iFound.compare_exchange_weak(iPrev, iKey); )
+                ;
+            break;
+        }
+    }
+}
+
+uint32_t Bbs::TrialDecryptor::Decrypt(const ByteBuffer& msg, ByteBuffer& res, uint32_t iKey0 /* = 0 */)
+{
+    if (msg.empty())
+        return s_NotFound;
+
+    m_pMsg = &msg;
+
+    m_vCandidates.clear();
+    for (uint32_t i = iKey0; i < m_vKeys.size(); i++)
+        if (!m_TagFilter || Tag::MaybeMatch(&msg.front(), static_cast<uint32_t>(msg.size()), m_vKeys[i].m_Pk))
+            m_vCandidates.push_back(i);
 
-    p += remotePublic.nBytes + hvMac.nBytes;
-    n -= (remotePublic.nBytes + hvMac.nBytes);
+    m_nPassed += m_vCandidates.size();
 
-    hmac.Write(p, n);
-    hmac >> hvMac2;
+    Executor* pExec = Executor::s_pInstance;
+    if (pExec && (pExec->get_Threads() > 1) && (m_vCandidates.size() > 1))
+    {
+        m_iFound = s_NotFound;
+        pExec->ExecAll(*this);
+
+        uint32_t iKey = m_iFound;
+        if (s_NotFound != iKey)
+            BEAM_VERIFY(TryKey(iKey, res)); // the found one decrypts again, the others are rejected anyway
+
+        return iKey;
+    }
 
-    return (hvMac == hvMac2);
+    for (uint32_t i = 0; i < m_vCandidates.size(); i++)
+        if (TryKey(m_vCandidates[i], res))
+            return m_vCandidates[i];
+
+    return s_NotFound;
 }
 
 void Bbs::get_HashPartial(ECC::Hash::Processor& hp, const BbsMsg& msg)
@@ -300,10 +469,14 @@ NodeConnection::NodeConnection()
 	,m_RulesCfgSent(false)
 {
 #define THE_MACRO(code, msg) \
-    m_Protocol.add_message_handler<NodeConnection, msg##_NoInit, &NodeConnection::OnMsgInternal>(uint8_t(code), this, 0, 1024*1024*10);
+    if (BodyPack::s_Code != code) \
+        m_Protocol.add_message_handler<NodeConnection, msg##_NoInit, &NodeConnection::OnMsgInternal>(uint8_t(code), this, 0, g_MaxMsgSize);
 
     BeamNodeMsgsAll(THE_MACRO)
 #undef THE_MACRO
+
+    // block packs are parsed in-place
+    m_Protocol.add_custom_message_handler(BodyPack::s_Code, this, 0, g_MaxMsgSize, OnBodyPackRaw);
 }
 
 NodeConnection::~NodeConnection()
@@ -320,6 +493,7 @@ void NodeConnection::Reset()
     }
 
 	m_RulesCfgSent = false;
+	m_Compression.m_Remote = false;
     m_Connection = NULL;
     m_pAsyncFail = NULL;
 
@@ -518,11 +692,127 @@ bool NodeConnection::IsLive() const
     return m_Connection && !m_pAsyncFail;
 }
 
+// Only large msgs that don't mix secret and peer-controlled data are compressed
+template <typename T> inline bool IsCompressible(const T&) { return false; }
+inline bool IsCompressible(const HdrPack&) { return true; }
+inline bool IsCompressible(const Body&) { return true; }
+inline bool IsCompressible(const BodyPack&) { return true; }
+inline bool IsCompressible(const ShieldedList&) { return true; }
+
+template <typename T>
+bool NodeConnection::SendCompressed(uint8_t nCode, const T& v)
+{
+    if (!m_Compression.m_Remote || !m_Compression.m_Threshold || !IsCompressible(v))
+        return false;
+
+    Serializer ser;
+    ser & v;
+
+    SerializeBuffer sb = ser.buffer();
+    if (sb.second < m_Compression.m_Threshold)
+        return false;
+
+    Compressed msg;
+    msg.m_Code = nCode;
+    msg.m_SizeRaw = static_cast<uint32_t>(sb.second);
+    beam::Compression::Compress(msg.m_Data, sb.first, sb.second);
+
+    if (msg.m_Data.size() >= sb.second)
+        return false; // incompressible, send as-is
+
+    Send(msg);
+    return true;
+}
+
+bool NodeConnection::OnMsg2(Compressed&& msg)
+{
+    if ((Compressed::s_Code == msg.m_Code) || (msg.m_Code >= m_Protocol.max_message_types()) || (msg.m_SizeRaw > g_MaxMsgSize))
+        ThrowUnexpected();
+
+    ByteBuffer buf;
+    if (!beam::Compression::Decompress(buf, msg.m_Data.empty() ? nullptr : &msg.m_Data.front(), msg.m_Data.size(), msg.m_SizeRaw))
+        ThrowUnexpected("decompression");
+
+    // dispatch the wrapped msg the usual way. The return value must be forwarded, since the handler may have destroyed this object.
+    return m_Protocol.on_new_message(0, msg.m_Code, buf.empty() ? nullptr : &buf.front(), buf.size());
+}
+
+void BodyPackReader::Reset(const void* p, size_t n)
+{
+	m_Der.reset(p, n);
+	m_Size = n;
+
+	size_t nCount = m_Der.read_seq_size();
+	if (nCount > n)
+		NodeConnection::ThrowUnexpected(); // each body takes at least 1 byte
+
+	m_Remaining = static_cast<uint32_t>(nCount);
+}
+
+bool BodyPackReader::MoveNext(Blob& bbP, Blob& bbE)
+{
+	if (!m_Remaining)
+		return false;
+
+	size_t nP, nE;
+	bbP.p = m_Der.read_seq(nP);
+	bbE.p = m_Der.read_seq(nE);
+
+	bbP.n = static_cast<uint32_t>(nP);
+	bbE.n = static_cast<uint32_t>(nE);
+
+	m_Remaining--;
+	return true;
+}
+
+void BodyPackReader::TestEnd()
+{
+	if (m_Remaining || m_Der.bytes_left())
+		NodeConnection::ThrowUnexpected();
+}
+
+bool NodeConnection::OnBodyPack(BodyPackReader& r)
+{
+	BodyPack msg;
+
+	Blob bbP, bbE;
+	while (r.MoveNext(bbP, bbE))
+	{
+		msg.m_Bodies.emplace_back();
+		bbP.Export(msg.m_Bodies.back().m_Perishable);
+		bbE.Export(msg.m_Bodies.back().m_Eternal);
+	}
+
+	r.TestEnd();
+	return OnMsg2(std::move(msg));
+}
+
+bool NodeConnection::OnBodyPackRaw(void* pThis, IErrorHandler&, Deserializer&, uint64_t, const void* p, size_t n)
+{
+	NodeConnection& x = *static_cast<NodeConnection*>(pThis);
+	try {
+		x.TestInputMsgContext(BodyPack::s_Code);
+
+		BodyPackReader r;
+		r.Reset(p, n);
+		return x.OnBodyPack(r);
+
+	} catch (const NodeProcessingException& e) {
+		x.OnProcessingExc(e);
+		return false;
+	} catch (const std::exception& e) {
+		x.OnExc(e);
+		return false;
+	}
+}
+
 #define THE_MACRO(code, msg) \
 void NodeConnection::Send(const msg& v) \
 { \
     if (!IsLive()) \
         return; \
+    if (SendCompressed(uint8_t(code), v)) \
+        return; \
     m_SerializeCache.clear(); \
     MsgSerializer& ser = m_Protocol.serializeNoFinalize(m_SerializeCache, uint8_t(code), v); \
     m_Protocol.Encrypt(m_SerializeCache, ser); \
@@ -612,6 +902,8 @@ void NodeConnection::SendLogin()
 {
 	Login msg;
 	msg.m_Flags = LoginFlags::ExtensionsAll;
+	if (m_Compression.m_Threshold)
+		msg.m_Flags |= LoginFlags::Compression;
 	SetupLogin(msg);
 
 	const Rules& r = Rules::get();
@@ -739,6 +1031,8 @@ void NodeConnection::OnLoginInternal(Height hScheme, Login&& msg)
 		}
 	}
 
+	m_Compression.m_Remote = (LoginFlags::Compression & msg.m_Flags) != 0;
+
 	if (hScheme < MaxHeight)
 	{
 		LOG_WARNING() << "Peer " << m_Connection->peer_address() << " incompatible with fork " << (hScheme + 1);
@@ -21,6 +21,7 @@
 #include "../p2p/connection.h"
 #include "../utility/io/tcpserver.h"
 #include "../utility/io/timer.h"
+#include "../utility/executor.h"
 #include "aes.h"
 #include "block_crypt.h"
 
@@ -84,6 +85,12 @@ namespace proto {
     macro(ECC::Point, Utxo) \
     macro(Height, MaturityMin) /* set to non-zero in case the result is too big, and should be retrieved within multiple queries */
 
+#define BeamNodeMsg_GetProofKernels(macro) \
+    macro(std::vector<Merkle::Hash>, IDs)
+
+#define BeamNodeMsg_GetProofUtxos(macro) \
+    macro(std::vector<ECC::Point>, Utxos)
+
 #define BeamNodeMsg_GetProofShieldedOutp(macro) \
     macro(ECC::Point, SerialPub)
 
@@ -112,6 +119,18 @@ namespace proto {
 #define BeamNodeMsg_ProofUtxo(macro) \
     macro(std::vector<Input::Proof>, Proofs)
 
+#define BeamNodeMsg_ProofKernels(macro) \
+    macro(std::vector<Height>, Heights) /* for each requested kernel, 0 if not found */ \
+    macro(std::vector<Merkle::Proof>, Proofs) /* for each found kernel, up to the Kernels root of its block */ \
+    macro(std::vector<Block::SystemState::Full>, States) /* distinct heights of the found kernels, ascending */ \
+    macro(Merkle::MultiProof, ProofStates) /* merged proof of those States (except the tip) */ \
+    macro(Merkle::Hash, RootLive)
+
+#define BeamNodeMsg_ProofUtxos(macro) \
+    macro(std::vector<uint32_t>, Counts) /* num of proofs for each requested utxo */ \
+    macro(std::vector<Input::Proof>, Proofs) /* all together, without the common part */ \
+    macro(Merkle::Proof, ProofLive) /* common part, from the Utxos root up to the Definition */
+
 #define BeamNodeMsg_ProofShieldedOutp(macro) \
     macro(ECC::Point, Commitment) \
     macro(TxoID, ID) \
@@ -239,6 +258,11 @@ namespace proto {
     macro(Asset::ID, AssetsMax) \
     macro(Asset::ID, AssetsActive) \
 
+#define BeamNodeMsg_Compressed(macro) \
+    macro(uint8_t, Code) /* code of the wrapped msg */ \
+    macro(uint32_t, SizeRaw) \
+    macro(ByteBuffer, Data)
+
 #define BeamNodeMsgsAll(macro) \
     /* general msgs */ \
     macro(0x00, Login0) \
@@ -310,6 +334,13 @@ namespace proto {
     macro(0x3f, BbsMsg) \
     macro(0x45, GetStateSummary) \
     macro(0x46, StateSummary) \
+    /* transport */ \
+    macro(0x47, Compressed) \
+    /* batched proofs */ \
+    macro(0x48, GetProofKernels) \
+    macro(0x49, ProofKernels) \
+    macro(0x4a, GetProofUtxos) \
+    macro(0x4b, ProofUtxos) \
 
 
     struct LoginFlags {
@@ -321,7 +352,9 @@ namespace proto {
         static const uint32_t Extension2             = 0x20; // Supports large HdrPack, BlockPack with parameters
         static const uint32_t Extension3             = 0x40; // Supports Login1, Status (former Boolean) for NewTransaction result, compatible with Fork H1
         static const uint32_t Extension4             = 0x80; // Supports proto::Events (replaces proto::EventsLegacy)
-	    static const uint32_t Recognized             = 0xff;
+        static const uint32_t Compression            = 0x100; // Accepts proto::Compressed for large msgs (headers, blocks, shielded list). Optional
+        static const uint32_t ProofsBatch            = 0x200; // Supports GetProofKernels and GetProofUtxos. Optional
+	    static const uint32_t Recognized             = 0x3ff;
 
 
 		static const uint32_t ExtensionsBeforeHF1 =
@@ -342,6 +375,8 @@ namespace proto {
     };
 
 	static const uint32_t g_HdrPackMaxSize = 2048; // about 400K
+	static const uint32_t g_MaxMsgSize = 1024 * 1024 * 10;
+	static const uint32_t g_ProofsBatchMax = 1024; // max items in GetProofKernels, GetProofUtxos
 
     struct Event
     {
@@ -489,6 +524,20 @@ namespace proto {
 
 	};
 
+	// Parses the serialized BodyPack in-place. The bodies refer to the msg buffer, nothing is copied
+	struct BodyPackReader
+	{
+		uint32_t m_Remaining = 0;
+		size_t m_Size = 0; // total serialized size
+
+		void Reset(const void*, size_t);
+		bool MoveNext(Blob& bbP, Blob& bbE); // throws on malformed data
+		void TestEnd(); // throws if not fully consumed
+
+	private:
+		Deserializer m_Der;
+	};
+
     enum Unused_ { Unused };
     enum Uninitialized_ { Uninitialized };
 
@@ -509,6 +558,7 @@ namespace proto {
     inline void ZeroInit(Block::SystemState::Full& x) { ZeroObject(x); }
     inline void ZeroInit(Block::SystemState::Sequence::Prefix& x) { ZeroObject(x); }
     inline void ZeroInit(Block::ChainWorkProof& x) {}
+    inline void ZeroInit(Merkle::MultiProof&) {}
     inline void ZeroInit(ECC::Point& x) { ZeroObject(x); }
     inline void ZeroInit(ECC::Signature& x) { ZeroObject(x); }
     inline void ZeroInit(TxKernel::LongProof& x) { ZeroObject(x.m_State); }
@@ -543,8 +593,56 @@ namespace proto {
 
 		typedef uintBig_t<4> NonceType;
 
-		bool Encrypt(ByteBuffer& res, const PeerID& publicAddr, ECC::Scalar::Native& nonce, const void*, uint32_t); // will fail iff addr is invalid
+		// Optional recipient tag, lets the receiver reject messages addressed to others via a hash, before the ECDH.
+		// It's appended by the sender as a cleartext trailer of the ciphertext. Since it's also a part of the MAC-protected plaintext - the receivers just see a few extra payload bytes after the decryption.
+		// Note: whoever knows the recipient address can recognize the tagged messages addressed to it, hence it's opt-in for the sender.
+		struct Tag
+		{
+			static const uint32_t s_Bytes = 2;
+			static const uint32_t s_Magic = 0x7a61bb5e;
+			static const uint32_t s_TrailerSize = s_Bytes + sizeof(s_Magic);
+
+			typedef uintBig_t<s_Bytes> Type;
+
+			static void Get(Type&, const PeerID& pkEphemeral, const PeerID& pkRecipient);
+			static bool IsPresent(const uint8_t* p, uint32_t n);
+			static bool MaybeMatch(const uint8_t* p, uint32_t n, const PeerID& pkRecipient); // untagged messages always pass
+		};
+
+		bool Encrypt(ByteBuffer& res, const PeerID& publicAddr, ECC::Scalar::Native& nonce, const void*, uint32_t, bool bTag = false); // will fail iff addr is invalid
 		bool Decrypt(uint8_t*& p, uint32_t& n, const ECC::Scalar::Native& privateAddr);
+		bool Decrypt(uint8_t*& p, uint32_t& n, const ECC::Scalar::Native& privateAddr, const PeerID& publicAddr); // saves the derivation of the public addr
+
+		// Trial decryption of a message with multiple keys. Keys are optionally prefiltered by the tag, the remaining are tried in parallel if the Executor is available.
+		struct TrialDecryptor
+			:public Executor::TaskSync
+		{
+			struct Key {
+				ECC::Scalar::Native m_sk;
+				PeerID m_Pk;
+			};
+
+			std::vector<Key> m_vKeys;
+
+			// Skip the keys that don't match the tag. Enable only if the senders tag their messages: the trailer is recognized by its marker,
+			// hence a message of an untagged sender may be skipped if its ciphertext accidentally ends with it (probability 2^-32).
+			bool m_TagFilter = false;
+
+			static const uint32_t s_NotFound = static_cast<uint32_t>(-1);
+
+			// Returns the index of the lowest matching key starting from iKey0, or s_NotFound
+			uint32_t Decrypt(const ByteBuffer& msg, ByteBuffer& res, uint32_t iKey0 = 0);
+
+			uint64_t m_nPassed = 0; // stat, keys that passed the prefilter (i.e. ECDH attempts)
+
+		private:
+			const ByteBuffer* m_pMsg;
+			std::vector<uint32_t> m_vCandidates;
+			std::atomic<uint32_t> m_iFound;
+
+			virtual void Exec(Executor::Context&) override;
+			bool TryKey(uint32_t iKey, ByteBuffer& res) const;
+		};
 	};
 
 	struct TxStatus
@@ -700,6 +798,11 @@ namespace proto {
 
 		void OnLoginInternal(Height hPeerMaxScheme, Login&&);
 
+		template <typename T>
+		bool SendCompressed(uint8_t nCode, const T&);
+
+		static bool OnBodyPackRaw(void*, IErrorHandler&, Deserializer&, uint64_t, const void*, size_t);
+
     public:
 
         NodeConnection();
@@ -730,6 +833,11 @@ namespace proto {
 		virtual void OnMsg(Login0&&) override;
 		virtual void OnMsg(Login&&) override;
         virtual void OnMsg(EventsLegacy&&) override; // auto-convert
+        using INodeMsgHandler::OnMsg2;
+        virtual bool OnMsg2(Compressed&&) override; // auto-unwrap
+
+		// Streaming receive of the block pack. By default it's deserialized in full, and passed to OnMsg(BodyPack&&)
+		virtual bool OnBodyPack(BodyPackReader&);
 
         virtual void GenerateSChannelNonce(ECC::Scalar::Native&); // Must be overridden to support SChannel
 
@@ -788,6 +896,12 @@ namespace proto {
 
         virtual void OnDisconnect(const DisconnectReason&) {}
 
+		struct Compression
+		{
+			uint32_t m_Threshold = 0; // min serialized size of the eligible msgs to compress. Set to 0 to disable (then it's not advertised to the peer)
+			bool m_Remote = false; // peer accepts compressed msgs
+		} m_Compression;
+
 		size_t get_Unsent() const;
 		size_t m_UnsentHiMark = 0;
 		void TestNotDrown();
@@ -43,7 +43,7 @@ void RadixTree::Clear()
 {
 	if (m_RootOffset)
 	{
-		OnDirty();
+		OnModified();
 
 		DeleteNode(get_Root());
 		m_RootOffset = 0;
@@ -201,7 +201,7 @@ RadixTree::Leaf* RadixTree::Find(CursorBase& cu, const uint8_t* pKey, uint16_t n
 	if (!bCreate)
 		return nullptr;
 
-	OnDirty();
+	OnModified();
 
 	Leaf* pN = CreateLeaf();
 
@@ -268,9 +268,99 @@ RadixTree::Leaf* RadixTree::Find(CursorBase& cu, const uint8_t* pKey, uint16_t n
 	return pN;
 }
 
+RadixTree::Leaf* RadixTree::Append(CursorBase& cu, const uint8_t* pKey, uint16_t nBits)
+{
+	OnModified();
+
+	Leaf* pN = CreateLeaf();
+
+	struct Guard
+	{
+		Leaf* m_pLeaf;
+		RadixTree* m_pTree;
+
+		~Guard() {
+			if (m_pLeaf)
+				m_pTree->DeleteLeaf(m_pLeaf);
+		}
+	} g;
+
+	g.m_pTree = this;
+	g.m_pLeaf = pN;
+
+	memcpy(GetLeafKey(*pN), pKey, (nBits + 7) >> 3);
+
+	if (m_RootOffset)
+	{
+		assert(cu.m_nPtrs && (cu.m_nBits == nBits));
+
+		// find the 1st differing bit
+		const uint8_t* pPrev = GetLeafKey(cu.get_Leaf());
+		uint16_t nDiff = 0;
+		for (uint16_t i = 0; ; i++)
+		{
+			assert((i << 3) < nBits); // keys must be different
+			uint8_t x = pKey[i] ^ pPrev[i];
+			if (x)
+			{
+				for (nDiff = i << 3; !(0x80 & x); x <<= 1)
+					nDiff++;
+				break;
+			}
+		}
+
+		assert(nDiff < nBits);
+		assert(1 & CursorBase::get_BitRawStat(pKey, nDiff)); // must be greater
+
+		// go up to the node that contains this bit. All the nodes in the path have the greatest keys, the branch bit can't be the differing one.
+		uint16_t nStart = nBits - cu.m_pp[cu.m_nPtrs - 1]->get_Bits();
+		while (nStart > nDiff)
+		{
+			assert(cu.m_nPtrs > 1);
+			cu.m_nPtrs--;
+			nStart -= cu.m_pp[cu.m_nPtrs - 1]->get_Bits() + 1;
+		}
+
+		Node* p = cu.m_pp[cu.m_nPtrs - 1];
+		assert(nDiff < nStart + p->get_Bits());
+
+		cu.InvalidateElement();
+
+		// split
+		Joint* pJ = CreateJoint();
+		pJ->m_pKeyPtr.set_Strict(get_NodeKey(*p));
+		pJ->m_Bits = nDiff - nStart;
+
+		ReplaceTip(cu, pJ);
+		cu.m_pp[cu.m_nPtrs - 1] = pJ;
+
+		pN->m_Bits = nBits - (nDiff + 1);
+		p->m_Bits -= nDiff - nStart + 1;
+
+		pJ->m_ppC[1].set_Strict(pN);
+		pJ->m_ppC[0].set_Strict(p);
+
+	} else
+	{
+		set_Root(pN);
+		pN->m_Bits = nBits;
+		cu.m_nPtrs = 0;
+	}
+
+	cu.m_pp[cu.m_nPtrs++] = pN;
+	cu.m_nPosInLastNode = pN->m_Bits;
+	cu.m_nBits = nBits;
+
+	pN->m_Bits |= Node::s_Leaf;
+
+	g.m_pLeaf = NULL; // dismissed
+
+	return pN;
+}
+
 void RadixTree::Delete(CursorBase& cu)
 {
-	OnDirty();
+	OnModified();
 
 	assert(cu.m_nPtrs);
 
@@ -507,6 +597,22 @@ const Merkle::Hash& RadixHashTree::get_Hash(Node& n, Merkle::Hash& hv)
 	return x.m_Hash;
 }
 
+RadixTree::Leaf* RadixHashTree::Append(CursorBase& cu, const uint8_t* pKey, uint16_t nBits)
+{
+	Leaf* pRet = RadixTree::Append(cu, pKey, nBits);
+
+	uint16_t n = cu.get_Depth();
+	if (n > 1)
+	{
+		Joint& x = Cast::Up<Joint>(*cu.get_pp()[n - 2]);
+
+		Merkle::Hash hv;
+		get_Hash(*x.m_ppC[0].get_Strict(), hv);
+	}
+
+	return pRet;
+}
+
 void RadixHashTree::get_Proof(Merkle::Proof& proof, const CursorBase& cu)
 {
 	uint16_t n = cu.get_Depth();
@@ -593,6 +699,23 @@ void UtxoTree::DeleteLeaf(Leaf* p)
 	DeleteEmptyLeaf(p);
 }
 
+UtxoTree::MyLeaf* UtxoTree::Append(CursorBase& cu, const Key& key, TxoID id)
+{
+	if (m_RootOffset)
+	{
+		MyLeaf& x = Cast::Up<MyLeaf>(cu.get_Leaf());
+		if (x.m_Key.V == key.V)
+		{
+			PushID(id, x);
+			return &x;
+		}
+	}
+
+	MyLeaf* p = Cast::Up<MyLeaf>(RadixHashTree::Append(cu, key.V.m_pData, key.s_Bits));
+	p->m_ID = id;
+	return p;
+}
+
 void UtxoTree::PushID(TxoID id, MyLeaf& x)
 {
 	if (!x.IsExt())
@@ -855,7 +978,7 @@ bool UtxoTreeMapped::Open(const char* sz, const Stamp& s)
 		0x44, 0x98, 0xFF, 0xD5,
 		0xDD, 0x1A, 0x46, 0xF8,
 		0xA1, 0xCD, 0x14, 0xEA,
-		0xFE, 0x35, 0xD7, 0x0FA
+		0xFE, 0x35, 0xD7, 0x0FB
 	};
 
 	MappedFile::Defs d;
@@ -866,17 +989,188 @@ bool UtxoTreeMapped::Open(const char* sz, const Stamp& s)
 
 	m_Mapping.Open(sz, d);
 
+	m_JournalRolledBack = 0;
+
 	Hdr& h = get_Hdr();
-	if (!h.m_Dirty && (h.m_Stamp == s))
+	if (!h.m_Dirty)
 	{
-		m_RootOffset = h.m_Root;
-		return true;
+		if (h.m_Stamp == s)
+		{
+			m_RootOffset = h.m_Root;
+			JournalReset(); // in case the flush was interrupted
+			return true;
+		}
+	}
+	else
+	{
+		// unclean shutdown. Roll back the modifications that were not committed
+		if (h.m_JournalValid && ((h.m_Stamp == s) || (h.m_StampPending == s)))
+		{
+			m_RootOffset = h.m_Root;
+
+			if (JournalRollback((h.m_Stamp == s) ? 0 : h.m_JournalCommitted))
+			{
+				JournalReset();
+
+				Hdr& h2 = get_Hdr(); // the mapping may have moved
+				h2.m_Dirty = 0;
+				h2.m_Root = m_RootOffset;
+				h2.m_Stamp = s;
+				return true;
+			}
+
+			m_RootOffset = 0; // prevent cleanup
+		}
 	}
 
 	m_Mapping.Open(sz, d, true); // reset
 	return false;
 }
 
+bool UtxoTreeMapped::JournalRollback(MappedFile::Offset nStop)
+{
+	if (get_Hdr().m_JournalOp)
+		return false; // interrupted in the middle of a modification
+
+	while (true)
+	{
+		Hdr& h = get_Hdr();
+		if (h.m_Journal == nStop)
+			break;
+		if (!h.m_Journal)
+			return false; // the stop entry wasn't found
+
+		JournalEntry& x0 = m_Mapping.get_At<JournalEntry>(h.m_Journal);
+		JournalEntry x = x0;
+		h.m_Journal = x.m_Next;
+		m_Mapping.Free(Type::Journal, &x0);
+
+		EnsureReserve();
+
+		Cursor cu;
+		bool bCreate = !x.m_Add;
+		MyLeaf* p = Find(cu, x.m_Key, bCreate);
+
+		if (x.m_Add)
+		{
+			if (!p)
+				return false;
+
+			if (p->IsExt())
+			{
+				if (PopID(*p) != x.m_ID)
+					return false;
+				cu.InvalidateElement();
+			}
+			else
+			{
+				if (p->m_ID != x.m_ID)
+					return false;
+				Delete(cu);
+			}
+		}
+		else
+		{
+			if (bCreate)
+				p->m_ID = x.m_ID;
+			else
+			{
+				PushID(x.m_ID, *p);
+				cu.InvalidateElement();
+			}
+		}
+
+		m_JournalRolledBack++;
+	}
+
+	return true;
+}
+
+void UtxoTreeMapped::JournalReset()
+{
+	Hdr& h = get_Hdr();
+	while (h.m_Journal)
+	{
+		JournalEntry& x = m_Mapping.get_At<JournalEntry>(h.m_Journal);
+		h.m_Journal = x.m_Next;
+		m_Mapping.Free(Type::Journal, &x);
+	}
+
+	h.m_JournalValid = 1;
+	h.m_JournalOp = 0;
+	h.m_JournalCommitted = 0;
+	h.m_StampPending = Zero;
+}
+
+void UtxoTreeMapped::JournalBegin()
+{
+	get_Hdr().m_JournalOp = 1;
+}
+
+void UtxoTreeMapped::JournalEnd(const Key& key, TxoID id, bool bAdd)
+{
+	if (get_Hdr().m_JournalValid)
+	{
+		JournalEntry& x = *Allocate<JournalEntry>(Type::Journal);
+		x.m_Next = get_Hdr().m_Journal;
+		x.m_Key = key;
+		x.m_ID = id;
+		x.m_Add = bAdd;
+
+		get_Hdr().m_Journal = m_Mapping.get_Offset(&x);
+	}
+
+	Hdr& h = get_Hdr();
+	h.m_Root = m_RootOffset;
+	h.m_JournalOp = 0;
+
+	if (m_Mapping.IsTrackingModified())
+		MarkModified(key);
+}
+
+void UtxoTreeMapped::MarkModified(const Key& key)
+{
+	// The operation modified the nodes on the path to the key (and their hashes will be updated), the sibling of the tip
+	// (split or merged), and the queue of the leaf. Allocated and freed elements are marked by the mapping.
+	Cursor cu;
+	bool bCreate = false;
+	MyLeaf* p = Find(cu, key, bCreate);
+
+	Node** pp = cu.get_pp();
+	uint16_t nDepth = cu.get_Depth();
+
+	for (uint16_t i = 0; i < nDepth; i++)
+		MarkModified(*pp[i]);
+
+	if (nDepth > 1)
+	{
+		const Joint& x = Cast::Up<Joint>(*pp[nDepth - 2]);
+		for (size_t i = 0; i < _countof(x.m_ppC); i++)
+			MarkModified(*x.m_ppC[i].get_Strict());
+	}
+
+	if (p && p->IsExt())
+		m_Mapping.MarkModified(p->m_pIDs.get_Strict(), sizeof(MyLeaf::IDQueue));
+}
+
+void UtxoTreeMapped::MarkModified(const Node& n)
+{
+	m_Mapping.MarkModified(&n, (Node::s_Leaf & n.m_Bits) ? sizeof(MyLeaf) : sizeof(MyJoint));
+}
+
+void UtxoTreeMapped::JournalCancel()
+{
+	get_Hdr().m_JournalOp = 0;
+	m_Mapping.MarkModifiedAll(); // the key is unknown, the path may be invalidated
+}
+
+void UtxoTreeMapped::JournalMarkCommit(const Stamp& s)
+{
+	Hdr& h = get_Hdr();
+	h.m_StampPending = s;
+	h.m_JournalCommitted = h.m_Journal;
+}
+
 void UtxoTreeMapped::Close()
 {
 	m_RootOffset = 0; // prevent cleanup
@@ -893,11 +1187,16 @@ void UtxoTreeMapped::FlushStrict(const Stamp& s)
 	Hdr& h = get_Hdr();
 	assert(h.m_Dirty);
 
+	h.m_JournalValid = 0; // until reset
+
 	h.m_Dirty = 0;
 	h.m_Root = m_RootOffset;
 	// TODO: flush
 
 	h.m_Stamp = s;
+
+	JournalReset();
+	m_Mapping.MarkModified(&get_Hdr(), sizeof(Hdr));
 }
 
 void UtxoTreeMapped::EnsureReserve()
@@ -907,7 +1206,8 @@ void UtxoTreeMapped::EnsureReserve()
 		m_Mapping.EnsureReserve(Type::Leaf, sizeof(MyLeaf), 1);
 		m_Mapping.EnsureReserve(Type::Joint, sizeof(MyJoint), 1);
 		m_Mapping.EnsureReserve(Type::Queue, sizeof(MyLeaf::IDQueue), 1);
-		m_Mapping.EnsureReserve(Type::Node, sizeof(MyLeaf::IDNode), 1);
+		m_Mapping.EnsureReserve(Type::Node, sizeof(MyLeaf::IDNode), 2); // PushID may convert the leaf into the queue of 2
+		m_Mapping.EnsureReserve(Type::Journal, sizeof(JournalEntry), 1);
 	}
 	catch (const std::exception& e)
 	{
@@ -923,6 +1223,35 @@ void UtxoTreeMapped::OnDirty()
 	get_Hdr().m_Dirty = 1;
 }
 
+void UtxoTreeMapped::OnModified()
+{
+	Hdr& h = get_Hdr();
+	if (!h.m_JournalOp)
+	{
+		h.m_JournalValid = 0; // not journaled
+		m_Mapping.MarkModifiedAll();
+	}
+
+	OnDirty();
+}
+
+UtxoTree::MyLeaf* UtxoTreeMapped::Append(CursorBase& cu, const Key& key, TxoID id)
+{
+	intptr_t nBase0 = get_Base();
+	EnsureReserve();
+
+	intptr_t nDelta = get_Base() - nBase0;
+	if (nDelta && m_RootOffset)
+	{
+		// remapped, the cursor points to the old mapping
+		Node** pp = cu.get_pp();
+		for (uint16_t i = 0; i < cu.get_Depth(); i++)
+			pp[i] = reinterpret_cast<Node*>(reinterpret_cast<intptr_t>(pp[i]) + nDelta);
+	}
+
+	return UtxoTree::Append(cu, key, id);
+}
+
 intptr_t UtxoTreeMapped::get_Base() const
 {
 	return reinterpret_cast<intptr_t>(m_Mapping.get_Base());
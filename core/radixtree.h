@@ -83,6 +83,7 @@ public:
 
 
 	virtual void OnDirty() {}
+	virtual void OnModified() { OnDirty(); } // structural change, as opposed to the hash cache update
 
 protected:
 	Node* get_Root() const;
@@ -141,6 +142,10 @@ public:
 
 	Leaf* Find(CursorBase& cu, const uint8_t* pKey, uint16_t nBits, bool& bCreate);
 
+	// Bulk load of the sorted keys. The key must be greater than all the existing ones, cu must point to the greatest element (ignored if the tree is empty).
+	// The split position is deduced from the previous key, there's no descent from the root.
+	Leaf* Append(CursorBase& cu, const uint8_t* pKey, uint16_t nBits);
+
 	void Delete(CursorBase& cu);
 
 	struct ITraveler
@@ -190,6 +195,9 @@ public:
 	void get_Hash(Merkle::Hash&);
 	void get_Proof(Merkle::Proof&, const CursorBase&);
 
+	// Same as RadixTree::Append, in addition calculates the hash of the subtree that won't be modified by the subsequent appends (while it's still in cache)
+	Leaf* Append(CursorBase& cu, const uint8_t* pKey, uint16_t nBits);
+
 protected:
 	// RadixTree
 	virtual Joint* CreateJoint() override { return new MyJoint; }
@@ -291,6 +299,9 @@ public:
 		return Cast::Up<MyLeaf>(RadixTree::Find(cu, key.V.m_pData, key.s_Bits, bCreate));
 	}
 
+	// Bulk load. The elements must come in ascending order of (key, ID). Equal keys are merged into the same leaf.
+	MyLeaf* Append(CursorBase& cu, const Key& key, TxoID);
+
 	~UtxoTree() { Clear(); }
 
 	void PushID(TxoID, MyLeaf&);
@@ -378,10 +389,26 @@ class UtxoTreeMapped
 			Joint,
 			Queue,
 			Node,
+			Journal,
 			count
 		};
 	};
 
+#pragma pack(push, 1)
+	struct JournalEntry
+	{
+		MappedFile::Offset m_Next; // older entry
+		Key m_Key;
+		TxoID m_ID;
+		uint8_t m_Add;
+	};
+#pragma pack(pop)
+
+	bool JournalRollback(MappedFile::Offset nStop);
+	void JournalReset();
+	void MarkModified(const Key&);
+	void MarkModified(const Node&);
+
 protected:
 
 	template <typename T>
@@ -406,6 +433,7 @@ protected:
 public:
 
 	virtual void OnDirty() override;
+	virtual void OnModified() override;
 
 	typedef Merkle::Hash Stamp;
 
@@ -413,18 +441,39 @@ public:
 
 	bool Open(const char* sz, const Stamp&);
 	bool IsOpen() const { return m_Mapping.get_Base() != nullptr; }
+	const MappedFile& get_Mapping() const { return m_Mapping; }
+	MappedFile& get_Mapping() { return m_Mapping; } // for the Copier. The journaled modifications are marked, others mark everything
 
 	void Close();
 	void FlushStrict(const Stamp&);
 
 	void EnsureReserve();
 
+	// Bulk load (see UtxoTree::Append), takes care of the reserve. The cursor is adjusted if the mapping moves.
+	MyLeaf* Append(CursorBase& cu, const Key& key, TxoID);
+
+	// Journal of the modifications since the last flush, kept within the image (newest first).
+	// After an unclean shutdown the image is rolled back to the committed state on Open, instead of being rebuilt.
+	// Modifications that are not enclosed in JournalBegin/JournalEnd (such as the initial build) invalidate the journal until the next flush.
+	void JournalBegin(); // call EnsureReserve() before
+	void JournalEnd(const Key&, TxoID, bool bAdd);
+	void JournalCancel(); // the operation didn't modify the tree
+	void JournalMarkCommit(const Stamp&); // call before the DB commit, which is followed by FlushStrict
+
+	uint64_t m_JournalRolledBack = 0; // num of modifications undone on Open
+
 #pragma pack(push, 1)
 	struct Hdr
 	{
 		MappedFile::Offset m_Root;
 		MappedFile::Offset m_Dirty; // boolean, just aligned
 		Stamp m_Stamp;
+
+		MappedFile::Offset m_Journal; // newest entry
+		MappedFile::Offset m_JournalValid; // boolean
+		MappedFile::Offset m_JournalOp; // boolean, modification in progress
+		MappedFile::Offset m_JournalCommitted; // newest entry of the pending commit
+		Stamp m_StampPending;
 	};
 #pragma pack(pop)
 
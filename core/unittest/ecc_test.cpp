@@ -22,6 +22,7 @@
 #include "../aes.h"
 #include "../proto.h"
 #include "../lelantus.h"
+#include "../compression.h"
 #include "../../utility/executor.h"
 
 #if defined(__clang__) || defined(__GNUC__) || defined(__GNUG__)
@@ -1560,6 +1561,331 @@ void TestBbs()
 	n = (uint32_t) buf.size();
 
 	verify_test(!beam::proto::Bbs::Decrypt(p, n, privateAddr));
+
+	// tagged
+	Scalar::Native privateAddr2;
+	beam::PeerID publicAddr2;
+	SetRandom(privateAddr2);
+	publicAddr2.FromSk(privateAddr2);
+
+	SetRandom(nonce);
+	verify_test(beam::proto::Bbs::Encrypt(buf, publicAddr2, nonce, szMsg, sizeof(szMsg), true));
+	verify_test(beam::proto::Bbs::Tag::IsPresent(&buf.front(), (uint32_t) buf.size()));
+	verify_test(beam::proto::Bbs::Tag::MaybeMatch(&buf.front(), (uint32_t) buf.size(), publicAddr2));
+
+	uint32_t nRejected = 0;
+	for (uint32_t i = 0; i < 10; i++)
+	{
+		SetRandom(privateAddr);
+		publicAddr.FromSk(privateAddr);
+		if (!beam::proto::Bbs::Tag::MaybeMatch(&buf.front(), (uint32_t) buf.size(), publicAddr))
+			nRejected++;
+	}
+	verify_test(nRejected >= 9); // false positive is possible, though unlikely
+
+	beam::ByteBuffer buf2 = buf;
+	p = &buf2.front();
+	n = (uint32_t) buf2.size();
+	verify_test(beam::proto::Bbs::Decrypt(p, n, privateAddr2, publicAddr2));
+	verify_test(n == sizeof(szMsg) + beam::proto::Bbs::Tag::s_TrailerSize); // the trailer is not stripped
+	verify_test(!memcmp(p, szMsg, sizeof(szMsg)));
+
+	// the older receivers see the tag as a part of the payload
+	beam::ByteBuffer bufOld(buf.begin(), buf.end() - 1);
+	bufOld.push_back(buf.back() ^ 1); // spoil the magic
+	verify_test(!beam::proto::Bbs::Tag::IsPresent(&bufOld.front(), (uint32_t) bufOld.size()));
+	p = &bufOld.front();
+	n = (uint32_t) bufOld.size();
+	verify_test(!beam::proto::Bbs::Decrypt(p, n, privateAddr2)); // MAC covers the trailer
+
+	// trial decryption
+	beam::proto::Bbs::TrialDecryptor td;
+	td.m_vKeys.resize(20);
+	for (uint32_t i = 0; i < td.m_vKeys.size(); i++)
+	{
+		beam::proto::Bbs::TrialDecryptor::Key& k = td.m_vKeys[i];
+		SetRandom(k.m_sk);
+		k.m_Pk.FromSk(k.m_sk);
+	}
+
+	const uint32_t iTrg = 13;
+
+	struct MyExec
+		:public beam::ExecutorMT
+	{
+		virtual uint32_t get_Threads() override { return 3; }
+
+		virtual void RunThread(uint32_t iThread) override
+		{
+			ExecutorMT::Context ctx;
+			ctx.m_iThread = iThread;
+			RunThreadCtx(ctx);
+		}
+	} ex;
+
+	for (uint32_t iCycle = 0; iCycle < 4; iCycle++)
+	{
+		bool bTag = !!(iCycle & 1);
+		std::unique_ptr<beam::Executor::Scope> pScope;
+		if (iCycle & 2)
+			pScope = std::make_unique<beam::Executor::Scope>(ex);
+
+		SetRandom(nonce);
+		verify_test(beam::proto::Bbs::Encrypt(buf, td.m_vKeys[iTrg].m_Pk, nonce, szMsg, sizeof(szMsg), bTag));
+
+		td.m_nPassed = 0;
+		td.m_TagFilter = bTag;
+		verify_test(td.Decrypt(buf, buf2) == iTrg);
+		verify_test(buf2.size() == sizeof(szMsg) + (bTag ? beam::proto::Bbs::Tag::s_TrailerSize : 0));
+		verify_test(!memcmp(&buf2.front(), szMsg, sizeof(szMsg)));
+
+
+		if (bTag)
+			verify_test(td.m_nPassed < 3);
+		else
+			verify_test(td.m_nPassed == td.m_vKeys.size());
+
+		// duplicated key: the lowest is returned, then the next one
+		td.m_vKeys[iTrg + 4] = td.m_vKeys[iTrg];
+		verify_test(td.Decrypt(buf, buf2) == iTrg);
+		verify_test(td.Decrypt(buf, buf2, iTrg + 1) == iTrg + 4);
+		verify_test(td.Decrypt(buf, buf2, iTrg + 5) == td.s_NotFound);
+
+		SetRandom(td.m_vKeys[iTrg + 4].m_sk);
+		td.m_vKeys[iTrg + 4].m_Pk.FromSk(td.m_vKeys[iTrg + 4].m_sk);
+
+		// replace the target key
+		SetRandom(td.m_vKeys[iTrg].m_sk);
+		td.m_vKeys[iTrg].m_Pk.FromSk(td.m_vKeys[iTrg].m_sk);
+		verify_test(td.Decrypt(buf, buf2) == td.s_NotFound);
+	}
+}
+
+void PrepareHdrPack(beam::proto::HdrPack& msg, uint32_t nCount)
+{
+	// roughly mimic the real headers: random hashes and PoW, steady timestamps and difficulty, many blocks without kernels
+	ZeroObject(msg.m_Prefix);
+	msg.m_Prefix.m_Height = 100500;
+	SetRandom(msg.m_Prefix.m_Prev);
+	msg.m_Prefix.m_ChainWork = 77777777U;
+
+	msg.m_vElements.resize(nCount);
+	for (uint32_t i = 0; i < nCount; i++)
+	{
+		beam::Block::SystemState::Sequence::Element& x = msg.m_vElements[i];
+		ZeroObject(x);
+
+		if (!(i % 4))
+			SetRandom(x.m_Kernels);
+		SetRandom(x.m_Definition);
+		x.m_TimeStamp = 1600000000 + i * 60;
+		GenerateRandom(&x.m_PoW.m_Indices.front(), static_cast<uint32_t>(x.m_PoW.m_Indices.size()));
+		SetRandom(x.m_PoW.m_Nonce);
+		x.m_PoW.m_Difficulty.m_Packed = 0x1234567;
+	}
+}
+
+void TestCompressionRoundtrip(const beam::ByteBuffer& buf)
+{
+	beam::ByteBuffer bufC, bufD;
+	beam::Compression::Compress(bufC, buf.empty() ? nullptr : &buf.front(), buf.size());
+	verify_test(!bufC.empty());
+
+	verify_test(beam::Compression::Decompress(bufD, &bufC.front(), bufC.size(), buf.size()));
+	verify_test(bufD == buf);
+
+	// wrong expected size
+	verify_test(!beam::Compression::Decompress(bufD, &bufC.front(), bufC.size(), buf.size() + 1));
+	if (!buf.empty())
+		verify_test(!beam::Compression::Decompress(bufD, &bufC.front(), bufC.size(), buf.size() - 1));
+
+	// truncated
+	verify_test(!beam::Compression::Decompress(bufD, &bufC.front(), bufC.size() - 1, buf.size()));
+
+	// corrupted. Must not crash, the result is irrelevant
+	for (uint32_t i = 0; i < 50; i++)
+	{
+		beam::ByteBuffer bufX = bufC;
+		bufX[rand() % bufX.size()] ^= static_cast<uint8_t>(1 + rand() % 0xff);
+		beam::Compression::Decompress(bufD, &bufX.front(), bufX.size(), buf.size());
+	}
+}
+
+void TestCompression()
+{
+	beam::ByteBuffer buf;
+	TestCompressionRoundtrip(buf);
+
+	buf.resize(3, 'x');
+	TestCompressionRoundtrip(buf);
+
+	// random, incompressible
+	buf.resize(100000);
+	GenerateRandom(&buf.front(), static_cast<uint32_t>(buf.size()));
+	TestCompressionRoundtrip(buf);
+
+	// highly repetitive, including long overlapping matches
+	for (size_t i = 0; i < buf.size(); i++)
+		buf[i] = static_cast<uint8_t>(i % 7);
+	TestCompressionRoundtrip(buf);
+
+	beam::ByteBuffer bufC;
+	beam::Compression::Compress(bufC, &buf.front(), buf.size());
+	verify_test(bufC.size() * 50 < buf.size());
+
+	// real msg
+	beam::proto::HdrPack msg;
+	PrepareHdrPack(msg, 200);
+
+	beam::Serializer ser;
+	ser & msg;
+	ser.swap_buf(buf);
+	TestCompressionRoundtrip(buf);
+
+	beam::Compression::Compress(bufC, &buf.front(), buf.size());
+	verify_test(bufC.size() < buf.size());
+}
+
+void TestBodyPackReader()
+{
+	beam::proto::BodyPack msg;
+	msg.m_Bodies.resize(5);
+
+	for (size_t i = 0; i < msg.m_Bodies.size(); i++)
+	{
+		beam::proto::BodyBuffers& bb = msg.m_Bodies[i];
+		bb.m_Perishable.resize(i * 300); // including empty, and with multi-byte size encoding
+		bb.m_Eternal.resize(i + 1);
+
+		if (!bb.m_Perishable.empty())
+			GenerateRandom(&bb.m_Perishable.front(), static_cast<uint32_t>(bb.m_Perishable.size()));
+		GenerateRandom(&bb.m_Eternal.front(), static_cast<uint32_t>(bb.m_Eternal.size()));
+	}
+
+	beam::Serializer ser;
+	ser & msg;
+
+	beam::ByteBuffer buf;
+	ser.swap_buf(buf);
+
+	beam::proto::BodyPackReader r;
+	r.Reset(&buf.front(), buf.size());
+	verify_test(r.m_Remaining == msg.m_Bodies.size());
+
+	beam::Blob bbP, bbE;
+	for (size_t i = 0; i < msg.m_Bodies.size(); i++)
+	{
+		verify_test(r.MoveNext(bbP, bbE));
+		verify_test(bbP == beam::Blob(msg.m_Bodies[i].m_Perishable));
+		verify_test(bbE == beam::Blob(msg.m_Bodies[i].m_Eternal));
+
+		// refers to the original buffer
+		verify_test((bbE.p >= &buf.front()) && (bbE.p < &buf.front() + buf.size()));
+	}
+
+	verify_test(!r.MoveNext(bbP, bbE));
+	r.TestEnd();
+
+	// truncated
+	r.Reset(&buf.front(), buf.size() - 1);
+
+	bool bThrown = false;
+	try {
+		while (r.MoveNext(bbP, bbE))
+			;
+	}
+	catch (const std::exception&) {
+		bThrown = true;
+	}
+	verify_test(bThrown);
+}
+
+void PrepareTxVectors(beam::ByteBuffer& buf, uint32_t nCount)
+{
+	beam::TxVectors::Full txv;
+
+	for (uint32_t i = 0; i < nCount; i++)
+	{
+		txv.m_vInputs.emplace_back(new beam::Input);
+		SetRandom(txv.m_vInputs.back()->m_Commitment.m_X);
+
+		txv.m_vOutputs.emplace_back(new beam::Output);
+		beam::Output& outp = *txv.m_vOutputs.back();
+		SetRandom(outp.m_Commitment.m_X);
+		outp.m_pConfidential.reset(new RangeProof::Confidential);
+		SetRandom(outp.m_pConfidential->m_Mu.m_Value);
+
+		beam::TxKernelStd* pKrn = new beam::TxKernelStd;
+		txv.m_vKernels.emplace_back(pKrn);
+		pKrn->m_Fee = i;
+		SetRandom(pKrn->m_Commitment.m_X);
+	}
+
+	beam::Serializer ser;
+	ser
+		& Cast::Down<beam::TxVectors::Perishable>(txv)
+		& Cast::Down<beam::TxVectors::Eternal>(txv);
+	ser.swap_buf(buf);
+}
+
+void DecodeTxVectors(beam::TxVectors::Full& txv, const beam::ByteBuffer& buf)
+{
+	beam::Deserializer der;
+	der.reset(buf);
+	der
+		& Cast::Down<beam::TxVectors::Perishable>(txv)
+		& Cast::Down<beam::TxVectors::Eternal>(txv);
+}
+
+void TestArena()
+{
+	beam::ByteBuffer buf;
+	PrepareTxVectors(buf, 50);
+
+	beam::TxVectors::Full txv0;
+	DecodeTxVectors(txv0, buf);
+
+	{
+		beam::Arena arena;
+		beam::TxVectors::Full txv;
+
+		{
+			beam::Arena::Scope scope(&arena);
+			DecodeTxVectors(txv, buf);
+
+			{
+				// suspended arena
+				beam::Arena::Scope scope2(nullptr);
+				size_t n0 = arena.get_Allocated();
+				beam::Input::Ptr pInp(new beam::Input);
+				verify_test(arena.get_Allocated() == n0);
+			}
+		}
+
+		verify_test(arena.get_Allocated() > buf.size());
+
+		// same contents
+		beam::Serializer ser;
+		ser
+			& Cast::Down<beam::TxVectors::Perishable>(txv)
+			& Cast::Down<beam::TxVectors::Eternal>(txv);
+
+		beam::ByteBuffer buf2;
+		ser.swap_buf(buf2);
+		verify_test(buf == buf2);
+
+		// mixing with heap-allocated elements is ok
+		txv.m_vInputs.pop_back();
+		txv.m_vInputs.push_back(std::move(txv0.m_vInputs.back()));
+		txv0.m_vInputs.pop_back();
+	}
+
+	// arena elements destroyed before the arena
+	beam::Arena arena;
+	beam::Arena::Scope scope(&arena);
+	beam::Output::Ptr pOutp(new beam::Output);
+	pOutp.reset();
+	verify_test(arena.get_Allocated() > 0);
 }
 
 void TestRatio(const beam::Difficulty& d0, const beam::Difficulty& d1, double k)
@@ -2152,6 +2478,9 @@ void TestAll()
 	TestAES();
 	TestKdf();
 	TestBbs();
+	TestCompression();
+	TestBodyPackReader();
+	TestArena();
 	TestDifficulty();
 	TestRandom();
 	TestFourCC();
@@ -2615,6 +2944,132 @@ void RunBenchmark()
 		} while (bm.ShouldContinue());
 	}
 
+	{
+		// sync bandwidth and CPU cost of the transport compression, for the max-size headers pack
+		beam::proto::HdrPack msg;
+		PrepareHdrPack(msg, beam::proto::g_HdrPackMaxSize);
+
+		beam::Serializer ser;
+		ser & msg;
+		beam::ByteBuffer buf, bufC, bufD;
+		ser.swap_buf(buf);
+
+		{
+			BenchmarkMeter bm("Compress.HdrPack");
+			bm.N = 10;
+			do
+			{
+				for (uint32_t i = 0; i < bm.N; i++)
+					beam::Compression::Compress(bufC, &buf.front(), buf.size());
+
+			} while (bm.ShouldContinue());
+		}
+
+		{
+			BenchmarkMeter bm("Decompress.HdrPack");
+			bm.N = 10;
+			do
+			{
+				for (uint32_t i = 0; i < bm.N; i++)
+					verify_test(beam::Compression::Decompress(bufD, &bufC.front(), bufC.size(), buf.size()));
+
+			} while (bm.ShouldContinue());
+		}
+
+		printf("%-24s: %u -> %u bytes (%.1f%%)\n", "Compress.HdrPack.Size", (uint32_t) buf.size(), (uint32_t) bufC.size(), 100. * bufC.size() / buf.size());
+
+		// incompressible data (such as rangeproofs) should be skipped fast
+		buf.resize(0x100000);
+		GenerateRandom(&buf.front(), static_cast<uint32_t>(buf.size()));
+
+		BenchmarkMeter bm("Compress.Random-1MB");
+		bm.N = 10;
+		do
+		{
+			for (uint32_t i = 0; i < bm.N; i++)
+				beam::Compression::Compress(bufC, &buf.front(), buf.size());
+
+		} while (bm.ShouldContinue());
+	}
+
+	{
+		// decode-plus-free of the tx elements, comparable to a big block
+		beam::ByteBuffer buf;
+		PrepareTxVectors(buf, 1000);
+
+		{
+			BenchmarkMeter bm("TxVectors.Decode.Heap");
+			bm.N = 10;
+			do
+			{
+				for (uint32_t i = 0; i < bm.N; i++)
+				{
+					beam::TxVectors::Full txv;
+					DecodeTxVectors(txv, buf);
+				}
+
+			} while (bm.ShouldContinue());
+		}
+
+		{
+			BenchmarkMeter bm("TxVectors.Decode.Arena");
+			bm.N = 10;
+			do
+			{
+				for (uint32_t i = 0; i < bm.N; i++)
+				{
+					beam::Arena arena;
+					beam::TxVectors::Full txv;
+
+					beam::Arena::Scope scope(&arena);
+					DecodeTxVectors(txv, buf);
+				}
+
+			} while (bm.ShouldContinue());
+		}
+	}
+
+	{
+		// wallet BBS processing, per incoming message, vs the number of own addresses on the channel
+		beam::proto::Bbs::TrialDecryptor td;
+		beam::ByteBuffer buf, buf2(300); // typical SetTxParameter size
+
+		Scalar::Native sk;
+		beam::PeerID pk;
+		SetRandom(sk);
+		pk.FromSk(sk);
+
+		for (uint32_t nKeys = 1; nKeys <= 256; nKeys <<= 4)
+		{
+			while (td.m_vKeys.size() < nKeys)
+			{
+				td.m_vKeys.emplace_back();
+				SetRandom(td.m_vKeys.back().m_sk);
+				td.m_vKeys.back().m_Pk.FromSk(td.m_vKeys.back().m_sk);
+			}
+
+			for (uint32_t iTag = 0; iTag < 2; iTag++)
+			{
+				Scalar::Native nonce;
+				SetRandom(nonce);
+				verify_test(beam::proto::Bbs::Encrypt(buf, pk, nonce, &buf2.front(), (uint32_t) buf2.size(), !!iTag)); // not for us
+
+				char sz[0x40];
+				sprintf(sz, "Bbs.Trial.%s.x%u", iTag ? "Tagged" : "Plain", nKeys);
+				td.m_TagFilter = !!iTag;
+
+				BenchmarkMeter bm(sz);
+				bm.N = 1;
+				do
+				{
+					for (uint32_t i = 0; i < bm.N; i++)
+						td.Decrypt(buf, buf2);
+
+				} while (bm.ShouldContinue());
+			}
+		}
+	}
+
 	{
 		uint8_t pBuf[0x400];
 
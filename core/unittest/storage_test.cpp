@@ -13,6 +13,8 @@
 // limitations under the License.
 
 #include <iostream>
+#include <chrono>
+#include <cstring>
 #include "../radixtree.h"
 #include "../navigator.h"
 #include "../../utility/serialize.h"
@@ -487,6 +489,497 @@ namespace beam
 		}
 	};
 
+	void UtxoMappedAdd(UtxoTreeMapped& t, const UtxoTree::Key& key, TxoID id, bool bJournal)
+	{
+		t.EnsureReserve();
+		if (bJournal)
+			t.JournalBegin();
+
+		UtxoTree::Cursor cu;
+		bool bCreate = true;
+		UtxoTree::MyLeaf* p = t.Find(cu, key, bCreate);
+
+		if (bCreate)
+			p->m_ID = id;
+		else
+		{
+			t.PushID(id, *p);
+			cu.InvalidateElement();
+		}
+		t.OnDirty();
+
+		if (bJournal)
+			t.JournalEnd(key, id, true);
+	}
+
+	void UtxoMappedDel(UtxoTreeMapped& t, const UtxoTree::Key& key)
+	{
+		t.EnsureReserve();
+		t.JournalBegin();
+
+		UtxoTree::Cursor cu;
+		bool bCreate = false;
+		UtxoTree::MyLeaf* p = t.Find(cu, key, bCreate);
+		verify_test(p);
+
+		TxoID id;
+		if (p->IsExt())
+		{
+			id = t.PopID(*p);
+			cu.InvalidateElement();
+			t.OnDirty();
+		}
+		else
+		{
+			id = p->m_ID;
+			t.Delete(cu);
+		}
+
+		t.JournalEnd(key, id, false);
+	}
+
+	void TestUtxoTreeMappedJournal(uint32_t nBase, bool bBench)
+	{
+#ifdef WIN32
+		const char* sz = "myutxo.bin";
+#else // WIN32
+		const char* sz = "/tmp/myutxo.bin";
+#endif // WIN32
+
+		DeleteFile(sz);
+
+		const uint32_t nBlocks = 40;
+		const uint32_t nPerBlock = nBase / nBlocks / 10; // each block spends nPerBlock base keys
+
+		std::vector<UtxoTree::Key> vKeys(nBase + nPerBlock * nBlocks);
+		for (uint32_t i = 0; i < vKeys.size(); i++)
+		{
+			UtxoTree::Key::Data d;
+			SetRandomUtxoKey(d);
+			vKeys[i] = d;
+		}
+
+		UtxoTreeMapped::Stamp s0, s1, sBad;
+		s0 = 1U;
+		s1 = 2U;
+		sBad = 3U;
+
+		Merkle::Hash hv0, hv1, hv;
+		TxoID idNext = 0;
+
+		// spends one base key, adds 2 new ones, one of them duplicated
+		auto fnBlock = [&](UtxoTreeMapped& t, uint32_t iBlock)
+		{
+			for (uint32_t i = 0; i < nPerBlock; i++)
+			{
+				uint32_t iKey = nBase + iBlock * nPerBlock + i;
+				UtxoMappedDel(t, vKeys[iBlock * nPerBlock + i]);
+				UtxoMappedAdd(t, vKeys[iKey], idNext++, true);
+				UtxoMappedAdd(t, vKeys[iKey / 2], idNext++, true);
+			}
+		};
+
+		auto t0 = std::chrono::steady_clock::now();
+
+		{
+			// initial build, not journaled
+			UtxoTreeMapped t;
+			verify_test(!t.Open(sz, s0));
+
+			for (uint32_t i = 0; i < nBase; i++)
+				UtxoMappedAdd(t, vKeys[i], idNext++, false);
+
+			t.get_Hash(hv0);
+			t.FlushStrict(s0);
+		}
+
+		auto t1 = std::chrono::steady_clock::now();
+
+		{
+			UtxoTreeMapped t;
+			verify_test(t.Open(sz, s0));
+
+			for (uint32_t i = 0; i < nBlocks / 2; i++)
+				fnBlock(t, i);
+
+			t.get_Hash(hv1);
+			t.JournalMarkCommit(s1);
+			// the DB is committed, but the image isn't flushed
+
+			for (uint32_t i = nBlocks / 2; i < nBlocks; i++)
+				fnBlock(t, i);
+
+			t.Close(); // unclean shutdown
+		}
+
+		auto t2 = std::chrono::steady_clock::now();
+
+		{
+			// rolled back to the pending commit
+			UtxoTreeMapped t;
+			verify_test(t.Open(sz, s1));
+			verify_test(t.m_JournalRolledBack == nPerBlock * 3 * (nBlocks - nBlocks / 2));
+
+			t.get_Hash(hv);
+			verify_test(hv == hv1);
+
+			// the uncommitted modifications are rolled back completely
+			fnBlock(t, nBlocks - 1);
+			t.Close();
+		}
+
+		auto t3 = std::chrono::steady_clock::now();
+
+		if (bBench)
+			printf("UtxoTreeMapped: build of %u = %u ms, rollback of %u modifications = %u ms\n",
+				nBase,
+				(uint32_t) std::chrono::duration_cast<std::chrono::milliseconds>(t1 - t0).count(),
+				nPerBlock * 3 * (nBlocks - nBlocks / 2),
+				(uint32_t) std::chrono::duration_cast<std::chrono::milliseconds>(t3 - t2).count());
+
+		{
+			UtxoTreeMapped t;
+			verify_test(t.Open(sz, s1));
+			verify_test(t.m_JournalRolledBack == nPerBlock * 3);
+
+			t.get_Hash(hv);
+			verify_test(hv == hv1);
+
+			// interrupted modification
+			t.EnsureReserve();
+			t.JournalBegin();
+			t.OnDirty();
+			t.Close();
+		}
+
+		{
+			UtxoTreeMapped t;
+			verify_test(!t.Open(sz, s1)); // must be rebuilt
+		}
+
+		{
+			// not journaled modification
+			UtxoTreeMapped t;
+			verify_test(!t.Open(sz, s0));
+			for (uint32_t i = 0; i < 10; i++)
+				UtxoMappedAdd(t, vKeys[i], i, false);
+			t.FlushStrict(s0);
+
+			UtxoMappedAdd(t, vKeys[10], 10, false);
+			t.Close();
+
+			verify_test(!t.Open(sz, s0));
+		}
+
+		{
+			// stamp mismatch
+			UtxoTreeMapped t;
+			verify_test(!t.Open(sz, s0));
+			UtxoMappedAdd(t, vKeys[0], 0, false);
+			t.FlushStrict(s0);
+			UtxoMappedAdd(t, vKeys[1], 1, true);
+			t.Close();
+
+			verify_test(!t.Open(sz, sBad));
+		}
+
+		DeleteFile(sz);
+	}
+
+	void TestUtxoTreeBulk(uint32_t nElems, bool bBench)
+	{
+		struct Element
+		{
+			UtxoTree::Key m_Key;
+			TxoID m_ID;
+
+			bool operator < (const Element& x) const
+			{
+				int n = m_Key.V.cmp(x.m_Key.V);
+				return (n < 0) || (!n && (m_ID < x.m_ID));
+			}
+		};
+
+		std::vector<Element> vElems(nElems);
+		for (uint32_t i = 0; i < vElems.size(); i++)
+		{
+			Element& x = vElems[i];
+			x.m_ID = i;
+
+			if (i % 7)
+			{
+				UtxoTree::Key::Data d;
+				SetRandomUtxoKey(d);
+				x.m_Key = d;
+			}
+			else
+				x.m_Key = vElems[i / 2].m_Key; // duplicated
+		}
+
+		Merkle::Hash hv0, hv1, hv2;
+
+		auto t0 = std::chrono::steady_clock::now();
+
+		UtxoTree t0Tree;
+		for (uint32_t i = 0; i < vElems.size(); i++)
+		{
+			UtxoTree::Cursor cu;
+			bool bCreate = true;
+			UtxoTree::MyLeaf* p = t0Tree.Find(cu, vElems[i].m_Key, bCreate);
+
+			if (bCreate)
+				p->m_ID = vElems[i].m_ID;
+			else
+				t0Tree.PushID(vElems[i].m_ID, *p);
+		}
+		t0Tree.get_Hash(hv0);
+
+		auto t1 = std::chrono::steady_clock::now();
+
+		std::sort(vElems.begin(), vElems.end());
+
+		UtxoTree t1Tree;
+		UtxoTree::Cursor cu;
+		for (uint32_t i = 0; i < vElems.size(); i++)
+			t1Tree.Append(cu, vElems[i].m_Key, vElems[i].m_ID);
+		t1Tree.get_Hash(hv1);
+
+		auto t2 = std::chrono::steady_clock::now();
+
+		verify_test(hv0 == hv1);
+		verify_test(t0Tree.Count() == t1Tree.Count());
+
+		if (bBench)
+			printf("UtxoTree: build of %u, random order = %u ms, bulk = %u ms\n",
+				(uint32_t) vElems.size(),
+				(uint32_t) std::chrono::duration_cast<std::chrono::milliseconds>(t1 - t0).count(),
+				(uint32_t) std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1).count());
+
+		// the same order of the IDs
+		for (uint32_t i = 0; i < vElems.size(); i += 7)
+		{
+			UtxoTree::Cursor cu0, cu1;
+			bool bCreate = false;
+			UtxoTree::MyLeaf* p0 = t0Tree.Find(cu0, vElems[i].m_Key, bCreate);
+			UtxoTree::MyLeaf* p1 = t1Tree.Find(cu1, vElems[i].m_Key, bCreate);
+			verify_test(p0 && p1);
+
+			verify_test(p0->IsExt() == p1->IsExt());
+			if (p0->IsExt())
+			{
+				verify_test(p0->get_Count() == p1->get_Count());
+				auto pN1 = p1->m_pIDs.get_Strict()->m_pTop.get_Strict();
+				for (auto pN0 = p0->m_pIDs.get_Strict()->m_pTop.get_Strict(); pN0; pN0 = pN0->m_pNext.get(), pN1 = pN1->m_pNext.get())
+					verify_test(pN0->m_ID == pN1->m_ID);
+			}
+			else
+				verify_test(p0->m_ID == p1->m_ID);
+		}
+
+		// the result is a regular tree
+		for (uint32_t i = 0; i < vElems.size(); i += 5)
+		{
+			UtxoTree::Cursor cu0, cu1;
+			bool bCreate = false;
+			UtxoTree::MyLeaf* p0 = t0Tree.Find(cu0, vElems[i].m_Key, bCreate);
+			UtxoTree::MyLeaf* p1 = t1Tree.Find(cu1, vElems[i].m_Key, bCreate);
+			verify_test(!p0 == !p1);
+
+			if (p0)
+			{
+				t0Tree.Delete(cu0);
+				t1Tree.Delete(cu1);
+			}
+		}
+
+		t0Tree.get_Hash(hv0);
+		t1Tree.get_Hash(hv2);
+		verify_test(hv0 == hv2);
+
+		// mapped
+#ifdef WIN32
+		const char* sz = "myutxo.bin";
+#else // WIN32
+		const char* sz = "/tmp/myutxo.bin";
+#endif // WIN32
+
+		DeleteFile(sz);
+		{
+			UtxoTreeMapped::Stamp s0 = 1U;
+			UtxoTreeMapped t;
+			verify_test(!t.Open(sz, s0));
+
+			auto t3 = std::chrono::steady_clock::now();
+
+			UtxoTree::Cursor cu2;
+			for (uint32_t i = 0; i < vElems.size(); i++)
+				t.Append(cu2, vElems[i].m_Key, vElems[i].m_ID);
+
+			t.get_Hash(hv2);
+			t.FlushStrict(s0);
+
+			if (bBench)
+				printf("UtxoTreeMapped: bulk build of %u = %u ms\n",
+					(uint32_t) vElems.size(),
+					(uint32_t) std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - t3).count());
+		}
+		DeleteFile(sz);
+
+		verify_test(hv2 == hv1);
+	}
+
+	bool ReadWholeFile(const char* sz, ByteBuffer& buf)
+	{
+		std::FStream f;
+		if (!f.Open(sz, true))
+			return false;
+
+		buf.resize(static_cast<size_t>(f.get_Remaining()));
+		if (!buf.empty())
+			f.read(&buf.front(), buf.size());
+		return true;
+	}
+
+	void TestUtxoTreeMappedCopy()
+	{
+#ifdef WIN32
+		const char* sz = "myutxo.bin";
+		const char* szCopy = "myutxo-copy.bin";
+#else // WIN32
+		const char* sz = "/tmp/myutxo.bin";
+		const char* szCopy = "/tmp/myutxo-copy.bin";
+#endif // WIN32
+
+		DeleteFile(sz);
+		DeleteFile(szCopy);
+
+		const uint32_t nMaxWrite = 32;
+
+		UtxoTreeMapped::Stamp s;
+		s = 1U;
+		TxoID idNext = 0;
+		Merkle::Hash hv0, hv1;
+
+		UtxoTreeMapped t;
+		verify_test(!t.Open(sz, s));
+
+		std::vector<UtxoTree::Key> vKeys; // with duplicates
+
+		// mixed modifications, all of them must be tracked for the copy
+		auto fnBlock = [&](uint32_t nCount)
+		{
+			for (uint32_t i = 0; i < nCount; i++)
+			{
+				uint32_t nOp = vKeys.empty() ? 0 : (rand() % 4);
+				if (nOp < 2)
+				{
+					UtxoTree::Key::Data d;
+					SetRandomUtxoKey(d);
+					vKeys.emplace_back();
+					vKeys.back() = d;
+				}
+				else
+				{
+					size_t iKey = rand() % vKeys.size();
+					if (2 == nOp)
+						vKeys.push_back(vKeys[iKey]); // duplicate
+					else
+					{
+						UtxoMappedDel(t, vKeys[iKey]);
+						vKeys[iKey] = vKeys.back();
+						vKeys.pop_back();
+						continue;
+					}
+				}
+
+				UtxoMappedAdd(t, vKeys.back(), idNext++, true);
+			}
+
+			t.get_Hash(hv0); // modifies the image as well, must precede the commit
+
+			s.Inc();
+			t.FlushStrict(s);
+		};
+
+		// the copy of the consistent image must open as-is
+		auto fnVerify = [&]()
+		{
+			ByteBuffer buf0, buf1;
+			verify_test(ReadWholeFile(sz, buf0) && ReadWholeFile(szCopy, buf1));
+			verify_test(buf0 == buf1);
+
+			UtxoTreeMapped t1;
+			verify_test(t1.Open(szCopy, s));
+			t1.get_Hash(hv1);
+			verify_test(hv0 == hv1);
+			verify_test(t1.Count() == t.Count());
+		};
+
+		fnBlock(50000);
+
+		MappedFile::Copier cp;
+		cp.Open(szCopy, t.get_Mapping());
+
+		// modified between the steps
+		for (uint32_t i = 0; i < 30; i++)
+		{
+			fnBlock(500);
+			verify_test(!cp.Step(nMaxWrite, false));
+		}
+
+		uint32_t nSteps = 0;
+		for (; !cp.Step(nMaxWrite, true); nSteps++)
+			if (nSteps == 1000)
+				break;
+
+		verify_test(nSteps < 1000);
+		fnVerify();
+
+		// too many modifications, the final pass must fail and resume
+		fnBlock(5000);
+		verify_test(!cp.Step(nMaxWrite, true));
+
+		for (nSteps = 0; !cp.Step(nMaxWrite, true); nSteps++)
+			if (nSteps == 1000)
+				break;
+
+		verify_test(nSteps < 1000);
+		fnVerify();
+
+		// few modifications are finalized at once
+		for (uint32_t i = 0; i < 20; i++)
+		{
+			fnBlock(1);
+			verify_test(cp.Step(nMaxWrite, true));
+			fnVerify();
+		}
+
+		// not journaled, everything is copied again
+		UtxoTree::Key::Data d;
+		SetRandomUtxoKey(d);
+		vKeys.emplace_back();
+		vKeys.back() = d;
+		UtxoMappedAdd(t, vKeys.back(), idNext++, false);
+		t.get_Hash(hv0);
+		s.Inc();
+		t.FlushStrict(s);
+
+		verify_test(!cp.Step(nMaxWrite, true));
+		for (nSteps = 0; !cp.Step(nMaxWrite, true); nSteps++)
+			if (nSteps == 1000)
+				break;
+
+		verify_test(nSteps < 1000);
+		fnVerify();
+
+		cp.Close();
+		verify_test(!t.get_Mapping().IsTrackingModified());
+		t.Close();
+
+		DeleteFile(sz);
+		DeleteFile(szCopy);
+	}
+
 	void TestMmr()
 	{
 		std::vector<Merkle::Hash> vHashes;
@@ -671,11 +1164,21 @@ namespace beam
 
 } // namespace beam
 
-int main()
+int main(int argc, char* argv[])
 {
 	beam::TestNavigator();
 	beam::TestUtxoTree();
+	beam::TestUtxoTreeMappedJournal(8000, false);
+	beam::TestUtxoTreeBulk(5000, false);
+	beam::TestUtxoTreeMappedCopy();
 	beam::TestMmr();
 
+	// timings of the large trees, not a part of the default run: storage_test --bench
+	if ((argc > 1) && !strcmp(argv[1], "--bench"))
+	{
+		beam::TestUtxoTreeMappedJournal(200000, true);
+		beam::TestUtxoTreeBulk(200000, true);
+	}
+
 	return g_TestsFailed ? -1 : 0;
 }
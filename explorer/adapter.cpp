@@ -20,13 +20,21 @@
 #include "nlohmann/json.hpp"
 #include "utility/helpers.h"
 #include "utility/logger.h"
+#include "utility/io/asyncevent.h"
+#include "utility/io/timer.h"
+#include <list>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 
 namespace beam { namespace explorer {
 
 namespace {
 
 static const size_t PACKER_FRAGMENTS_SIZE = 4096;
-static const size_t CACHE_DEPTH = 100000;
+static const size_t CACHE_SIZE_LIMIT = 64 * 1024 * 1024; // bytes of rendered /block responses
+static const Height PRERENDER_MAX_BLOCKS = 16; // max num of the newest blocks rendered in background on each state change
+static const Height INDEX_MAX_BLOCKS = 50; // max num of blocks indexed at once, the rest is indexed in the following reactor iterations
 
 const char* hash_to_hex(char* buf, const Merkle::Hash& hash) {
     return to_hex(buf, hash.m_pData, hash.nBytes);
@@ -47,63 +55,247 @@ const char* difficulty_to_hex(char* buf, const Difficulty& d) {
     return uint256_to_hex(buf, raw);
 }
 
+// LRU cache of rendered /block responses, limited by the total size
 struct ResponseCache {
     io::SharedBuffer status;
-    std::map<Height, io::SharedBuffer> blocks;
     Height currentHeight=0;
 
-    explicit ResponseCache(size_t depth) : _depth(depth)
+    explicit ResponseCache(size_t sizeLimit) : _sizeLimit(sizeLimit)
     {}
 
-    void compact() {
-        if (blocks.empty() || currentHeight <= _depth) return;
-        Height horizon = currentHeight - _depth;
-        if (blocks.rbegin()->first < horizon) {
-            blocks.clear();
-            return;
-        }
-        auto b = blocks.begin();
-        auto it = b;
-        while (it != blocks.end()) {
-            if (it->first >= horizon) break;
-            ++it;
-        }
-        blocks.erase(b, it);
-    }
-
     bool get_block(io::SerializedMsg& out, Height h) {
-        const auto& it = blocks.find(h);
-        if (it == blocks.end()) return false;
-        out.push_back(it->second);
+        const auto& it = _blocks.find(h);
+        if (it == _blocks.end()) return false;
+        _lru.splice(_lru.begin(), _lru, it->second.lru);
+        out.push_back(it->second.body);
         return true;
     }
 
+    bool has_block(Height h) const {
+        return _blocks.find(h) != _blocks.end();
+    }
+
     void put_block(Height h, const io::SharedBuffer& body) {
-        if (currentHeight - h > _depth) return;
-        compact();
-        blocks[h] = body;
+        if (body.size > _sizeLimit) return;
+
+        const auto& it = _blocks.find(h);
+        if (it != _blocks.end()) erase(it);
+
+        _lru.push_front(h);
+        _blocks[h] = Entry{ body, _lru.begin() };
+        _size += body.size;
+
+        while (_size > _sizeLimit) {
+            erase(_blocks.find(_lru.back()));
+        }
+    }
+
+    void erase_from(Height h) {
+        for (auto it = _blocks.lower_bound(h); it != _blocks.end(); ) {
+            erase(it++);
+        }
     }
 
 private:
-    size_t _depth;
+    struct Entry {
+        io::SharedBuffer body;
+        std::list<Height>::iterator lru;
+    };
+
+    using Blocks = std::map<Height, Entry>;
+
+    void erase(Blocks::iterator it) {
+        _size -= it->second.body.size;
+        _lru.erase(it->second.lru);
+        _blocks.erase(it);
+    }
+
+    Blocks _blocks;
+    std::list<Height> _lru; // the most recently used is at the front
+    size_t _size = 0;
+    size_t _sizeLimit;
 };
 
 using nlohmann::json;
 
+struct BlockData {
+    Block::SystemState::Full state;
+    Block::SystemState::ID id;
+    Block::Body block;
+};
+
+/// Builds /block response. Doesn't access the node, may be called from any thread
+void render_block(json& out, const BlockData& d) {
+    const Height height = d.id.m_Height;
+    char buf[80];
+
+    json inputs = json::array();
+    for (const auto &v : d.block.m_vInputs) {
+        inputs.push_back(
+        json{
+            {"commitment", uint256_to_hex(buf, v->m_Commitment.m_X)},
+            {"maturity",   v->m_Internal.m_Maturity}
+        }
+        );
+    }
+
+    json outputs = json::array();
+    for (const auto &v : d.block.m_vOutputs) {
+        outputs.push_back(
+        json{
+            {"commitment", uint256_to_hex(buf, v->m_Commitment.m_X)},
+            {"maturity",   v->get_MinMaturity(height)},
+            {"coinbase",   v->m_Coinbase},
+            {"incubation", v->m_Incubation}
+        }
+        );
+    }
+
+    json kernels = json::array();
+    for (const auto &v : d.block.m_vKernels) {
+
+		TxStats s;
+		v->AddStats(s);
+
+		ECC::Point::Native exc;
+		v->IsValid(height, exc);
+
+		ECC::Point comm(exc);
+
+        kernels.push_back(
+            json{
+                {"id", hash_to_hex(buf, v->m_Internal.m_ID)},
+                {"excess", uint256_to_hex(buf, comm.m_X)},
+                {"minHeight", v->m_Height.m_Min},
+                {"maxHeight", v->m_Height.m_Max},
+                {"fee", AmountBig::get_Lo(s.m_Fee)}
+            }
+        );
+    }
+
+    out = json{
+        {"found",      true},
+        {"timestamp",  d.state.m_TimeStamp},
+        {"height",     d.state.m_Height},
+        {"hash",       hash_to_hex(buf, d.id.m_Hash)},
+        {"prev",       hash_to_hex(buf, d.state.m_Prev)},
+        {"difficulty", d.state.m_PoW.m_Difficulty.ToFloat()},
+        {"chainwork",  uint256_to_hex(buf, d.state.m_ChainWork)},
+        {"subsidy",    Rules::get_Emission(d.state.m_Height)},
+        {"inputs",     inputs},
+        {"outputs",    outputs},
+        {"kernels",    kernels}
+    };
+
+    LOG_DEBUG() << out;
+}
+
+using RenderHook = std::function<void(uint64_t)>;
+
+/// Renders new blocks in background, so that they're in the cache before the crawlers ask for them.
+/// Block data is extracted from the node DB by the caller (the DB is single-threaded), json building and serialization is done here
+class Prerenderer {
+public:
+    struct Task {
+        BlockData data;
+        uint64_t generation;
+    };
+
+    struct Result {
+        Height height;
+        uint64_t generation;
+        io::SharedBuffer body;
+    };
+
+    Prerenderer(io::AsyncEvent::Trigger&& onResults, const RenderHook& onRender) :
+        _onResults(std::move(onResults)),
+        _onRender(onRender),
+        _stop(false),
+        _thread(&Prerenderer::run, this)
+    {}
+
+    ~Prerenderer() {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stop = true;
+        }
+        _cond.notify_one();
+        _thread.join();
+    }
+
+    void push(std::unique_ptr<Task>&& task) {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _tasks.push_back(std::move(task));
+        }
+        _cond.notify_one();
+    }
+
+    void take_results(std::vector<Result>& out) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        out.swap(_results);
+    }
+
+private:
+    void run() {
+        HttpMsgCreator packer(PACKER_FRAGMENTS_SIZE);
+        io::SerializedMsg sm;
+
+        while (true) {
+            std::unique_ptr<Task> task;
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _cond.wait(lock, [this]() { return _stop || !_tasks.empty(); });
+                if (_stop) break;
+                task = std::move(_tasks.front());
+                _tasks.pop_front();
+            }
+
+            json j;
+            render_block(j, task->data);
+
+            sm.clear();
+            if (!serialize_json_msg(sm, packer, j)) continue;
+
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _results.push_back(Result{ task->data.id.m_Height, task->generation, io::normalize(sm, false) });
+            }
+            _onResults();
+
+            // after the result is posted, so that it reaches the cache even if the reactor is stopped from the hook
+            if (_onRender) _onRender(task->data.id.m_Height);
+        }
+    }
+
+    io::AsyncEvent::Trigger _onResults;
+    RenderHook _onRender;
+    std::mutex _mutex;
+    std::condition_variable _cond;
+    std::list<std::unique_ptr<Task>> _tasks;
+    std::vector<Result> _results;
+    bool _stop;
+    std::thread _thread;
+};
+
 } //namespace
 
 /// Explorer server backend, gets callback on status update and returns json messages for server
 class Adapter : public Node::IObserver, public IAdapter {
 public:
-    Adapter(Node& node) :
+    Adapter(Node& node, RenderHook&& onRender) :
         _packer(PACKER_FRAGMENTS_SIZE),
 		_node(node),
         _nodeBackend(node.get_Processor()),
         _statusDirty(true),
         _nodeIsSyncing(true),
-        _cache(CACHE_DEPTH)
+        _cache(CACHE_SIZE_LIMIT),
+        _onRender(std::move(onRender))
     {
         init_helper_fragments();
+        _prerenderedEvent = io::AsyncEvent::create(io::Reactor::get_Current(), BIND_THIS_MEMFN(on_prerendered));
+        _prerenderer = std::make_unique<Prerenderer>(_prerenderedEvent->get_trigger(), _onRender);
+        _indexTimer = io::Timer::create(io::Reactor::get_Current());
         _hook = &node.m_Cfg.m_Observer;
         _nextHook = *_hook;
         *_hook = this;
@@ -145,18 +337,249 @@ private:
         const auto& cursor = _nodeBackend.m_Cursor;
         _cache.currentHeight = cursor.m_Sid.m_Height;
         _statusDirty = true;
+        update_indexes();
+        prerender_new_blocks();
         if (_nextHook) _nextHook->OnStateChanged();
     }
 
     void OnRolledBack(const Block::SystemState::ID& id) override {
 
-        auto& blocks = _cache.blocks;
+        _cache.erase_from(id.m_Height);
+
+        // results of pending tasks may belong to the reverted branch
+        _prerenderGeneration++;
+        _prerenderedHeight = std::min(_prerenderedHeight, id.m_Height);
 
-        blocks.erase(blocks.lower_bound(id.m_Height), blocks.end());
+        if (_indexesReady && (_indexedHeight > id.m_Height)) {
+            NodeDB& db = _nodeBackend.get_DB();
+            db.ExplorerIndexesDelFrom(id.m_Height + 1);
+            _indexedHeight = id.m_Height;
+            save_indexed_state(id);
+        }
+        // the lower bounds are kept: the unavailable blocks, if any, are not the reverted ones
 
         if (_nextHook) _nextHook->OnRolledBack(id);
     }
 
+    void prerender_new_blocks() {
+        const Node::SyncStatus& s = _node.m_SyncStatus;
+        if (s.m_Done != s.m_Total) return;
+
+        Height hTop = _nodeBackend.m_Cursor.m_Sid.m_Height;
+        Height h = std::max(_prerenderedHeight + 1, Rules::HeightGenesis);
+        if (hTop >= PRERENDER_MAX_BLOCKS) {
+            h = std::max(h, hTop - PRERENDER_MAX_BLOCKS + 1);
+        }
+
+        for (; h <= hTop; ++h) {
+            if (_cache.has_block(h)) continue;
+
+            uint64_t row = 0;
+            auto task = std::make_unique<Prerenderer::Task>();
+            if (!extract_row(h, row, 0) || !extract_block_data(task->data, row)) break;
+
+            task->generation = _prerenderGeneration;
+            _prerenderer->push(std::move(task));
+        }
+
+        // if stopped early - retry from there on the next state change
+        _prerenderedHeight = h - 1;
+    }
+
+    void on_prerendered() {
+        std::vector<Prerenderer::Result> results;
+        _prerenderer->take_results(results);
+
+        for (auto& r : results) {
+            if ((r.generation == _prerenderGeneration) && (r.height <= _cache.currentHeight)) {
+                _cache.put_block(r.height, r.body);
+            }
+        }
+    }
+
+    void save_indexed_state(const Block::SystemState::ID& id) {
+        NodeDB& db = _nodeBackend.get_DB();
+        Blob blobHash(id.m_Hash);
+        db.ParamSet(NodeDB::ParamID::ExplorerIndexed, &id.m_Height, &blobHash);
+        db.ParamIntSet(NodeDB::ParamID::ExplorerTxoLow, _txoIndexedLow);
+        db.ParamIntSet(NodeDB::ParamID::ExplorerAssetsLow, _assetsIndexedLow);
+    }
+
+    void init_indexes() {
+        NodeDB& db = _nodeBackend.get_DB();
+        db.ExplorerIndexesCreate();
+
+        Block::SystemState::ID id;
+        Blob blobHash(id.m_Hash);
+        if (!db.ParamGet(NodeDB::ParamID::ExplorerIndexed, &id.m_Height, &blobHash) || (id.m_Height < Rules::HeightGenesis)) {
+            _indexedHeight = 0;
+        } else {
+            // make sure the index corresponds to the current branch (the node could run without the explorer)
+            uint64_t row = 0;
+            bool ok = (id.m_Height <= _nodeBackend.m_Cursor.m_Sid.m_Height) && extract_row(id.m_Height, row, 0);
+            if (ok) {
+                Merkle::Hash hv;
+                db.get_StateHash(row, hv);
+                ok = (hv == id.m_Hash);
+            }
+
+            if (ok) {
+                _indexedHeight = id.m_Height;
+                _txoIndexedLow = db.ParamIntGetDef(NodeDB::ParamID::ExplorerTxoLow, Rules::HeightGenesis);
+                _assetsIndexedLow = db.ParamIntGetDef(NodeDB::ParamID::ExplorerAssetsLow, Rules::HeightGenesis);
+            } else {
+                LOG_WARNING() << "Explorer indexes belong to a different branch, rebuilding";
+                db.ExplorerIndexesDelFrom(0);
+                _indexedHeight = 0;
+            }
+        }
+
+        _indexesReady = true;
+    }
+
+    struct AssetKrnWalker : public TxKernel::IWalker {
+        NodeDB& _db;
+        Height _height;
+        bool _allocKnown; // all the previous asset events are indexed, the ID of the created asset can be deduced
+
+        AssetKrnWalker(NodeDB& db, Height h, bool allocKnown) : _db(db), _height(h), _allocKnown(allocKnown) {}
+
+        bool OnKrn(const TxKernel& krn) override {
+            switch (krn.get_Subtype()) {
+                case TxKernel::Subtype::AssetCreate: {
+                    // The ID is assigned by the node at this height, the current asset with this owner (if any) may be a different one
+                    const auto& v = Cast::Up<TxKernelAssetCreate>(krn);
+                    if (_allocKnown) {
+                        _db.ExpAssetAdd(_db.ExpAssetFindMinFree(), _height, NodeDB::ExpAssetEvent::Create, 0, v.m_Internal.m_ID);
+                    }
+                    break;
+                }
+                case TxKernel::Subtype::AssetEmit: {
+                    const auto& v = Cast::Up<TxKernelAssetEmit>(krn);
+                    _db.ExpAssetAdd(v.m_AssetID, _height, NodeDB::ExpAssetEvent::Emit, v.m_Value, v.m_Internal.m_ID);
+                    break;
+                }
+                case TxKernel::Subtype::AssetDestroy: {
+                    const auto& v = Cast::Up<TxKernelAssetDestroy>(krn);
+                    _db.ExpAssetAdd(v.m_AssetID, _height, NodeDB::ExpAssetEvent::Destroy, 0, v.m_Internal.m_ID);
+                    break;
+                }
+                default:
+                    break;
+            }
+            return true;
+        }
+    };
+
+    void index_block(const NodeDB::StateID& sid) {
+        NodeDB& db = _nodeBackend.get_DB();
+        const Height h = sid.m_Height;
+
+        Block::Body block;
+        bool ok = true;
+        try {
+            ok = _nodeBackend.ExtractBlockWithExtra(block, sid);
+        } catch (...) {
+            ok = false;
+        }
+
+        TxVectors::Eternal txve;
+        const std::vector<TxKernel::Ptr>* pKernels = &block.m_vKernels;
+
+        if (ok) {
+            for (const auto& v : block.m_vInputs) {
+                db.ExpTxoAdd(v->m_Commitment.m_X, h, true);
+            }
+            for (const auto& v : block.m_vOutputs) {
+                db.ExpTxoAdd(v->m_Commitment.m_X, h, false);
+            }
+        } else {
+            // the commitment index is incomplete below, lookups won't report a missing commitment as not found
+            if ((_txoIndexedLow != h) || (Rules::HeightGenesis == h)) {
+                LOG_WARNING() << "Explorer: block " << h << " is not available, commitments are indexed above it";
+            }
+            _txoIndexedLow = h + 1;
+
+            // the kernels are kept by the node for all the blocks
+            try {
+                ByteBuffer bbE;
+                db.GetStateBlock(sid.m_Row, nullptr, &bbE, nullptr);
+                ok = !bbE.empty();
+                if (ok) {
+                    Deserializer der;
+                    der.reset(bbE);
+                    der & txve;
+                    pKernels = &txve.m_vKernels;
+                }
+            } catch (...) {
+                ok = false;
+            }
+
+            if (!ok) {
+                LOG_WARNING() << "Explorer: kernels of block " << h << " are not available, assets are indexed above it";
+                _assetsIndexedLow = h + 1;
+                return;
+            }
+        }
+
+        AssetKrnWalker wlk(db, h, _assetsIndexedLow <= Rules::HeightGenesis);
+        wlk.Process(*pKernels);
+    }
+
+    /// Indexes the blocks added since the last call, at most INDEX_MAX_BLOCKS at once. If more remain - continues on the timer,
+    /// so that the catch-up doesn't stall the node. Goes in the same DB transaction as the blocks themselves
+    void update_indexes() {
+        if (!_indexesReady) {
+            init_indexes();
+        }
+
+        const auto& cursor = _nodeBackend.m_Cursor;
+        if (_indexedHeight >= cursor.m_Sid.m_Height) return;
+
+        Height h0 = std::max(_indexedHeight + 1, Rules::HeightGenesis);
+        Height hEnd = std::min(cursor.m_Sid.m_Height, h0 + INDEX_MAX_BLOCKS - 1);
+
+        NodeDB::StateID sid;
+        sid.m_Row = 0;
+        for (sid.m_Height = h0; sid.m_Height <= hEnd; sid.m_Height++) {
+            if (!extract_row(sid.m_Height, sid.m_Row, 0)) break;
+            index_block(sid);
+        }
+
+        if (sid.m_Height == h0) return; // no progress
+
+        _indexedHeight = sid.m_Height - 1;
+        save_indexed_state((cursor.m_Sid.m_Height == _indexedHeight) ? cursor.m_ID : get_state_id(sid.m_Row));
+
+        if (_indexedHeight < cursor.m_Sid.m_Height) {
+            _indexTimer->start(0, false, BIND_THIS_MEMFN(update_indexes));
+        }
+    }
+
+    /// Adds the index state to a lookup response. Returns false if the index can't answer yet
+    bool get_index_status(json& j, Height hLow) {
+        const Height hTip = _nodeBackend.m_Cursor.m_Sid.m_Height;
+        if (!_indexesReady || (_indexedHeight < hTip)) {
+            j["error"] = "index not ready";
+            j["indexed"] = _indexedHeight;
+            j["height"] = hTip;
+            return false;
+        }
+
+        if (hLow > Rules::HeightGenesis) {
+            j["indexed_from"] = hLow; // the history may be incomplete
+        }
+        return true;
+    }
+
+    Block::SystemState::ID get_state_id(uint64_t row) {
+        Block::SystemState::Full s;
+        _nodeBackend.get_DB().get_State(row, s);
+        Block::SystemState::ID id;
+        s.get_ID(id);
+        return id;
+    }
+
     bool get_status(io::SerializedMsg& out) override {
         if (_statusDirty) {
             const auto& cursor = _nodeBackend.m_Cursor;
@@ -175,7 +598,12 @@ private:
                     { "low_horizon", _nodeBackend.m_Extra.m_TxoHi },
                     { "hash", hash_to_hex(buf, cursor.m_ID.m_Hash) },
                     { "chainwork",  uint256_to_hex(buf, cursor.m_Full.m_ChainWork) },
-                    { "peers_count", _node.get_AcessiblePeerCount() }
+                    { "peers_count", _node.get_AcessiblePeerCount() },
+                    { "filters_fp_rate", json{
+                        { "utxos", _nodeBackend.m_Filters.m_Utxos.get_FalsePositiveRate() },
+                        { "kernels", _nodeBackend.m_Filters.m_Kernels.get_FalsePositiveRate() },
+                        { "unique", _nodeBackend.m_Filters.m_Unique.get_FalsePositiveRate() }
+                    }}
                 }
             )) {
                 return false;
@@ -211,92 +639,30 @@ private:
         return true;
     }
 
-    bool extract_block_from_row(json& out, uint64_t row, Height height) {
+    bool extract_block_data(BlockData& d, uint64_t row) {
         NodeDB& db = _nodeBackend.get_DB();
 
-        Block::SystemState::Full blockState;
-		Block::SystemState::ID id;
-		Block::Body block;
-		bool ok = true;
-
         try {
-            db.get_State(row, blockState);
-			blockState.get_ID(id);
+            db.get_State(row, d.state);
+			d.state.get_ID(d.id);
 
 			NodeDB::StateID sid;
 			sid.m_Row = row;
-			sid.m_Height = id.m_Height;
-			_nodeBackend.ExtractBlockWithExtra(block, sid);
+			sid.m_Height = d.id.m_Height;
+			_nodeBackend.ExtractBlockWithExtra(d.block, sid);
 
 		} catch (...) {
-            ok = false;
+            return false;
         }
+        return true;
+    }
 
-
-        if (ok) {
-            char buf[80];
-
-            json inputs = json::array();
-            for (const auto &v : block.m_vInputs) {
-                inputs.push_back(
-                json{
-                    {"commitment", uint256_to_hex(buf, v->m_Commitment.m_X)},
-                    {"maturity",   v->m_Internal.m_Maturity}
-                }
-                );
-            }
-
-            json outputs = json::array();
-            for (const auto &v : block.m_vOutputs) {
-                outputs.push_back(
-                json{
-                    {"commitment", uint256_to_hex(buf, v->m_Commitment.m_X)},
-                    {"maturity",   v->get_MinMaturity(height)},
-                    {"coinbase",   v->m_Coinbase},
-                    {"incubation", v->m_Incubation}
-                }
-                );
-            }
-
-            json kernels = json::array();
-            for (const auto &v : block.m_vKernels) {
-
-				TxStats s;
-				v->AddStats(s);
-
-				ECC::Point::Native exc;
-				v->IsValid(height, exc);
-
-				ECC::Point comm(exc);
-
-                kernels.push_back(
-                    json{
-                        {"id", hash_to_hex(buf, v->m_Internal.m_ID)},
-                        {"excess", uint256_to_hex(buf, comm.m_X)},
-                        {"minHeight", v->m_Height.m_Min},
-                        {"maxHeight", v->m_Height.m_Max},
-                        {"fee", AmountBig::get_Lo(s.m_Fee)}
-                    }
-                );
-            }
-
-            out = json{
-                {"found",      true},
-                {"timestamp",  blockState.m_TimeStamp},
-                {"height",     blockState.m_Height},
-                {"hash",       hash_to_hex(buf, id.m_Hash)},
-                {"prev",       hash_to_hex(buf, blockState.m_Prev)},
-                {"difficulty", blockState.m_PoW.m_Difficulty.ToFloat()},
-                {"chainwork",  uint256_to_hex(buf, blockState.m_ChainWork)},
-                {"subsidy",    Rules::get_Emission(blockState.m_Height)},
-                {"inputs",     inputs},
-                {"outputs",    outputs},
-                {"kernels",    kernels}
-            };
-
-            LOG_DEBUG() << out;
-        }
-        return ok;
+    bool extract_block_from_row(json& out, uint64_t row) {
+        BlockData d;
+        if (!extract_block_data(d, row)) return false;
+        render_block(out, d);
+        if (_onRender) _onRender(d.id.m_Height);
+        return true;
     }
 
     bool extract_block(json& out, Height height, uint64_t& row, uint64_t* prevRow) {
@@ -309,7 +675,7 @@ private:
                 *prevRow = 0;
             }
         }
-        return ok && extract_block_from_row(out, row, height);
+        return ok && extract_block_from_row(out, row);
     }
 
     bool get_block_impl(io::SerializedMsg& out, uint64_t height, uint64_t& row, uint64_t* prevRow) {
@@ -424,6 +790,80 @@ private:
         return true;
     }
 
+    bool get_kernel(io::SerializedMsg& out, const ByteBuffer& id) override {
+        Height h = _nodeBackend.get_DB().FindKernel(id);
+        bool found = (h >= Rules::HeightGenesis);
+
+        char buf[80];
+        json j{ { "found", found }, { "id", to_hex(buf, id.data(), std::min(id.size(), sizeof(buf) / 2 - 1)) } };
+        if (found) {
+            j["height"] = h;
+        }
+        return serialize_json_msg(out, _packer, j);
+    }
+
+    bool get_commitment(io::SerializedMsg& out, const ByteBuffer& commitmentX) override {
+        if (commitmentX.size() > ECC::uintBig::nBytes) return false;
+
+        // leading zeroes may be omitted
+        ECC::uintBig x(Zero);
+        std::copy(commitmentX.begin(), commitmentX.end(), x.m_pData + x.nBytes - commitmentX.size());
+
+        char buf[80];
+        json j{ { "commitment", uint256_to_hex(buf, x) } };
+        if (!get_index_status(j, _txoIndexedLow)) {
+            return serialize_json_msg(out, _packer, j);
+        }
+
+        json history = json::array();
+        NodeDB::WalkerExpTxo wlk;
+        for (_nodeBackend.get_DB().ExpTxoFind(wlk, x); wlk.MoveNext(); ) {
+            history.push_back(json{
+                { "height", wlk.m_Height },
+                { "spent", wlk.m_Spent }
+            });
+        }
+
+        set_lookup_result(j, history, _txoIndexedLow);
+        return serialize_json_msg(out, _packer, j);
+    }
+
+    void set_lookup_result(json& j, json& history, Height hLow) {
+        if (history.empty() && (hLow > Rules::HeightGenesis)) {
+            j["error"] = "index incomplete"; // not a proof of absence
+        } else {
+            j["found"] = !history.empty();
+            j["history"] = std::move(history);
+        }
+    }
+
+    bool get_asset(io::SerializedMsg& out, uint64_t id) override {
+        json j{ { "id", id } };
+        if (!get_index_status(j, _assetsIndexedLow)) {
+            return serialize_json_msg(out, _packer, j);
+        }
+
+        static const char* eventNames[] = { "create", "emit", "destroy" };
+
+        char buf[80];
+        json history = json::array();
+        NodeDB::WalkerExpAsset wlk;
+        for (_nodeBackend.get_DB().ExpAssetFind(wlk, static_cast<Asset::ID>(id)); wlk.MoveNext(); ) {
+            json e{
+                { "height", wlk.m_Height },
+                { "event", (wlk.m_Event < _countof(eventNames)) ? eventNames[wlk.m_Event] : "" },
+                { "kernel", hash_to_hex(buf, wlk.m_KernelID) }
+            };
+            if (NodeDB::ExpAssetEvent::Emit == wlk.m_Event) {
+                e["value"] = wlk.m_Value;
+            }
+            history.push_back(e);
+        }
+
+        set_lookup_result(j, history, _assetsIndexedLow);
+        return serialize_json_msg(out, _packer, j);
+    }
+
     HttpMsgCreator _packer;
 
     // node db interface
@@ -444,12 +884,29 @@ private:
     Node::IObserver* _nextHook;
 
     ResponseCache _cache;
+    RenderHook _onRender;
+
+    io::AsyncEvent::Ptr _prerenderedEvent;
+    std::unique_ptr<Prerenderer> _prerenderer;
+    uint64_t _prerenderGeneration = 0;
+    Height _prerenderedHeight = 0;
+
+    // secondary indexes are initialized on the first state change, when the node DB is already open
+    bool _indexesReady = false;
+    Height _indexedHeight = 0;
+    Height _txoIndexedLow = Rules::HeightGenesis; // the indexes are complete in [low, _indexedHeight]
+    Height _assetsIndexedLow = Rules::HeightGenesis;
+    io::Timer::Ptr _indexTimer;
 
     io::SerializedMsg _sm;
 };
 
 IAdapter::Ptr create_adapter(Node& node) {
-    return IAdapter::Ptr(new Adapter(node));
+    return IAdapter::Ptr(new Adapter(node, RenderHook()));
+}
+
+IAdapter::Ptr create_adapter_with_render_hook(Node& node, RenderHook&& onRender) {
+    return IAdapter::Ptr(new Adapter(node, std::move(onRender)));
 }
 
 }} //namespaces
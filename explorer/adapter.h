@@ -14,6 +14,7 @@
 
 #include "utility/io/buffer.h"
 #include "utility/common.h"
+#include <functional>
 
 namespace beam {
 
@@ -39,8 +40,20 @@ struct IAdapter {
     virtual bool get_blocks(io::SerializedMsg& out, uint64_t startHeight, uint64_t n) = 0;
 
     virtual bool get_peers(io::SerializedMsg& out) = 0;
+
+    /// Height of the kernel, from the node's kernel index
+    virtual bool get_kernel(io::SerializedMsg& out, const ByteBuffer& id) = 0;
+
+    /// Heights where the output commitment (its X coordinate) was created and spent
+    virtual bool get_commitment(io::SerializedMsg& out, const ByteBuffer& commitmentX) = 0;
+
+    /// Asset create/emit/destroy history
+    virtual bool get_asset(io::SerializedMsg& out, uint64_t id) = 0;
 };
 
 IAdapter::Ptr create_adapter(Node& node);
 
+/// For tests only! onRender is called with the height of each rendered /block response, also from the background pre-rendering thread
+IAdapter::Ptr create_adapter_with_render_hook(Node& node, std::function<void(uint64_t)>&& onRender);
+
 }} //namespaces
@@ -31,7 +31,7 @@ static const unsigned SERVER_RESTART_INTERVAL = 1000;
 static const unsigned ACL_REFRESH_INTERVAL = 5555;
 
 enum Dirs {
-    DIR_STATUS, DIR_BLOCK, DIR_BLOCKS, DIR_PEERS
+    DIR_STATUS, DIR_BLOCK, DIR_BLOCKS, DIR_PEERS, DIR_KERNEL, DIR_COMMITMENT, DIR_ASSET
     // etc
 };
 
@@ -57,13 +57,17 @@ void Server::start_server() {
             _bindAddress,
             BIND_THIS_MEMFN(on_stream_accepted)
         );
-        LOG_INFO() << STS << "listens to " << _bindAddress;
+        LOG_INFO() << STS << "listens to " << _server->address();
     } catch (const std::exception& e) {
         LOG_ERROR() << STS << "cannot start server: " << e.what() << " restarting in  " << SERVER_RESTART_INTERVAL << " msec";
         _timers.set_timer(SERVER_RESTART_TIMER, SERVER_RESTART_INTERVAL, BIND_THIS_MEMFN(start_server));
     }
 }
 
+io::Address Server::get_address() const {
+    return _server ? _server->address() : io::Address();
+}
+
 void Server::refresh_acl() {
     _acl.refresh();
     _timers.set_timer(ACL_REFRESH_TIMER, ACL_REFRESH_INTERVAL, BIND_THIS_MEMFN(refresh_acl));
@@ -112,7 +116,8 @@ bool Server::on_request(uint64_t id, const HttpMsgReader::Message& msg) {
     const std::string& path = msg.msg->get_path();
 
     static const std::map<std::string_view, int> dirs {
-        { "status", DIR_STATUS }, { "block", DIR_BLOCK }, { "blocks", DIR_BLOCKS }, { "peers", DIR_PEERS}
+        { "status", DIR_STATUS }, { "block", DIR_BLOCK }, { "blocks", DIR_BLOCKS }, { "peers", DIR_PEERS},
+        { "kernel", DIR_KERNEL }, { "commitment", DIR_COMMITMENT }, { "asset", DIR_ASSET }
     };
 
     const HttpConnection::Ptr& conn = it->second;
@@ -133,23 +138,34 @@ bool Server::on_request(uint64_t id, const HttpMsgReader::Message& msg) {
             case DIR_PEERS:
                 func = &Server::send_peers;
                 break;
+            case DIR_KERNEL:
+                func = &Server::send_kernel;
+                break;
+            case DIR_COMMITMENT:
+                func = &Server::send_commitment;
+                break;
+            case DIR_ASSET:
+                func = &Server::send_asset;
+                break;
             default:
                 break;
         }
     }
 
     bool keepalive = false;
+    _keepalive = msg.msg->is_keep_alive();
 
     if (func) {
         //bool validKey = _acl.check(_currentUrl.args["m"], _currentUrl.args["n"], _currentUrl.args["h"]);
         bool validKey = _acl.check(conn->peer_address());
         if (!validKey) {
+            _keepalive = false;
             send(conn, 403, "Forbidden");
         } else {
             keepalive = (this->*func)(conn);
         }
     } else {
-        send(conn, 404, "Not Found");
+        keepalive = send(conn, 404, "Not Found");
     }
 
     if (!keepalive) {
@@ -215,27 +231,71 @@ bool Server::send_peers(const HttpConnection::Ptr& conn) {
     return send(conn, 200, "OK");
 }
 
+bool Server::send_kernel(const HttpConnection::Ptr& conn) {
+    ByteBuffer id;
+    if (!_currentUrl.get_hex_arg("id", id)) {
+        return send(conn, 400, "Bad request");
+    }
+    if (!_backend.get_kernel(_body, id)) {
+        return send(conn, 500, "Internal error #4");
+    }
+    return send(conn, 200, "OK");
+}
+
+bool Server::send_commitment(const HttpConnection::Ptr& conn) {
+    ByteBuffer commitment;
+    if (!_currentUrl.get_hex_arg("id", commitment)) {
+        return send(conn, 400, "Bad request");
+    }
+    if (!_backend.get_commitment(_body, commitment)) {
+        return send(conn, 500, "Internal error #4");
+    }
+    return send(conn, 200, "OK");
+}
+
+bool Server::send_asset(const HttpConnection::Ptr& conn) {
+    auto id = _currentUrl.get_int_arg("id", -1);
+    if (id < 0) {
+        return send(conn, 400, "Bad request");
+    }
+    if (!_backend.get_asset(_body, id)) {
+        return send(conn, 500, "Internal error #4");
+    }
+    return send(conn, 200, "OK");
+}
+
 bool Server::send(const HttpConnection::Ptr& conn, int code, const char* message) {
     assert(conn);
 
     size_t bodySize = 0;
     for (const auto& f : _body) { bodySize += f.size; }
 
+    // Persistent connections need explicit length even if there's no body. Error responses don't break
+    // the connection, so that the pipelined requests that follow are served
+    HeaderPair headers[1];
+    size_t nHeaders = 0;
+    if (!_keepalive) {
+        headers[nHeaders++] = HeaderPair("Connection", "close");
+    } else if (!bodySize) {
+        headers[nHeaders++] = HeaderPair("Content-Length", 0UL);
+    }
+
     bool ok = _msgCreator.create_response(
         _headers,
         code,
         message,
-        0, //headers,
-        0, //sizeof(headers) / sizeof(HeaderPair),
+        headers,
+        nHeaders,
         1,
         "application/json",
         bodySize
     );
 
     if (ok) {
-        auto result = conn->write_msg(_headers);
+        // flushed by the connection once all the requests read so far are processed
+        auto result = conn->write_msg(_headers, false);
         if (result && bodySize > 0) {
-            result = conn->write_msg(_body);
+            result = conn->write_msg(_body, false);
         }
         if (!result) ok = false;
     } else {
@@ -244,7 +304,7 @@ bool Server::send(const HttpConnection::Ptr& conn, int code, const char* message
 
     _headers.clear();
     _body.clear();
-    return (ok && code == 200);
+    return (ok && _keepalive);
 }
 
 Server::IPAccessControl::IPAccessControl(const std::string &ipsFileName) :
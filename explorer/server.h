@@ -28,6 +28,9 @@ class Server {
 public:
     Server(IAdapter& adapter, io::Reactor& reactor, io::Address bindAddress, const std::string& keysFileName, const std::vector<uint32_t>& whitelist);
 
+    /// Actual listening address (with the port resolved if bound to port 0), empty until the server started
+    io::Address get_address() const;
+
 private:
     class IPAccessControl {
     public:
@@ -53,6 +56,9 @@ private:
     bool send_block(const HttpConnection::Ptr& conn);
     bool send_blocks(const HttpConnection::Ptr& conn);
     bool send_peers(const HttpConnection::Ptr& conn);
+    bool send_kernel(const HttpConnection::Ptr& conn);
+    bool send_commitment(const HttpConnection::Ptr& conn);
+    bool send_asset(const HttpConnection::Ptr& conn);
     bool send(const HttpConnection::Ptr& conn, int code, const char* message);
 
     HttpMsgCreator _msgCreator;
@@ -65,6 +71,7 @@ private:
     HttpUrl _currentUrl;
     io::SerializedMsg _headers;
     io::SerializedMsg _body;
+    bool _keepalive = false; // requested by the current request
     //AccessControl _acl;
     IPAccessControl _acl;
     std::vector<uint32_t> _whitelist;
@@ -0,0 +1,320 @@
+// Copyright 2018 The Beam Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "explorer/adapter.h"
+#include "explorer/server.h"
+#include "http/http_msg_creator.h"
+#include "utility/io/timer.h"
+#include "utility/logger.h"
+#include <chrono>
+#include <cstring>
+
+using namespace beam;
+
+namespace {
+
+static const Height NUM_BLOCKS = 100;
+static const size_t BLOCK_BODY_SIZE = 2000;
+
+int g_TestsFailed = 0;
+
+void TestFailed(const char* szExpr, uint32_t nLine)
+{
+    printf("Test failed! Line=%u, Expression: %s\n", nLine, szExpr);
+    g_TestsFailed++;
+}
+
+#define verify_test(x) \
+    do { \
+        if (!(x)) \
+            TestFailed(#x, __LINE__); \
+    } while (false)
+
+/// Serves pre-rendered blocks, like the real adapter does from its cache
+struct DummyAdapter : explorer::IAdapter {
+    std::vector<io::SharedBuffer> blocks;
+
+    DummyAdapter() {
+        for (Height h = 1; h <= NUM_BLOCKS; h++) {
+            std::string s = "{\"found\":true,\"height\":" + std::to_string(h) + ",\"pad\":\"";
+            s.append(BLOCK_BODY_SIZE - s.size() - 2, 'x');
+            s += "\"}";
+            blocks.emplace_back(s.data(), s.size());
+        }
+    }
+
+    bool get_status(io::SerializedMsg& out) override { return false; }
+
+    bool get_block(io::SerializedMsg& out, uint64_t height) override {
+        if (height < 1 || height > NUM_BLOCKS) return false;
+        out.push_back(blocks[height - 1]);
+        return true;
+    }
+
+    bool get_block_by_hash(io::SerializedMsg& out, const ByteBuffer& hash) override { return false; }
+    bool get_block_by_kernel(io::SerializedMsg& out, const ByteBuffer& key) override { return false; }
+    bool get_blocks(io::SerializedMsg& out, uint64_t startHeight, uint64_t n) override { return false; }
+    bool get_peers(io::SerializedMsg& out) override { return false; }
+    bool get_kernel(io::SerializedMsg& out, const ByteBuffer& id) override { return false; }
+    bool get_commitment(io::SerializedMsg& out, const ByteBuffer& commitmentX) override { return false; }
+    bool get_asset(io::SerializedMsg& out, uint64_t id) override { return false; }
+};
+
+Height get_height(const HttpMessage& msg) {
+    size_t size = 0;
+    const char* body = (const char*)msg.get_body(size);
+    std::string s(body ? body : "", size);
+    size_t pos = s.find("\"height\":");
+    if (pos == std::string::npos) return 0;
+    return std::stoull(s.substr(pos + 9));
+}
+
+/// Many persistent connections, each keeps up to depth requests in flight
+class BenchClient {
+public:
+    BenchClient(io::Reactor& reactor, io::Address serverAddress, unsigned nConnections, unsigned depth, unsigned nRequests) :
+        _reactor(reactor),
+        _serverAddress(serverAddress),
+        _msgCreator(1000),
+        _conns(nConnections),
+        _depth(depth),
+        _nRequests(nRequests)
+    {}
+
+    void start() {
+        for (unsigned i = 0; (i < 64) && (i < _conns.size()); i++) {
+            connect_next();
+        }
+    }
+
+    double get_elapsed_s() const { return _elapsed_s; }
+    uint64_t get_total() const { return _total; }
+
+private:
+    struct Conn {
+        HttpConnection::Ptr conn;
+        unsigned sent = 0;
+        unsigned received = 0;
+    };
+
+    void connect_next() {
+        if (_nextConnect >= _conns.size()) return;
+        uint64_t tag = _nextConnect++;
+        if (!_reactor.tcp_connect(_serverAddress, tag, BIND_THIS_MEMFN(on_connected), 10000)) {
+            verify_test(!"connect");
+            _reactor.stop();
+        }
+    }
+
+    void on_connected(uint64_t tag, io::TcpStream::Ptr&& newStream, io::ErrorCode errorCode) {
+        if (errorCode) {
+            verify_test(!"connected");
+            _reactor.stop();
+            return;
+        }
+
+        _conns[tag].conn = std::make_unique<HttpConnection>(
+            tag,
+            BaseConnection::outbound,
+            BIND_THIS_MEMFN(on_response),
+            10000,
+            1024,
+            std::move(newStream)
+        );
+
+        if (++_nConnected < _conns.size()) {
+            connect_next();
+            return;
+        }
+
+        // all connected, go
+        _t0 = std::chrono::steady_clock::now();
+        for (uint64_t i = 0; i < _conns.size(); i++) {
+            for (unsigned j = 0; j < _depth; j++) {
+                send_request(i, j + 1 == _depth);
+            }
+        }
+    }
+
+    static Height expected_height(uint64_t iConn, unsigned iReq) {
+        return (iConn + iReq) % NUM_BLOCKS + 1;
+    }
+
+    void send_request(uint64_t iConn, bool flush) {
+        Conn& c = _conns[iConn];
+        if (c.sent >= _nRequests) return;
+
+        std::string path = "/block?height=" + std::to_string(expected_height(iConn, c.sent++));
+        static const HeaderPair headers[] = {
+            {"Host", "localhost" }
+        };
+        if (_msgCreator.create_request(_serialized, "GET", path.c_str(), headers, 1)) {
+            c.conn->write_msg(_serialized, flush);
+        }
+        _serialized.clear();
+    }
+
+    bool on_response(uint64_t id, const HttpMsgReader::Message& msg) {
+        if (msg.what != HttpMsgReader::http_message || !msg.msg) {
+            verify_test(!"response");
+            _reactor.stop();
+            return false;
+        }
+
+        Conn& c = _conns[id];
+        verify_test(msg.msg->get_status() == 200);
+        verify_test(get_height(*msg.msg) == expected_height(id, c.received)); // responses come in order
+
+        c.received++;
+        _total++;
+
+        // flushed by the connection after the read
+        send_request(id, false);
+
+        if (_total == uint64_t(_conns.size()) * _nRequests) {
+            _elapsed_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - _t0).count();
+            _reactor.stop();
+        }
+        return true;
+    }
+
+    io::Reactor& _reactor;
+    io::Address _serverAddress;
+    HttpMsgCreator _msgCreator;
+    io::SerializedMsg _serialized;
+    std::vector<Conn> _conns;
+    unsigned _depth;
+    unsigned _nRequests;
+    uint64_t _nextConnect = 0;
+    size_t _nConnected = 0;
+    uint64_t _total = 0;
+    std::chrono::steady_clock::time_point _t0;
+    double _elapsed_s = 0;
+};
+
+/// Sends several requests in a single write, checks the responses order and the connection close
+class PipelineClient {
+public:
+    explicit PipelineClient(io::Reactor& reactor) : _reactor(reactor) {}
+
+    void start(io::Address serverAddress) {
+        if (!serverAddress.port() || !_reactor.tcp_connect(serverAddress, 1, BIND_THIS_MEMFN(on_connected), 10000)) {
+            verify_test(!"connect");
+            _reactor.stop();
+        }
+    }
+
+    std::vector<int> statuses;
+    std::vector<Height> heights;
+    bool closed = false;
+
+private:
+    void on_connected(uint64_t, io::TcpStream::Ptr&& newStream, io::ErrorCode errorCode) {
+        if (errorCode) {
+            verify_test(!"connected");
+            _reactor.stop();
+            return;
+        }
+
+        _conn = std::make_unique<HttpConnection>(1, BaseConnection::outbound, BIND_THIS_MEMFN(on_response), 10000, 1024, std::move(newStream));
+
+        static const char requests[] =
+            "GET /block?height=5 HTTP/1.1\r\nHost: x\r\n\r\n"
+            "GET /nonexistent HTTP/1.1\r\nHost: x\r\n\r\n"
+            "GET /block?height=7 HTTP/1.1\r\nHost: x\r\n\r\n"
+            "GET /block?height=8 HTTP/1.1\r\nHost: x\r\nConnection: close\r\n\r\n"
+            "GET /block?height=9 HTTP/1.1\r\nHost: x\r\n\r\n"; // must be ignored
+
+        _conn->write_msg(io::SharedBuffer(requests, sizeof(requests) - 1));
+    }
+
+    bool on_response(uint64_t, const HttpMsgReader::Message& msg) {
+        if (msg.what == HttpMsgReader::http_message && msg.msg) {
+            statuses.push_back(msg.msg->get_status());
+            heights.push_back(get_height(*msg.msg));
+            return true;
+        }
+
+        closed = (msg.what == HttpMsgReader::connection_error) && (msg.connectionError == io::EC_EOF);
+        _conn.reset();
+        _reactor.stop();
+        return false;
+    }
+
+    io::Reactor& _reactor;
+    HttpConnection::Ptr _conn;
+};
+
+void test_pipelining() {
+    io::Reactor::Ptr reactor = io::Reactor::create();
+    io::Reactor::Scope scope(*reactor);
+
+    DummyAdapter adapter;
+    explorer::Server server(adapter, *reactor, io::Address::localhost(), "", {}); // any free port
+
+    PipelineClient client(*reactor);
+    io::Timer::Ptr startTimer = io::Timer::create(*reactor);
+    startTimer->start(100, false, [&client, &server]() { client.start(server.get_address()); });
+
+    reactor->run();
+
+    verify_test(client.statuses == std::vector<int>({ 200, 404, 200, 200 }));
+    verify_test(client.heights == std::vector<Height>({ 5, 0, 7, 8 }));
+    verify_test(client.closed);
+}
+
+void bench(unsigned nConnections, unsigned depth, unsigned nRequests) {
+    io::Reactor::Ptr reactor = io::Reactor::create();
+    io::Reactor::Scope scope(*reactor);
+
+    DummyAdapter adapter;
+    explorer::Server server(adapter, *reactor, io::Address::localhost(), "", {}); // any free port
+
+    std::unique_ptr<BenchClient> client;
+    io::Timer::Ptr startTimer = io::Timer::create(*reactor);
+    startTimer->start(100, false, [&]() {
+        client = std::make_unique<BenchClient>(*reactor, server.get_address(), nConnections, depth, nRequests);
+        client->start();
+    });
+
+    io::Timer::Ptr timeout = io::Timer::create(*reactor);
+    timeout->start(120000, false, [&reactor]() {
+        verify_test(!"timeout");
+        reactor->stop();
+    });
+
+    reactor->run();
+
+    verify_test(client && (client->get_total() == uint64_t(nConnections) * nRequests));
+    if (client && (client->get_elapsed_s() > 0)) {
+        LOG_INFO() << "/block: " << nConnections << " connections, pipeline depth " << depth << ": "
+            << uint64_t(client->get_total() / client->get_elapsed_s()) << " requests/sec";
+    }
+}
+
+} //namespace
+
+int main(int argc, char* argv[]) {
+    auto logger = Logger::create(LOG_LEVEL_INFO, LOG_LEVEL_INFO);
+
+    test_pipelining();
+
+    // load benchmark, not a part of the default run: server_test --bench
+    if ((argc > 1) && !strcmp(argv[1], "--bench")) {
+        bench(1000, 1, 20);
+        bench(1000, 8, 40);
+    }
+
+    return g_TestsFailed ? -1 : 0;
+}
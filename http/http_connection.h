@@ -42,8 +42,16 @@ public:
         )
     {
         _stream->enable_read(
-            [this](io::ErrorCode what, void* data, size_t size) -> bool
-            { return _msgReader.new_data_from_stream(what, data, size); }
+            [this](io::ErrorCode what, void* data, size_t size) -> bool {
+                if (!_msgReader.new_data_from_stream(what, data, size)) {
+                    // the object may be deleted here
+                    return false;
+                }
+                // Responses to all the (pipelined) requests of this chunk may be written with flush=false,
+                // they go to the socket at once. Write errors are reported via the read callback
+                _stream->write(io::SerializedMsg(), true);
+                return true;
+            }
         );
     }
 
@@ -31,6 +31,15 @@ bool serialize_json_msg(io::SerializedMsg& out, HttpMsgCreator& packer, const js
     return result;
 }
 
+bool serialize_json_msg(io::SerializedMsg& out, HttpMsgCreator& packer, const JsonStreamFunc& func) {
+    size_t initialFragments = out.size();
+    io::FragmentWriter& fw = packer.acquire_writer(out);
+    bool result = serialize_json_msg(fw, func);
+    packer.release_writer();
+    if (!result) out.resize(initialFragments);
+    return result;
+}
+
 } //namespace
 
 
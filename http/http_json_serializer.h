@@ -15,6 +15,7 @@
 #pragma once
 #include "nlohmann/json_fwd.hpp"
 #include "utility/io/buffer.h"
+#include "utility/io/json_serializer.h"
 
 namespace beam {
 
@@ -23,5 +24,8 @@ class HttpMsgCreator;
 // appends json msg to out by http packer
 bool serialize_json_msg(io::SerializedMsg& out, HttpMsgCreator& packer, const nlohmann::json& o);
 
+// appends json msg produced by func to out by http packer
+bool serialize_json_msg(io::SerializedMsg& out, HttpMsgCreator& packer, const JsonStreamFunc& func);
+
 } //namespace
 
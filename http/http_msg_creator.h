@@ -14,7 +14,7 @@
 
 #pragma once
 #include "utility/io/fragment_writer.h"
-#include "nlohmann/json_fwd.hpp"
+#include "utility/io/json_serializer.h"
 
 namespace beam {
 
@@ -86,4 +86,7 @@ private:
 // appends json msg to out by http packer
 bool serialize_json_msg(io::SerializedMsg& out, HttpMsgCreator& packer, const nlohmann::json& o);
 
+// appends json msg produced by func to out by http packer
+bool serialize_json_msg(io::SerializedMsg& out, HttpMsgCreator& packer, const JsonStreamFunc& func);
+
 } //namespace
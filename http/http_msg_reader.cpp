@@ -122,6 +122,15 @@ bool HttpUrl::has_arg(const std::string_view& name) const
     return args.find(name) != args.end();
 }
 
+bool HttpMessage::is_keep_alive() const {
+    std::string connection = get_header("connection");
+    std::transform(connection.begin(), connection.end(), connection.begin(), [](char c)->char { return (char)tolower(c);} );
+    if (get_http_minor_version() >= 1) {
+        return connection != "close";
+    }
+    return connection == "keep-alive";
+}
+
 std::string HttpMsgReader::Message::error_str() const {
     switch (what) {
         case HttpMsgReader::connection_error:
@@ -305,6 +314,10 @@ private:
         return response_status;
     }
 
+    int get_http_minor_version() const override {
+        return minor_http_version;
+    }
+
 public:
     std::vector<uint8_t> _body;
     size_t _bodyCursor=0;
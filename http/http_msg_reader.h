@@ -56,6 +56,10 @@ public:
     virtual const std::string& get_header(const std::string& headerName) const = 0;
     virtual const void* get_body(size_t& size) const = 0;
     virtual int get_status() const = 0;
+    virtual int get_http_minor_version() const = 0;
+
+    /// True if the peer wants the connection to persist (HTTP/1.1 default, or explicit keep-alive for HTTP/1.0)
+    bool is_keep_alive() const;
 };
 
 /// Extracts individual http messages from stream, performs header/size validation
@@ -0,0 +1,169 @@
+// Copyright 2018 The Beam Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bbs_store.h"
+
+namespace beam {
+
+void BbsMemStore::Msg::get_Data(NodeDB::WalkerBbs::Data& d) const
+{
+	d.m_Key = m_Key;
+	d.m_Channel = m_Channel.m_Value;
+	d.m_TimePosted = m_TimePosted;
+	d.m_Message = Blob(m_Message);
+	d.m_Nonce = m_Nonce;
+}
+
+size_t BbsMemStore::KeyHash::operator() (const Key& key) const
+{
+	// the key is a hash already
+	size_t val;
+	static_assert(sizeof(val) <= Key::nBytes, "");
+	memcpy(&val, key.m_pData, sizeof(val));
+	return val;
+}
+
+const BbsMemStore::Msg* BbsMemStore::Find(const Key& key) const
+{
+	auto it = m_Keys.find(key);
+	return (m_Keys.end() == it) ? nullptr : it->second;
+}
+
+uint64_t BbsMemStore::Insert(const NodeDB::WalkerBbs::Data& d)
+{
+	std::unique_ptr<Msg> pMsg(new Msg);
+	pMsg->m_ID.m_Value = ++m_LastID;
+	pMsg->m_Channel.m_Value = d.m_Channel;
+	pMsg->m_Channel.m_ID = m_LastID;
+	pMsg->m_Key = d.m_Key;
+	pMsg->m_TimePosted = d.m_TimePosted;
+	pMsg->m_Nonce = d.m_Nonce;
+	d.m_Message.Export(pMsg->m_Message);
+
+	bool bNew = m_Keys.emplace(d.m_Key, pMsg.get()).second;
+	assert(bNew); // must be unique
+	(void) bNew;
+
+	Msg& msg = *pMsg.release();
+	m_Seq.insert(m_Seq.end(), msg.m_ID);
+	m_Channels.insert(msg.m_Channel);
+	m_Buckets[msg.m_TimePosted / m_BucketDuration_s].push_back(msg.m_Bucket);
+
+	return msg.m_ID.m_Value;
+}
+
+uint64_t BbsMemStore::FindCursor(Timestamp t) const
+{
+	uint64_t id = m_LastID + 1;
+
+	auto it = m_Buckets.lower_bound(t / m_BucketDuration_s);
+	if (m_Buckets.end() == it)
+		return id;
+
+	// the boundary bucket may contain older messages
+	for (const auto& x : it->second)
+	{
+		const Msg& msg = x.get_ParentObj();
+		if (msg.m_TimePosted >= t)
+		{
+			id = msg.m_ID.m_Value;
+			break; // the bucket is ordered by ID
+		}
+	}
+
+	// the rest are newer. Within each bucket the first one has the lowest ID
+	for (it++; m_Buckets.end() != it; it++)
+		if (!it->second.empty())
+			std::setmin(id, it->second.front().get_ParentObj().m_ID.m_Value);
+
+	return id;
+}
+
+BbsMemStore::Msg::IDSet::const_iterator BbsMemStore::SeqFrom(uint64_t id) const
+{
+	Msg::ID key;
+	key.m_Value = id;
+	return m_Seq.upper_bound(key);
+}
+
+BbsMemStore::Msg::ChannelSet::const_iterator BbsMemStore::ChannelFrom(BbsChannel ch, uint64_t id) const
+{
+	Msg::Channel key;
+	key.m_Value = ch;
+	key.m_ID = id;
+	return m_Channels.upper_bound(key);
+}
+
+void BbsMemStore::Delete(Msg& msg)
+{
+	m_Keys.erase(msg.m_Key);
+	m_Seq.erase(Msg::IDSet::s_iterator_to(msg.m_ID));
+	m_Channels.erase(Msg::ChannelSet::s_iterator_to(msg.m_Channel));
+	delete &msg;
+}
+
+void BbsMemStore::DeleteFront(Msg::BucketList& lst, NodeDB::BbsTotals& totals)
+{
+	Msg& msg = lst.front().get_ParentObj();
+	lst.pop_front();
+
+	totals.m_Count--;
+	totals.m_Size -= msg.m_Message.size();
+	Delete(msg);
+}
+
+void BbsMemStore::Cleanup(NodeDB::BbsTotals& totals, Timestamp tsExpire, const NodeDB::BbsTotals& lims)
+{
+	while (!m_Buckets.empty())
+	{
+		auto it = m_Buckets.begin();
+		Msg::BucketList& lst = it->second;
+
+		bool bExpired = ((it->first + 1) * m_BucketDuration_s <= tsExpire);
+		if (bExpired)
+		{
+			// drop the whole bucket
+			while (!lst.empty())
+				DeleteFront(lst, totals);
+		}
+		else
+		{
+			// over the limits. Drop the oldest messages one by one
+			while (!lst.empty() && ((totals.m_Count > lims.m_Count) || (totals.m_Size > lims.m_Size)))
+				DeleteFront(lst, totals);
+
+			if (!lst.empty())
+				break;
+		}
+
+		m_Buckets.erase(it);
+	}
+}
+
+void BbsMemStore::Clear()
+{
+	for (auto& x : m_Buckets)
+	{
+		while (!x.second.empty())
+		{
+			Msg& msg = x.second.front().get_ParentObj();
+			x.second.pop_front();
+			Delete(msg);
+		}
+	}
+
+	m_Buckets.clear();
+}
+
+} // namespace beam
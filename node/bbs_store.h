@@ -0,0 +1,109 @@
+// Copyright 2018 The Beam Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <boost/intrusive/set.hpp>
+#include <boost/intrusive/list.hpp>
+#include <unordered_map>
+#include "db.h"
+
+namespace beam {
+
+// In-memory alternative to the BBS tables of the NodeDB, for nodes that relay lots of SBBS traffic.
+// Messages are indexed by key (hash index), by ID (sequence of arrival), and by channel+ID.
+// In addition they're grouped into time buckets (by the posted time), so that expiration drops the whole bucket at once.
+// Contents are not persisted, the store is empty after restart.
+struct BbsMemStore
+{
+	typedef NodeDB::WalkerBbs::Key Key;
+
+	struct Msg
+	{
+		struct ID
+			:public boost::intrusive::set_base_hook<>
+		{
+			uint64_t m_Value;
+			bool operator < (const ID& x) const { return m_Value < x.m_Value; }
+			IMPLEMENT_GET_PARENT_OBJ(Msg, m_ID)
+		} m_ID;
+
+		struct Channel
+			:public boost::intrusive::set_base_hook<>
+		{
+			BbsChannel m_Value;
+			uint64_t m_ID; // copy, for ordering within the channel
+			bool operator < (const Channel& x) const { return (m_Value < x.m_Value) || ((m_Value == x.m_Value) && (m_ID < x.m_ID)); }
+			IMPLEMENT_GET_PARENT_OBJ(Msg, m_Channel)
+		} m_Channel;
+
+		struct Bucket
+			:public boost::intrusive::list_base_hook<>
+		{
+			IMPLEMENT_GET_PARENT_OBJ(Msg, m_Bucket)
+		} m_Bucket;
+
+		Key m_Key;
+		Timestamp m_TimePosted;
+		uint32_t m_Nonce;
+		ByteBuffer m_Message;
+
+		void get_Data(NodeDB::WalkerBbs::Data&) const;
+
+		typedef boost::intrusive::set<ID> IDSet;
+		typedef boost::intrusive::multiset<Channel> ChannelSet;
+		typedef boost::intrusive::list<Bucket> BucketList; // in the order of arrival
+	};
+
+	Timestamp m_BucketDuration_s = 600;
+
+	BbsMemStore() = default;
+	BbsMemStore(const BbsMemStore&) = delete;
+	~BbsMemStore() { Clear(); }
+
+	const Msg* Find(const Key&) const;
+	uint64_t Insert(const NodeDB::WalkerBbs::Data&); // must be unique. Returns the ID
+
+	// same semantics as NodeDB::BbsFindCursor
+	uint64_t FindCursor(Timestamp) const;
+	uint64_t get_LastID() const { return m_LastID; }
+
+	// enumeration, starting from the element that follows the specified ID
+	Msg::IDSet::const_iterator SeqFrom(uint64_t id) const;
+	Msg::IDSet::const_iterator SeqEnd() const { return m_Seq.end(); }
+
+	Msg::ChannelSet::const_iterator ChannelFrom(BbsChannel, uint64_t id) const;
+	Msg::ChannelSet::const_iterator ChannelEnd() const { return m_Channels.end(); }
+
+	// Drops the buckets that expire before the given timestamp, then the oldest messages until in limits. Updates totals
+	void Cleanup(NodeDB::BbsTotals&, Timestamp tsExpire, const NodeDB::BbsTotals& lims);
+	void Clear();
+
+private:
+
+	struct KeyHash {
+		size_t operator() (const Key&) const;
+	};
+
+	Msg::IDSet m_Seq;
+	Msg::ChannelSet m_Channels;
+	std::unordered_map<Key, Msg*, KeyHash> m_Keys;
+	std::map<Timestamp, Msg::BucketList> m_Buckets; // bucket index -> messages
+	uint64_t m_LastID = 0;
+
+	void Delete(Msg&);
+	void DeleteFront(Msg::BucketList&, NodeDB::BbsTotals&);
+};
+
+} // namespace beam
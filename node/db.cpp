@@ -99,6 +99,18 @@ namespace beam {
 #define TblAssets_Data			"MetaData"
 #define TblAssets_LockHeight	"LockHeight"
 
+#define TblExpTxo				"ExpTxo"
+#define TblExpTxo_Commitment	"Commitment"
+#define TblExpTxo_Height		"Height"
+#define TblExpTxo_Spent			"Spent"
+
+#define TblExpAsset				"ExpAsset"
+#define TblExpAsset_ID			"ID"
+#define TblExpAsset_Height		"Height"
+#define TblExpAsset_Event		"Event"
+#define TblExpAsset_Value		"Value"
+#define TblExpAsset_Kernel		"Kernel"
+
 NodeDB::NodeDB()
 	:m_pDb(NULL)
 {
@@ -727,6 +739,103 @@ void NodeDB::Transaction::Rollback()
 	}
 }
 
+NodeDB::Backup::Backup()
+	:m_pDb(nullptr)
+	,m_pBackup(nullptr)
+	,m_bStarted(false)
+{
+}
+
+void NodeDB::Backup::TestRet(int ret)
+{
+	if (SQLITE_OK != ret)
+	{
+		char sz[0x1000];
+		snprintf(sz, _countof(sz), "sqlite backup err %d, %s", ret, m_pDb ? sqlite3_errmsg(m_pDb) : "");
+		throw std::runtime_error(sz);
+	}
+}
+
+void NodeDB::Backup::Open(NodeDB& db, const char* szPath)
+{
+	Close();
+
+	TestRet(sqlite3_open_v2(szPath, &m_pDb, SQLITE_OPEN_READWRITE | SQLITE_OPEN_NOMUTEX | SQLITE_OPEN_CREATE, NULL));
+
+	m_pBackup = sqlite3_backup_init(m_pDb, "main", db.m_pDb, "main");
+	if (!m_pBackup)
+		TestRet(sqlite3_errcode(m_pDb));
+
+	m_bStarted = false;
+}
+
+void NodeDB::Backup::Close()
+{
+	if (m_pBackup)
+	{
+		sqlite3_backup_finish(m_pBackup); // don't care about retval
+		m_pBackup = nullptr;
+	}
+
+	if (m_pDb)
+	{
+		sqlite3_close(m_pDb);
+		m_pDb = nullptr;
+	}
+}
+
+int NodeDB::Backup::StepRaw(int nPages)
+{
+	assert(m_pBackup);
+	int ret = sqlite3_backup_step(m_pBackup, nPages);
+
+	switch (ret)
+	{
+	case SQLITE_OK:
+	case SQLITE_DONE:
+	case SQLITE_BUSY:
+	case SQLITE_LOCKED:
+		break; // the last two are transient, retry on the next step
+
+	default:
+		TestRet(ret);
+	}
+
+	return ret;
+}
+
+bool NodeDB::Backup::Step(uint32_t nPages)
+{
+	if (!m_bStarted)
+	{
+		// zero pages: only acquires the source size, the remaining count is unknown before
+		if (SQLITE_OK != StepRaw(0))
+			return false;
+		m_bStarted = true;
+	}
+
+	uint32_t nRemaining = sqlite3_backup_remaining(m_pBackup);
+	if (nRemaining > nPages)
+	{
+		StepRaw(nPages); // at least 1 page remains, hence it can't complete
+		nRemaining = sqlite3_backup_remaining(m_pBackup);
+	}
+
+	return (nRemaining <= nPages);
+}
+
+void NodeDB::Backup::Finalize()
+{
+	int ret = StepRaw(-1);
+	if (SQLITE_DONE != ret)
+		TestRet((SQLITE_OK == ret) ? SQLITE_ERROR : ret);
+
+	TestRet(sqlite3_backup_finish(m_pBackup));
+	m_pBackup = nullptr;
+
+	Close();
+}
+
 #define StateCvt_Fields(macro, sep) \
 	macro(Height,		m_Height) sep \
 	macro(HashPrev,		m_Prev) sep \
@@ -2083,6 +2192,30 @@ Height NodeDB::FindKernel(const Blob& key)
 	return h;
 }
 
+void NodeDB::EnumKernels(WalkerKey& wlk)
+{
+	wlk.m_Rs.Reset(*this, Query::KernelEnum, "SELECT " TblKernels_Key " FROM " TblKernels);
+}
+
+bool NodeDB::WalkerKey::MoveNext()
+{
+	if (!m_Rs.Step())
+		return false;
+
+	m_Rs.get(0, m_Key);
+	return true;
+}
+
+uint64_t NodeDB::get_KernelsCount()
+{
+	Recordset rs(*this, Query::KernelCount, "SELECT COUNT(*) FROM " TblKernels);
+	rs.StepStrict();
+
+	uint64_t nRet;
+	rs.get(0, nRet);
+	return nRet;
+}
+
 Height NodeDB::FindBlock(const Blob& hash)
 {
     Recordset rs(*this, Query::BlockFind, "SELECT " TblStates_Height " FROM " TblStates" WHERE " TblStates_Hash "=? ORDER BY " TblStates_Height " DESC LIMIT 1");
@@ -2181,6 +2314,118 @@ NodeDB::StreamMmr::StreamMmr(NodeDB& db, StreamType::Enum eType, bool bStoreH0)
 
 	m_LastOut.m_Pos.H = Merkle::Position::HMax;
 	m_LastOut.m_Pos.X = static_cast<uint64_t>(-1);
+
+	m_nImageData = 0;
+	m_nImageDirty0 = m_nImageDirty1 = 0;
+}
+
+uint64_t NodeDB::StreamMmr::get_StreamSize(uint64_t nCount) const
+{
+	return get_TotalHashes(nCount, m_StoreH0) * sizeof(Merkle::Hash);
+}
+
+bool NodeDB::StreamMmr::OpenImage(const char* sz, const Stamp& s)
+{
+	// change this when format changes
+	static const uint8_t s_pSig[] = {
+		0x6D, 0x1C, 0x93, 0x2E,
+		0xB0, 0x57, 0x4A, 0xC1,
+		0x8F, 0x22, 0xE5, 0x7A,
+		0x39, 0xD4, 0x0B, 0x66
+	};
+
+	MappedFile::Defs d;
+	d.m_pSig = s_pSig;
+	d.m_nSizeSig = sizeof(s_pSig);
+	d.m_nBanks = 0;
+	d.m_nFixedHdr = sizeof(ImageHdr);
+
+	m_nImageData = d.get_SizeMin();
+	uint64_t nSize = get_StreamSize(m_Count);
+
+	m_Image.Open(sz, d);
+
+	const ImageHdr& h = get_ImageHdr();
+	if (!h.m_Dirty && (h.m_Stamp == s) && (m_Image.get_Size() >= m_nImageData + nSize))
+		return true;
+
+	m_Image.Open(sz, d, true); // reset
+	m_Image.EnsureSize(m_nImageData + nSize);
+
+	m_DB.StreamIO(m_eType, 0, get_ImageData(), nSize, false);
+	m_Image.Flush(m_nImageData, nSize);
+
+	ImageHdr& h2 = get_ImageHdr();
+	h2.m_Dirty = 0;
+	h2.m_Stamp = s;
+	m_Image.Flush(0, m_nImageData);
+
+	m_nImageDirty0 = m_nImageDirty1 = 0;
+
+	return false;
+}
+
+void NodeDB::StreamMmr::CloseImage()
+{
+	m_Image.Close();
+}
+
+NodeDB::StreamMmr::ImageHdr& NodeDB::StreamMmr::get_ImageHdr() const
+{
+	return *reinterpret_cast<ImageHdr*>(m_Image.get_FixedHdr());
+}
+
+uint8_t* NodeDB::StreamMmr::get_ImageData() const
+{
+	return Cast::NotConst(m_Image.get_Base()) + m_nImageData;
+}
+
+bool NodeDB::StreamMmr::IsImageDirty() const
+{
+	return IsImageOpen() && get_ImageHdr().m_Dirty;
+}
+
+void NodeDB::StreamMmr::FlushImage(const Stamp& s)
+{
+	if (!IsImageOpen())
+		return;
+
+	ImageHdr& h = get_ImageHdr();
+	if (h.m_Dirty)
+	{
+		// the data first, then the header that declares it valid
+		m_Image.Flush(m_nImageData + m_nImageDirty0, m_nImageDirty1 - m_nImageDirty0);
+		m_nImageDirty0 = m_nImageDirty1 = 0;
+
+		h.m_Dirty = 0;
+	}
+
+	h.m_Stamp = s;
+	m_Image.Flush(0, m_nImageData);
+}
+
+void NodeDB::StreamMmr::MarkImageDirty(uint64_t nOffs, uint32_t nSize)
+{
+	ImageHdr& h = get_ImageHdr();
+	if (!h.m_Dirty)
+	{
+		h.m_Dirty = 1;
+		m_Image.Flush(0, m_nImageData); // before the data is modified
+	}
+
+	if (!nSize)
+		return;
+
+	if (m_nImageDirty0 == m_nImageDirty1)
+	{
+		m_nImageDirty0 = nOffs;
+		m_nImageDirty1 = nOffs + nSize;
+	}
+	else
+	{
+		std::setmin(m_nImageDirty0, nOffs);
+		std::setmax(m_nImageDirty1, nOffs + nSize);
+	}
 }
 
 void NodeDB::StreamMmr::Append(const Merkle::Hash& hv)
@@ -2198,8 +2443,15 @@ void NodeDB::StreamMmr::ShrinkTo(uint64_t nCount)
 
 void NodeDB::StreamMmr::ResizeTo(uint64_t nCount)
 {
-	m_DB.StreamResize(m_eType, get_TotalHashes(nCount, m_StoreH0) * sizeof(Merkle::Hash), get_TotalHashes(m_Count, m_StoreH0) * sizeof(Merkle::Hash));
+	uint64_t nSize = get_StreamSize(nCount);
+	m_DB.StreamResize(m_eType, nSize, get_StreamSize(m_Count));
 	m_Count = nCount;
+
+	if (IsImageOpen())
+	{
+		MarkImageDirty(0, 0);
+		m_Image.EnsureSize(m_nImageData + nSize); // never shrinks
+	}
 }
 
 void NodeDB::StreamMmr::LoadElement(Merkle::Hash& hv, const Merkle::Position& pos) const
@@ -2207,13 +2459,30 @@ void NodeDB::StreamMmr::LoadElement(Merkle::Hash& hv, const Merkle::Position& po
 	if (CacheFind(hv, pos))
 		return;
 
-	m_DB.StreamIO(m_eType, Pos2Idx(pos, m_StoreH0) * sizeof(Merkle::Hash), hv.m_pData, hv.nBytes, false);
+	uint64_t nOffs = Pos2Idx(pos, m_StoreH0) * sizeof(Merkle::Hash);
+
+	if (IsImageOpen())
+	{
+		assert(m_nImageData + nOffs + hv.nBytes <= m_Image.get_Size());
+		memcpy(hv.m_pData, get_ImageData() + nOffs, hv.nBytes);
+	}
+	else
+		m_DB.StreamIO(m_eType, nOffs, hv.m_pData, hv.nBytes, false);
+
 	Cast::NotConst(this)->CacheAdd(hv, pos);
 }
 
 void NodeDB::StreamMmr::SaveElement(const Merkle::Hash& hv, const Merkle::Position& pos)
 {
-	m_DB.StreamIO(m_eType, Pos2Idx(pos, m_StoreH0) * sizeof(Merkle::Hash), Cast::NotConst(hv.m_pData), hv.nBytes, true);
+	uint64_t nOffs = Pos2Idx(pos, m_StoreH0) * sizeof(Merkle::Hash);
+	m_DB.StreamIO(m_eType, nOffs, Cast::NotConst(hv.m_pData), hv.nBytes, true);
+
+	if (IsImageOpen())
+	{
+		MarkImageDirty(nOffs, hv.nBytes);
+		memcpy(get_ImageData() + nOffs, hv.m_pData, hv.nBytes);
+	}
+
 	CacheAdd(hv, pos);
 }
 
@@ -2415,6 +2684,21 @@ void NodeDB::UniqueDeleteStrict(const Blob& key)
 	TestChanged1Row();
 }
 
+void NodeDB::EnumUnique(WalkerKey& wlk)
+{
+	wlk.m_Rs.Reset(*this, Query::UniqueEnum, "SELECT " TblUnique_Key " FROM " TblUnique);
+}
+
+uint64_t NodeDB::get_UniqueCount()
+{
+	Recordset rs(*this, Query::UniqueCount, "SELECT COUNT(*) FROM " TblUnique);
+	rs.StepStrict();
+
+	uint64_t nRet;
+	rs.get(0, nRet);
+	return nRet;
+}
+
 const Asset::ID NodeDB::s_AssetEmpty0 = Asset::s_MaxCount;
 
 Asset::ID NodeDB::AssetFindByOwner(const PeerID& owner)
@@ -2489,6 +2773,20 @@ void NodeDB::AssetAdd(Asset::Full& ai)
 	ParamIntSet(ParamID::AssetsCountUsed, ParamIntGetDef(ParamID::AssetsCountUsed) + 1);
 }
 
+void NodeDB::AssetAddAt(const Asset::Full& ai)
+{
+	Asset::ID nCount = static_cast<Asset::ID>(ParamIntGetDef(ParamID::AssetsCount));
+	assert(ai.m_ID > nCount);
+
+	while (++nCount < ai.m_ID)
+		AssetInsertRaw(nCount + s_AssetEmpty0, nullptr);
+
+	AssetInsertRaw(ai.m_ID, &ai);
+
+	ParamIntSet(ParamID::AssetsCount, ai.m_ID);
+	ParamIntSet(ParamID::AssetsCountUsed, ParamIntGetDef(ParamID::AssetsCountUsed) + 1);
+}
+
 Asset::ID NodeDB::AssetDelete(Asset::ID id)
 {
 	AssetDeleteRaw(id);
@@ -2554,6 +2852,123 @@ void NodeDB::AssetSetValue(Asset::ID id, const AmountBig::Type& val, Height hLoc
 	TestChanged1Row();
 }
 
+void NodeDB::ExplorerIndexesCreate()
+{
+	ExecQuick("CREATE TABLE IF NOT EXISTS [" TblExpTxo "] ("
+		"[" TblExpTxo_Commitment	"] BLOB NOT NULL,"
+		"[" TblExpTxo_Height		"] INTEGER NOT NULL,"
+		"[" TblExpTxo_Spent		"] INTEGER NOT NULL)");
+
+	ExecQuick("CREATE INDEX IF NOT EXISTS [Idx" TblExpTxo "] ON [" TblExpTxo "] ([" TblExpTxo_Commitment "],[" TblExpTxo_Height "]);");
+	ExecQuick("CREATE INDEX IF NOT EXISTS [Idx" TblExpTxo "H] ON [" TblExpTxo "] ([" TblExpTxo_Height "]);");
+
+	ExecQuick("CREATE TABLE IF NOT EXISTS [" TblExpAsset "] ("
+		"[" TblExpAsset_ID		"] INTEGER NOT NULL,"
+		"[" TblExpAsset_Height	"] INTEGER NOT NULL,"
+		"[" TblExpAsset_Event	"] INTEGER NOT NULL,"
+		"[" TblExpAsset_Value	"] INTEGER,"
+		"[" TblExpAsset_Kernel	"] BLOB)");
+
+	ExecQuick("CREATE INDEX IF NOT EXISTS [Idx" TblExpAsset "] ON [" TblExpAsset "] ([" TblExpAsset_ID "],[" TblExpAsset_Height "]);");
+	ExecQuick("CREATE INDEX IF NOT EXISTS [Idx" TblExpAsset "H] ON [" TblExpAsset "] ([" TblExpAsset_Height "]);");
+}
+
+void NodeDB::ExpTxoAdd(const ECC::uintBig& commitmentX, Height h, bool bSpent)
+{
+	Recordset rs(*this, Query::ExpTxoIns, "INSERT INTO " TblExpTxo "(" TblExpTxo_Commitment "," TblExpTxo_Height "," TblExpTxo_Spent ") VALUES(?,?,?)");
+	rs.put_As(0, commitmentX);
+	rs.put(1, h);
+	rs.put(2, bSpent ? 1U : 0U);
+	rs.Step();
+	TestChanged1Row();
+}
+
+void NodeDB::ExpAssetAdd(Asset::ID aid, Height h, ExpAssetEvent::Enum e, AmountSigned val, const Merkle::Hash& idKrn)
+{
+	Recordset rs(*this, Query::ExpAssetIns, "INSERT INTO " TblExpAsset "(" TblExpAsset_ID "," TblExpAsset_Height "," TblExpAsset_Event "," TblExpAsset_Value "," TblExpAsset_Kernel ") VALUES(?,?,?,?,?)");
+	rs.put(0, aid);
+	rs.put(1, h);
+	rs.put(2, static_cast<uint32_t>(e));
+	rs.put(3, static_cast<uint64_t>(val));
+	rs.put(4, idKrn);
+	rs.Step();
+	TestChanged1Row();
+}
+
+void NodeDB::ExplorerIndexesDelFrom(Height h)
+{
+	Recordset rs(*this, Query::ExpTxoDelFrom, "DELETE FROM " TblExpTxo " WHERE " TblExpTxo_Height ">=?");
+	rs.put(0, h);
+	rs.Step();
+
+	rs.Reset(*this, Query::ExpAssetDelFrom, "DELETE FROM " TblExpAsset " WHERE " TblExpAsset_Height ">=?");
+	rs.put(0, h);
+	rs.Step();
+}
+
+void NodeDB::ExpTxoFind(WalkerExpTxo& x, const ECC::uintBig& commitmentX)
+{
+	x.m_Rs.Reset(*this, Query::ExpTxoFind, "SELECT " TblExpTxo_Height "," TblExpTxo_Spent " FROM " TblExpTxo " WHERE " TblExpTxo_Commitment "=? ORDER BY " TblExpTxo_Height " ASC");
+	x.m_Rs.put_As(0, commitmentX);
+}
+
+bool NodeDB::WalkerExpTxo::MoveNext()
+{
+	if (!m_Rs.Step())
+		return false;
+	m_Rs.get(0, m_Height);
+
+	uint32_t nSpent;
+	m_Rs.get(1, nSpent);
+	m_Spent = (nSpent != 0);
+	return true;
+}
+
+void NodeDB::ExpAssetFind(WalkerExpAsset& x, Asset::ID aid)
+{
+	x.m_Rs.Reset(*this, Query::ExpAssetFind, "SELECT " TblExpAsset_Height "," TblExpAsset_Event "," TblExpAsset_Value "," TblExpAsset_Kernel " FROM " TblExpAsset " WHERE " TblExpAsset_ID "=? ORDER BY " TblExpAsset_Height " ASC");
+	x.m_Rs.put(0, aid);
+}
+
+Asset::ID NodeDB::ExpAssetFindMinFree()
+{
+	// live assets are created and not destroyed yet. The node assigns the lowest ID that is not in use
+	Recordset rs(*this, Query::ExpAssetLive, "SELECT " TblExpAsset_ID " FROM " TblExpAsset " WHERE " TblExpAsset_Event "<>? GROUP BY " TblExpAsset_ID
+		" HAVING SUM(CASE " TblExpAsset_Event " WHEN ? THEN 1 ELSE -1 END)>0 ORDER BY " TblExpAsset_ID " ASC");
+	rs.put(0, static_cast<uint32_t>(ExpAssetEvent::Emit));
+	rs.put(1, static_cast<uint32_t>(ExpAssetEvent::Create));
+
+	Asset::ID ret = 1; // 1-based
+	while (rs.Step())
+	{
+		Asset::ID aid;
+		rs.get(0, aid);
+		if (aid != ret)
+			break;
+		ret++;
+	}
+
+	return ret;
+}
+
+bool NodeDB::WalkerExpAsset::MoveNext()
+{
+	if (!m_Rs.Step())
+		return false;
+	m_Rs.get(0, m_Height);
+
+	uint32_t nEvent;
+	m_Rs.get(1, nEvent);
+	m_Event = static_cast<ExpAssetEvent::Enum>(nEvent);
+
+	uint64_t val;
+	m_Rs.get(2, val);
+	m_Value = static_cast<AmountSigned>(val);
+
+	m_Rs.get(3, m_KernelID);
+	return true;
+}
+
 void NodeDB::MigrateFrom18()
 {
 	{
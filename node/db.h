@@ -16,6 +16,7 @@
 
 #include "core/common.h"
 #include "core/block_crypt.h"
+#include "core/mapped_file.h"
 #include "sqlite/sqlite3.h"
 
 namespace beam {
@@ -59,6 +60,10 @@ public:
 			ShieldedInputs,
 			AssetsCount, // Including unused. The last element is guaranteed to be used.
 			AssetsCountUsed, // num of 'live' assets
+			ExplorerIndexed, // Height and hash of the last state indexed by the explorer
+			MmrStamp, // validates the memory-mapped MMR images
+			ExplorerTxoLow, // the explorer commitment index is complete starting from this height. The blocks below were (partially) unavailable
+			ExplorerAssetsLow, // same for the asset index
 		};
 	};
 
@@ -144,6 +149,8 @@ public:
 			KernelIns,
 			KernelFind,
 			KernelDel,
+			KernelEnum,
+			KernelCount,
 			TxoAdd,
 			TxoDel,
 			TxoDelFrom,
@@ -160,6 +167,8 @@ public:
 			UniqueIns,
 			UniqueFind,
 			UniqueDel,
+			UniqueEnum,
+			UniqueCount,
 
 			AssetFindOwner,
 			AssetFindMin,
@@ -168,6 +177,14 @@ public:
 			AssetGet,
 			AssetSetVal,
 
+			ExpTxoIns,
+			ExpTxoFind,
+			ExpTxoDelFrom,
+			ExpAssetIns,
+			ExpAssetFind,
+			ExpAssetDelFrom,
+			ExpAssetLive,
+
 			Dbg0,
 			Dbg1,
 			Dbg2,
@@ -271,6 +288,28 @@ public:
 		void Rollback();
 	};
 
+	// Online copy of the DB by the sqlite backup API, progressed in portions. Pages modified after being copied are updated in the copy as well.
+	// Must be stepped only when there's no uncommitted data. Errors are reported by std::runtime_error (the source DB is not affected).
+	class Backup {
+		sqlite3* m_pDb;
+		sqlite3_backup* m_pBackup;
+		bool m_bStarted;
+
+		void TestRet(int);
+		int StepRaw(int nPages);
+	public:
+		Backup();
+		~Backup() { Close(); }
+
+		void Open(NodeDB&, const char* szPath);
+		void Close(); // incomplete copy is left as-is
+		bool IsOpen() const { return NULL != m_pBackup; }
+
+		// Copies up to nPages, but never completes the backup. Returns true if the rest fits nPages, i.e. it's ready for Finalize
+		bool Step(uint32_t nPages);
+		void Finalize(); // copies the rest, and closes
+	};
+
 	// Hi-level functions
 
 	void ParamSet(uint32_t ID, const uint64_t*, const Blob*);
@@ -474,6 +513,16 @@ public:
 	void InsertKernel(const Blob&, Height h);
 	void DeleteKernel(const Blob&, Height h);
 	Height FindKernel(const Blob&); // in case of duplicates - returning the one with the largest Height
+
+	struct WalkerKey {
+		Recordset m_Rs;
+		Blob m_Key;
+
+		bool MoveNext();
+	};
+
+	void EnumKernels(WalkerKey&); // unordered, duplicates are possible
+	uint64_t get_KernelsCount();
     Height FindBlock(const Blob&);
 
 	uint64_t FindStateWorkGreater(const Difficulty::Raw&);
@@ -527,6 +576,17 @@ public:
 		void ShrinkTo(uint64_t nCount);
 		void ResizeTo(uint64_t nCount);
 
+		// Optional flat memory-mapped image of the stream. The DB stream remains the source of truth, the image only serves reads.
+		// If the image is missing, dirty or the stamp doesn't match - it's rebuilt from the stream.
+		// The dirty flag reaches the disk before the data is modified, and the data before the flag is cleared, hence the image
+		// survives a crash or power loss at any point: it's either consistent with the stamp, or dirty.
+		typedef Merkle::Hash Stamp;
+
+		bool OpenImage(const char* sz, const Stamp&); // returns false if the image was rebuilt
+		void CloseImage(); // a dirty image remains dirty, i.e. is rebuilt on the next open
+		bool IsImageDirty() const;
+		void FlushImage(const Stamp&); // call after the DB commit. Also re-stamps a clean image
+
 	protected:
 		// Mmr
 		virtual void LoadElement(Merkle::Hash& hv, const Merkle::Position& pos) const override;
@@ -550,6 +610,24 @@ public:
 
 		bool CacheFind(Merkle::Hash& hv, const Merkle::Position& pos) const;
 		void CacheAdd(const Merkle::Hash& hv, const Merkle::Position& pos);
+
+		struct ImageHdr
+		{
+			MappedFile::Offset m_Dirty;
+			Stamp m_Stamp;
+		};
+
+		MappedFile m_Image;
+		uint32_t m_nImageData; // data offset within the image
+		uint64_t m_nImageDirty0; // modified data range since the last flush
+		uint64_t m_nImageDirty1;
+
+		void MarkImageDirty(uint64_t nOffs, uint32_t nSize);
+
+		bool IsImageOpen() const { return m_Image.get_Base() != nullptr; }
+		ImageHdr& get_ImageHdr() const;
+		uint8_t* get_ImageData() const;
+		uint64_t get_StreamSize(uint64_t nCount) const;
 	};
 
 	class StatesMmr
@@ -571,14 +649,56 @@ public:
 	bool UniqueInsertSafe(const Blob& key, const Blob* pVal); // returns false if not unique (and doesn't update the value)
 	bool UniqueFind(const Blob& key, Recordset&);
 	void UniqueDeleteStrict(const Blob& key);
+	void EnumUnique(WalkerKey&); // unordered
+	uint64_t get_UniqueCount();
 
 	void AssetAdd(Asset::Full&); // sets ID=0 to auto assign, otherwise - specified ID must be used
+	void AssetAddAt(const Asset::Full&); // for import: IDs must be ascending, the skipped ones are marked unused
 	Asset::ID AssetFindByOwner(const PeerID&);
 	Asset::ID AssetDelete(Asset::ID); // returns remaining assets count (including the unused)
 	bool AssetGetSafe(Asset::Full&); // must set ID before invocation
 	void AssetSetValue(Asset::ID, const AmountBig::Type&, Height hLockHeight);
 	bool AssetGetNext(Asset::Full&); // for enum
 
+	// Explorer secondary indexes. Optional, the tables are created on demand
+	struct ExpAssetEvent {
+		enum Enum {
+			Create,
+			Emit,
+			Destroy,
+		};
+	};
+
+	void ExplorerIndexesCreate();
+	void ExpTxoAdd(const ECC::uintBig& commitmentX, Height, bool bSpent);
+	void ExpAssetAdd(Asset::ID, Height, ExpAssetEvent::Enum, AmountSigned, const Merkle::Hash& idKrn);
+	void ExplorerIndexesDelFrom(Height);
+
+	struct WalkerExpTxo
+	{
+		Recordset m_Rs;
+		Height m_Height;
+		bool m_Spent;
+
+		bool MoveNext();
+	};
+
+	void ExpTxoFind(WalkerExpTxo&, const ECC::uintBig& commitmentX); // ordered by Height
+
+	struct WalkerExpAsset
+	{
+		Recordset m_Rs;
+		Height m_Height;
+		ExpAssetEvent::Enum m_Event;
+		AmountSigned m_Value;
+		Merkle::Hash m_KernelID;
+
+		bool MoveNext();
+	};
+
+	void ExpAssetFind(WalkerExpAsset&, Asset::ID); // ordered by Height
+	Asset::ID ExpAssetFindMinFree(); // the ID the node would assign to the next created asset, according to the indexed events
+
 private:
 
 	sqlite3* m_pDb;
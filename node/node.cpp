@@ -94,6 +94,7 @@ void Node::UpdateSyncStatusRaw()
 	Height hTotal = m_Processor.m_Cursor.m_ID.m_Height;
 	Height hDoneBlocks = hTotal;
 	Height hDoneHdrs = hTotal;
+	Height hLowBlock = MaxHeight; // lowest missing block. The ranges above it may be requested (or even received) as well
 
 	if (m_Processor.IsFastSync())
 		hTotal = m_Processor.m_SyncData.m_Target.m_Height;
@@ -110,10 +111,9 @@ void Node::UpdateSyncStatusRaw()
 		if (bBlock)
 		{
 			assert(t.m_Key.first.m_Height);
-			// all the blocks up to this had been dloaded
 			std::setmax(hTotal, t.m_sidTrg.m_Height);
 			std::setmax(hDoneHdrs, t.m_sidTrg.m_Height);
-			std::setmax(hDoneBlocks, t.m_Key.first.m_Height - 1);
+			std::setmin(hLowBlock, t.m_Key.first.m_Height);
 		}
 		else
 		{
@@ -126,6 +126,10 @@ void Node::UpdateSyncStatusRaw()
 		}
 	}
 
+	// all the blocks below the lowest missing one had been dloaded
+	if (MaxHeight != hLowBlock)
+		std::setmax(hDoneBlocks, hLowBlock - 1);
+
 	// account for treasury
 	hTotal++;
 
@@ -368,38 +372,62 @@ bool Node::TryAssignTask(Task& t, Peer& p)
 	// assign
 	if (t.m_Key.second)
 	{
-		if (m_nTasksPackBody >= m_Cfg.m_MaxConcurrentBlocksRequest)
-			return false; // too many blocks requested
-
-		Height hCountExtra = t.m_sidTrg.m_Height - t.m_Key.first.m_Height;
+		if (nBlocks >= m_Cfg.m_BandwidthCtl.m_MaxBodyPacksPerPeer)
+			return false; // the peer is busy
 
+		const Block::SystemState::ID& id = t.m_Key.first;
 		proto::GetBodyPack msg;
 
-		if (t.m_Key.first.m_Height <= m_Processor.m_SyncData.m_Target.m_Height)
+		if (id.m_Height)
 		{
-			// fast-sync mode, diluted blocks request.
-			msg.m_Top.m_Height = m_Processor.m_SyncData.m_Target.m_Height;
-			if (m_Processor.IsFastSync())
-				m_Processor.get_DB().get_StateHash(m_Processor.m_SyncData.m_Target.m_Row, msg.m_Top.m_Hash);
-			else
-				msg.m_Top.m_Hash = Zero; // treasury
+			bool bFastSync = (id.m_Height <= m_Processor.m_SyncData.m_Target.m_Height);
+
+			NodeDB::StateID sidTop = bFastSync ? m_Processor.m_SyncData.m_Target : t.m_sidTrg;
+			assert(sidTop.m_Height >= id.m_Height);
+
+			// adjust the range wrt peer bandwidth, and don't overlap the next requested range
+			Height hTop = id.m_Height + p.get_BodyPackCount() - 1;
+
+			for (TaskSet::iterator it = m_setTasks.upper_bound(t); m_setTasks.end() != it; it++)
+			{
+				const Task& t2 = *it;
+				if (t2.m_Key.second && !t2.m_bReissued && (t2.m_Key.first.m_Height > id.m_Height))
+				{
+					std::setmin(hTop, t2.m_Key.first.m_Height - 1);
+					break;
+				}
+			}
+
+			if (hTop < sidTop.m_Height)
+			{
+				const uint64_t* pRows = m_Processor.FindCachedRows(t.m_sidTrg, t.m_sidTrg.m_Height - id.m_Height);
+				if (pRows)
+				{
+					sidTop.m_Height = hTop;
+					sidTop.m_Row = pRows[t.m_sidTrg.m_Height - hTop];
+				}
+			}
+
+			msg.m_Top.m_Height = sidTop.m_Height;
+			m_Processor.get_DB().get_StateHash(sidTop.m_Row, msg.m_Top.m_Hash);
+			msg.m_CountExtra = sidTop.m_Height - id.m_Height;
+
+			if (bFastSync)
+			{
+				// fast-sync mode, diluted blocks request.
+				msg.m_Height0 = m_Processor.m_SyncData.m_h0;
+				msg.m_HorizonLo1 = m_Processor.m_SyncData.m_TxoLo;
+				msg.m_HorizonHi1 = m_Processor.m_SyncData.m_Target.m_Height;
+			}
 
-			msg.m_CountExtra = m_Processor.m_SyncData.m_Target.m_Height - t.m_Key.first.m_Height;
-			msg.m_Height0 = m_Processor.m_SyncData.m_h0;
-			msg.m_HorizonLo1 = m_Processor.m_SyncData.m_TxoLo;
-			msg.m_HorizonHi1 = m_Processor.m_SyncData.m_Target.m_Height;
+			m_BodySched.OnRequested(sidTop.m_Height, sidTop.m_Row);
 		}
 		else
-		{
-			// std blocks request
-			msg.m_Top.m_Height = t.m_sidTrg.m_Height;
-			m_Processor.get_DB().get_StateHash(t.m_sidTrg.m_Row, msg.m_Top.m_Hash);
-			msg.m_CountExtra = hCountExtra;
-		}
+			msg.m_Top.m_Hash = Zero; // treasury
 
 		p.Send(msg);
 
-		t.m_nCount = std::min(static_cast<uint32_t>(msg.m_CountExtra), m_Cfg.m_BandwidthCtl.m_MaxBodyPackCount) + 1; // just an estimate, the actual num of blocks can be smaller
+		t.m_nCount = static_cast<uint32_t>(msg.m_CountExtra) + 1;
 		m_nTasksPackBody += t.m_nCount;
 	}
 	else
@@ -476,41 +504,232 @@ void Node::Peer::SetTimerWrtFirstTask()
 
 void Node::Processor::RequestData(const Block::SystemState::ID& id, bool bBlock, const NodeDB::StateID& sidTrg)
 {
-	Node::Task tKey;
-    tKey.m_Key.first = id;
-    tKey.m_Key.second = bBlock;
+	Node::Task::Key key;
+	key.first = id;
+	key.second = bBlock;
 
-    TaskSet::iterator it = get_ParentObj().m_setTasks.find(tKey);
-    if (get_ParentObj().m_setTasks.end() == it)
-    {
-        LOG_INFO() << "Requesting " << (bBlock ? "block" : "header") << " " << id;
+	Node::Task& t = get_ParentObj().RequestTask(key, sidTrg);
 
-		Node::Task* pTask = new Node::Task;
-        pTask->m_Key = tKey.m_Key;
-        pTask->m_sidTrg = sidTrg;
+	if (!t.m_pOwner)
+	{
+		if (t.m_sidTrg.m_Height < sidTrg.m_Height)
+			t.m_sidTrg = sidTrg;
+
+		get_ParentObj().TryAssignTask(t);
+	}
+
+	if (bBlock && id.m_Height)
+		get_ParentObj().ScheduleBodies(id.m_Height, sidTrg);
+}
+
+Node::Task* Node::FindTask(const Task::Key& key)
+{
+	Task tKey;
+	tKey.m_Key = key;
+
+	// skip the stalled duplicates
+	for (TaskSet::iterator it = m_setTasks.lower_bound(tKey); (m_setTasks.end() != it) && (it->m_Key == key); it++)
+		if (!it->m_bReissued)
+			return &(*it);
+
+	return nullptr;
+}
+
+Node::Task& Node::RequestTask(const Task::Key& key, const NodeDB::StateID& sidTrg)
+{
+	Task* pTask = FindTask(key);
+	if (pTask)
 		pTask->m_bNeeded = true;
-        pTask->m_nCount = 0;
-        pTask->m_pOwner = NULL;
+	else
+	{
+		LOG_INFO() << "Requesting " << (key.second ? "block" : "header") << " " << key.first;
 
-        get_ParentObj().m_setTasks.insert(*pTask);
-        get_ParentObj().m_lstTasksUnassigned.push_back(*pTask);
+		pTask = new Task;
+		pTask->m_Key = key;
+		pTask->m_sidTrg = sidTrg;
+		pTask->m_bNeeded = true;
+		pTask->m_bReissued = false;
+		pTask->m_nCount = 0;
+		pTask->m_pOwner = NULL;
 
-        get_ParentObj().TryAssignTask(*pTask);
+		m_setTasks.insert(*pTask);
+		m_lstTasksUnassigned.push_back(*pTask);
+	}
+
+	return *pTask;
+}
 
+void Node::BodySched::OnRequested(Height h, uint64_t row)
+{
+	if (h > m_hTop)
+	{
+		m_hTop = h;
+		m_rowTop = row;
 	}
-	else
+}
+
+void Node::BodySched::OnReceived(size_t nSize, size_t nCount)
+{
+	assert(nCount);
+	uint32_t nAvg = static_cast<uint32_t>(nSize / nCount);
+
+	m_AvgBodySize = (m_AvgBodySize * 7 + nAvg) / 8;
+	std::setmax(m_AvgBodySize, 1U);
+}
+
+void Node::ScheduleBodies(Height hLow, const NodeDB::StateID& sidTrg)
+{
+	// Request the ranges above the lowest missing block in parallel from other peers.
+	// The distance is bounded, so that the out-of-order blocks don't accumulate indefinitely.
+	assert(sidTrg.m_Height >= hLow);
+
+	Height hMax = std::min(sidTrg.m_Height, hLow + std::max<Height>(m_Cfg.m_BandwidthCtl.m_MaxBodiesAhead, 1) - 1);
+
+	if (!m_BodySched.m_bTimerRunning)
+	{
+		if (!m_BodySched.m_pTimer)
+			m_BodySched.m_pTimer = io::Timer::create(io::Reactor::get_Current());
+
+		m_BodySched.m_pTimer->start(1000, true, [this]() { CheckBodiesStall(); });
+		m_BodySched.m_bTimerRunning = true;
+	}
+
+	const uint64_t* pRows = m_Processor.FindCachedRows(sidTrg, sidTrg.m_Height - hLow);
+	if (!pRows)
+		return;
+
+	NodeDB& db = m_Processor.get_DB();
+
+	// keep the pending ranges of this branch
+	for (TaskSet::iterator it = m_setTasks.begin(); m_setTasks.end() != it; it++)
+	{
+		Task& t = *it;
+		const Block::SystemState::ID& id = t.m_Key.first;
+		if (!t.m_Key.second || t.m_bReissued || (id.m_Height <= hLow) || (id.m_Height > hMax))
+			continue;
+
+		Merkle::Hash hv;
+		db.get_StateHash(pRows[sidTrg.m_Height - id.m_Height], hv);
+		if (hv == id.m_Hash)
+			t.m_bNeeded = true;
+	}
+
+	if ((m_BodySched.m_hTop < hLow) || (m_BodySched.m_hTop > sidTrg.m_Height) || (pRows[sidTrg.m_Height - m_BodySched.m_hTop] != m_BodySched.m_rowTop))
 	{
-		Node::Task& t = *it;
-		t.m_bNeeded = true;
+		// the highest requested range is obsolete, or on a different branch. Will be reset on the next request
+		m_BodySched.m_hTop = 0;
+		return;
+	}
+
+	for (Height h = m_BodySched.m_hTop + 1; h <= hMax; h = m_BodySched.m_hTop + 1)
+	{
+		NodeDB::StateID sid;
+		sid.m_Height = h;
+		sid.m_Row = pRows[sidTrg.m_Height - h];
+
+		if (NodeDB::StateFlags::Functional & db.GetStateFlags(sid.m_Row))
+		{
+			m_BodySched.OnRequested(sid.m_Height, sid.m_Row); // already have it
+			continue;
+		}
+
+		Task::Key key;
+		db.get_StateID(sid, key.first);
+		key.second = true;
 
+		Task& t = RequestTask(key, sidTrg);
 		if (!t.m_pOwner)
 		{
-			if (t.m_sidTrg.m_Height < sidTrg.m_Height)
-				t.m_sidTrg = sidTrg;
+			TryAssignTask(t);
+			if (!t.m_pOwner)
+				break; // no available peers
+		}
 
-			get_ParentObj().TryAssignTask(t);
+		if (m_BodySched.m_hTop < h)
+			break; // should not happen
+	}
+}
+
+void Node::CheckBodiesStall()
+{
+	// Find the lowest requested range. If it's delayed w.r.t. its owner bandwidth - re-request it from a faster peer
+	Task* pTask = nullptr;
+	for (TaskSet::iterator it = m_setTasks.begin(); m_setTasks.end() != it; it++)
+	{
+		Task& t = *it;
+		if (t.m_Key.second && !t.m_bReissued && t.m_Key.first.m_Height)
+		{
+			pTask = &t;
+			break;
 		}
 	}
+
+	if (!pTask)
+	{
+		// nothing is downloaded, restarted by the next request
+		m_BodySched.m_pTimer->cancel();
+		m_BodySched.m_bTimerRunning = false;
+		return;
+	}
+
+	if (!pTask->m_pOwner || !pTask->m_bNeeded)
+		return;
+
+	Peer& p0 = *pTask->m_pOwner;
+	uint32_t bps0 = p0.get_Bps();
+
+	// expected time, including the requests queued before it
+	uint64_t nSize = 0;
+	for (TaskList::iterator it = p0.m_lstTasks.begin(); p0.m_lstTasks.end() != it; it++)
+	{
+		nSize += static_cast<uint64_t>(it->m_nCount) * m_BodySched.m_AvgBodySize;
+		if (&(*it) == pTask)
+			break;
+	}
+
+	uint64_t nExpected_ms = p0.m_Rtt_ms + nSize * 1000 / std::max(bps0, 1U);
+	std::setmax(nExpected_ms, static_cast<uint64_t>(m_Cfg.m_BandwidthCtl.m_BodyPackDuration_ms));
+
+	PeerManager::TimePoint tp;
+	uint32_t dt_ms = tp.get() - pTask->m_TimeAssigned_ms;
+	if (dt_ms <= nExpected_ms * m_Cfg.m_BandwidthCtl.m_BodyStallFactor)
+		return;
+
+	// the rating of the owner doesn't reflect the stall yet, compare with its actual rate (as if the range arrived now)
+	std::setmin(bps0, static_cast<uint32_t>(std::min<uint64_t>(nSize * 1000 / dt_ms, static_cast<uint32_t>(-1))));
+
+	Task* pDup = new Task;
+	pDup->m_Key = pTask->m_Key;
+	pDup->m_sidTrg = pTask->m_sidTrg;
+	pDup->m_bNeeded = true;
+	pDup->m_bReissued = false;
+	pDup->m_nCount = 0;
+	pDup->m_pOwner = NULL;
+
+	// hide the original before assigning, otherwise the dup range would be clamped by it
+	pTask->m_bReissued = true;
+
+	m_setTasks.insert(*pDup);
+	m_lstTasksUnassigned.push_back(*pDup);
+
+	for (PeerMan::LiveSet::iterator it = m_PeerMan.m_LiveSet.begin(); m_PeerMan.m_LiveSet.end() != it; it++)
+	{
+		Peer& p = *it->m_p;
+		if ((&p == &p0) || (p.get_Bps() <= bps0))
+			continue;
+
+		if (TryAssignTask(*pDup, p))
+		{
+			LOG_INFO() << pTask->m_Key.first << " Block pack stalled on " << p0.m_RemoteAddr << ", re-requested from " << p.m_RemoteAddr;
+
+			m_BodySched.m_Reissued++;
+			pTask->m_bNeeded = false; // will be discarded once complete
+			return;
+		}
+	}
+
+	pTask->m_bReissued = false;
+	DeleteUnassignedTask(*pDup);
 }
 
 void Node::Processor::OnPeerInsane(const PeerID& peerID)
@@ -565,6 +784,7 @@ void Node::Processor::DeleteOutdated()
 void Node::Processor::OnNewState()
 {
     m_Cwp.Reset();
+    m_CwpCache.m_Cropped.Reset();
 
 	if (!IsTreasuryHandled())
         return;
@@ -615,18 +835,47 @@ void Node::Processor::OnNewState()
 	get_ParentObj().MaybeGenerateRecovery();
 }
 
+// shielded in/outs, as written in the recovery info
+template <typename TSer>
+struct RecoveryShieldedWalker
+    :public NodeProcessor::KrnWalkerShielded
+{
+    TSer& m_Ser;
+    RecoveryShieldedWalker(TSer& ser) :m_Ser(ser) {}
+
+    virtual bool OnKrnEx(const TxKernelShieldedInput& krn) override
+    {
+        m_Ser & m_Height;
+        m_Ser & false;
+        m_Ser & krn.m_SpendProof.m_SpendPk;
+        return true;
+    }
+
+    virtual bool OnKrnEx(const TxKernelShieldedOutput& krn) override
+    {
+        Cast::NotConst(krn).m_Txo.m_pAsset.reset(); // not needed for recovery atm
+
+        m_Ser & m_Height;
+        m_Ser & true;
+        m_Ser & krn.m_Txo;
+        m_Ser & krn.m_Msg;
+        return true;
+    }
+};
+
 void Node::MaybeGenerateRecovery()
 {
 	if (!m_PostStartSynced || m_Cfg.m_Recovery.m_sPathOutput.empty() || !m_Cfg.m_Recovery.m_Granularity)
 		return;
 
+	if (m_RecoveryGen.IsInProgress())
+		return;
+
 	Height h0 = m_Processor.get_DB().ParamIntGetDef(NodeDB::ParamID::LastRecoveryHeight);
 	const Height& h1 = m_Processor.m_Cursor.m_ID.m_Height; // alias
 	if (h1 < h0 + m_Cfg.m_Recovery.m_Granularity)
 		return;
 
-	LOG_INFO() << "Generating recovery...";
-
 	std::ostringstream os;
 	os
 		<< m_Cfg.m_Recovery.m_sPathOutput
@@ -637,23 +886,24 @@ void Node::MaybeGenerateRecovery()
 	std::string sTmp = sPath;
 	sTmp += ".tmp";
 
-	bool bOk = GenerateRecoveryInfo(sTmp.c_str());
-	if (bOk)
+	if (m_RecoveryGen.Start(sPath, sTmp))
 	{
-#ifdef WIN32
-		bOk =
-			MoveFileExW(Utf8toUtf16(sTmp.c_str()).c_str(), Utf8toUtf16(sPath.c_str()).c_str(), MOVEFILE_REPLACE_EXISTING) ||
-			(GetLastError() == ERROR_FILE_NOT_FOUND);
-#else // WIN32
-		bOk =
-			!rename(sTmp.c_str(), sPath.c_str()) ||
-			(ENOENT == errno);
-#endif // WIN32
+		LOG_INFO() << "Generating recovery from " << m_RecoveryGen.m_idBase << "...";
+		return;
 	}
 
+	LOG_INFO() << "Generating recovery...";
+
+	bool bOk =
+		GenerateRecoveryInfo(sTmp.c_str()) &&
+		RecoveryGen::Commit(sPath, sTmp);
+
 	if (bOk) {
 		LOG_INFO() << "Recovery generation done";
 		m_Processor.get_DB().ParamIntSet(NodeDB::ParamID::LastRecoveryHeight, h1);
+
+		m_RecoveryGen.m_sPathBase = sPath;
+		m_RecoveryGen.m_idBase = m_Processor.m_Cursor.m_ID;
 	} else
 	{
 		LOG_INFO() << "Recovery generation failed";
@@ -661,10 +911,157 @@ void Node::MaybeGenerateRecovery()
 	}
 }
 
+bool Node::RecoveryGen::Commit(const std::string& sPath, const std::string& sTmp)
+{
+#ifdef WIN32
+	return
+		MoveFileExW(Utf8toUtf16(sTmp.c_str()).c_str(), Utf8toUtf16(sPath.c_str()).c_str(), MOVEFILE_REPLACE_EXISTING) ||
+		(GetLastError() == ERROR_FILE_NOT_FOUND);
+#else // WIN32
+	return
+		!rename(sTmp.c_str(), sPath.c_str()) ||
+		(ENOENT == errno);
+#endif // WIN32
+}
+
+bool Node::RecoveryGen::Start(const std::string& sPath, const std::string& sTmp)
+{
+	if (m_sPathBase.empty())
+		return false;
+
+	Processor& p = get_ParentObj().m_Processor;
+	Height hTip = p.m_Cursor.m_ID.m_Height;
+	if (hTip <= m_idBase.m_Height)
+		return false;
+
+	// the base must still belong to the current branch
+	NodeDB::StateID sid;
+	sid.m_Row = p.FindActiveAtStrict(m_idBase.m_Height);
+
+	Merkle::Hash hv;
+	p.get_DB().get_StateHash(sid.m_Row, hv);
+	if (hv != m_idBase.m_Hash)
+	{
+		m_sPathBase.clear();
+		return false;
+	}
+
+	if (!p.BuildCwp())
+		return false;
+
+	std::unique_ptr<Job> pJob = std::make_unique<Job>();
+	RecoveryInfo::Delta& d = pJob->m_Delta;
+
+	for (sid.m_Height = m_idBase.m_Height + 1; sid.m_Height <= hTip; sid.m_Height++)
+	{
+		sid.m_Row = p.FindActiveAtStrict(sid.m_Height);
+
+		Block::Body block;
+		if (!p.ExtractBlockWithExtra(block, sid))
+		{
+			m_sPathBase.clear();
+			return false;
+		}
+
+		for (size_t i = 0; i < block.m_vOutputs.size(); i++)
+			d.AddUtxo(sid.m_Height, std::move(block.m_vOutputs[i]));
+
+		for (size_t i = 0; i < block.m_vInputs.size(); i++)
+		{
+			const Input& inp = *block.m_vInputs[i];
+			d.AddSpent(inp.m_Commitment, inp.m_Internal.m_Maturity);
+		}
+	}
+
+	Height hFork2 = Rules::get().pForks[2].m_Height;
+	if (hTip >= hFork2)
+	{
+		Serializer ser;
+		RecoveryShieldedWalker<Serializer> wlk(ser);
+		p.EnumKernels(wlk, HeightRange(std::max(m_idBase.m_Height + 1, hFork2), hTip));
+		ser.swap_buf(d.m_Shielded);
+
+		Asset::Full ai;
+		ai.m_ID = 0;
+
+		while (p.get_DB().AssetGetNext(ai))
+			d.m_vAssets.push_back(ai);
+	}
+
+	pJob->m_Cwp = p.m_Cwp;
+	pJob->m_ID = p.m_Cursor.m_ID;
+	pJob->m_sBase = m_sPathBase;
+	pJob->m_sPath = sPath;
+	pJob->m_sTmp = sTmp;
+
+	if (!m_pEvt)
+		m_pEvt = io::AsyncEvent::create(io::Reactor::get_Current(), [this]() { OnDone(); });
+
+	m_pJob = std::move(pJob);
+
+	m_Thread = std::thread([this]()
+	{
+		Job& job = *m_pJob;
+
+		try {
+			job.m_Ok =
+				job.m_Delta.Merge(job.m_sBase.c_str(), job.m_sTmp.c_str(), job.m_Cwp) &&
+				Commit(job.m_sPath, job.m_sTmp);
+		}
+		catch (const std::exception& e) {
+			LOG_WARNING() << "Incremental recovery generation failed: " << e.what();
+		}
+
+		m_pEvt->post();
+	});
+
+	return true;
+}
+
+void Node::RecoveryGen::OnDone()
+{
+	if (!m_pJob)
+		return;
+
+	if (m_Thread.joinable())
+		m_Thread.join();
+
+	std::unique_ptr<Job> pJob = std::move(m_pJob);
+
+	if (pJob->m_Ok)
+	{
+		LOG_INFO() << "Recovery generation done";
+
+		m_sPathBase = pJob->m_sPath;
+		m_idBase = pJob->m_ID;
+
+		get_ParentObj().m_Processor.get_DB().ParamIntSet(NodeDB::ParamID::LastRecoveryHeight, pJob->m_ID.m_Height);
+	}
+	else
+	{
+		LOG_INFO() << "Recovery generation failed";
+		beam::DeleteFile(pJob->m_sTmp.c_str());
+		m_sPathBase.clear(); // next time from scratch
+	}
+}
+
+void Node::RecoveryGen::Stop()
+{
+	if (m_Thread.joinable())
+		m_Thread.join();
+
+	m_pJob.reset();
+}
+
 void Node::Processor::OnRolledBack()
 {
     LOG_INFO() << "Rolled back to: " << m_Cursor.m_ID;
 
+	// cached bodies may reference outputs whose spend status was reverted
+	get_ParentObj().m_BodyCache.Clear();
+
+	m_CwpCache.OnRolledBack(m_Cursor.m_Full.m_Height);
+
 	// Delete shielded txs which referenced shielded outputs which were reverted
 	TxPool::Fluff& txp = get_ParentObj().m_TxPool;
 	for (TxPool::Fluff::Queue::iterator it = txp.m_Queue.begin(); txp.m_Queue.end() != it; )
@@ -759,6 +1156,11 @@ void Node::Processor::Stop()
     {
         m_pFlushTimer->cancel();
     }
+
+    if (m_pBackupTimer)
+    {
+        m_pBackupTimer->cancel();
+    }
 }
 
 Key::IPKdf* Node::Processor::get_ViewerKey()
@@ -806,12 +1208,37 @@ void Node::Processor::InitializeUtxosProgress(uint64_t done, uint64_t total)
         node.m_Cfg.m_Observer->InitializeUtxosProgress(done, total);   
 }
 
+void Node::Processor::RescanOwnedTxosProgress(uint64_t done, uint64_t total)
+{
+    auto& node = get_ParentObj();
+
+    if (node.m_Cfg.m_Observer)
+        node.m_Cfg.m_Observer->RescanOwnedTxosProgress(done, total);
+}
+
 void Node::Processor::OnFlushTimer()
 {
     m_bFlushPending = false;
     CommitDB();
 }
 
+void Node::Processor::StartBackup(const char* sz)
+{
+    BackupStart(sz);
+
+    // commits are made on each modification, but the node may be idle
+    if (!m_pBackupTimer)
+        m_pBackupTimer = io::Timer::create(io::Reactor::get_Current());
+
+    m_pBackupTimer->start(get_ParentObj().m_Cfg.m_Timeout.m_BackupStep_ms, true, [this]() { CommitDB(); });
+}
+
+void Node::Processor::OnBackupOver(bool bSuccess)
+{
+    if (m_pBackupTimer)
+        m_pBackupTimer->cancel();
+}
+
 void Node::Processor::FlushDB()
 {
     if (m_bFlushPending)
@@ -829,6 +1256,7 @@ Node::Peer* Node::AllocPeer(const beam::io::Address& addr)
     m_lstPeers.push_back(*pPeer);
 
 	pPeer->m_UnsentHiMark = m_Cfg.m_BandwidthCtl.m_Drown;
+	pPeer->m_Compression.m_Threshold = m_Cfg.m_BandwidthCtl.m_CompressThreshold;
     pPeer->m_pInfo = NULL;
     pPeer->m_Flags = 0;
     pPeer->m_Port = 0;
@@ -898,9 +1326,7 @@ void Node::Initialize(IExternalPOW* externalPOW)
 
     m_PeerMan.Initialize();
     m_Miner.Initialize(externalPOW);
-	m_Processor.get_DB().get_BbsTotals(m_Bbs.m_Totals);
-    m_Bbs.Cleanup();
-	m_Bbs.m_HighestPosted_s = m_Processor.get_DB().get_BbsMaxTime();
+	m_Bbs.Initialize();
 }
 
 uint32_t Node::get_AcessiblePeerCount() const
@@ -1014,13 +1440,64 @@ bool Node::Bbs::IsInLimits() const
 		(m_Totals.m_Size <= lims.m_Size);
 }
 
-void Node::Bbs::Cleanup()
+void Node::Bbs::Initialize()
 {
+	const Config::Bbs& cfg = get_ParentObj().m_Cfg.m_Bbs;
 	NodeDB& db = get_ParentObj().m_Processor.get_DB();
-	NodeDB::WalkerBbsTimeLen wlk;
 
+	if (cfg.m_InMemory)
+	{
+		m_pMem = std::make_unique<BbsMemStore>();
+		m_pMem->m_BucketDuration_s = std::max(cfg.m_BucketDuration_s, 1U);
+
+		ZeroObject(m_Totals);
+		m_HighestPosted_s = 0;
+		return;
+	}
+
+	db.get_BbsTotals(m_Totals);
+	Cleanup();
+	m_HighestPosted_s = db.get_BbsMaxTime();
+}
+
+bool Node::Bbs::Find(const NodeDB::WalkerBbs::Key& key)
+{
+	if (m_pMem)
+		return !!m_pMem->Find(key);
+
+	return !!get_ParentObj().m_Processor.get_DB().BbsFind(key);
+}
+
+uint64_t Node::Bbs::Insert(const NodeDB::WalkerBbs::Data& d)
+{
+	if (m_pMem)
+		return m_pMem->Insert(d);
+
+	return get_ParentObj().m_Processor.get_DB().BbsIns(d);
+}
+
+uint64_t Node::Bbs::FindCursor(Timestamp t)
+{
+	if (m_pMem)
+		return m_pMem->FindCursor(t);
+
+	return get_ParentObj().m_Processor.get_DB().BbsFindCursor(t);
+}
+
+void Node::Bbs::Cleanup()
+{
 	Timestamp ts = getTimestamp() - get_ParentObj().m_Cfg.m_Bbs.m_MessageTimeout_s;
 
+	if (m_pMem)
+	{
+		m_pMem->Cleanup(m_Totals, ts, get_ParentObj().m_Cfg.m_Bbs.m_Limit);
+		m_LastCleanup_ms = GetTime_ms();
+		return;
+	}
+
+	NodeDB& db = get_ParentObj().m_Processor.get_DB();
+	NodeDB::WalkerBbsTimeLen wlk;
+
 	for (db.EnumAllBbs(wlk); wlk.MoveNext(); )
 	{
 		if (IsInLimits() && (wlk.m_Time >= ts))
@@ -1166,6 +1643,8 @@ void Node::Peer::SetupLogin(proto::Login& msg)
 
 	if (m_This.m_Cfg.m_Bbs.IsEnabled())
 		msg.m_Flags |= proto::LoginFlags::Bbs; // indicate ability to receive and broadcast BBS messages
+
+	msg.m_Flags |= proto::LoginFlags::ProofsBatch;
 }
 
 Height Node::Peer::get_MinPeerFork()
@@ -1585,9 +2064,14 @@ void Node::Peer::ModifyRatingWrtData(size_t nSize)
 	uint64_t tTotal_ms = static_cast<uint64_t>(t0_ms) + dt_ms;
 	assert(tTotal_ms); // can't overflow
 
-	uint32_t bw0 = PeerManager::Rating::ToBps(m_pInfo->m_RawRating.m_Value);
+	uint32_t bw0 = get_Bps();
 	uint64_t v = static_cast<uint64_t>(bw0) * t0_s + nSize;
 
+	// whatever exceeds the transfer time (wrt the previous bandwidth) is accounted as latency
+	uint64_t tTransfer_ms = static_cast<uint64_t>(nSize) * 1000 / std::max(bw0, 1U);
+	uint32_t dtLatency_ms = (dt_ms > tTransfer_ms) ? static_cast<uint32_t>(dt_ms - tTransfer_ms) : 0;
+	m_Rtt_ms = m_Rtt_ms ? ((m_Rtt_ms * 3 + dtLatency_ms) / 4) : dtLatency_ms;
+
 	uint32_t bwAvg = static_cast<uint32_t>(v * 1000 / tTotal_ms);
 
 	uint32_t nRatingAvg = PeerManager::Rating::FromBps(bwAvg);
@@ -1597,6 +2081,26 @@ void Node::Peer::ModifyRatingWrtData(size_t nSize)
 	m_This.m_PeerMan.m_LiveSet.insert(Cast::Up<PeerMan::PeerInfoPlus>(m_pInfo)->m_Live);
 }
 
+uint32_t Node::Peer::get_Bps() const
+{
+	return PeerManager::Rating::ToBps(m_pInfo->m_RawRating.m_Value);
+}
+
+uint32_t Node::Peer::get_BodyPackCount() const
+{
+	const Config::BandwidthCtl& bwc = m_This.m_Cfg.m_BandwidthCtl;
+	uint32_t nAvg = m_This.m_BodySched.m_AvgBodySize;
+
+	// blocks that would be transferred within the desired time, and fit the max pack size (assuming it's the same for the remote)
+	uint64_t nSize = static_cast<uint64_t>(get_Bps()) * bwc.m_BodyPackDuration_ms / 1000;
+	std::setmin(nSize, static_cast<uint64_t>(bwc.m_MaxBodyPackSize));
+
+	uint64_t nCount = nSize / nAvg;
+	std::setmin(nCount, static_cast<uint64_t>(bwc.m_MaxBodyPackCount));
+
+	return std::max(static_cast<uint32_t>(nCount), 1U);
+}
+
 void Node::Peer::OnMsg(proto::DataMissing&&)
 {
     Task& t = get_FirstTask();
@@ -1769,6 +2273,9 @@ void Node::Peer::OnMsg(proto::GetBodyPack&& msg)
 {
 	Processor& p = m_This.m_Processor; // alias
 
+	if (msg.m_Top.m_Height && m_This.m_Cfg.m_TestMode.m_IgnoreBodyRequests)
+		return;
+
     if (msg.m_Top.m_Height)
     {
 		NodeDB::StateID sid;
@@ -1842,6 +2349,35 @@ void Node::Peer::OnMsg(proto::GetBodyPack&& msg)
 }
 
 bool Node::Peer::GetBlock(proto::BodyBuffers& out, const NodeDB::StateID& sid, const proto::GetBodyPack& msg, bool bActive)
+{
+	size_t nMaxSize = m_This.m_Cfg.m_BandwidthCtl.m_BodyCacheSize;
+	if (!nMaxSize)
+		return GetBlockRaw(out, sid, msg, bActive);
+
+	// The perishable part depends on the spend heights of the block outputs. It's immutable only if all the spends that may affect it are already in the past.
+	// The eternal part (kernels) never changes.
+	if ((proto::BodyBuffers::None != msg.m_FlagP) && (std::max(msg.m_HorizonHi1, sid.m_Height) > m_This.m_Processor.m_Cursor.m_ID.m_Height))
+		return GetBlockRaw(out, sid, msg, bActive);
+
+	BodyCache::Key key;
+	key.m_Row = sid.m_Row;
+	key.m_Height0 = msg.m_Height0;
+	key.m_HorizonLo1 = msg.m_HorizonLo1;
+	key.m_HorizonHi1 = msg.m_HorizonHi1;
+	key.m_FlagP = msg.m_FlagP;
+	key.m_FlagE = msg.m_FlagE;
+
+	if (m_This.m_BodyCache.Find(out, key))
+		return true;
+
+	if (!GetBlockRaw(out, sid, msg, bActive))
+		return false;
+
+	m_This.m_BodyCache.Insert(out, key, nMaxSize);
+	return true;
+}
+
+bool Node::Peer::GetBlockRaw(proto::BodyBuffers& out, const NodeDB::StateID& sid, const proto::GetBodyPack& msg, bool bActive)
 {
 	ByteBuffer* pP = nullptr;
 	ByteBuffer* pE = nullptr;
@@ -1894,6 +2430,74 @@ bool Node::Peer::GetBlock(proto::BodyBuffers& out, const NodeDB::StateID& sid, c
 	return true;
 }
 
+bool Node::BodyCache::Key::operator < (const Key& x) const
+{
+	if (m_Row != x.m_Row)
+		return (m_Row < x.m_Row);
+	if (m_Height0 != x.m_Height0)
+		return (m_Height0 < x.m_Height0);
+	if (m_HorizonLo1 != x.m_HorizonLo1)
+		return (m_HorizonLo1 < x.m_HorizonLo1);
+	if (m_HorizonHi1 != x.m_HorizonHi1)
+		return (m_HorizonHi1 < x.m_HorizonHi1);
+	if (m_FlagP != x.m_FlagP)
+		return (m_FlagP < x.m_FlagP);
+	return (m_FlagE < x.m_FlagE);
+}
+
+bool Node::BodyCache::Find(proto::BodyBuffers& out, const Key& key)
+{
+	Item n;
+	n.m_Key = key;
+
+	Set::iterator it = m_set.find(n);
+	if (m_set.end() == it)
+		return false;
+
+	Item& x = *it;
+	out = x.m_Body;
+
+	// move to the most recently used position
+	m_lst.erase(List::s_iterator_to(x));
+	m_lst.push_back(x);
+
+	return true;
+}
+
+void Node::BodyCache::Insert(const proto::BodyBuffers& body, const Key& key, size_t nMaxSize)
+{
+	size_t nSize = body.m_Eternal.size() + body.m_Perishable.size();
+	if (nSize > nMaxSize)
+		return;
+
+	while (!m_lst.empty() && (m_Size + nSize > nMaxSize))
+		Delete(m_lst.front());
+
+	Item* p = new Item;
+	p->m_Key = key;
+	p->m_Body = body;
+
+	m_set.insert(*p);
+	m_lst.push_back(*p);
+	m_Size += nSize;
+}
+
+void Node::BodyCache::Delete(Item& x)
+{
+	assert(m_Size >= x.get_Size());
+	m_Size -= x.get_Size();
+
+	m_lst.erase(List::s_iterator_to(x));
+	m_set.erase(Set::s_iterator_to(x));
+	delete &x;
+}
+
+void Node::BodyCache::Clear()
+{
+	while (!m_lst.empty())
+		Delete(m_lst.back());
+}
+
 void Node::Peer::OnMsg(proto::Body&& msg)
 {
 	Task& t = get_FirstTask();
@@ -1916,8 +2520,9 @@ void Node::Peer::OnMsg(proto::Body&& msg)
 	OnFirstTaskDone(eStatus);
 }
 
-void Node::Peer::OnMsg(proto::BodyPack&& msg)
+bool Node::Peer::OnBodyPack(proto::BodyPackReader& r)
 {
+	// The bodies are parsed one-by-one directly from the msg buffer, and stored as-is. No intermediate copies
 	Task& t = get_FirstTask();
 
 	if (!t.m_Key.second || !t.m_nCount)
@@ -1929,48 +2534,72 @@ void Node::Peer::OnMsg(proto::BodyPack&& msg)
 	assert(t.m_sidTrg.m_Height >= id.m_Height);
 	Height hCountExtra = t.m_sidTrg.m_Height - id.m_Height;
 
-	if (msg.m_Bodies.size() > hCountExtra + 1)
+	const uint32_t nCount = r.m_Remaining;
+	if (nCount > t.m_nCount)
 		ThrowUnexpected();
 
-	size_t nSize = 0;
-	for (size_t i = 0; i < msg.m_Bodies.size(); i++)
-	{
-		nSize +=
-			msg.m_Bodies[i].m_Eternal.size() +
-			msg.m_Bodies[i].m_Perishable.size();
-	}
-	ModifyRatingWrtData(nSize);
+	ModifyRatingWrtData(r.m_Size);
 
 	NodeProcessor::DataStatus::Enum eStatus = NodeProcessor::DataStatus::Rejected;
-	if (!msg.m_Bodies.empty())
+	if (nCount)
 	{
 		const uint64_t* pPtr = p.get_CachedRows(t.m_sidTrg, hCountExtra);
 		if (pPtr)
 		{
-			LOG_INFO() << id << " Block pack received " << id.m_Height << "-" << (id.m_Height + msg.m_Bodies.size() - 1);
+			LOG_INFO() << id << " Block pack received " << id.m_Height << "-" << (id.m_Height + nCount - 1);
 
 			eStatus = NodeProcessor::DataStatus::Accepted;
+			bool bInvalid = false;
+			size_t nSize = 0;
 
-			for (Height h = 0; h < msg.m_Bodies.size(); h++)
+			Blob bbP, bbE;
+			for (Height h = 0; r.MoveNext(bbP, bbE); h++)
 			{
 				NodeDB::StateID sid;
 				sid.m_Row = pPtr[hCountExtra - h];
 				sid.m_Height = id.m_Height + h;
 
-				const proto::BodyBuffers& bb = msg.m_Bodies[h];
+				nSize += size_t(bbP.n) + size_t(bbE.n);
 
-				NodeProcessor::DataStatus::Enum es2 = p.OnBlock(sid, bb.m_Perishable, bb.m_Eternal, m_pInfo->m_ID.m_Key);
+				NodeProcessor::DataStatus::Enum es2 = p.OnBlock(sid, bbP, bbE, m_pInfo->m_ID.m_Key);
 				if (NodeProcessor::DataStatus::Invalid == es2)
 				{
 					p.OnPeerInsane(m_pInfo->m_ID.m_Key);
+					bInvalid = true;
 					break;
 				}
 			}
+
+			if (!bInvalid)
+			{
+				r.TestEnd();
+				m_This.m_BodySched.OnReceived(nSize, nCount);
+			}
+
+			if (!bInvalid && t.m_bNeeded && (nCount < t.m_nCount))
+			{
+				// partial pack, the remainder may be above the lowest missing block, request it right away
+				NodeDB::StateID sid;
+				sid.m_Height = id.m_Height + nCount;
+				sid.m_Row = pPtr[hCountExtra - nCount];
+
+				if (!(NodeDB::StateFlags::Functional & p.get_DB().GetStateFlags(sid.m_Row)))
+				{
+					Task::Key key;
+					p.get_DB().get_StateID(sid, key.first);
+					key.second = true;
+
+					Task& t2 = m_This.RequestTask(key, t.m_sidTrg);
+					if (!t2.m_pOwner)
+						m_This.TryAssignTask(t2);
+				}
+			}
 		}
 	}
 
 	p.TryGoUpAsync();
 	OnFirstTaskDone(eStatus);
+	return true;
 }
 
 void Node::Peer::OnFirstTaskDone(NodeProcessor::DataStatus::Enum eStatus)
@@ -2695,6 +3324,26 @@ void Node::Peer::BroadcastBbs()
 
 	size_t nExtra = 0;
 
+	if (m_This.m_Bbs.m_pMem)
+	{
+		const BbsMemStore& mem = *m_This.m_Bbs.m_pMem;
+		for (auto it = mem.SeqFrom(m_CursorBbs); mem.SeqEnd() != it; it++)
+		{
+			const BbsMemStore::Msg& msg = it->get_ParentObj();
+			m_CursorBbs = msg.m_ID.m_Value;
+
+			proto::BbsHaveMsg msgOut;
+			msgOut.m_Key = msg.m_Key;
+			Send(msgOut);
+
+			nExtra += msg.m_Message.size();
+			if (IsChocking(nExtra))
+				break;
+		}
+
+		return;
+	}
+
 	NodeDB& db = m_This.m_Processor.get_DB();
 	NodeDB::WalkerBbsLite wlk;
 
@@ -2910,6 +3559,151 @@ void Node::Peer::OnMsg(proto::GetProofUtxo&& msg)
     Send(t.m_Msg);
 }
 
+void Node::Processor::GenerateProofStatesStrict(Merkle::MultiProof& proof, const std::vector<Block::SystemState::Full>& vStates)
+{
+    struct MyBuilder
+        :public Merkle::MultiProof::Builder
+    {
+        Processor& m_Proc;
+        MyBuilder(Merkle::MultiProof& x, Processor& p)
+            :Merkle::MultiProof::Builder(x)
+            ,m_Proc(p)
+        {
+        }
+
+        virtual void get_Proof(Merkle::IProofBuilder& bld, uint64_t i) override
+        {
+            m_Proc.m_Mmr.m_States.get_Proof(bld, i);
+        }
+
+    } bld(proof, *this);
+
+    for (size_t i = 0; i < vStates.size(); i++)
+    {
+        Height h = vStates[i].m_Height;
+        if (h == m_Cursor.m_Sid.m_Height)
+            break; // the tip is verified directly
+
+        assert(h < m_Cursor.m_Sid.m_Height);
+        bld.Add(m_Mmr.m_States.H2I(h));
+    }
+}
+
+void Node::Peer::OnMsg(proto::GetProofKernels&& msg)
+{
+    if (msg.m_IDs.size() > proto::g_ProofsBatchMax)
+        ThrowUnexpected();
+
+    proto::ProofKernels msgOut;
+
+    Processor& p = m_This.m_Processor;
+    if (!p.IsFastSync())
+    {
+        msgOut.m_Heights.resize(msg.m_IDs.size());
+
+        std::vector<Height> vHeights;
+        for (size_t i = 0; i < msg.m_IDs.size(); i++)
+        {
+            Merkle::Proof proof;
+            Height h = p.get_ProofKernel(proof, nullptr, msg.m_IDs[i]);
+            if (h < Rules::HeightGenesis)
+                continue;
+
+            msgOut.m_Heights[i] = h;
+            msgOut.m_Proofs.push_back(std::move(proof));
+            vHeights.push_back(h);
+        }
+
+        // all the found kernels share the proof of their states
+        std::sort(vHeights.begin(), vHeights.end());
+        vHeights.erase(std::unique(vHeights.begin(), vHeights.end()), vHeights.end());
+
+        msgOut.m_States.resize(vHeights.size());
+        for (size_t i = 0; i < vHeights.size(); i++)
+            p.get_DB().get_State(p.FindActiveAtStrict(vHeights[i]), msgOut.m_States[i]);
+
+        p.GenerateProofStatesStrict(msgOut.m_ProofStates, msgOut.m_States);
+
+        NodeProcessor::Evaluator ev(p);
+        ev.get_Live(msgOut.m_RootLive);
+    }
+
+    Send(msgOut);
+}
+
+void Node::Peer::OnMsg(proto::GetProofUtxos&& msg)
+{
+    if (msg.m_Utxos.size() > proto::g_ProofsBatchMax)
+        ThrowUnexpected();
+
+    struct Traveler :public UtxoTree::ITraveler
+    {
+        proto::ProofUtxos& m_Msg;
+        UtxoTree& m_Utxos;
+        uint32_t m_Count = 0;
+
+        virtual bool OnLeaf(const RadixTree::Leaf& x) override {
+
+            const UtxoTree::MyLeaf& v = Cast::Up<UtxoTree::MyLeaf>(x);
+            UtxoTree::Key::Data d;
+            d = v.m_Key;
+
+            Input::Proof& ret = m_Msg.m_Proofs.emplace_back();
+
+            ret.m_State.m_Count = v.get_Count();
+            ret.m_State.m_Maturity = d.m_Maturity;
+            m_Utxos.get_Proof(ret.m_Proof, *m_pCu); // up to the Utxos root only
+
+            return ++m_Count < Input::Proof::s_EntriesMax;
+        }
+
+        Traveler(proto::ProofUtxos& msg, UtxoTree& t) :m_Msg(msg), m_Utxos(t) {}
+    };
+
+    proto::ProofUtxos msgOut;
+
+    Processor& p = m_This.m_Processor;
+    if (!p.IsFastSync())
+    {
+        msgOut.m_Counts.resize(msg.m_Utxos.size());
+
+        for (size_t i = 0; i < msg.m_Utxos.size(); i++)
+        {
+            Traveler t(msgOut, p.get_Utxos());
+
+            UtxoTree::Cursor cu;
+            t.m_pCu = &cu;
+
+            UtxoTree::Key kMin, kMax;
+
+            UtxoTree::Key::Data d;
+            d.m_Commitment = msg.m_Utxos[i];
+            d.m_Maturity = 0;
+            kMin = d;
+            d.m_Maturity = Height(-1);
+            kMax = d;
+
+            t.m_pBound[0] = kMin.V.m_pData;
+            t.m_pBound[1] = kMax.V.m_pData;
+
+            p.get_Utxos().Traverse(t);
+            msgOut.m_Counts[i] = t.m_Count;
+        }
+
+        struct MyProofBuilder
+            :public NodeProcessor::ProofBuilder
+        {
+            using ProofBuilder::ProofBuilder;
+            virtual bool get_Utxos(Merkle::Hash&) override { return false; }
+        };
+
+        MyProofBuilder pb(p, msgOut.m_ProofLive);
+        pb.GenerateProof();
+    }
+
+    Send(msgOut);
+}
+
 void Node::Processor::GenerateProofShielded(Merkle::Proof& p, const uintBigFor<TxoID>::Type& mmrIdx)
 {
     TxoID nIdx;
@@ -3049,6 +3843,7 @@ bool Node::Processor::BuildCwp()
         :public Block::ChainWorkProof::ISource
     {
         Processor& m_Proc;
+        CwpCache::StateMap m_States; // sampled for this proof
 
         Source(Processor& proc)
             :m_Proc(proc)
@@ -3056,8 +3851,13 @@ bool Node::Processor::BuildCwp()
 
         virtual void get_StateAt(Block::SystemState::Full& s, const Difficulty::Raw& d) override
         {
-            uint64_t rowid = m_Proc.get_DB().FindStateWorkGreater(d);
-            m_Proc.get_DB().get_State(rowid, s);
+            if (!m_Proc.m_CwpCache.FindState(s, d))
+            {
+                uint64_t rowid = m_Proc.get_DB().FindStateWorkGreater(d);
+                m_Proc.get_DB().get_State(rowid, s);
+            }
+
+            m_States[s.m_ChainWork] = s;
         }
 
         virtual void get_Proof(Merkle::IProofBuilder& bld, Height h) override
@@ -3069,6 +3869,7 @@ bool Node::Processor::BuildCwp()
     Source src(*this);
 
     m_Cwp.Create(src, m_Cursor.m_Full);
+    m_CwpCache.m_States.swap(src.m_States);
 
     Evaluator ev(*this);
     ev.get_Live(m_Cwp.m_hvRootLive);
@@ -3076,6 +3877,36 @@ bool Node::Processor::BuildCwp()
     return true;
 }
 
+bool Node::Processor::CwpCache::FindState(Block::SystemState::Full& s, const Difficulty::Raw& d) const
+{
+    // the 1st state whose chainwork is greater than d
+    StateMap::const_iterator it = m_States.upper_bound(d);
+    if (m_States.end() == it)
+        return false;
+
+    // it's the one only if its predecessor doesn't exceed d
+    const Block::SystemState::Full& x = it->second;
+    Difficulty::Raw dPrev = x.m_ChainWork - x.m_PoW.m_Difficulty;
+    if (dPrev > d)
+        return false;
+
+    s = x;
+    return true;
+}
+
+void Node::Processor::CwpCache::OnRolledBack(Height h)
+{
+    m_Cropped.Reset();
+
+    for (StateMap::iterator it = m_States.begin(); m_States.end() != it; )
+    {
+        if (it->second.m_Height > h)
+            m_States.erase(it++);
+        else
+            it++;
+    }
+}
+
 void Node::Peer::OnMsg(proto::GetProofChainWork&& msg)
 {
     proto::ProofChainWork msgOut;
@@ -3083,8 +3914,15 @@ void Node::Peer::OnMsg(proto::GetProofChainWork&& msg)
     Processor& p = m_This.m_Processor;
     if (!p.IsFastSync() && p.BuildCwp())
     {
-        msgOut.m_Proof.m_LowerBound = msg.m_LowerBound;
-        BEAM_VERIFY(msgOut.m_Proof.Crop(p.m_Cwp));
+        Block::ChainWorkProof& cwpCropped = p.m_CwpCache.m_Cropped;
+        if (cwpCropped.IsEmpty() || (cwpCropped.m_LowerBound != msg.m_LowerBound))
+        {
+            cwpCropped.Reset();
+            cwpCropped.m_LowerBound = msg.m_LowerBound;
+            BEAM_VERIFY(cwpCropped.Crop(p.m_Cwp));
+        }
+
+        msgOut.m_Proof = cwpCropped;
     }
 
     Send(msgOut);
@@ -3137,7 +3975,6 @@ void Node::Peer::OnMsg(proto::BbsMsg&& msg)
     if (msg.m_TimePosted + Rules::get().DA.MaxAhead_s < m_This.m_Bbs.m_HighestPosted_s)
         return; // don't allow too much out-of-order messages
 
-    NodeDB& db = m_This.m_Processor.get_DB();
     NodeDB::WalkerBbs wlk;
 
     wlk.m_Data.m_Channel = msg.m_Channel;
@@ -3147,12 +3984,12 @@ void Node::Peer::OnMsg(proto::BbsMsg&& msg)
 
     Bbs::CalcMsgKey(wlk.m_Data);
 
-    if (db.BbsFind(wlk.m_Data.m_Key))
+    if (m_This.m_Bbs.Find(wlk.m_Data.m_Key))
         return; // already have it
 
     m_This.m_Bbs.MaybeCleanup();
 
-    uint64_t id = db.BbsIns(wlk.m_Data);
+    uint64_t id = m_This.m_Bbs.Insert(wlk.m_Data);
     m_This.m_Bbs.m_W.Delete(wlk.m_Data.m_Key);
 
 	std::setmax(m_This.m_Bbs.m_HighestPosted_s, msg.m_TimePosted);
@@ -3202,8 +4039,7 @@ void Node::Peer::OnMsg(proto::BbsHaveMsg&& msg)
     if (!m_This.m_Cfg.m_Bbs.IsEnabled())
 		ThrowUnexpected();
 
-    NodeDB& db = m_This.m_Processor.get_DB();
-	if (db.BbsFind(msg.m_Key)) {
+	if (m_This.m_Bbs.Find(msg.m_Key)) {
 		// stupid compiler insists on parentheses here!
 		return; // already have it
 	}
@@ -3223,6 +4059,18 @@ void Node::Peer::OnMsg(proto::BbsGetMsg&& msg)
 	if (!m_This.m_Cfg.m_Bbs.IsEnabled())
 		ThrowUnexpected();
 
+	if (m_This.m_Bbs.m_pMem)
+	{
+		const BbsMemStore::Msg* pMsg = m_This.m_Bbs.m_pMem->Find(msg.m_Key);
+		if (pMsg)
+		{
+			NodeDB::WalkerBbs::Data d;
+			pMsg->get_Data(d);
+			SendBbsMsg(d);
+		}
+		return;
+	}
+
 	NodeDB& db = m_This.m_Processor.get_DB();
     NodeDB::WalkerBbs wlk;
 
@@ -3265,7 +4113,7 @@ void Node::Peer::OnMsg(proto::BbsSubscribe&& msg)
         m_This.m_Bbs.m_Subscribed.insert(pS->m_Bbs);
         m_Subscriptions.insert(pS->m_Peer);
 
-		pS->m_Cursor = m_This.m_Processor.get_DB().BbsFindCursor(msg.m_TimeFrom) - 1;
+		pS->m_Cursor = m_This.m_Bbs.FindCursor(msg.m_TimeFrom) - 1;
 
 		BroadcastBbs(*pS);
     }
@@ -3278,6 +4126,26 @@ void Node::Peer::BroadcastBbs(Bbs::Subscription& s)
 	if (IsChocking())
 		return;
 
+	if (m_This.m_Bbs.m_pMem)
+	{
+		const BbsMemStore& mem = *m_This.m_Bbs.m_pMem;
+		for (auto it = mem.ChannelFrom(s.m_Peer.m_Channel, s.m_Cursor); mem.ChannelEnd() != it; it++)
+		{
+			if (it->m_Value != s.m_Peer.m_Channel)
+				break;
+
+			NodeDB::WalkerBbs::Data d;
+			it->get_ParentObj().get_Data(d);
+			SendBbsMsg(d);
+			s.m_Cursor = it->m_ID;
+
+			if (IsChocking())
+				break;
+		}
+
+		return;
+	}
+
 	NodeDB& db = m_This.m_Processor.get_DB();
 	NodeDB::WalkerBbs wlk;
 
@@ -3299,7 +4167,7 @@ void Node::Peer::OnMsg(proto::BbsResetSync&& msg)
 	if (!m_This.m_Cfg.m_Bbs.IsEnabled())
 		ThrowUnexpected();
 
-	m_CursorBbs = m_This.m_Processor.get_DB().BbsFindCursor(msg.m_TimeFrom) - 1;
+	m_CursorBbs = m_This.m_Bbs.FindCursor(msg.m_TimeFrom) - 1;
 	BroadcastBbs();
 }
 
@@ -4238,32 +5106,7 @@ bool Node::GenerateRecoveryInfo(const char* szPath)
             ser & MaxHeight; // terminator
 
             // shielded in/outs
-            struct MyKrnWalker
-                :public NodeProcessor::KrnWalkerShielded
-            {
-                MySerializer& m_Ser;
-                MyKrnWalker(MySerializer& ser) :m_Ser(ser) {}
-
-                virtual bool OnKrnEx(const TxKernelShieldedInput& krn) override
-                {
-                    m_Ser & m_Height;
-                    m_Ser & false;
-                    m_Ser & krn.m_SpendProof.m_SpendPk;
-                    return true;
-                }
-
-                virtual bool OnKrnEx(const TxKernelShieldedOutput& krn) override
-                {
-                    Cast::NotConst(krn).m_Txo.m_pAsset.reset(); // not needed for recovery atm
-
-                    m_Ser & m_Height;
-                    m_Ser & true;
-                    m_Ser & krn.m_Txo;
-                    m_Ser & krn.m_Msg;
-                    return true;
-                }
-
-            } wlk(ser);
+            RecoveryShieldedWalker<MySerializer> wlk(ser);
 
             m_Processor.EnumKernels(wlk, HeightRange(h, m_Processor.m_Cursor.m_ID.m_Height));
 
@@ -4289,6 +5132,16 @@ bool Node::GenerateRecoveryInfo(const char* szPath)
 	return true;
 }
 
+void Node::ExportSnapshot(const char* szPath)
+{
+	m_Processor.ExportSnapshot(szPath);
+}
+
+void Node::StartBackup(const char* szPath)
+{
+	m_Processor.StartBackup(szPath);
+}
+
 void Node::PrintTxos()
 {
     if (!m_Keys.m_pOwner)
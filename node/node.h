@@ -15,11 +15,13 @@
 #pragma once
 
 #include "processor.h"
+#include "bbs_store.h"
 #include "utility/io/timer.h"
 #include "core/proto.h"
 #include "core/block_crypt.h"
 #include "core/shielded.h"
 #include "core/peer_manager.h"
+#include "core/block_rw.h"
 #include <boost/intrusive/list.hpp>
 #include <boost/intrusive/set.hpp>
 #include <condition_variable>
@@ -38,6 +40,7 @@ struct Node
 		virtual void OnStateChanged() {}
 		virtual void OnRolledBack(const Block::SystemState::ID& id) {};
 		virtual void InitializeUtxosProgress(uint64_t done, uint64_t total) {};
+		virtual void RescanOwnedTxosProgress(uint64_t done, uint64_t total) {};
 
         enum Error
         {
@@ -67,9 +70,9 @@ struct Node
 			uint32_t m_TopPeersUpd_ms = 1000 * 60 * 10; // once in 10 minutes
 			uint32_t m_PeersUpdate_ms	= 1000; // reconsider every second
 			uint32_t m_PeersDbFlush_ms = 1000 * 60; // 1 minute
+			uint32_t m_BackupStep_ms = 250; // hot backup progress when idle. The I/O per step is bounded by NodeProcessor::Backup
 		} m_Timeout;
 
-		uint32_t m_MaxConcurrentBlocksRequest = 18;
 		uint32_t m_MaxPoolTransactions = 100 * 1000;
 		uint32_t m_MiningThreads = 0; // by default disabled
 
@@ -87,6 +90,10 @@ struct Node
 			uint32_t m_MessageTimeout_s = 3600 * 12; // 1/2 day
 			uint32_t m_CleanupPeriod_ms = 3600 * 1000; // 1 hour
 
+			// keep messages in memory instead of the DB. Saves the DB churn for nodes with heavy BBS traffic, but messages are lost on restart
+			bool m_InMemory = false;
+			uint32_t m_BucketDuration_s = 600; // expiration granularity of the in-memory store
+
 			NodeDB::BbsTotals m_Limit;
 
 			Bbs()
@@ -111,11 +118,22 @@ struct Node
 			size_t m_MaxBodyPackSize = 1024 * 1024 * 5;
 			uint32_t m_MaxBodyPackCount = 3000;
 
+			// blocks download
+			uint32_t m_MaxBodyPacksPerPeer = 2; // pipelined requests, hides the latency
+			uint32_t m_BodyPackDuration_ms = 1000 * 4; // desired transfer time. The pack size is adjusted wrt measured peer bandwidth
+			Height m_MaxBodiesAhead = 1024 * 16; // max distance between the lowest missing block and the highest requested one
+			uint32_t m_BodyStallFactor = 3; // the lowest pack is re-requested from a faster peer if it takes longer than expected by this factor
+
+			size_t m_BodyCacheSize = 1024 * 1024 * 64; // bodies prepared for peers, shared across requests. Set to 0 to disable
+
+			uint32_t m_CompressThreshold = 1024 * 4; // min size of headers/blocks msg to compress, if the peer accepts. Set to 0 to disable
+
 		} m_BandwidthCtl;
 
 		struct TestMode {
 			// for testing only!
 			uint32_t m_FakePowSolveTime_ms = 15 * 1000;
+			bool m_IgnoreBodyRequests = false; // emulates a stalled peer
 
 		} m_TestMode;
 
@@ -170,7 +188,50 @@ struct Node
 	~Node();
 	void Initialize(IExternalPOW* externalPOW=nullptr);
 
+	// bodies prepared for peers, in LRU order, bounded by Config::BandwidthCtl::m_BodyCacheSize
+	struct BodyCache
+	{
+		struct Key
+		{
+			uint64_t m_Row;
+			Height m_Height0;
+			Height m_HorizonLo1;
+			Height m_HorizonHi1;
+			uint8_t m_FlagP;
+			uint8_t m_FlagE;
+
+			bool operator < (const Key&) const;
+		};
+
+		struct Item
+			:public boost::intrusive::set_base_hook<>
+			,public boost::intrusive::list_base_hook<>
+		{
+			Key m_Key;
+			proto::BodyBuffers m_Body;
+
+			size_t get_Size() const { return m_Body.m_Eternal.size() + m_Body.m_Perishable.size(); }
+			bool operator < (const Item& x) const { return (m_Key < x.m_Key); }
+		};
+
+		typedef boost::intrusive::list<Item> List; // LRU order, the most recently used is at the back
+		typedef boost::intrusive::multiset<Item> Set;
+
+		List m_lst;
+		Set m_set;
+		size_t m_Size = 0;
+
+		bool Find(proto::BodyBuffers&, const Key&);
+		void Insert(const proto::BodyBuffers&, const Key&, size_t nMaxSize);
+		void Delete(Item&);
+		void Clear();
+
+		~BodyCache() { Clear(); }
+	};
+
 	NodeProcessor& get_Processor() { return m_Processor; } // for tests only!
+	BodyCache& get_BodyCache() { return m_BodyCache; } // for tests only!
+	uint32_t get_BodiesReissued() const { return m_BodySched.m_Reissued; } // for tests only!
 
 	struct SyncStatus
 	{
@@ -194,6 +255,8 @@ struct Node
 	bool m_PostStartSynced = false;
 
 	bool GenerateRecoveryInfo(const char*);
+	void ExportSnapshot(const char*); // throws on error
+	void StartBackup(const char*); // hot backup, completed asynchronously. Throws on error
 	void PrintTxos();
 
 	bool DecodeAndCheckHdrs(std::vector<Block::SystemState::Full>&, const proto::HdrPack&);
@@ -214,6 +277,7 @@ private:
 		void OnEvent(Height, const proto::Event::Base&) override;
 		void OnDummy(const CoinID&, Height) override;
 		void InitializeUtxosProgress(uint64_t done, uint64_t total) override;
+		void RescanOwnedTxosProgress(uint64_t done, uint64_t total) override;
 		void Stop();
 
 		struct MyExecutorMT
@@ -233,7 +297,23 @@ private:
 		Block::ChainWorkProof m_Cwp; // cached
 		bool BuildCwp();
 
+		struct CwpCache
+		{
+			// States sampled by the last built proof, keyed by their chainwork.
+			// The sampling is seeded by the tip, but the consecutive states near the tip are re-sampled for the following tips.
+			typedef std::map<Difficulty::Raw, Block::SystemState::Full> StateMap;
+			StateMap m_States;
+
+			// The last cropped proof. FlyClients that start from the same point request the same crop
+			Block::ChainWorkProof m_Cropped;
+
+			bool FindState(Block::SystemState::Full&, const Difficulty::Raw&) const;
+			void OnRolledBack(Height); // forget the states of the reverted branch
+
+		} m_CwpCache;
+
 		void GenerateProofStateStrict(Merkle::HardProof&, Height);
+		void GenerateProofStatesStrict(Merkle::MultiProof&, const std::vector<Block::SystemState::Full>&);
 		void GenerateProofShielded(Merkle::Proof&, const uintBigFor<TxoID>::Type& mmrIdx);
 
 		bool m_bFlushPending = false;
@@ -241,6 +321,10 @@ private:
 		void OnFlushTimer();
 		void FlushDB();
 
+		io::Timer::Ptr m_pBackupTimer;
+		void StartBackup(const char*);
+		virtual void OnBackupOver(bool bSuccess) override;
+
 		bool m_bGoUpPending = false;
 		io::Timer::Ptr m_pGoUpTimer;
 		void TryGoUpAsync();
@@ -267,6 +351,7 @@ private:
 		Key m_Key;
 
 		bool m_bNeeded;
+		bool m_bReissued; // stalled, duplicated to another peer
 		uint32_t m_nCount;
 		uint32_t m_TimeAssigned_ms;
 		NodeDB::StateID m_sidTrg;
@@ -290,12 +375,69 @@ private:
 	void TryAssignTask(Task&);
 	bool TryAssignTask(Task&, Peer&);
 	void DeleteUnassignedTask(Task&);
+	Task* FindTask(const Task::Key&);
+	Task& RequestTask(const Task::Key&, const NodeDB::StateID& sidTrg);
+
+	struct BodySched
+	{
+		// top of the highest requested range
+		Height m_hTop = 0;
+		uint64_t m_rowTop = 0;
+
+		uint32_t m_AvgBodySize = 1024; // running estimate, used to size the requests
+		uint32_t m_Reissued = 0; // stalled ranges re-requested from other peers
+		io::Timer::Ptr m_pTimer; // stall check, while there're blocks to download
+		bool m_bTimerRunning = false;
+
+		void OnRequested(Height, uint64_t row);
+		void OnReceived(size_t nSize, size_t nCount);
+
+	} m_BodySched;
+
+	void ScheduleBodies(Height hLow, const NodeDB::StateID& sidTrg);
+	void CheckBodiesStall();
+
+	BodyCache m_BodyCache;
 
 	void InitKeys();
 	void InitIDs();
 	void RefreshOwnedUtxos();
 	void MaybeGenerateRecovery();
 
+	// Recovery files after the 1st one are produced incrementally on a background thread: the previous file is merged
+	// with the changes since its height, which are collected on the node thread (cheap, only the recent blocks are read).
+	struct RecoveryGen
+	{
+		struct Job
+		{
+			RecoveryInfo::Delta m_Delta;
+			Block::ChainWorkProof m_Cwp;
+			Block::SystemState::ID m_ID;
+			std::string m_sBase;
+			std::string m_sPath;
+			std::string m_sTmp;
+			bool m_Ok = false;
+		};
+
+		std::string m_sPathBase; // last generated file
+		Block::SystemState::ID m_idBase;
+
+		std::unique_ptr<Job> m_pJob;
+		std::thread m_Thread;
+		io::AsyncEvent::Ptr m_pEvt;
+
+		bool IsInProgress() const { return !!m_pJob; }
+		bool Start(const std::string& sPath, const std::string& sTmp);
+		void OnDone();
+		void Stop();
+
+		static bool Commit(const std::string& sPath, const std::string& sTmp);
+
+		~RecoveryGen() { Stop(); }
+
+		IMPLEMENT_GET_PARENT_OBJ(Node, m_RecoveryGen)
+	} m_RecoveryGen;
+
 	struct Wanted
 	{
 		typedef ECC::Hash::Value KeyType;
@@ -375,10 +517,17 @@ private:
 
 		static void CalcMsgKey(NodeDB::WalkerBbs::Data&);
 		uint32_t m_LastCleanup_ms = 0;
+		void Initialize();
 		void Cleanup();
 		void MaybeCleanup();
 		bool IsInLimits() const;
 
+		std::unique_ptr<BbsMemStore> m_pMem; // if configured, instead of the DB
+
+		bool Find(const NodeDB::WalkerBbs::Key&);
+		uint64_t Insert(const NodeDB::WalkerBbs::Data&);
+		uint64_t FindCursor(Timestamp);
+
 		struct Subscription
 		{
 			struct InBbs :public boost::intrusive::set_base_hook<> {
@@ -479,6 +628,7 @@ private:
 		TxPool::Fluff::Element* m_pCursorTx;
 
 		TaskList m_lstTasks;
+		uint32_t m_Rtt_ms = 0; // latency estimate, excluding the transfer time
 		std::set<Task::Key> m_setRejected; // data that shouldn't be requested from this peer. Reset after reconnection or on receiving NewTip
 
 		Bbs::Subscription::PeerSet m_Subscriptions;
@@ -504,6 +654,7 @@ private:
 		void OnChocking();
 		void SetTxCursor(TxPool::Fluff::Element*);
 		bool GetBlock(proto::BodyBuffers&, const NodeDB::StateID&, const proto::GetBodyPack&, bool bActive);
+		bool GetBlockRaw(proto::BodyBuffers&, const NodeDB::StateID&, const proto::GetBodyPack&, bool bActive);
 
 		bool IsChocking(size_t nExtra = 0);
 		bool ShouldAssignTasks();
@@ -512,6 +663,8 @@ private:
 		void OnFirstTaskDone();
 		void OnFirstTaskDone(NodeProcessor::DataStatus::Enum);
 		void ModifyRatingWrtData(size_t nSize);
+		uint32_t get_Bps() const;
+		uint32_t get_BodyPackCount() const;
 
 		void SendTx(Transaction::Ptr& ptx, bool bFluff);
 
@@ -535,7 +688,7 @@ private:
 		virtual void OnMsg(proto::GetBody&&) override;
 		virtual void OnMsg(proto::GetBodyPack&&) override;
 		virtual void OnMsg(proto::Body&&) override;
-		virtual void OnMsg(proto::BodyPack&&) override;
+		virtual bool OnBodyPack(proto::BodyPackReader&) override;
 		virtual void OnMsg(proto::NewTransaction&&) override;
 		virtual void OnMsg(proto::HaveTransaction&&) override;
 		virtual void OnMsg(proto::GetTransaction&&) override;
@@ -544,6 +697,8 @@ private:
 		virtual void OnMsg(proto::GetProofKernel&&) override;
 		virtual void OnMsg(proto::GetProofKernel2&&) override;
 		virtual void OnMsg(proto::GetProofUtxo&&) override;
+		virtual void OnMsg(proto::GetProofKernels&&) override;
+		virtual void OnMsg(proto::GetProofUtxos&&) override;
 		virtual void OnMsg(proto::GetProofShieldedOutp&&) override;
 		virtual void OnMsg(proto::GetProofShieldedInp&&) override;
 		virtual void OnMsg(proto::GetProofAsset&&) override;
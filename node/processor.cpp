@@ -163,10 +163,17 @@ void NodeProcessor::Initialize(const char* szPath, const StartParams& sp)
 	m_Mmr.m_States.m_Count = m_Cursor.m_Sid.m_Height - Rules::HeightGenesis;
 	InitCursor(false);
 
-	InitializeUtxos(szPath);
+	InitializeMmrImages(szPath);
+
+	if (sp.m_sSnapshot.empty())
+		InitializeUtxos(szPath);
+	else
+		ImportSnapshot(szPath, sp.m_sSnapshot.c_str());
 
 	m_Extra.m_Txos = get_TxosBefore(m_Cursor.m_ID.m_Height + 1);
 
+	InitializeFilters();
+
 	m_Horizon.Normalize();
 
 	if (PruneOld() && !sp.m_Vacuum)
@@ -185,6 +192,8 @@ void NodeProcessor::InitializeUtxos(const char* sz)
 	if (InitUtxoMapping(sz, false))
 	{
 		LOG_INFO() << "UTXO image found";
+		if (m_Utxos.m_JournalRolledBack)
+			LOG_INFO() << "UTXO image rolled back to the committed state, " << m_Utxos.m_JournalRolledBack << " modifications undone";
 		if (TestDefinition())
 			return; // ok
 
@@ -215,6 +224,152 @@ bool NodeProcessor::TestDefinition()
 	return m_Cursor.m_Full.m_Definition == hv;
 }
 
+void NodeProcessor::InitializeFilters()
+{
+	InitializeFilterUtxos();
+	InitializeFilterKernels();
+	InitializeFilterUnique();
+
+	LOG_INFO() << "Membership filters built. Utxos=" << m_Filters.m_Utxos.m_Inserted << ", Kernels=" << m_Filters.m_Kernels.m_Inserted << ", Unique=" << m_Filters.m_Unique.m_Inserted;
+}
+
+void NodeProcessor::InitializeFilterUtxos()
+{
+	struct Traveler :public UtxoTree::ITraveler
+	{
+		MembershipFilter* m_pFilter = nullptr;
+		uint64_t m_Count = 0;
+
+		virtual bool OnLeaf(const RadixTree::Leaf& x) override
+		{
+			if (m_pFilter)
+			{
+				UtxoTree::Key::Data d;
+				d = Cast::Up<UtxoTree::MyLeaf>(x).m_Key;
+				m_pFilter->Insert(d.m_Commitment.m_X);
+			}
+			else
+				m_Count++;
+
+			return true;
+		}
+	} t;
+
+	m_Utxos.Traverse(t); // count
+
+	m_Filters.m_Utxos.Reset(t.m_Count);
+	t.m_pFilter = &m_Filters.m_Utxos;
+	m_Utxos.Traverse(t);
+}
+
+void NodeProcessor::InitializeFilterKernels()
+{
+	m_Filters.m_Kernels.Reset(m_DB.get_KernelsCount());
+
+	NodeDB::WalkerKey wlk;
+	for (m_DB.EnumKernels(wlk); wlk.MoveNext(); )
+		m_Filters.m_Kernels.Insert(wlk.m_Key);
+}
+
+void NodeProcessor::InitializeFilterUnique()
+{
+	m_Filters.m_Unique.Reset(m_DB.get_UniqueCount());
+
+	NodeDB::WalkerKey wlk;
+	for (m_DB.EnumUnique(wlk); wlk.MoveNext(); )
+		m_Filters.m_Unique.Insert(wlk.m_Key);
+}
+
+void NodeProcessor::RebuildOverfilledFilters()
+{
+	if (m_Filters.m_Utxos.IsOverfilled())
+	{
+		LOG_INFO() << "Rebuilding Utxo filter";
+		InitializeFilterUtxos();
+	}
+
+	if (m_Filters.m_Kernels.IsOverfilled())
+	{
+		LOG_INFO() << "Rebuilding Kernel filter";
+		InitializeFilterKernels();
+	}
+
+	if (m_Filters.m_Unique.IsOverfilled())
+	{
+		LOG_INFO() << "Rebuilding Unique filter";
+		InitializeFilterUnique();
+	}
+}
+
+void NodeProcessor::MembershipFilter::Reset(uint64_t nKeys)
+{
+	m_Capacity = std::max<uint64_t>(nKeys * 2, 0x10000);
+	m_Inserted = 0;
+
+	uint64_t nBits = 64;
+	while (nBits < m_Capacity * s_BitsPerKey)
+		nBits <<= 1;
+
+	m_vWords.assign(nBits >> 6, 0);
+}
+
+bool NodeProcessor::MembershipFilter::Probe(const Blob& key, bool bSet)
+{
+	assert(IsEnabled());
+
+	uint64_t pH[2] = { 0 };
+	memcpy(pH, key.p, std::min<size_t>(key.n, sizeof(pH)));
+
+	// double hashing. The step is odd, hence the probes are distinct
+	uint64_t nMask = (uint64_t(m_vWords.size()) << 6) - 1;
+	uint64_t nPos = pH[0];
+	uint64_t nStep = pH[1] | 1;
+
+	for (uint32_t i = 0; i < s_Probes; i++, nPos += nStep)
+	{
+		uint64_t& w = m_vWords[(nPos & nMask) >> 6];
+		uint64_t msk = uint64_t(1) << (nPos & 63);
+
+		if (bSet)
+			w |= msk;
+		else
+			if (!(w & msk))
+				return false;
+	}
+
+	return true;
+}
+
+void NodeProcessor::MembershipFilter::Insert(const Blob& key)
+{
+	if (IsEnabled())
+	{
+		Probe(key, true);
+		m_Inserted++;
+	}
+}
+
+bool NodeProcessor::MembershipFilter::MayContain(const Blob& key) const
+{
+	return
+		!IsEnabled() ||
+		Cast::NotConst(*this).Probe(key, false);
+}
+
+bool NodeProcessor::MembershipFilter::Test(const Blob& key)
+{
+	if (MayContain(key))
+		return true;
+
+	m_Rejected++;
+	return false;
+}
+
+double NodeProcessor::MembershipFilter::get_FalsePositiveRate() const
+{
+	uint64_t nNegatives = m_Rejected + m_Missed;
+	return nNegatives ? (double(m_Missed) / double(nNegatives)) : 0.;
+}
 
 // Ridiculous! Had to write this because strmpi isn't standard!
 int My_strcmpi(const char* sz1, const char* sz2)
@@ -234,9 +389,8 @@ int My_strcmpi(const char* sz1, const char* sz2)
 	return 0;
 }
 
-void NodeProcessor::get_UtxoMappingPath(std::string& sPath, const char* sz)
+void NodeProcessor::get_DerivedPath(std::string& sPath, const char* sz, const char* szName)
 {
-	// derive UTXO path from db path
 	sPath = sz;
 
 	static const char szSufix[] = ".db";
@@ -245,7 +399,28 @@ void NodeProcessor::get_UtxoMappingPath(std::string& sPath, const char* sz)
 	if ((sPath.size() >= nSufix) && !My_strcmpi(sPath.c_str() + sPath.size() - nSufix, szSufix))
 		sPath.resize(sPath.size() - nSufix);
 
-	sPath += "-utxo-image.bin";
+	sPath += szName;
+}
+
+void NodeProcessor::get_UtxoMappingPath(std::string& sPath, const char* sz)
+{
+	// derive UTXO path from db path
+	get_DerivedPath(sPath, sz, "-utxo-image.bin");
+}
+
+void NodeProcessor::InitializeMmrImages(const char* sz)
+{
+	NodeDB::StreamMmr::Stamp s;
+	Blob blob(s);
+
+	if (!m_DB.ParamGet(NodeDB::ParamID::MmrStamp, nullptr, &blob))
+	{
+		ECC::GenRandom(s);
+		m_DB.ParamSet(NodeDB::ParamID::MmrStamp, nullptr, &blob);
+	}
+
+	if (!m_Mmr.OpenImages(sz, s))
+		LOG_INFO() << "MMR images rebuilt";
 }
 
 bool NodeProcessor::InitUtxoMapping(const char* sz, bool bForceReset)
@@ -293,6 +468,46 @@ NodeProcessor::Mmr::Mmr(NodeDB& db)
 {
 }
 
+bool NodeProcessor::Mmr::OpenImages(const char* sz, const NodeDB::StreamMmr::Stamp& s)
+{
+	std::string sPath;
+	bool bOk = true;
+
+	get_DerivedPath(sPath, sz, "-states-mmr.bin");
+	bOk &= m_States.OpenImage(sPath.c_str(), s);
+
+	get_DerivedPath(sPath, sz, "-shielded-mmr.bin");
+	bOk &= m_Shielded.OpenImage(sPath.c_str(), s);
+
+	get_DerivedPath(sPath, sz, "-assets-mmr.bin");
+	bOk &= m_Assets.OpenImage(sPath.c_str(), s);
+
+	return bOk;
+}
+
+bool NodeProcessor::Mmr::IsImageDirty() const
+{
+	return
+		m_States.IsImageDirty() ||
+		m_Shielded.IsImageDirty() ||
+		m_Assets.IsImageDirty();
+}
+
+void NodeProcessor::Mmr::FlushImages(const NodeDB::StreamMmr::Stamp& s)
+{
+	// the stamp is common, so the clean images are re-stamped too
+	m_States.FlushImage(s);
+	m_Shielded.FlushImage(s);
+	m_Assets.FlushImage(s);
+}
+
+void NodeProcessor::Mmr::CloseImages()
+{
+	m_States.CloseImage();
+	m_Shielded.CloseImage();
+	m_Assets.CloseImage();
+}
+
 NodeProcessor::NodeProcessor()
 	:m_Mmr(m_DB)
 {
@@ -300,6 +515,8 @@ NodeProcessor::NodeProcessor()
 
 NodeProcessor::~NodeProcessor()
 {
+	BackupAbort(); // must be closed before the DB
+
 	if (m_DbTx.IsInProgress())
 	{
 		try {
@@ -315,6 +532,8 @@ void NodeProcessor::CommitUtxosAndDB()
 	UtxoTreeMapped::Stamp us;
 
 	bool bFlushUtxos = (m_Utxos.IsOpen() && m_Utxos.get_Hdr().m_Dirty);
+	bool bFlushMmr = m_Mmr.IsImageDirty();
+	NodeDB::StreamMmr::Stamp ms;
 
 	if (bFlushUtxos)
 	{
@@ -329,14 +548,42 @@ void NodeProcessor::CommitUtxosAndDB()
 		m_DB.ParamSet(NodeDB::ParamID::UtxoStamp, nullptr, &blob);
 	}
 
+	if (bFlushMmr)
+	{
+		Blob blob(ms);
+
+		if (m_DB.ParamGet(NodeDB::ParamID::MmrStamp, nullptr, &blob)) {
+			ECC::Hash::Processor() << ms >> ms;
+		} else {
+			ECC::GenRandom(ms);
+		}
+
+		m_DB.ParamSet(NodeDB::ParamID::MmrStamp, nullptr, &blob);
+	}
+
+	if (bFlushUtxos && IsBackupInProgress())
+	{
+		// update the hash cache now, so that its modifications are tracked within this commit (see MappedFile::Copier)
+		Merkle::Hash hv;
+		m_Utxos.get_Hash(hv);
+	}
+
+	if (bFlushUtxos)
+		m_Utxos.JournalMarkCommit(us); // lets the image be rolled forward to this commit after an unclean shutdown
+
 	m_DbTx.Commit();
 
 	if (bFlushUtxos)
 		m_Utxos.FlushStrict(us);
+
+	if (bFlushMmr)
+		m_Mmr.FlushImages(ms);
 }
 
 void NodeProcessor::Vacuum()
 {
+	BackupAbort(); // the DB is rebuilt
+
 	if (m_DbTx.IsInProgress())
 		m_DbTx.Commit();
 
@@ -352,6 +599,10 @@ void NodeProcessor::CommitDB()
 	if (m_DbTx.IsInProgress())
 	{
 		CommitUtxosAndDB();
+
+		if (IsBackupInProgress())
+			BackupStep(); // nothing is uncommitted now
+
 		m_DbTx.Start(m_DB);
 	}
 }
@@ -680,7 +931,11 @@ void NodeProcessor::EnumCongestions()
 const uint64_t* NodeProcessor::get_CachedRows(const NodeDB::StateID& sid, Height nCountExtra)
 {
 	EnumCongestionsInternal();
+	return FindCachedRows(sid, nCountExtra);
+}
 
+const uint64_t* NodeProcessor::FindCachedRows(const NodeDB::StateID& sid, Height nCountExtra)
+{
 	CongestionCache::TipCongestion* pVal = m_CongestionCache.Find(sid);
 	if (pVal)
 	{
@@ -1092,6 +1347,7 @@ struct NodeProcessor::MultiblockContext
 		{
 			typedef std::shared_ptr<SharedBlock> Ptr;
 
+			Arena m_Arena; // must outlive the body
 			Block::Body m_Body;
 			size_t m_Size;
 			TxBase::Context::Params m_Pars;
@@ -1405,6 +1661,8 @@ void NodeProcessor::TryGoUp()
 	if (bDirty)
 	{
 		PruneOld();
+		RebuildOverfilledFilters();
+
 		if (m_Cursor.m_Sid.m_Row != rowid)
 			OnNewState();
 	}
@@ -1611,6 +1869,7 @@ void NodeProcessor::DeleteBlocksInRange(const NodeDB::StateID& sidTop, Height hS
 
 void NodeProcessor::DeleteBlock(uint64_t row)
 {
+	m_KrnMmrCache.Delete(row);
 	m_DB.DelStateBlockAll(row);
 	m_DB.SetStateNotFunctional(row);
 }
@@ -1642,6 +1901,7 @@ Height NodeProcessor::PruneOld()
 
 			do
 			{
+				m_KrnMmrCache.Delete(rowid);
 				if (!m_DB.DeleteState(rowid, rowid))
 					break;
 				hRet++;
@@ -1861,25 +2121,88 @@ void NodeProcessor::ProofBuilderHard::OnProof(Merkle::Hash& hv, bool bNewOnRight
 	m_Proof.back() = hv;
 }
 
-uint64_t NodeProcessor::ProcessKrnMmr(Merkle::Mmr& mmr, std::vector<TxKernel::Ptr>& vKrn, const Merkle::Hash& idKrn, TxKernel::Ptr* ppRes)
+uint64_t NodeProcessor::KrnMmrCache::Item::Find(const Merkle::Hash& idKrn) const
+{
+	// in case of duplicates take the last one, as before
+	auto it = std::upper_bound(m_vSorted.begin(), m_vSorted.end(), Entry(idKrn, static_cast<uint32_t>(-1)));
+	if ((m_vSorted.begin() == it) || ((--it)->first != idKrn))
+		return uint64_t(-1);
+
+	return it->second;
+}
+
+const NodeProcessor::KrnMmrCache::Item* NodeProcessor::KrnMmrCache::Find(uint64_t row)
+{
+	Item n;
+	n.m_Row = row;
+
+	Set::iterator it = m_set.find(n);
+	if (m_set.end() == it)
+		return nullptr;
+
+	Item& x = *it;
+
+	// move to the most recently used position
+	m_lst.erase(List::s_iterator_to(x));
+	m_lst.push_back(x);
+
+	return &x;
+}
+
+const NodeProcessor::KrnMmrCache::Item& NodeProcessor::KrnMmrCache::Insert(uint64_t row, const std::vector<TxKernel::Ptr>& vKrn)
 {
-	uint64_t iRet = uint64_t (-1);
+	Item* p = new Item;
+	p->m_Row = row;
+	p->m_Mmr.Resize(vKrn.size());
+	p->m_vSorted.resize(vKrn.size());
 
 	for (size_t i = 0; i < vKrn.size(); i++)
 	{
-		TxKernel::Ptr& p = vKrn[i];
-		const Merkle::Hash& hv = p->m_Internal.m_ID;
-		mmr.Append(hv);
+		const Merkle::Hash& hv = vKrn[i]->m_Internal.m_ID;
+		p->m_Mmr.Append(hv);
 
-		if (hv == idKrn)
-		{
-			iRet = i; // found
-			if (ppRes)
-				ppRes->swap(p);
-		}
+		Item::Entry& e = p->m_vSorted[i];
+		e.first = hv;
+		e.second = static_cast<uint32_t>(i);
 	}
 
-	return iRet;
+	std::sort(p->m_vSorted.begin(), p->m_vSorted.end());
+
+	m_set.insert(*p);
+	m_lst.push_back(*p);
+	m_Size += p->get_Size();
+
+	// the new item is kept even if it exceeds the limit alone
+	while ((m_Size > s_MaxSize) && (&m_lst.front() != p))
+		Delete(m_lst.front());
+
+	return *p;
+}
+
+void NodeProcessor::KrnMmrCache::Delete(uint64_t row)
+{
+	Item n;
+	n.m_Row = row;
+
+	Set::iterator it = m_set.find(n);
+	if (m_set.end() != it)
+		Delete(*it);
+}
+
+void NodeProcessor::KrnMmrCache::Delete(Item& x)
+{
+	assert(m_Size >= x.get_Size());
+	m_Size -= x.get_Size();
+
+	m_lst.erase(List::s_iterator_to(x));
+	m_set.erase(Set::s_iterator_to(x));
+	delete &x;
+}
+
+void NodeProcessor::KrnMmrCache::Clear()
+{
+	while (!m_lst.empty())
+		Delete(m_lst.back());
 }
 
 Height NodeProcessor::get_ProofKernel(Merkle::Proof& proof, TxKernel::Ptr* ppRes, const Merkle::Hash& idKrn)
@@ -1890,23 +2213,34 @@ Height NodeProcessor::get_ProofKernel(Merkle::Proof& proof, TxKernel::Ptr* ppRes
 
 	uint64_t rowid = FindActiveAtStrict(h);
 
-	ByteBuffer bbE;
-	m_DB.GetStateBlock(rowid, nullptr, &bbE, nullptr);
+	const KrnMmrCache::Item* pItem = m_KrnMmrCache.Find(rowid);
 
 	TxVectors::Eternal txve;
+	if (!pItem || ppRes)
+	{
+		ByteBuffer bbE;
+		m_DB.GetStateBlock(rowid, nullptr, &bbE, nullptr);
 
-	Deserializer der;
-	der.reset(bbE);
-	der & txve;
+		Deserializer der;
+		der.reset(bbE);
+		der & txve;
 
-	Merkle::FixedMmr mmr;
-	mmr.Resize(txve.m_vKernels.size());
-	size_t iTrg = ProcessKrnMmr(mmr, txve.m_vKernels, idKrn, ppRes);
+		if (!pItem)
+			pItem = &m_KrnMmrCache.Insert(rowid, txve.m_vKernels);
+	}
 
+	uint64_t iTrg = pItem->Find(idKrn);
 	if (uint64_t(-1) == iTrg)
 		OnCorrupted();
 
-	mmr.get_Proof(proof, iTrg);
+	pItem->m_Mmr.get_Proof(proof, iTrg);
+
+	if (ppRes)
+	{
+		assert(iTrg < txve.m_vKernels.size());
+		ppRes->swap(txve.m_vKernels[iTrg]);
+	}
+
 	return h;
 }
 
@@ -2127,6 +2461,8 @@ bool NodeProcessor::HandleBlock(const NodeDB::StateID& sid, const Block::SystemS
 	Block::Body& block = pShared->m_Body;
 
 	try {
+		Arena::Scope scopeArena(&pShared->m_Arena);
+
 		Deserializer der;
 		der.reset(bbP);
 		der & Cast::Down<Block::BodyBase>(block);
@@ -2617,7 +2953,7 @@ void NodeProcessor::RescanOwnedTxos()
 		LOG_INFO() << "Rescanning owned Txos...";
 
 		TxoRecover wlk(*pKey, *this);
-		EnumTxos(wlk);
+		EnumTxosRecoverMT(wlk);
 
 		LOG_INFO() << "Recovered " << wlk.m_Unspent << "/" << wlk.m_Total << " unspent/total Txos";
 	}
@@ -2658,8 +2994,13 @@ bool NodeProcessor::IsDummy(const CoinID&  cid)
 
 Height NodeProcessor::FindVisibleKernel(const Merkle::Hash& id, const BlockInterpretCtx& bic)
 {
+	if (!m_Filters.m_Kernels.Test(id))
+		return Rules::HeightGenesis - 1;
+
 	Height h = m_DB.FindKernel(id);
-	if (h >= Rules::HeightGenesis)
+	if (h < Rules::HeightGenesis)
+		m_Filters.m_Kernels.OnMissed();
+	else
 	{
 		assert(h <= bic.m_Height);
 
@@ -2953,6 +3294,8 @@ bool NodeProcessor::HandleKernel(const TxKernelShieldedOutput& krn, BlockInterpr
 			if (!m_DB.UniqueInsertSafe(blobKey, &blobVal))
 				return false;
 
+			m_Filters.m_Unique.Insert(blobKey);
+
 			if (bic.m_StoreShieldedOutput)
 			{
 				ECC::Point::Native pt, pt2;
@@ -3051,6 +3394,8 @@ bool NodeProcessor::HandleKernel(const TxKernelShieldedInput& krn, BlockInterpre
 			if (!m_DB.UniqueInsertSafe(blobKey, &blobVal))
 				return false;
 
+			m_Filters.m_Unique.Insert(blobKey);
+
 			if (bic.m_UpdateMmrs)
 			{
 				ShieldedTxo::DescriptionInp d;
@@ -3178,6 +3523,9 @@ bool NodeProcessor::HandleBlockElement(const Input& v, BlockInterpretCtx& bic)
 
 	if (bic.m_Fwd)
 	{
+		if (!m_Filters.m_Utxos.Test(v.m_Commitment.m_X))
+			return false;
+
 		struct Traveler :public UtxoTree::ITraveler {
 			virtual bool OnLeaf(const RadixTree::Leaf& x) override {
 				return false; // stop iteration
@@ -3196,17 +3544,25 @@ bool NodeProcessor::HandleBlockElement(const Input& v, BlockInterpretCtx& bic)
 		t.m_pBound[0] = kMin.V.m_pData;
 		t.m_pBound[1] = kMax.V.m_pData;
 
+		m_Utxos.EnsureReserve();
+
 		if (m_Utxos.Traverse(t))
+		{
+			m_Filters.m_Utxos.OnMissed();
 			return false;
+		}
 
 		p = &Cast::Up<UtxoTree::MyLeaf>(cu.get_Leaf());
 
-		d = p->m_Key;
+		UtxoTree::Key key = p->m_Key;
+		d = key;
 		assert(d.m_Commitment == v.m_Commitment);
 		assert(d.m_Maturity < bic.m_Height);
 
 		TxoID nID = p->m_ID;
 
+		m_Utxos.JournalBegin();
+
 		if (!p->IsExt())
 			m_Utxos.Delete(cu);
 		else
@@ -3216,6 +3572,8 @@ bool NodeProcessor::HandleBlockElement(const Input& v, BlockInterpretCtx& bic)
 			m_Utxos.OnDirty();
 		}
 
+		m_Utxos.JournalEnd(key, nID, false);
+
 		Cast::NotConst(v).m_Internal.m_Maturity = d.m_Maturity;
 		Cast::NotConst(v).m_Internal.m_ID = nID;
 
@@ -3228,8 +3586,10 @@ bool NodeProcessor::HandleBlockElement(const Input& v, BlockInterpretCtx& bic)
 		key = d;
 
 		m_Utxos.EnsureReserve();
+		m_Utxos.JournalBegin();
 
 		p = m_Utxos.Find(cu, key, bCreate);
+		m_Filters.m_Utxos.Insert(v.m_Commitment.m_X);
 
 		if (bCreate)
 			p->m_ID = v.m_Internal.m_ID;
@@ -3239,6 +3599,8 @@ bool NodeProcessor::HandleBlockElement(const Input& v, BlockInterpretCtx& bic)
 			cu.InvalidateElement();
 			m_Utxos.OnDirty();
 		}
+
+		m_Utxos.JournalEnd(key, v.m_Internal.m_ID, true);
 	}
 
 	return true;
@@ -3253,7 +3615,11 @@ bool NodeProcessor::HandleBlockElement(const Output& v, BlockInterpretCtx& bic)
 	UtxoTree::Key key;
 	key = d;
 
+	if (bic.m_Fwd && !bic.ValidateAssetRange(v.m_pAsset))
+		return false; // before the tree is modified
+
 	m_Utxos.EnsureReserve();
+	m_Utxos.JournalBegin();
 
 	UtxoTree::Cursor cu;
 	bool bCreate = true;
@@ -3262,12 +3628,12 @@ bool NodeProcessor::HandleBlockElement(const Output& v, BlockInterpretCtx& bic)
 	cu.InvalidateElement();
 	m_Utxos.OnDirty();
 
+	TxoID nID;
+
 	if (bic.m_Fwd)
 	{
-		if (!bic.ValidateAssetRange(v.m_pAsset))
-			return false;
-
-		TxoID nID = m_Extra.m_Txos;
+		nID = m_Extra.m_Txos;
+		m_Filters.m_Utxos.Insert(v.m_Commitment.m_X);
 
 		if (bCreate)
 			p->m_ID = nID;
@@ -3276,7 +3642,10 @@ bool NodeProcessor::HandleBlockElement(const Output& v, BlockInterpretCtx& bic)
 			// protect again overflow attacks, though it's highly unlikely (Input::Count is currently limited to 32 bits, it'd take millions of blocks)
 			Input::Count nCountInc = p->get_Count() + 1;
 			if (!nCountInc)
+			{
+				m_Utxos.JournalCancel();
 				return false;
+			}
 
 			m_Utxos.PushID(nID, *p);
 		}
@@ -3289,11 +3658,16 @@ bool NodeProcessor::HandleBlockElement(const Output& v, BlockInterpretCtx& bic)
 		m_Extra.m_Txos--;
 
 		if (!p->IsExt())
+		{
+			nID = p->m_ID;
 			m_Utxos.Delete(cu);
+		}
 		else
-			m_Utxos.PopID(*p);
+			nID = m_Utxos.PopID(*p);
 	}
 
+	m_Utxos.JournalEnd(key, nID, bic.m_Fwd);
+
 	return true;
 }
 
@@ -3331,7 +3705,10 @@ bool NodeProcessor::HandleBlockElement(const TxKernel& v, BlockInterpretCtx& bic
 	}
 
 	if (bSaveID && bic.m_Fwd)
+	{
 		m_DB.InsertKernel(v.m_Internal.m_ID, bic.m_Height);
+		m_Filters.m_Kernels.Insert(v.m_Internal.m_ID);
+	}
 
 	return true;
 }
@@ -3530,9 +3907,14 @@ bool NodeProcessor::ValidateUniqueNoDup(BlockInterpretCtx& bic, const Blob& key)
 	if (bic.m_pDups->Find(key))
 		return false;
 
-	NodeDB::Recordset rs;
-	if (m_DB.UniqueFind(key, rs))
-		return false;
+	if (m_Filters.m_Unique.Test(key))
+	{
+		NodeDB::Recordset rs;
+		if (m_DB.UniqueFind(key, rs))
+			return false;
+
+		m_Filters.m_Unique.OnMissed();
+	}
 
 	bic.m_pDups->Add(key);
 
@@ -4017,6 +4399,9 @@ uint8_t NodeProcessor::ValidateTxContextEx(const Transaction& tx, const HeightRa
 
 bool NodeProcessor::ValidateInputs(const ECC::Point& comm, Input::Count nCount /* = 1 */)
 {
+	if (!m_Filters.m_Utxos.Test(comm.m_X))
+		return false;
+
 	struct Traveler :public UtxoTree::ITraveler
 	{
 		uint32_t m_Count;
@@ -4049,7 +4434,13 @@ bool NodeProcessor::ValidateInputs(const ECC::Point& comm, Input::Count nCount /
 	t.m_pBound[0] = kMin.V.m_pData;
 	t.m_pBound[1] = kMax.V.m_pData;
 
-	return !m_Utxos.Traverse(t);
+	if (m_Utxos.Traverse(t))
+	{
+		m_Filters.m_Utxos.OnMissed();
+		return false;
+	}
+
+	return true;
 }
 
 size_t NodeProcessor::GenerateNewBlockInternal(BlockContext& bc, BlockInterpretCtx& bic)
@@ -4500,8 +4891,6 @@ bool NodeProcessor::EnumKernels(IKrnWalker& wlkKrn, const HeightRange& hr)
 	ByteBuffer bbE;
 	TxVectors::Eternal txve;
 
-	m_Extra.m_ShieldedOutputs = 0;
-
 	for (wlkKrn.m_Height = hr.m_Min; wlkKrn.m_Height <= hr.m_Max; wlkKrn.m_Height++)
 	{
 		uint64_t row = FindActiveAtStrict(wlkKrn.m_Height);
@@ -4552,56 +4941,931 @@ bool NodeProcessor::ITxoRecover::OnTxo(const NodeDB::WalkerTxo& wlk, Height hCre
 	return OnTxo(wlk, hCreate, outp, cid);
 }
 
-bool NodeProcessor::ITxoWalker_UnspentNaked::OnTxo(const NodeDB::WalkerTxo& wlk, Height hCreate)
+struct NodeProcessor::TxoRecoverMT
+	:public ITxoWalker
 {
-	if (wlk.m_SpendHeight != MaxHeight)
-		return true;
+	static const uint32_t s_Batch = 4096;
 
-	uint8_t pNaked[s_TxoNakedMax];
-	TxoToNaked(pNaked, Cast::NotConst(wlk).m_Value); // save allocation and deserialization of sig
-
-	return ITxoWalker::OnTxo(wlk, hCreate);
-}
+	struct Item
+	{
+		TxoID m_ID;
+		Height m_hCreate;
+		Height m_SpendHeight;
+		ByteBuffer m_Value;
 
-bool NodeProcessor::ITxoWalker_Unspent::OnTxo(const NodeDB::WalkerTxo& wlk, Height hCreate)
-{
-	if (wlk.m_SpendHeight != MaxHeight)
-		return true;
+		// set by the executor threads
+		std::unique_ptr<Output> m_pOutput; // only if recognized
+		CoinID m_Cid;
+	};
 
-	return ITxoWalker::OnTxo(wlk, hCreate);
-}
+	NodeProcessor& m_This;
+	ITxoRecover& m_Trg;
+	std::vector<Item> m_vItems;
+	uint32_t m_Count = 0;
 
-void NodeProcessor::InitializeUtxos()
-{
-	assert(!m_Extra.m_Txos);
+	TxoRecoverMT(NodeProcessor& x, ITxoRecover& trg)
+		:m_This(x)
+		,m_Trg(trg)
+	{
+		m_vItems.resize(s_Batch);
+	}
 
-	struct Walker
-		:public ITxoWalker_UnspentNaked
+	struct MyTask
+		:public Executor::TaskSync
 	{
-		TxoID m_TxosTotal;
-		NodeProcessor& m_This;
-		Walker(NodeProcessor& x) :m_This(x) {}
+		TxoRecoverMT* m_pThis;
 
-		virtual bool OnTxo(const NodeDB::WalkerTxo& wlk, Height hCreate) override
+		virtual void Exec(Executor::Context& ctx) override
 		{
-			m_This.InitializeUtxosProgress(wlk.m_ID, m_TxosTotal);
-			return ITxoWalker_UnspentNaked::OnTxo(wlk, hCreate);
+			uint32_t i0, nCount;
+			ctx.get_Portion(i0, nCount, m_pThis->m_Count);
+
+			for (uint32_t i = 0; i < nCount; i++)
+				m_pThis->Recover(m_pThis->m_vItems[i0 + i]);
 		}
+	};
 
-		virtual bool OnTxo(const NodeDB::WalkerTxo& wlk, Height hCreate, Output& outp) override
-		{
-			m_This.m_Extra.m_Txos = wlk.m_ID;
-			BlockInterpretCtx bic(hCreate, true);
-			if (!m_This.HandleBlockElement(outp, bic))
-				OnCorrupted();
+	void Recover(Item& x) const
+	{
+		Deserializer der;
+		der.reset(&x.m_Value.front(), x.m_Value.size());
+
+		std::unique_ptr<Output> pOutp = std::make_unique<Output>();
+		der & *pOutp;
+
+		if (pOutp->Recover(x.m_hCreate, m_Trg.m_Key, x.m_Cid))
+			x.m_pOutput = std::move(pOutp);
+	}
 
+	virtual bool OnTxo(const NodeDB::WalkerTxo& wlk, Height hCreate) override
+	{
+		if (TxoIsNaked(wlk.m_Value))
 			return true;
-		}
-	};
 
-	Walker wlk(*this);
-	wlk.m_TxosTotal = get_TxosBefore(m_Cursor.m_ID.m_Height + 1);
-	EnumTxos(wlk);
+		Item& x = m_vItems[m_Count++];
+		x.m_ID = wlk.m_ID;
+		x.m_hCreate = hCreate;
+		x.m_SpendHeight = wlk.m_SpendHeight;
+		x.m_Value.assign((const uint8_t*) wlk.m_Value.p, (const uint8_t*) wlk.m_Value.p + wlk.m_Value.n);
+
+		return (m_Count < s_Batch) || Flush();
+	}
+
+	bool Flush()
+	{
+		if (!m_Count)
+			return true;
+
+		MyTask t;
+		t.m_pThis = this;
+		m_This.get_Executor().ExecAll(t);
+
+		uint32_t nCount = m_Count;
+		m_Count = 0;
+
+		for (uint32_t i = 0; i < nCount; i++)
+		{
+			Item& x = m_vItems[i];
+			if (!x.m_pOutput)
+				continue;
+
+			NodeDB::WalkerTxo wlk;
+			wlk.m_ID = x.m_ID;
+			wlk.m_Value = x.m_Value;
+			wlk.m_SpendHeight = x.m_SpendHeight;
+
+			bool bContinue = m_Trg.OnTxo(wlk, x.m_hCreate, *x.m_pOutput, x.m_Cid);
+			x.m_pOutput.reset();
+
+			if (!bContinue)
+				return false;
+		}
+
+		m_This.RescanOwnedTxosProgress(m_vItems[nCount - 1].m_ID, m_This.m_Extra.m_Txos);
+		return true;
+	}
+};
+
+bool NodeProcessor::EnumTxosRecoverMT(ITxoRecover& wlkTrg)
+{
+	TxoRecoverMT wlk(*this, wlkTrg);
+	return
+		EnumTxos(wlk) &&
+		wlk.Flush();
+}
+
+bool NodeProcessor::ITxoWalker_UnspentNaked::OnTxo(const NodeDB::WalkerTxo& wlk, Height hCreate)
+{
+	if (wlk.m_SpendHeight != MaxHeight)
+		return true;
+
+	uint8_t pNaked[s_TxoNakedMax];
+	TxoToNaked(pNaked, Cast::NotConst(wlk).m_Value); // save allocation and deserialization of sig
+
+	return ITxoWalker::OnTxo(wlk, hCreate);
+}
+
+bool NodeProcessor::ITxoWalker_Unspent::OnTxo(const NodeDB::WalkerTxo& wlk, Height hCreate)
+{
+	if (wlk.m_SpendHeight != MaxHeight)
+		return true;
+
+	return ITxoWalker::OnTxo(wlk, hCreate);
+}
+
+// Bulk load. The DB is read sequentially, the naked TXOs are decoded in parallel, sorted by the key, and then appended to the tree in a single pass.
+// The IDs of the duplicated keys come in ascending order, hence the resulting tree is the same as if the TXOs were inserted one by one.
+struct NodeProcessor::UtxosBuilderMT
+	:public ITxoWalker
+{
+	static const uint32_t s_Batch = 0x10000;
+
+	struct Item
+	{
+		TxoID m_ID;
+		Height m_hCreate;
+		uint32_t m_Size;
+		uint8_t m_pNaked[s_TxoNakedMax];
+	};
+
+	struct Element
+	{
+		UtxoTree::Key m_Key;
+		TxoID m_ID;
+
+		bool operator < (const Element& x) const
+		{
+			int n = m_Key.V.cmp(x.m_Key.V);
+			return (n < 0) || (!n && (m_ID < x.m_ID));
+		}
+	};
+
+	NodeProcessor& m_This;
+	TxoID m_TxosTotal;
+	std::vector<Item> m_vItems;
+	uint32_t m_Count = 0;
+	std::vector<Element> m_vRes;
+
+	UtxosBuilderMT(NodeProcessor& x)
+		:m_This(x)
+	{
+		m_vItems.resize(s_Batch);
+		m_TxosTotal = x.get_TxosBefore(x.m_Cursor.m_ID.m_Height + 1);
+	}
+
+	struct MyTask
+		:public Executor::TaskSync
+	{
+		UtxosBuilderMT* m_pThis;
+		Element* m_pRes;
+
+		virtual void Exec(Executor::Context& ctx) override
+		{
+			uint32_t i0, nCount;
+			ctx.get_Portion(i0, nCount, m_pThis->m_Count);
+
+			for (uint32_t i = 0; i < nCount; i++)
+				Decode(m_pRes[i0 + i], m_pThis->m_vItems[i0 + i]);
+		}
+	};
+
+	static void Decode(Element& trg, const Item& x)
+	{
+		Deserializer der;
+		der.reset(x.m_pNaked, x.m_Size);
+
+		Output outp;
+		der & outp;
+
+		UtxoTree::Key::Data d;
+		d.m_Commitment = outp.m_Commitment;
+		d.m_Maturity = outp.get_MinMaturity(x.m_hCreate);
+
+		trg.m_Key = d;
+		trg.m_ID = x.m_ID;
+	}
+
+	virtual bool OnTxo(const NodeDB::WalkerTxo& wlk, Height hCreate) override
+	{
+		m_This.InitializeUtxosProgress(wlk.m_ID, m_TxosTotal);
+
+		if (wlk.m_SpendHeight != MaxHeight)
+			return true;
+
+		Item& x = m_vItems[m_Count++];
+		x.m_ID = wlk.m_ID;
+		x.m_hCreate = hCreate;
+
+		Blob v = wlk.m_Value;
+		TxoToNaked(x.m_pNaked, v);
+		x.m_Size = v.n;
+
+		if (m_Count == s_Batch)
+			Flush();
+
+		return true;
+	}
+
+	void Flush()
+	{
+		if (!m_Count)
+			return;
+
+		size_t n0 = m_vRes.size();
+		m_vRes.resize(n0 + m_Count);
+
+		MyTask t;
+		t.m_pThis = this;
+		t.m_pRes = &m_vRes[n0];
+		m_This.get_Executor().ExecAll(t);
+
+		m_Count = 0;
+	}
+
+	struct SortTask
+		:public Executor::TaskSync
+	{
+		std::vector<Element>* m_pV;
+		std::vector<uint32_t> m_vBounds;
+
+		virtual void Exec(Executor::Context& ctx) override
+		{
+			uint32_t i0, nCount;
+			ctx.get_Portion(i0, nCount, static_cast<uint32_t>(m_pV->size()));
+
+			std::sort(m_pV->begin() + i0, m_pV->begin() + i0 + nCount);
+			m_vBounds[ctx.m_iThread + 1] = i0 + nCount;
+		}
+	};
+
+	void Sort()
+	{
+		// sort the portions in parallel, then merge them
+		SortTask t;
+		t.m_pV = &m_vRes;
+		t.m_vBounds.resize(m_This.get_Executor().get_Threads() + 1, 0);
+		m_This.get_Executor().ExecAll(t);
+
+		uint32_t nPortions = static_cast<uint32_t>(t.m_vBounds.size() - 1);
+		for (uint32_t nStep = 1; nStep < nPortions; nStep <<= 1)
+		{
+			for (uint32_t i = 0; i + nStep < nPortions; i += (nStep << 1))
+			{
+				uint32_t iEnd = std::min(i + (nStep << 1), nPortions);
+				std::inplace_merge(m_vRes.begin() + t.m_vBounds[i], m_vRes.begin() + t.m_vBounds[i + nStep], m_vRes.begin() + t.m_vBounds[iEnd]);
+			}
+		}
+	}
+
+	void Build()
+	{
+		UtxoTree::Cursor cu;
+		for (size_t i = 0; i < m_vRes.size(); i++)
+		{
+			UtxoTree::MyLeaf* p = m_This.m_Utxos.Append(cu, m_vRes[i].m_Key, m_vRes[i].m_ID);
+			if (!p->get_Count())
+				OnCorrupted(); // overflow
+		}
+	}
+};
+
+void NodeProcessor::InitializeUtxos()
+{
+	assert(!m_Extra.m_Txos);
+
+	UtxosBuilderMT wlk(*this);
+	EnumTxos(wlk);
+	wlk.Flush();
+
+	std::vector<UtxosBuilderMT::Item>().swap(wlk.m_vItems);
+
+	wlk.Sort();
+	wlk.Build();
+}
+
+struct NodeProcessor::Snapshot
+{
+	static const uint32_t s_Version = 1;
+	static const uint32_t s_Batch = 0x1000; // headers verified at once
+	static const uint8_t s_FlagInput = 2; // OR-ed with Y of the shielded input key, see HandleKernel(TxKernelShieldedInput)
+
+	typedef yas::binary_oarchive<std::FStream, SERIALIZE_OPTIONS> Writer;
+	typedef yas::binary_iarchive<std::FStream, SERIALIZE_OPTIONS> Reader;
+
+	static void Fail(const char* sz)
+	{
+		std::ostringstream os;
+		os << "Snapshot: " << sz;
+		throw std::runtime_error(os.str());
+	}
+
+	// the lowest height of the kernels visible to the block that follows h
+	static Height get_KernelsLo(Height h)
+	{
+		const Rules& r = Rules::get();
+		if ((h + 1 >= r.pForks[2].m_Height) && (h + 1 - Rules::HeightGenesis > r.MaxKernelValidityDH))
+			return h + 1 - r.MaxKernelValidityDH;
+
+		return Rules::HeightGenesis;
+	}
+
+	struct ShieldedItem
+	{
+		TxoID m_MmrIndex;
+		TxoID m_ID; // outputs only
+		Height m_Height;
+		ECC::Point m_Key; // SerialPub or SpendPk (unflagged)
+		ECC::Point m_Commitment; // outputs only
+		bool m_Output;
+
+		bool operator < (const ShieldedItem& x) const { return m_MmrIndex < x.m_MmrIndex; }
+	};
+
+	struct KrnMmr
+		:public Merkle::FlyMmr
+	{
+		const std::vector<Merkle::Hash>& m_v;
+
+		KrnMmr(const std::vector<Merkle::Hash>& v)
+			:Merkle::FlyMmr(v.size())
+			,m_v(v)
+		{
+		}
+
+		virtual void LoadElement(Merkle::Hash& hv, uint64_t n) const override {
+			assert(n < m_Count);
+			hv = m_v[n];
+		}
+	};
+
+	struct Hdr
+	{
+		Block::SystemState::Full m_State;
+		TxoID m_Txos;
+		bool m_Valid;
+	};
+
+	struct PoWTask
+		:public Executor::TaskSync
+	{
+		std::vector<Hdr>* m_pV;
+
+		virtual void Exec(Executor::Context& ctx) override
+		{
+			uint32_t i0, nCount;
+			ctx.get_Portion(i0, nCount, static_cast<uint32_t>(m_pV->size()));
+
+			for (uint32_t i = 0; i < nCount; i++)
+			{
+				Hdr& x = (*m_pV)[i0 + i];
+				x.m_Valid = x.m_State.IsValid();
+			}
+		}
+	};
+};
+
+void NodeProcessor::ExportSnapshot(const char* sz)
+{
+	if (m_Cursor.m_ID.m_Height < Rules::HeightGenesis)
+		Snapshot::Fail("no state");
+	if (IsFastSync())
+		Snapshot::Fail("fast-sync in progress");
+
+	const Height hTop = m_Cursor.m_ID.m_Height;
+
+	std::FStream fs;
+	fs.Open(sz, false, true);
+	Snapshot::Writer ser(fs);
+
+	uint32_t nVer = Snapshot::s_Version;
+	ser & nVer;
+	ser & Rules::get().get_LastFork().m_Hash;
+	ser & hTop;
+
+	ByteBuffer bb;
+	if (!(Rules::get().TreasuryChecksum == Zero))
+		m_DB.ParamGet(NodeDB::ParamID::Treasury, nullptr, nullptr, &bb);
+
+	ser & m_Extra.m_TxosTreasury;
+	ser & bb;
+
+	// headers, with the TXO counts after each block
+	Block::SystemState::Full s;
+	for (Height h = Rules::HeightGenesis; h <= hTop; h++)
+	{
+		uint64_t row = FindActiveAtStrict(h);
+		m_DB.get_State(row, s);
+		TxoID nTxos = m_DB.get_StateTxos(row);
+
+		ser & s;
+		ser & nTxos;
+	}
+
+	ECC::Scalar offs;
+	if (!m_DB.get_StateExtra(m_Cursor.m_Sid.m_Row, offs))
+		OnCorrupted();
+	ser & offs;
+
+	// unspent TXOs
+	NodeDB::WalkerTxo wlk;
+	for (m_DB.EnumTxos(wlk, 0); wlk.MoveNext(); )
+	{
+		if (wlk.m_SpendHeight != MaxHeight)
+			continue;
+
+		wlk.m_Value.Export(bb);
+		ser & wlk.m_ID;
+		ser & bb;
+	}
+
+	ser & MaxHeight; // terminator
+
+	// shielded ins/outs, in the MMR order
+	std::vector<Snapshot::ShieldedItem> vShielded;
+	vShielded.reserve(m_Mmr.m_Shielded.m_Count);
+
+	NodeDB::WalkerKey wlkU;
+	for (m_DB.EnumUnique(wlkU); wlkU.MoveNext(); )
+	{
+		Snapshot::ShieldedItem& x = vShielded.emplace_back();
+		if (sizeof(x.m_Key) != wlkU.m_Key.n)
+			OnCorrupted();
+		memcpy(&x.m_Key, wlkU.m_Key.p, sizeof(x.m_Key));
+
+		NodeDB::Recordset rs;
+		if (!m_DB.UniqueFind(Blob(&x.m_Key, sizeof(x.m_Key)), rs))
+			OnCorrupted();
+
+		x.m_Output = !(Snapshot::s_FlagInput & x.m_Key.m_Y);
+		if (x.m_Output)
+		{
+			const ShieldedOutpPacked& sop = rs.get_As<ShieldedOutpPacked>(0);
+			sop.m_MmrIndex.Export(x.m_MmrIndex);
+			sop.m_Height.Export(x.m_Height);
+			sop.m_TxoID.Export(x.m_ID);
+			x.m_Commitment = sop.m_Commitment;
+		}
+		else
+		{
+			const ShieldedInpPacked& sip = rs.get_As<ShieldedInpPacked>(0);
+			sip.m_MmrIndex.Export(x.m_MmrIndex);
+			sip.m_Height.Export(x.m_Height);
+			x.m_Key.m_Y &= ~Snapshot::s_FlagInput;
+		}
+	}
+
+	std::sort(vShielded.begin(), vShielded.end());
+
+	uint64_t nShielded = vShielded.size();
+	if (m_Mmr.m_Shielded.m_Count != nShielded)
+		OnCorrupted();
+
+	ser & nShielded;
+
+	TxoID nOuts = 0;
+	for (uint64_t i = 0; i < nShielded; i++)
+	{
+		const Snapshot::ShieldedItem& x = vShielded[i];
+		if (x.m_MmrIndex != i)
+			OnCorrupted();
+
+		ser & x.m_Output;
+		ser & x.m_Height;
+		ser & x.m_Key;
+
+		if (x.m_Output)
+		{
+			if (x.m_ID != nOuts++)
+				OnCorrupted();
+			ser & x.m_Commitment;
+		}
+	}
+
+	std::vector<Snapshot::ShieldedItem>().swap(vShielded);
+
+	// assets
+	std::vector<Asset::Full> vAssets;
+	Asset::Full ai;
+	ai.m_ID = 0;
+
+	while (m_DB.AssetGetNext(ai))
+		vAssets.push_back(ai);
+
+	ser & vAssets;
+
+	// kernel IDs of the blocks within the visibility horizon
+	Height hKrn0 = Snapshot::get_KernelsLo(hTop);
+	ser & hKrn0;
+
+	std::vector<Merkle::Hash> vKrn;
+	for (Height h = hKrn0; h <= hTop; h++)
+	{
+		m_DB.GetStateBlock(FindActiveAtStrict(h), nullptr, &bb, nullptr);
+		if (bb.empty())
+			Snapshot::Fail("block data unavailable");
+
+		TxVectors::Eternal txve;
+		Deserializer der;
+		der.reset(bb);
+		der & txve;
+
+		vKrn.resize(txve.m_vKernels.size());
+		for (size_t i = 0; i < vKrn.size(); i++)
+			vKrn[i] = txve.m_vKernels[i]->m_Internal.m_ID;
+
+		ser & vKrn;
+	}
+
+	ser & nVer; // trailer, to detect truncation
+
+	fs.Flush();
+
+	LOG_INFO() << "Snapshot exported at " << m_Cursor.m_ID;
+}
+
+void NodeProcessor::ImportSnapshot(const char* szPath, const char* szSnapshot)
+{
+	if ((m_Cursor.m_ID.m_Height >= Rules::HeightGenesis) || m_DB.ParamGet(NodeDB::ParamID::Treasury, nullptr, nullptr))
+		Snapshot::Fail("the DB is not empty");
+
+	LOG_INFO() << "Importing snapshot...";
+
+	try
+	{
+		ImportSnapshotInternal(szSnapshot);
+
+		LOG_INFO() << "Building UTXO image...";
+		InitUtxoMapping(szPath, true);
+		InitializeUtxos();
+
+		if (!TestDefinition())
+			Snapshot::Fail("Definition mismatch");
+	}
+	catch (...)
+	{
+		// leave the DB empty
+		m_Utxos.Close();
+		m_DbTx.Rollback();
+		m_Mmr.CloseImages(); // contain the rolled-back data, remain dirty
+		throw;
+	}
+
+	LOG_INFO() << "Snapshot imported at " << m_Cursor.m_ID;
+}
+
+void NodeProcessor::ImportSnapshotInternal(const char* sz)
+{
+	std::FStream fs;
+	fs.Open(sz, true, true);
+	Snapshot::Reader der(fs);
+
+	uint32_t nVer;
+	der & nVer;
+	if (Snapshot::s_Version != nVer)
+		Snapshot::Fail("unsupported version");
+
+	Merkle::Hash hv;
+	der & hv;
+	if (Rules::get().get_LastFork().m_Hash != hv)
+		Snapshot::Fail("incompatible configuration");
+
+	Height hTop;
+	der & hTop;
+	if (hTop < Rules::HeightGenesis)
+		Snapshot::Fail("no state");
+
+	// treasury
+	TxoID nTxosTreasury;
+	ByteBuffer bb;
+	der & nTxosTreasury;
+	der & bb;
+
+	if (Rules::get().TreasuryChecksum == Zero)
+	{
+		if ((m_Extra.m_TxosTreasury != nTxosTreasury) || !bb.empty())
+			Snapshot::Fail("unexpected treasury");
+	}
+	else
+	{
+		ECC::Hash::Processor()
+			<< Blob(bb)
+			>> hv;
+
+		if (Rules::get().TreasuryChecksum != hv)
+			Snapshot::Fail("treasury mismatch");
+
+		Treasury::Data td;
+		Deserializer der2;
+		der2.reset(bb);
+		der2 & td;
+
+		TxoID nOuts = 0;
+		for (size_t iG = 0; iG < td.m_vGroups.size(); iG++)
+			nOuts += td.m_vGroups[iG].m_Data.m_vOutputs.size();
+
+		if (nOuts + 1 != nTxosTreasury)
+			Snapshot::Fail("treasury TXOs mismatch");
+
+		m_Extra.m_TxosTreasury = nTxosTreasury;
+
+		Blob blob(bb);
+		m_DB.ParamSet(NodeDB::ParamID::Treasury, &m_Extra.m_TxosTreasury, &blob);
+	}
+
+	// headers. Verified the same way as during the sync, the PoW in parallel
+	TxoID nTxos = m_Extra.m_TxosTreasury;
+	Timestamp tsMax = getTimestamp() + Rules::get().DA.MaxAhead_s;
+
+	PeerID pid;
+	ZeroObject(pid);
+
+	std::vector<Snapshot::Hdr> vHdrs;
+
+	for (Height h = Rules::HeightGenesis; h <= hTop; )
+	{
+		vHdrs.resize(static_cast<size_t>(std::min<Height>(Snapshot::s_Batch, hTop - h + 1)));
+		for (size_t i = 0; i < vHdrs.size(); i++)
+		{
+			der & vHdrs[i].m_State;
+			der & vHdrs[i].m_Txos;
+		}
+
+		Snapshot::PoWTask t;
+		t.m_pV = &vHdrs;
+		get_Executor().ExecAll(t);
+
+		for (size_t i = 0; i < vHdrs.size(); i++, h++)
+		{
+			const Block::SystemState::Full& s = vHdrs[i].m_State;
+
+			if (!vHdrs[i].m_Valid)
+				Snapshot::Fail("header invalid");
+
+			if ((s.m_Height != h) || (s.m_Prev != m_Cursor.m_ID.m_Hash))
+				Snapshot::Fail("headers not chained");
+
+			Difficulty::Raw wrk = m_Cursor.m_Full.m_ChainWork + s.m_PoW.m_Difficulty;
+			if (wrk != s.m_ChainWork)
+				Snapshot::Fail("chainwork mismatch");
+
+			if (m_Cursor.m_DifficultyNext.m_Packed != s.m_PoW.m_Difficulty.m_Packed)
+				Snapshot::Fail("difficulty mismatch");
+
+			if ((s.m_TimeStamp <= get_MovingMedian()) || (s.m_TimeStamp > tsMax))
+				Snapshot::Fail("timestamp inconsistent");
+
+			if (vHdrs[i].m_Txos < nTxos)
+				Snapshot::Fail("TXO counts inconsistent");
+			nTxos = vHdrs[i].m_Txos;
+
+			Block::SystemState::ID id;
+			s.get_ID(id);
+			if (m_DB.StateFindSafe(id))
+				Snapshot::Fail("the DB is not empty");
+
+			NodeDB::StateID sid;
+			sid.m_Height = h;
+			sid.m_Row = m_DB.InsertState(s, pid);
+			m_DB.SetStateFunctional(sid.m_Row);
+			m_DB.set_StateTxosAndExtra(sid.m_Row, &nTxos, nullptr, nullptr);
+
+			if (m_Cursor.m_ID.m_Height >= Rules::HeightGenesis)
+				m_Mmr.m_States.Append(m_Cursor.m_ID.m_Hash);
+
+			m_DB.MoveFwd(sid);
+			m_Cursor.m_Sid = sid;
+			m_Cursor.m_Full = s;
+			InitCursor(true);
+
+			m_RecentStates.Push(sid.m_Row, s);
+		}
+	}
+
+	std::vector<Snapshot::Hdr>().swap(vHdrs);
+
+	ECC::Scalar offs;
+	der & offs;
+
+	Blob blobExtra(offs.m_Value);
+	m_DB.set_StateTxosAndExtra(m_Cursor.m_Sid.m_Row, &nTxos, &blobExtra, nullptr);
+
+	// unspent TXOs
+	for (TxoID idNext = 0; ; )
+	{
+		TxoID id;
+		der & id;
+		if (MaxHeight == id)
+			break;
+
+		if ((id < idNext) || (id >= nTxos))
+			Snapshot::Fail("TXOs inconsistent");
+		idNext = id + 1;
+
+		der & bb;
+
+		Output outp;
+		Deserializer der2;
+		der2.reset(bb);
+		der2 & outp;
+
+		m_DB.TxoAdd(id, Blob(bb));
+	}
+
+	// shielded
+	uint64_t nShielded;
+	der & nShielded;
+
+	std::vector<ECC::Point::Storage> vPts;
+	Height hPrev = 0;
+
+	for (uint64_t i = 0; i < nShielded; i++)
+	{
+		bool bOutput;
+		Height h;
+		ECC::Point key;
+		der & bOutput;
+		der & h;
+		der & key;
+
+		if ((h < hPrev) || (h > hTop) || (key.m_Y > 1))
+			Snapshot::Fail("shielded inconsistent");
+		hPrev = h;
+
+		if (bOutput)
+		{
+			ShieldedTxo::DescriptionOutp d;
+			d.m_SerialPub = key;
+			d.m_ID = vPts.size();
+			d.m_Height = h;
+			der & d.m_Commitment;
+			d.get_Hash(hv);
+
+			ShieldedOutpPacked sop;
+			sop.m_Height = h;
+			sop.m_MmrIndex = i;
+			sop.m_TxoID = d.m_ID;
+			sop.m_Commitment = d.m_Commitment;
+
+			Blob blobVal(&sop, sizeof(sop));
+			if (!m_DB.UniqueInsertSafe(Blob(&key, sizeof(key)), &blobVal))
+				Snapshot::Fail("shielded duplicate");
+
+			ECC::Point::Native pt, pt2;
+			pt.Import(d.m_Commitment); // don't care if Import fails, as during the block interpretation
+			pt2.Import(key);
+			pt += pt2;
+			pt.Export(vPts.emplace_back());
+		}
+		else
+		{
+			ShieldedTxo::DescriptionInp d;
+			d.m_SpendPk = key;
+			d.m_Height = h;
+			d.get_Hash(hv);
+
+			ShieldedInpPacked sip;
+			sip.m_Height = h;
+			sip.m_MmrIndex = i;
+
+			key.m_Y |= Snapshot::s_FlagInput;
+
+			Blob blobVal(&sip, sizeof(sip));
+			if (!m_DB.UniqueInsertSafe(Blob(&key, sizeof(key)), &blobVal))
+				Snapshot::Fail("shielded duplicate");
+		}
+
+		m_Mmr.m_Shielded.Append(hv);
+	}
+
+	m_Extra.m_ShieldedOutputs = vPts.size();
+	if (!vPts.empty())
+	{
+		m_DB.ShieldedResize(vPts.size(), 0);
+		m_DB.ShieldedWrite(0, &vPts.front(), vPts.size());
+	}
+
+	m_DB.ParamIntSet(NodeDB::ParamID::ShieldedOutputs, m_Extra.m_ShieldedOutputs);
+	m_DB.ParamIntSet(NodeDB::ParamID::ShieldedInputs, nShielded - m_Extra.m_ShieldedOutputs);
+
+	// assets
+	std::vector<Asset::Full> vAssets;
+	der & vAssets;
+
+	for (size_t i = 0; i < vAssets.size(); i++)
+	{
+		const Asset::Full& ai = vAssets[i];
+		if ((ai.m_ID <= m_Mmr.m_Assets.m_Count) || (ai.m_ID > Asset::s_MaxCount))
+			Snapshot::Fail("assets inconsistent");
+
+		m_DB.AssetAddAt(ai);
+
+		// unused slots
+		while (m_Mmr.m_Assets.m_Count + 1 < ai.m_ID)
+		{
+			m_Mmr.m_Assets.ResizeTo(m_Mmr.m_Assets.m_Count + 1);
+			m_Mmr.m_Assets.Replace(m_Mmr.m_Assets.m_Count - 1, Zero);
+		}
+
+		m_Mmr.m_Assets.ResizeTo(ai.m_ID);
+		ai.get_Hash(hv);
+		m_Mmr.m_Assets.Replace(ai.m_ID - 1, hv);
+	}
+
+	// kernels
+	Height hKrn0;
+	der & hKrn0;
+	if (Snapshot::get_KernelsLo(hTop) != hKrn0)
+		Snapshot::Fail("kernels range mismatch");
+
+	std::vector<Merkle::Hash> vKrn;
+	Block::SystemState::Full s;
+
+	for (Height h = hKrn0; h <= hTop; h++)
+	{
+		der & vKrn;
+
+		m_DB.get_State(FindActiveAtStrict(h), s);
+
+		Snapshot::KrnMmr fmmr(vKrn);
+		fmmr.get_Hash(hv);
+		if (s.m_Kernels != hv)
+			Snapshot::Fail("kernel commitment mismatch");
+
+		for (size_t i = 0; i < vKrn.size(); i++)
+			m_DB.InsertKernel(vKrn[i], h);
+	}
+
+	der & nVer;
+	if (Snapshot::s_Version != nVer)
+		Snapshot::Fail("corrupted");
+
+	// nothing below the snapshot height
+	m_Extra.m_Fossil = m_Extra.m_TxoLo = m_Extra.m_TxoHi = hTop;
+	m_DB.ParamIntSet(NodeDB::ParamID::FossilHeight, hTop);
+	m_DB.ParamIntSet(NodeDB::ParamID::HeightTxoLo, hTop);
+	m_DB.ParamIntSet(NodeDB::ParamID::HeightTxoHi, hTop);
+}
+
+void NodeProcessor::BackupStart(const char* sz)
+{
+	BackupAbort();
+
+	if (m_DbTx.IsInProgress())
+		CommitDB(); // the backup reads via our connection, must start from the committed data
+
+	std::string sUtxos;
+	get_UtxoMappingPath(sUtxos, sz);
+
+	try
+	{
+		m_Backup.m_Db.Open(m_DB, sz);
+		m_Backup.m_Utxos.Open(sUtxos.c_str(), m_Utxos.get_Mapping());
+	}
+	catch (const std::exception&)
+	{
+		m_Backup.m_Db.Close();
+		m_Backup.m_Utxos.Close();
+		throw;
+	}
+
+	LOG_INFO() << "Backup started: " << sz;
+}
+
+void NodeProcessor::BackupAbort()
+{
+	if (!IsBackupInProgress())
+		return;
+
+	m_Backup.m_Db.Close();
+	m_Backup.m_Utxos.Close();
+
+	LOG_WARNING() << "Backup aborted";
+	OnBackupOver(false);
+}
+
+void NodeProcessor::BackupStep()
+{
+	// called between the transactions, both the DB and the image are at the same commit
+	try
+	{
+		bool bDb = m_Backup.m_Db.Step(m_Backup.m_DbPages);
+
+		// finalize the image only when the DB is ready to complete at the same commit
+		if (!m_Backup.m_Utxos.Step(m_Backup.m_UtxoChunks, bDb) || !bDb)
+			return;
+
+		m_Backup.m_Utxos.Close();
+		m_Backup.m_Db.Finalize();
+	}
+	catch (const std::exception& e)
+	{
+		LOG_ERROR() << "Backup failed: " << e.what();
+		BackupAbort();
+		return;
+	}
+
+	LOG_INFO() << "Backup completed at " << m_Cursor.m_ID;
+	OnBackupOver(true);
 }
 
 bool NodeProcessor::GetBlock(const NodeDB::StateID& sid, ByteBuffer* pEthernal, ByteBuffer* pPerishable, Height h0, Height hLo1, Height hHi1, bool bActive)
@@ -53,6 +53,7 @@ class NodeProcessor
 	void InitializeUtxos();
 	bool TestDefinition();
 	void CommitUtxosAndDB();
+	void BackupStep();
 	void RequestDataInternal(const Block::SystemState::ID&, uint64_t row, bool bBlock, const NodeDB::StateID& sidTrg);
 
 	bool HandleTreasury(const Blob&);
@@ -88,9 +89,48 @@ class NodeProcessor
 	BeamKernelsAll(THE_MACRO)
 #undef THE_MACRO
 
-	static uint64_t ProcessKrnMmr(Merkle::Mmr&, std::vector<TxKernel::Ptr>&, const Merkle::Hash& idKrn, TxKernel::Ptr* ppRes);
+	// Kernel MMRs of recently queried blocks, to answer kernel proofs without decoding the block each time
+	struct KrnMmrCache
+	{
+		static const size_t s_MaxSize = 1024 * 1024 * 16;
+
+		struct Item
+			:public boost::intrusive::set_base_hook<>
+			,public boost::intrusive::list_base_hook<>
+		{
+			typedef std::pair<Merkle::Hash, uint32_t> Entry; // kernel ID -> index within block
+
+			uint64_t m_Row;
+			std::vector<Entry> m_vSorted;
+			Merkle::FixedMmr m_Mmr;
+
+			size_t get_Size() const { return m_vSorted.size() * (sizeof(Entry) + sizeof(Merkle::Hash) * 2); }
+			bool operator < (const Item& x) const { return (m_Row < x.m_Row); }
+
+			uint64_t Find(const Merkle::Hash& idKrn) const; // returns -1 if not found
+		};
+
+		typedef boost::intrusive::list<Item> List; // LRU order, the most recently used is at the back
+		typedef boost::intrusive::multiset<Item> Set;
+
+		List m_lst;
+		Set m_set;
+		size_t m_Size = 0;
+
+		const Item* Find(uint64_t row);
+		const Item& Insert(uint64_t row, const std::vector<TxKernel::Ptr>&);
+		void Delete(uint64_t row);
+		void Delete(Item&);
+		void Clear();
+
+		~KrnMmrCache() { Clear(); }
+
+	} m_KrnMmrCache;
 
 	struct KrnFlyMmr;
+	struct TxoRecoverMT;
+	struct UtxosBuilderMT;
+	struct Snapshot;
 
 	static const uint32_t s_TxoNakedMin = sizeof(ECC::Point); // minimal output size - commitment
 	static const uint32_t s_TxoNakedMax = s_TxoNakedMin + 0x10; // In case the output has the Incubation period - extra size is needed (actually less than this).
@@ -106,6 +146,14 @@ class NodeProcessor
 	void InitCursor(bool bMovingUp);
 	bool InitUtxoMapping(const char*, bool bForceReset);
 	void InitializeUtxos(const char*);
+	void InitializeMmrImages(const char*);
+	void ImportSnapshot(const char* szPath, const char* szSnapshot);
+	void ImportSnapshotInternal(const char*);
+	void InitializeFilters();
+	void InitializeFilterUtxos();
+	void InitializeFilterKernels();
+	void InitializeFilterUnique();
+	void RebuildOverfilledFilters();
 	static void OnCorrupted();
 
 	typedef std::pair<int64_t, std::pair<int64_t, Difficulty::Raw> > THW; // Time-Height-Work. Time and Height are signed
@@ -169,12 +217,14 @@ public:
 		bool m_Vacuum = false;
 		bool m_ResetSelfID = false;
 		bool m_EraseSelfID = false;
+		std::string m_sSnapshot; // state snapshot to import. Allowed for the empty DB only
 	};
 
 	void Initialize(const char* szPath);
 	void Initialize(const char* szPath, const StartParams&);
 
 	static void get_UtxoMappingPath(std::string&, const char*);
+	static void get_DerivedPath(std::string&, const char* szDbPath, const char* szName);
 
 	NodeProcessor();
 	virtual ~NodeProcessor();
@@ -235,6 +285,43 @@ public:
 
 	} m_SyncData;
 
+	// In-memory Bloom filters in front of the UTXO, kernel and unique (shielded) lookups.
+	// The keys are commitments and hashes, i.e. already uniformly distributed, the probe positions are taken directly from them.
+	// Insert-only: the spent/reverted keys remain as false positives until the next rebuild. Hence a negative answer is always exact.
+	struct MembershipFilter
+	{
+		static const uint32_t s_Probes = 6;
+		static const uint32_t s_BitsPerKey = 16; // for the designed capacity. Less than 0.1% false positives
+
+		std::vector<uint64_t> m_vWords;
+		uint64_t m_Capacity = 0;
+		uint64_t m_Inserted = 0;
+
+		// stats
+		uint64_t m_Rejected = 0; // negatives, the lookup was skipped
+		uint64_t m_Missed = 0; // passed the filter, but the lookup failed
+
+		bool IsEnabled() const { return !m_vWords.empty(); }
+		bool IsOverfilled() const { return m_Inserted > m_Capacity; }
+		double get_FalsePositiveRate() const;
+
+		void Reset(uint64_t nKeys); // allocates with the capacity twice the given number of keys
+		void Insert(const Blob&);
+		bool MayContain(const Blob&) const; // always true if disabled
+		bool Test(const Blob&); // same as MayContain, updates the stats
+		void OnMissed() { m_Missed++; }
+
+	private:
+		bool Probe(const Blob&, bool bSet);
+	};
+
+	struct Filters
+	{
+		MembershipFilter m_Utxos; // commitments
+		MembershipFilter m_Kernels; // kernel IDs
+		MembershipFilter m_Unique; // shielded serials and spend keys
+	} m_Filters;
+
 	bool IsFastSync() const { return m_SyncData.m_Target.m_Row != 0; }
 
 	void SaveSyncData();
@@ -309,6 +396,7 @@ public:
 
 	void EnumCongestions();
 	const uint64_t* get_CachedRows(const NodeDB::StateID&, Height nCountExtra); // retval valid till next call to this func, or to EnumCongestions()
+	const uint64_t* FindCachedRows(const NodeDB::StateID&, Height nCountExtra); // same, but w/o cache refresh. Safe to call during EnumCongestions()
 	void TryGoUp();
 	void TryGoTo(NodeDB::StateID&);
 	void OnFastSyncOver(MultiblockContext&, bool& bContextFail);
@@ -323,7 +411,9 @@ public:
 	virtual void OnNewState() {}
 	virtual void OnRolledBack() {}
 	virtual void OnModified() {}
+	virtual void OnBackupOver(bool bSuccess) {}
 	virtual void InitializeUtxosProgress(uint64_t done, uint64_t total) {}
+	virtual void RescanOwnedTxosProgress(uint64_t done, uint64_t total) {}
 
 	struct MyExecutor
 		:public Executor
@@ -424,6 +514,10 @@ public:
 		virtual bool OnTxo(const NodeDB::WalkerTxo&, Height hCreate, Output&, const CoinID&) = 0;
 	};
 
+	// Same as EnumTxos, but the recovery attempts are run in batches on the executor threads.
+	// The recognized Txos are still reported in the TXO order, on the calling thread.
+	bool EnumTxosRecoverMT(ITxoRecover&);
+
 	struct ITxoWalker_UnspentNaked
 		:public ITxoWalker
 	{
@@ -438,6 +532,25 @@ public:
 
 	bool EnumKernels(IKrnWalker&, const HeightRange&);
 
+	// Consistent state at the cursor: headers, unspent TXOs, shielded ins/outs, assets, and the kernels visible to the next block.
+	// Verified on import against the headers and the Definition of the last one. Throws on error.
+	void ExportSnapshot(const char*);
+
+	// Hot backup of the DB and the UTXO image, made while the node is running. Progressed by bounded portions on each commit (see CommitDB),
+	// both copies are completed at the same commit, once the image modifications left to copy fit a single portion. MMR images are not copied (rebuilt on start).
+	struct Backup
+	{
+		uint32_t m_DbPages = 0x400; // per commit
+		uint32_t m_UtxoChunks = 0x10; // per commit, of MappedFile::Copier::s_ChunkSize
+
+		NodeDB::Backup m_Db;
+		MappedFile::Copier m_Utxos;
+	} m_Backup;
+
+	void BackupStart(const char*); // the image path is derived from the DB path. Throws on error
+	void BackupAbort();
+	bool IsBackupInProgress() const { return m_Backup.m_Db.IsOpen(); }
+
 	struct KrnWalkerShielded
 		:public IKrnWalker
 	{
@@ -500,6 +613,11 @@ public:
 		NodeDB::StreamMmr m_Shielded;
 		NodeDB::StreamMmr m_Assets;
 
+		bool OpenImages(const char* szDbPath, const NodeDB::StreamMmr::Stamp&); // returns false if any was rebuilt
+		bool IsImageDirty() const;
+		void FlushImages(const NodeDB::StreamMmr::Stamp&);
+		void CloseImages();
+
 	} m_Mmr;
 
 private:
@@ -558,6 +558,15 @@ namespace beam
 		verify_test(db.FindKernel(bBodyP) == 7);
 		verify_test(db.FindKernel(bBodyE) == 0);
 
+		verify_test(db.get_KernelsCount() == 4);
+		{
+			uint32_t nKrns = 0;
+			NodeDB::WalkerKey wlk;
+			for (db.EnumKernels(wlk); wlk.MoveNext(); nKrns++)
+				verify_test(wlk.m_Key == bBodyP);
+			verify_test(nKrns == 4);
+		}
+
 		db.DeleteKernel(bBodyP, 7);
 		verify_test(db.FindKernel(bBodyP) == 5);
 		db.DeleteKernel(bBodyP, 5);
@@ -595,6 +604,14 @@ namespace beam
 		verify_test(db.UniqueInsertSafe(k1, nullptr));
 		verify_test(!db.UniqueInsertSafe(k1, nullptr));
 
+		verify_test(db.get_UniqueCount() == 1);
+		{
+			NodeDB::WalkerKey wlk;
+			db.EnumUnique(wlk);
+			verify_test(wlk.MoveNext() && (wlk.m_Key == Blob(k1)));
+			verify_test(!wlk.MoveNext());
+		}
+
 
 		// Assets
 		Asset::Full ai1, ai2;
@@ -645,6 +662,26 @@ namespace beam
 		verify_test(db.AssetDelete(4) == 1);
 		verify_test(db.AssetDelete(1) == 0);
 
+		// Explorer asset index, should deduce the same IDs
+		db.ExplorerIndexesCreate();
+		Merkle::Hash hvKrn(Zero);
+		verify_test(db.ExpAssetFindMinFree() == 1);
+
+		for (Asset::ID aid = 1; aid <= 3; aid++)
+			db.ExpAssetAdd(aid, 10, NodeDB::ExpAssetEvent::Create, 0, hvKrn);
+		db.ExpAssetAdd(2, 11, NodeDB::ExpAssetEvent::Emit, 5, hvKrn);
+		verify_test(db.ExpAssetFindMinFree() == 4);
+
+		db.ExpAssetAdd(2, 12, NodeDB::ExpAssetEvent::Destroy, 0, hvKrn);
+		verify_test(db.ExpAssetFindMinFree() == 2);
+		db.ExpAssetAdd(2, 13, NodeDB::ExpAssetEvent::Create, 0, hvKrn);
+		verify_test(db.ExpAssetFindMinFree() == 4);
+
+		db.ExplorerIndexesDelFrom(12);
+		verify_test(db.ExpAssetFindMinFree() == 4);
+		db.ExplorerIndexesDelFrom(0);
+		verify_test(db.ExpAssetFindMinFree() == 1);
+
 		// StreamMmr, test cache
 		struct MyMmr
 			:public NodeDB::StreamMmr
@@ -676,6 +713,74 @@ namespace beam
 		// in a 'friendly' scenario, where we only add and calculate root - cache must be 100% effective
 		verify_test(!myMmr.m_Miss);
 
+		// StreamMmr image must be consistent with the stream
+		{
+			std::string sImg = std::string(sz) + "-mmr-test.bin";
+			DeleteFile(sImg.c_str());
+
+			NodeDB::StreamMmr::Stamp s1 = 1U, s2 = 2U;
+
+			NodeDB::StreamMmr mmrImg(db, NodeDB::StreamType::ShieldedMmr, true);
+			mmrImg.m_Count = myMmr.m_Count;
+			verify_test(!mmrImg.OpenImage(sImg.c_str(), s1)); // created from the stream
+			verify_test(!mmrImg.IsImageDirty());
+
+			for (uint32_t i = 0; i < 300; i++)
+				mmrImg.Append(Merkle::Hash(i + 100));
+
+			verify_test(mmrImg.IsImageDirty());
+			mmrImg.ShrinkTo(250);
+			mmrImg.Append(Merkle::Hash(7U));
+
+			mmrImg.FlushImage(s1);
+			mmrImg.CloseImage();
+
+			auto fnCompare = [&db](const NodeDB::StreamMmr& mmr)
+			{
+				NodeDB::StreamMmr mmrRaw(db, NodeDB::StreamType::ShieldedMmr, true);
+				mmrRaw.m_Count = mmr.m_Count;
+
+				Merkle::Hash hv1, hv2;
+				mmr.get_Hash(hv1);
+				mmrRaw.get_Hash(hv2);
+				verify_test(hv1 == hv2);
+
+				for (uint64_t i = 0; i < mmr.m_Count; i += 17)
+				{
+					Merkle::Proof p1, p2;
+					mmr.get_Proof(p1, i);
+					mmrRaw.get_Proof(p2, i);
+					verify_test(p1 == p2);
+				}
+			};
+
+			for (uint32_t i = 0; i < 2; i++)
+			{
+				NodeDB::StreamMmr mmr(db, NodeDB::StreamType::ShieldedMmr, true);
+				mmr.m_Count = mmrImg.m_Count;
+
+				// reused with the same stamp, rebuilt otherwise
+				verify_test(mmr.OpenImage(sImg.c_str(), i ? s2 : s1) == !i);
+				fnCompare(mmr);
+			}
+
+			{
+				// modified, but not flushed (i.e. not committed): remains dirty, rebuilt despite the matching stamp
+				NodeDB::StreamMmr mmr(db, NodeDB::StreamType::ShieldedMmr, true);
+				mmr.m_Count = mmrImg.m_Count;
+				verify_test(mmr.OpenImage(sImg.c_str(), s2));
+
+				mmr.Append(Merkle::Hash(8U));
+				mmr.CloseImage();
+
+				verify_test(!mmr.OpenImage(sImg.c_str(), s2));
+				verify_test(!mmr.IsImageDirty());
+				fnCompare(mmr);
+			}
+
+			DeleteFile(sImg.c_str());
+		}
+
 		tr.Commit();
 	}
 
@@ -699,6 +804,129 @@ namespace beam
 		}
 	}
 
+	void TestBbsMemStore()
+	{
+		BbsMemStore mem;
+		mem.m_BucketDuration_s = 100;
+
+		NodeDB::BbsTotals totals;
+		ZeroObject(totals);
+
+		NodeDB::WalkerBbs::Data d;
+		d.m_Message.p = "hello";
+		d.m_Message.n = 5;
+		d.m_Nonce = 0;
+
+		const uint32_t nCount = 200;
+		for (uint32_t i = 0; i < nCount; i++)
+		{
+			d.m_Key = i + 1;
+			d.m_Channel = i % 7;
+			d.m_TimePosted = 1000 + i * 10 - (i % 3) * 20; // slightly out-of-order
+
+			verify_test(!mem.Find(d.m_Key));
+			verify_test(mem.Insert(d) == i + 1);
+			verify_test(mem.Find(d.m_Key));
+
+			totals.m_Count++;
+			totals.m_Size += d.m_Message.n;
+		}
+
+		// per-channel sequence
+		for (BbsChannel ch = 0; ch < 7; ch++)
+		{
+			uint32_t n = 0;
+			uint64_t id = 0;
+			for (auto it = mem.ChannelFrom(ch, 0); (mem.ChannelEnd() != it) && (it->m_Value == ch); it++, n++)
+			{
+				verify_test(it->m_ID > id);
+				id = it->m_ID;
+				verify_test((id - 1) % 7 == ch);
+			}
+
+			verify_test(n == (nCount - ch + 6) / 7);
+		}
+
+		auto itSeq = mem.SeqFrom(150);
+		verify_test((mem.SeqEnd() != itSeq) && (itSeq->m_Value == 151));
+
+		// cursor: lowest ID posted not earlier than the given time
+		for (Timestamp t = 900; t < 3200; t += 7)
+		{
+			uint64_t id = nCount + 1;
+			for (uint32_t i = 0; i < nCount; i++)
+				if (1000 + i * 10 - (i % 3) * 20 >= t)
+				{
+					id = i + 1;
+					break;
+				}
+
+			verify_test(mem.FindCursor(t) == id);
+		}
+
+		// expiration drops whole buckets only
+		NodeDB::BbsTotals lims;
+		lims.m_Count = nCount;
+		lims.m_Size = totals.m_Size;
+
+		mem.Cleanup(totals, 1250, lims);
+		verify_test(!mem.Find(21U)); // t=1160
+		verify_test(!mem.Find(24U)); // t=1190
+		verify_test(mem.Find(22U)); // t=1210
+		verify_test(mem.FindCursor(0) == 22);
+
+		// limits: drop the oldest
+		lims.m_Count = 50;
+		mem.Cleanup(totals, 1250, lims);
+		verify_test(totals.m_Count == 50);
+		verify_test(totals.m_Size == 50 * 5);
+		verify_test(mem.Find(nCount));
+
+		mem.Cleanup(totals, 10000, lims);
+		verify_test(!totals.m_Count && !totals.m_Size);
+		verify_test(mem.SeqEnd() == mem.SeqFrom(0));
+		verify_test(mem.FindCursor(0) == nCount + 1);
+	}
+
+	void TestMembershipFilter()
+	{
+		NodeProcessor::MembershipFilter f;
+		verify_test(!f.IsEnabled() && f.MayContain(Blob(nullptr, 0))); // disabled filter passes everything
+
+		const uint32_t nCount = 20000;
+		f.Reset(nCount);
+		verify_test(f.IsEnabled());
+
+		std::vector<Merkle::Hash> vKeys(nCount);
+		for (uint32_t i = 0; i < nCount; i++)
+		{
+			ECC::GenRandom(vKeys[i]);
+			f.Insert(vKeys[i]);
+		}
+
+		// no false negatives
+		for (uint32_t i = 0; i < nCount; i++)
+			verify_test(f.Test(vKeys[i]));
+		verify_test(!f.m_Rejected);
+
+		// false positives are rare
+		for (uint32_t i = 0; i < nCount; i++)
+		{
+			Merkle::Hash hv;
+			ECC::GenRandom(hv);
+			if (f.Test(hv))
+				f.OnMissed();
+		}
+
+		verify_test(f.m_Rejected + f.m_Missed == nCount);
+		verify_test(f.get_FalsePositiveRate() < 0.01);
+		verify_test(!f.IsOverfilled());
+
+		for (uint64_t i = f.m_Inserted; i <= f.m_Capacity; i++)
+			f.Insert(vKeys[i % nCount]);
+		verify_test(f.IsOverfilled());
+	}
+
 	struct MiniWallet
 	{
 		Key::IKdf::Ptr m_pKdf;
@@ -996,6 +1224,29 @@ namespace beam
 				const Input& inp = *block.m_vInputs[i];
 				verify_test(inp.m_Internal.m_ID && inp.m_Internal.m_Maturity);
 			}
+
+			// kernel proofs, built from scratch and from the cache
+			Block::SystemState::Full s;
+			np.get_DB().get_State(sid.m_Row, s);
+
+			for (size_t i = 0; i < block.m_vKernels.size(); i++)
+			{
+				const Merkle::Hash& idKrn = block.m_vKernels[i]->m_Internal.m_ID;
+
+				for (uint32_t iPass = 0; iPass < 2; iPass++)
+				{
+					Merkle::Proof proof;
+					TxKernel::Ptr pKrn;
+					verify_test(np.get_ProofKernel(proof, iPass ? &pKrn : nullptr, idKrn) == h);
+
+					Merkle::Hash hv = idKrn;
+					Merkle::Interpret(hv, proof);
+					verify_test(hv == s.m_Kernels);
+
+					if (iPass)
+						verify_test(pKrn && (pKrn->m_Internal.m_ID == idKrn));
+				}
+			}
 		}
 
 	}
@@ -1449,6 +1700,10 @@ namespace beam
 
 		node2.m_Cfg.m_BeaconPort = g_Port;
 
+		// compress whatever is compressible, to test the transport compression
+		node.m_Cfg.m_BandwidthCtl.m_CompressThreshold = 1;
+		node2.m_Cfg.m_BandwidthCtl.m_CompressThreshold = 1;
+
 		ECC::SetRandom(node);
 		ECC::SetRandom(node2);
 
@@ -1578,7 +1833,142 @@ namespace beam
 		DeleteFile(g_sz3);
 	}
 
+	void TestNodeParallelSync(bool bStalledPeer)
+	{
+		// Node0, Node1 (after the conversation test) -> Node2. Blocks are requested in small packs from both peers.
+		// If bStalledPeer - Node1 doesn't answer the block requests, its ranges must be re-requested from Node0 before the request timeout
+
+		io::Reactor::Ptr pReactor(io::Reactor::create());
+		io::Reactor::Scope scope(*pReactor);
+
+		Node node, node2, node3;
+		node.m_Cfg.m_sPathLocal = g_sz;
+		node.m_Cfg.m_Listen.port(g_Port);
+		node.m_Cfg.m_Listen.ip(INADDR_ANY);
+
+		node2.m_Cfg.m_sPathLocal = g_sz2;
+		node2.m_Cfg.m_Listen.port(g_Port + 1);
+		node2.m_Cfg.m_Listen.ip(INADDR_ANY);
+
+		node3.m_Cfg.m_sPathLocal = g_sz3;
+		node3.m_Cfg.m_Connect.resize(2);
+		node3.m_Cfg.m_Connect[0].resolve("127.0.0.1");
+		node3.m_Cfg.m_Connect[0].port(g_Port);
+		node3.m_Cfg.m_Connect[1].resolve("127.0.0.1");
+		node3.m_Cfg.m_Connect[1].port(g_Port + 1);
+		node3.m_Cfg.m_BandwidthCtl.m_MaxBodyPackCount = 8;
+		node3.m_Cfg.m_BandwidthCtl.m_MaxBodiesAhead = 30;
+
+		if (bStalledPeer)
+		{
+			node2.m_Cfg.m_TestMode.m_IgnoreBodyRequests = true;
+
+			node3.m_Cfg.m_Timeout.m_GetBlock_ms = 1000 * 60; // longer than the test
+			node3.m_Cfg.m_BandwidthCtl.m_BodyPackDuration_ms = 100;
+		}
+
+		ECC::SetRandom(node);
+		ECC::SetRandom(node2);
+		ECC::SetRandom(node3);
+
+		node.Initialize();
+		node2.Initialize();
+
+		const Height hTrg = node.get_Processor().m_Cursor.m_ID.m_Height;
+		verify_test(hTrg == node2.get_Processor().m_Cursor.m_ID.m_Height);
+
+		struct MyObserver
+			:public Node::IObserver
+		{
+			Node* m_pNode;
+			Node* m_pSrc;
+			Height m_hTrg;
+			uint64_t m_Done = 0;
+			uint32_t m_Updates = 0;
+
+			Height get_ContiguousHeight()
+			{
+				// highest block such that all the blocks below are received (not necessarily applied yet)
+				NodeProcessor& src = m_pSrc->get_Processor();
+				NodeDB& db = m_pNode->get_Processor().get_DB();
+
+				Height h = m_pNode->get_Processor().m_Cursor.m_ID.m_Height;
+				for (; h < m_hTrg; h++)
+				{
+					NodeDB::StateID sid;
+					sid.m_Height = h + 1;
+					sid.m_Row = src.FindActiveAtStrict(sid.m_Height);
+
+					Block::SystemState::ID id;
+					src.get_DB().get_StateID(sid, id);
+
+					uint64_t row = db.StateFindSafe(id);
+					if (!row || !(NodeDB::StateFlags::Functional & db.GetStateFlags(row)))
+						break;
+				}
+
+				return h;
+			}
+
+			virtual void OnSyncProgress() override
+			{
+				const Node::SyncStatus& s = m_pNode->m_SyncStatus;
+				m_Updates++;
+
+				verify_test(s.m_Done >= m_Done);
+				m_Done = s.m_Done;
+
+				// headers are accounted up to the target, blocks - only the contiguous ones (+ treasury)
+				uint64_t nMax = (m_hTrg + 1) * Node::SyncStatus::s_WeightHdr + (get_ContiguousHeight() + 1) * Node::SyncStatus::s_WeightBlock;
+				verify_test(s.m_Done <= nMax);
+			}
+		} obs;
+
+		obs.m_pNode = &node3;
+		obs.m_pSrc = &node;
+		obs.m_hTrg = hTrg;
+		node3.m_Cfg.m_Observer = &obs;
 
+		node3.Initialize();
+
+		struct MyTimer
+		{
+			Node* m_pNode;
+			Height m_hTrg;
+			uint32_t m_Cycles = 0;
+			io::Timer::Ptr m_pTimer;
+
+			void OnTimer()
+			{
+				if (m_pNode->get_Processor().m_Cursor.m_ID.m_Height == m_hTrg)
+					io::Reactor::get_Current().stop();
+				else
+				{
+					if (m_Cycles++ > 300)
+					{
+						fail_test("Sync didn't complete");
+						io::Reactor::get_Current().stop();
+					}
+				}
+			}
+		} t;
+
+		t.m_pNode = &node3;
+		t.m_hTrg = hTrg;
+		t.m_pTimer = io::Timer::create(*pReactor);
+		t.m_pTimer->start(100, true, [&t]() { t.OnTimer(); });
+
+		pReactor->run();
+
+		verify_test(node3.get_Processor().m_Cursor.m_ID.m_Height == hTrg);
+		verify_test(node3.get_Processor().m_Cursor.m_Full == node.get_Processor().m_Cursor.m_Full);
+		verify_test(obs.m_Updates);
+
+		if (bStalledPeer)
+			verify_test(node3.get_BodiesReissued());
+
+		node3.m_Cfg.m_Observer = nullptr;
+	}
 
 	void TestNodeClientProto()
 	{
@@ -1594,6 +1984,10 @@ namespace beam
 		node.m_Cfg.m_TestMode.m_FakePowSolveTime_ms = 100;
 		node.m_Cfg.m_MiningThreads = 1;
 
+		std::string sRecoveryPrefix = std::string(g_sz3) + "_auto_";
+		node.m_Cfg.m_Recovery.m_sPathOutput = sRecoveryPrefix;
+		node.m_Cfg.m_Recovery.m_Granularity = 3; // the 1st is full, the following are incremental
+
 		ECC::SetRandom(node);
 
 		node.m_Cfg.m_Horizon.m_Branching = 6;
@@ -1620,6 +2014,8 @@ namespace beam
 			std::list<ECC::Point> m_queProofsExpected;
 			std::list<uint32_t> m_queProofsStateExpected;
 			std::list<uint32_t> m_queProofsKrnExpected;
+			std::list<std::vector<ECC::Point> > m_queProofsUtxosExpected;
+			std::list<std::vector<Merkle::Hash> > m_queProofsKrnsExpected;
 			uint32_t m_nChainWorkProofsPending = 0;
 			uint32_t m_nBbsMsgsPending = 0;
 			uint32_t m_nRecoveryPending = 0;
@@ -1696,6 +2092,8 @@ namespace beam
 				return
 					m_queProofsExpected.empty() &&
 					m_queProofsKrnExpected.empty() &&
+					m_queProofsUtxosExpected.empty() &&
+					m_queProofsKrnsExpected.empty() &&
 					m_queProofsStateExpected.empty() &&
 					!m_nChainWorkProofsPending;
 			}
@@ -2071,6 +2469,8 @@ namespace beam
 					Send(msgOut2);
 				}
 
+				proto::GetProofUtxos msgUtxos;
+
 				for (auto it = m_Wallet.m_MyUtxos.begin(); m_Wallet.m_MyUtxos.end() != it; it++)
 				{
 					const MiniWallet::MyUtxo& utxo = it->second;
@@ -2084,9 +2484,20 @@ namespace beam
 					{
 						Send(msgOut2);
 						m_queProofsExpected.push_back(msgOut2.m_Utxo);
+
+						if (msgUtxos.m_Utxos.size() < proto::g_ProofsBatchMax)
+							msgUtxos.m_Utxos.push_back(msgOut2.m_Utxo);
 					}
 				}
 
+				if (!msgUtxos.m_Utxos.empty())
+				{
+					m_queProofsUtxosExpected.push_back(msgUtxos.m_Utxos);
+					Send(msgUtxos);
+				}
+
+				proto::GetProofKernels msgKrns;
+
 				for (uint32_t i = 0; i < m_Wallet.m_MyKernels.size(); i++)
 				{
 					const MiniWallet::MyKernel mk = m_Wallet.m_MyKernels[i];
@@ -2106,12 +2517,29 @@ namespace beam
 					Send(msgOut3);
 
 					m_queProofsKrnExpected.push_back(i);
+
+					if (msgKrns.m_IDs.size() < proto::g_ProofsBatchMax)
+						msgKrns.m_IDs.push_back(krn.m_Internal.m_ID);
+				}
+
+				if (!msgKrns.m_IDs.empty())
+				{
+					m_queProofsKrnsExpected.push_back(msgKrns.m_IDs);
+					Send(msgKrns);
 				}
 
 				{
 					proto::GetProofChainWork msgOut2;
 					Send(msgOut2);
 					m_nChainWorkProofsPending++;
+
+					// cropped, twice. The 2nd one is served from the cached crop
+					msgOut2.m_LowerBound = m_vStates[m_vStates.size() / 2].m_ChainWork;
+					for (int i = 0; i < 2; i++)
+					{
+						Send(msgOut2);
+						m_nChainWorkProofsPending++;
+					}
 				}
 
 				proto::NewTransaction msgTx;
@@ -2358,6 +2786,80 @@ namespace beam
 					fail_test("unexpected proof");
 			}
 
+			virtual void OnMsg(proto::ProofUtxos&& msg) override
+			{
+				if (m_queProofsUtxosExpected.empty())
+				{
+					fail_test("unexpected proof");
+					return;
+				}
+
+				const std::vector<ECC::Point>& vUtxos = m_queProofsUtxosExpected.front();
+				verify_test(msg.m_Counts.size() == vUtxos.size());
+
+				size_t iProof = 0;
+				for (size_t i = 0; i < vUtxos.size(); i++)
+				{
+					verify_test(msg.m_Counts[i]);
+
+					for (uint32_t j = 0; j < msg.m_Counts[i]; j++)
+					{
+						verify_test(iProof < msg.m_Proofs.size());
+						Input::Proof& p = msg.m_Proofs[iProof++];
+						p.m_Proof.insert(p.m_Proof.end(), msg.m_ProofLive.begin(), msg.m_ProofLive.end());
+						verify_test(m_vStates.back().IsValidProofUtxo(vUtxos[i], p));
+					}
+				}
+				verify_test(iProof == msg.m_Proofs.size());
+
+				m_queProofsUtxosExpected.pop_front();
+			}
+
+			virtual void OnMsg(proto::ProofKernels&& msg) override
+			{
+				if (m_queProofsKrnsExpected.empty())
+				{
+					fail_test("unexpected proof");
+					return;
+				}
+
+				const std::vector<Merkle::Hash>& vIDs = m_queProofsKrnsExpected.front();
+				verify_test(msg.m_Heights.size() == vIDs.size());
+				verify_test(m_vStates.back().IsValidProofStates(msg.m_States.empty() ? nullptr : &msg.m_States.front(), msg.m_States.size(), msg.m_ProofStates, msg.m_RootLive));
+
+				size_t iProof = 0;
+				for (size_t i = 0; i < vIDs.size(); i++)
+				{
+					if (!msg.m_Heights[i])
+						continue;
+
+					verify_test(iProof < msg.m_Proofs.size());
+					Merkle::Hash hv = vIDs[i];
+					Merkle::Interpret(hv, msg.m_Proofs[iProof++]);
+
+					bool bFound = false;
+					for (const auto& s : msg.m_States)
+						if (s.m_Height == msg.m_Heights[i])
+							bFound = (s.m_Kernels == hv);
+					verify_test(bFound);
+				}
+				verify_test(iProof == msg.m_Proofs.size());
+
+				// trailing hash
+				msg.m_ProofStates.m_vData.emplace_back(Zero);
+				verify_test(!m_vStates.back().IsValidProofStates(msg.m_States.empty() ? nullptr : &msg.m_States.front(), msg.m_States.size(), msg.m_ProofStates, msg.m_RootLive));
+				msg.m_ProofStates.m_vData.pop_back();
+
+				// tamper with the shared proof
+				if (!msg.m_ProofStates.m_vData.empty())
+				{
+					msg.m_ProofStates.m_vData.front().Inc();
+					verify_test(!m_vStates.back().IsValidProofStates(&msg.m_States.front(), msg.m_States.size(), msg.m_ProofStates, msg.m_RootLive));
+				}
+
+				m_queProofsKrnsExpected.pop_front();
+			}
+
 			virtual void OnMsg(proto::ProofChainWork&& msg) override
 			{
 				verify_test(m_nChainWorkProofsPending);
@@ -2504,8 +3006,37 @@ namespace beam
 		addr.resolve("127.0.0.1");
 		addr.port(g_Port);
 
+		// full recovery at each height where the incremental one may be generated, to compare with
+		struct RecoveryObserver
+			:public Node::IObserver
+		{
+			Node* m_pNode;
+			std::string m_sPrefix;
+
+			virtual void OnSyncProgress() override {}
+
+			virtual void OnStateChanged() override
+			{
+				NodeProcessor& np = m_pNode->get_Processor();
+				Height h0 = np.get_DB().ParamIntGetDef(NodeDB::ParamID::LastRecoveryHeight);
+				if (np.m_Cursor.m_ID.m_Height < h0 + m_pNode->m_Cfg.m_Recovery.m_Granularity)
+					return;
+
+				std::ostringstream os;
+				os << m_sPrefix << np.m_Cursor.m_ID;
+				verify_test(m_pNode->GenerateRecoveryInfo(os.str().c_str()));
+			}
+		} recObs;
+
+		std::string sRecoveryFullPrefix = std::string(g_sz3) + "_full_";
+		recObs.m_pNode = &node;
+		recObs.m_sPrefix = sRecoveryFullPrefix;
+		node.m_Cfg.m_Observer = &recObs;
+
 		node.m_Cfg.m_Treasury = g_Treasury;
+		node.m_Cfg.m_Bbs.m_InMemory = true; // node2 keeps them in the DB
 		node.Initialize();
+		node.m_PostStartSynced = true; // standalone miner, let it generate the recovery
 
 		cl.Connect(addr);
 
@@ -2585,18 +3116,25 @@ namespace beam
 			:public NodeProcessor::ITxoRecover
 		{
 			uint32_t m_Recovered = 0;
+			std::vector<TxoID> m_vIDs;
 
 			TxoRecover(Key::IPKdf& key) :NodeProcessor::ITxoRecover(key) {}
 
-			virtual bool OnTxo(const NodeDB::WalkerTxo&, Height hCreate, Output&, const CoinID&) override
+			virtual bool OnTxo(const NodeDB::WalkerTxo& wlk, Height hCreate, Output&, const CoinID&) override
 			{
 				m_Recovered++;
+				m_vIDs.push_back(wlk.m_ID);
 				return true;
 			}
 		};
 
 		TxoRecover wlk(*node.m_Keys.m_pOwner);
 		node2.get_Processor().EnumTxos(wlk);
+
+		// the MT version must recognize the same Txos, in the same order
+		TxoRecover wlkMT(*node.m_Keys.m_pOwner);
+		node2.get_Processor().EnumTxosRecoverMT(wlkMT);
+		verify_test(wlkMT.m_vIDs == wlk.m_vIDs);
 
 		node.get_Processor().RescanOwnedTxos();
 
@@ -2654,6 +3192,70 @@ namespace beam
 
 		verify_test((p.m_SpendKeys.size() == 1) && (p.m_Spent == 1) && p.m_Utxos && p.m_Assets);
 
+		{
+			// the last auto-generated recovery must be consistent as well
+			node.m_Cfg.m_Observer = nullptr;
+
+			NodeProcessor& np = node.get_Processor();
+			Height hRec = np.get_DB().ParamIntGetDef(NodeDB::ParamID::LastRecoveryHeight);
+			verify_test(hRec > Rules::get().pForks[2].m_Height);
+
+			auto fnRead = [](const std::string& sPath, ByteBuffer& buf)
+			{
+				std::FStream fs;
+				if (!fs.Open(sPath.c_str(), true))
+					return false;
+
+				buf.resize(static_cast<size_t>(fs.get_Remaining()));
+				if (!buf.empty())
+					fs.read(&buf.front(), buf.size());
+				return true;
+			};
+
+			uint32_t nAuto = 0;
+
+			for (Height h = Rules::HeightGenesis; h <= np.m_Cursor.m_ID.m_Height; h++)
+			{
+				NodeDB::StateID sid;
+				sid.m_Height = h;
+				sid.m_Row = np.FindActiveAtStrict(h);
+
+				Block::SystemState::ID id;
+				np.get_DB().get_StateID(sid, id);
+
+				std::ostringstream os;
+				os << sRecoveryPrefix << id;
+
+				std::ostringstream osFull;
+				osFull << sRecoveryFullPrefix << id;
+
+				ByteBuffer buf1, buf2;
+				if (fnRead(os.str(), buf1))
+				{
+					nAuto++;
+
+					// incremental or not, must be the same as the full one generated at this height
+					verify_test(fnRead(osFull.str(), buf2));
+					verify_test(buf1 == buf2);
+				}
+
+				if (h == hRec)
+				{
+					MyParser p2;
+					p2.m_pOwner = p.m_pOwner;
+					p2.m_pViewer = &viewer;
+
+					verify_test(p2.Proceed(os.str().c_str()));
+					verify_test(p2.m_Utxos && p2.m_Assets && !p2.m_SpendKeys.empty());
+				}
+
+				beam::DeleteFile(os.str().c_str());
+				beam::DeleteFile(osFull.str().c_str());
+			}
+
+			verify_test(nAuto > 1); // the 1st is full, the following are merged
+		}
+
 		auto logger = beam::Logger::create(LOG_LEVEL_DEBUG, LOG_LEVEL_DEBUG);
 		node.PrintTxos();
 	}
@@ -2823,9 +3425,25 @@ namespace beam
 							addr.resolve("127.0.0.1");
 							addr.port(g_Port);
 				net.m_Cfg.m_vNodes.resize(4, addr); // create several connections, let the compete
+				net.m_Cfg.m_MaxInFlight = 3; // make sure the requests are spread
 
 				net.Connect();
 
+				{
+					// batched proofs (nothing is found)
+					RequestKernels::Ptr pKrnls(new RequestKernels);
+					pKrnls->m_Msg.m_IDs.resize(3, Zero);
+					net.PostRequest(*pKrnls, *this);
+					m_nProofsExpected++;
+
+					RequestUtxos::Ptr pUtxos(new RequestUtxos);
+					pUtxos->m_Msg.m_Utxos.resize(3);
+					for (auto& pt : pUtxos->m_Msg.m_Utxos)
+						ZeroObject(pt);
+					net.PostRequest(*pUtxos, *this);
+					m_nProofsExpected++;
+				}
+
 				// request several proofs
 				for (uint32_t i = 0; i < 10; i++)
 				{
@@ -2858,7 +3476,14 @@ namespace beam
 				m_bRunning = true;
 				io::Reactor::get_Current().run();
 				KillTimer();
+
+				m_nConnectionsUsed = 0;
+				for (const auto& c : net.m_Connections)
+					if (c.m_RequestsDone)
+						m_nConnectionsUsed++;
 			}
+
+			uint32_t m_nConnectionsUsed = 0;
 		};
 
 		const Height hThrd1 = 250;
@@ -2868,6 +3493,7 @@ namespace beam
 		MyFlyClient fc;
 		// simple case
 		fc.SyncSync();
+		verify_test(fc.m_nConnectionsUsed > 1); // striped over several connections
 
 		verify_test(fc.m_bTip);
 		verify_test(fc.m_hRolledTo == MaxHeight);
@@ -2909,6 +3535,610 @@ namespace beam
 		verify_test(!fc.m_Hist.m_Map.empty() && fc.m_Hist.m_Map.rbegin()->second.m_Height == hThrd2);
 	}
 
+	// snapshot contents, in the format of NodeProcessor::ExportSnapshot, to produce well-formed but inconsistent ones
+	struct SnapshotData
+	{
+		typedef yas::binary_oarchive<std::FStream, SERIALIZE_OPTIONS> Writer;
+		typedef yas::binary_iarchive<std::FStream, SERIALIZE_OPTIONS> Reader;
+
+		struct Hdr
+		{
+			Block::SystemState::Full m_State;
+			TxoID m_Txos;
+		};
+
+		struct Txo
+		{
+			TxoID m_ID;
+			ByteBuffer m_Value;
+		};
+
+		struct Shielded
+		{
+			bool m_Output;
+			Height m_Height;
+			ECC::Point m_Key;
+			ECC::Point m_Commitment; // outputs only
+		};
+
+		uint32_t m_Ver;
+		Merkle::Hash m_hvFork;
+		Height m_hTop;
+		TxoID m_TxosTreasury;
+		ByteBuffer m_Treasury;
+		std::vector<Hdr> m_vHdrs;
+		ECC::Scalar m_Offset;
+		std::vector<Txo> m_vTxos;
+		std::vector<Shielded> m_vShielded;
+		std::vector<Asset::Full> m_vAssets;
+		Height m_hKrn0;
+		std::vector<std::vector<Merkle::Hash> > m_vKrns;
+
+		void Read(const char* sz)
+		{
+			std::FStream fs;
+			fs.Open(sz, true, true);
+			Reader der(fs);
+
+			der & m_Ver;
+			der & m_hvFork;
+			der & m_hTop;
+			der & m_TxosTreasury;
+			der & m_Treasury;
+
+			m_vHdrs.resize(static_cast<size_t>(m_hTop - Rules::HeightGenesis + 1));
+			for (auto& x : m_vHdrs)
+			{
+				der & x.m_State;
+				der & x.m_Txos;
+			}
+
+			der & m_Offset;
+
+			while (true)
+			{
+				TxoID id;
+				der & id;
+				if (MaxHeight == id)
+					break;
+
+				m_vTxos.emplace_back().m_ID = id;
+				der & m_vTxos.back().m_Value;
+			}
+
+			uint64_t nShielded;
+			der & nShielded;
+			m_vShielded.resize(static_cast<size_t>(nShielded));
+			for (auto& x : m_vShielded)
+			{
+				der & x.m_Output;
+				der & x.m_Height;
+				der & x.m_Key;
+				if (x.m_Output)
+					der & x.m_Commitment;
+			}
+
+			der & m_vAssets;
+
+			der & m_hKrn0;
+			m_vKrns.resize(static_cast<size_t>(m_hTop - m_hKrn0 + 1));
+			for (auto& v : m_vKrns)
+				der & v;
+
+			uint32_t nVer;
+			der & nVer;
+			verify_test(m_Ver == nVer);
+		}
+
+		void Write(const char* sz) const
+		{
+			std::FStream fs;
+			fs.Open(sz, false, true);
+			Writer ser(fs);
+
+			ser & m_Ver;
+			ser & m_hvFork;
+			ser & m_hTop;
+			ser & m_TxosTreasury;
+			ser & m_Treasury;
+
+			for (const auto& x : m_vHdrs)
+			{
+				ser & x.m_State;
+				ser & x.m_Txos;
+			}
+
+			ser & m_Offset;
+
+			for (const auto& x : m_vTxos)
+			{
+				ser & x.m_ID;
+				ser & x.m_Value;
+			}
+			ser & MaxHeight;
+
+			uint64_t nShielded = m_vShielded.size();
+			ser & nShielded;
+			for (const auto& x : m_vShielded)
+			{
+				ser & x.m_Output;
+				ser & x.m_Height;
+				ser & x.m_Key;
+				if (x.m_Output)
+					ser & x.m_Commitment;
+			}
+
+			ser & m_vAssets;
+
+			ser & m_hKrn0;
+			for (const auto& v : m_vKrns)
+				ser & v;
+
+			ser & m_Ver;
+
+			fs.Flush();
+		}
+	};
+
+	// the import must fail with the given reason, and leave the DB empty
+	void TestSnapshotRejected(const char* szSnapshot, const char* szReason)
+	{
+		DeleteFile(g_sz2);
+
+		NodeProcessor::StartParams sp;
+		sp.m_sSnapshot = szSnapshot;
+
+		{
+			NodeProcessor np2;
+			std::string sErr;
+			try {
+				np2.Initialize(g_sz2, sp);
+			} catch (const std::exception& e) {
+				sErr = e.what();
+			}
+			verify_test(!sErr.empty());
+			if (szReason)
+				verify_test(std::string::npos != sErr.find(szReason));
+		}
+
+		{
+			NodeProcessor np2;
+			np2.Initialize(g_sz2);
+			verify_test(np2.m_Cursor.m_ID.m_Height < Rules::HeightGenesis);
+		}
+
+		DeleteFile(g_sz2);
+	}
+
+	void TestSnapshot()
+	{
+		const char* szSnapshot = "mytest.snapshot";
+		const char* szSnapshotBad = "mytest-bad.snapshot";
+
+		DeleteFile(g_sz2);
+
+		NodeProcessor np;
+		np.Initialize(g_sz);
+		verify_test(np.m_Cursor.m_ID.m_Height >= Rules::HeightGenesis);
+		np.ExportSnapshot(szSnapshot);
+
+		NodeProcessor::StartParams sp;
+		sp.m_sSnapshot = szSnapshot;
+
+		{
+			NodeProcessor np2;
+			np2.Initialize(g_sz2, sp);
+
+			verify_test(np2.m_Cursor.m_ID.m_Height == np.m_Cursor.m_ID.m_Height);
+			verify_test(np2.m_Cursor.m_ID.m_Hash == np.m_Cursor.m_ID.m_Hash);
+			verify_test(np2.m_Cursor.m_DifficultyNext.m_Packed == np.m_Cursor.m_DifficultyNext.m_Packed);
+			verify_test(np2.m_Mmr.m_Shielded.m_Count == np.m_Mmr.m_Shielded.m_Count);
+			verify_test(np2.m_Mmr.m_Assets.m_Count == np.m_Mmr.m_Assets.m_Count);
+			verify_test(np2.m_Extra.m_ShieldedOutputs == np.m_Extra.m_ShieldedOutputs);
+			verify_test(np2.m_Extra.m_Txos == np.m_Extra.m_Txos);
+
+			Merkle::Hash hv1, hv2;
+			np.get_Utxos().get_Hash(hv1);
+			np2.get_Utxos().get_Hash(hv2);
+			verify_test(hv1 == hv2);
+		}
+
+		{
+			// reopen as usual
+			NodeProcessor np2;
+			np2.Initialize(g_sz2);
+			verify_test(np2.m_Cursor.m_ID.m_Hash == np.m_Cursor.m_ID.m_Hash);
+		}
+
+		{
+			// not empty anymore
+			NodeProcessor np2;
+			bool bThrown = false;
+			try {
+				np2.Initialize(g_sz2, sp);
+			} catch (const std::exception&) {
+				bThrown = true;
+			}
+			verify_test(bThrown);
+		}
+
+		{
+			// truncated
+			std::FStream fsIn, fsOut;
+			fsIn.Open(szSnapshot, true, true);
+			ByteBuffer bb(static_cast<size_t>(fsIn.get_Remaining() / 2));
+			fsIn.read(&bb.front(), bb.size());
+			fsOut.Open(szSnapshotBad, false, true);
+			fsOut.write(&bb.front(), bb.size());
+		}
+
+		TestSnapshotRejected(szSnapshotBad, nullptr);
+
+		// well-formed, but inconsistent with the roots
+		SnapshotData sd;
+		sd.Read(szSnapshot);
+
+		sp.m_sSnapshot = szSnapshotBad;
+
+		{
+			// re-written as is
+			sd.Write(szSnapshotBad);
+			NodeProcessor np2;
+			np2.Initialize(g_sz2, sp);
+			verify_test(np2.m_Cursor.m_ID.m_Hash == np.m_Cursor.m_ID.m_Hash);
+		}
+		DeleteFile(g_sz2);
+
+		verify_test(!sd.m_vTxos.empty());
+		if (!sd.m_vTxos.empty())
+		{
+			// TXO commitment byte flipped
+			SnapshotData sd2 = sd;
+			ByteBuffer& bb = sd2.m_vTxos.front().m_Value;
+
+			Output outp;
+			Deserializer der;
+			der.reset(bb);
+			der & outp;
+
+			const uint8_t* pX = outp.m_Commitment.m_X.m_pData;
+			auto it = std::search(bb.begin(), bb.end(), pX, pX + outp.m_Commitment.m_X.nBytes);
+			verify_test(bb.end() != it);
+			if (bb.end() != it)
+			{
+				*it ^= 1;
+				sd2.Write(szSnapshotBad);
+				TestSnapshotRejected(szSnapshotBad, "Definition mismatch");
+			}
+		}
+
+		{
+			// per-block TXO count: an unspent TXO (and the rest of its block) is attributed to the next block, its maturity changes
+			SnapshotData sd2 = sd;
+			bool bFound = false;
+
+			for (size_t i = 0; (i + 1 < sd2.m_vHdrs.size()) && !bFound; i++)
+			{
+				TxoID nPrev = i ? sd2.m_vHdrs[i - 1].m_Txos : sd2.m_TxosTreasury;
+				TxoID& nTxos = sd2.m_vHdrs[i].m_Txos;
+
+				for (const auto& x : sd2.m_vTxos)
+					if ((x.m_ID >= nPrev) && (x.m_ID < nTxos))
+					{
+						nTxos = x.m_ID;
+						bFound = true;
+						break;
+					}
+			}
+
+			verify_test(bFound);
+			if (bFound)
+			{
+				sd2.Write(szSnapshotBad);
+				TestSnapshotRejected(szSnapshotBad, "Definition mismatch");
+			}
+		}
+
+		{
+			// kernel ID
+			SnapshotData sd2 = sd;
+			bool bFound = false;
+
+			for (auto& v : sd2.m_vKrns)
+				if (!v.empty() && !bFound)
+				{
+					v.front().Inc();
+					bFound = true;
+				}
+
+			verify_test(bFound);
+			if (bFound)
+			{
+				sd2.Write(szSnapshotBad);
+				TestSnapshotRejected(szSnapshotBad, "kernel commitment mismatch");
+			}
+		}
+
+		verify_test(!sd.m_vShielded.empty());
+		if (!sd.m_vShielded.empty())
+		{
+			// shielded key
+			SnapshotData sd2 = sd;
+			sd2.m_vShielded.front().m_Key.m_X.Inc();
+
+			sd2.Write(szSnapshotBad);
+			TestSnapshotRejected(szSnapshotBad, "Definition mismatch");
+		}
+
+		DeleteFile(szSnapshot);
+		DeleteFile(szSnapshotBad);
+	}
+
+	void TestBackup()
+	{
+		struct MyProcessor
+			:public NodeProcessor
+		{
+			bool m_UtxosRebuilt = false;
+			bool m_BackupOk = false;
+
+			virtual void InitializeUtxosProgress(uint64_t done, uint64_t total) override { m_UtxosRebuilt = true; }
+			virtual void OnBackupOver(bool bSuccess) override { m_BackupOk = bSuccess; }
+		};
+
+		std::string sUtxos;
+		NodeProcessor::get_UtxoMappingPath(sUtxos, g_sz2);
+
+		DeleteFile(g_sz2);
+
+		Block::SystemState::ID id;
+		Merkle::Hash hv1, hv2;
+
+		{
+			MyProcessor np;
+			np.Initialize(g_sz);
+			verify_test(np.m_Cursor.m_ID.m_Height >= Rules::HeightGenesis);
+
+			// small portions, many steps
+			np.m_Backup.m_DbPages = 4;
+			np.m_Backup.m_UtxoChunks = 1;
+			np.BackupStart(g_sz2);
+
+			for (uint32_t i = 0; np.IsBackupInProgress() && (i < 100000); i++)
+				np.CommitDB();
+
+			verify_test(!np.IsBackupInProgress());
+			verify_test(np.m_BackupOk);
+
+			id = np.m_Cursor.m_ID;
+			np.get_Utxos().get_Hash(hv1);
+		}
+
+		{
+			// the copy is usable as-is, the image matches the DB
+			MyProcessor np2;
+			np2.Initialize(g_sz2);
+
+			verify_test(!np2.m_UtxosRebuilt);
+			verify_test(np2.m_Cursor.m_ID == id);
+
+			np2.get_Utxos().get_Hash(hv2);
+			verify_test(hv1 == hv2);
+		}
+
+		DeleteFile(g_sz2);
+		DeleteFile(sUtxos.c_str());
+	}
+
+	void TestFlyClientStriping()
+	{
+		// 2 connections to the same node. The requests are spread within the in-flight limit,
+		// the ones of a dropped connection go to the remaining one, which then takes all (no limit for a single connection)
+		io::Reactor::Ptr pReactor(io::Reactor::create());
+		io::Reactor::Scope scope(*pReactor);
+
+		Node node;
+		node.m_Cfg.m_sPathLocal = g_sz;
+		node.m_Cfg.m_Listen.port(g_Port);
+		node.m_Cfg.m_Listen.ip(INADDR_ANY);
+		node.m_Cfg.m_MiningThreads = 0;
+		node.m_Cfg.m_Treasury = g_Treasury;
+		ECC::SetRandom(node);
+		node.Initialize();
+
+		RaiseHeightTo(node, 20);
+
+		typedef proto::FlyClient::NetworkStd::Connection Connection;
+
+		struct MyFlyClient
+			:public proto::FlyClient
+			,public proto::FlyClient::Request::IHandler
+		{
+			enum {
+				s_MaxInFlight = 3,
+				s_Requests = 300,
+				s_DropAfter = 30
+			};
+
+			Block::SystemState::HistoryMap m_Hist;
+			NetworkStd m_Net;
+			io::Timer::Ptr m_pTimer;
+
+			std::vector<RequestKernel::Ptr> m_vReqs;
+			uint32_t m_Done = 0;
+			size_t m_MaxInFlight = 0; // observed before the drop
+
+			Connection* m_pDropped = nullptr;
+			uint32_t m_DroppedDone = 0;
+			size_t m_DroppedInFlight = 0;
+			size_t m_RemainingInFlight = 0;
+
+			MyFlyClient()
+				:m_Net(*this)
+			{
+				m_pTimer = io::Timer::create(io::Reactor::get_Current());
+			}
+
+			virtual Block::SystemState::IHistory& get_History() override { return m_Hist; }
+
+			void OnWaitTip()
+			{
+				// post the requests once both are synced, otherwise the 1st one would take them all
+				for (const auto& c : m_Net.m_Connections)
+					if (!c.IsLive() || !c.IsAtTip())
+						return;
+
+				m_pTimer->cancel();
+
+				m_vReqs.resize(s_Requests);
+				for (auto& pReq : m_vReqs)
+				{
+					pReq.reset(new RequestKernel);
+					m_Net.PostRequest(*pReq, *this);
+				}
+			}
+
+			virtual void OnComplete(Request& r) override
+			{
+				verify_test(this == r.m_pTrg);
+				m_Done++;
+
+				if (!m_pDropped)
+					for (const auto& c : m_Net.m_Connections)
+						std::setmax(m_MaxInFlight, c.m_lst.size());
+
+				if (s_DropAfter == m_Done)
+					m_pTimer->start(0, false, [this]() { OnDrop(); }); // not from within the connection callback
+
+				if (s_Requests == m_Done)
+					io::Reactor::get_Current().stop();
+			}
+
+			void OnDrop()
+			{
+				verify_test(!m_pDropped);
+
+				for (auto& c : m_Net.m_Connections)
+				{
+					verify_test(c.m_RequestsDone); // both were used
+					if (!m_pDropped && !c.m_lst.empty())
+						m_pDropped = &c;
+				}
+
+				verify_test(m_pDropped);
+				if (!m_pDropped)
+					return;
+
+				m_DroppedDone = m_pDropped->m_RequestsDone;
+				m_DroppedInFlight = m_pDropped->m_lst.size();
+
+				m_pDropped->ResetAll(); // as if disconnected
+
+				verify_test(m_pDropped->m_lst.empty());
+				verify_test(m_Net.m_lst.empty()); // all went to the remaining connection
+
+				for (auto& c : m_Net.m_Connections)
+					if (&c != m_pDropped)
+						m_RemainingInFlight = c.m_lst.size();
+			}
+		};
+
+		MyFlyClient fc;
+
+		io::Address addr;
+		addr.resolve("127.0.0.1");
+		addr.port(g_Port);
+		fc.m_Net.m_Cfg.m_vNodes.resize(2, addr);
+		fc.m_Net.m_Cfg.m_MaxInFlight = MyFlyClient::s_MaxInFlight;
+		fc.m_Net.Connect();
+
+		fc.m_pTimer->start(50, true, [&fc]() { fc.OnWaitTip(); });
+
+		io::Timer::Ptr pTimeout = io::Timer::create(*pReactor);
+		pTimeout->start(60 * 1000, false, []() { io::Reactor::get_Current().stop(); });
+
+		pReactor->run();
+
+		verify_test(MyFlyClient::s_Requests == fc.m_Done);
+		verify_test(fc.m_MaxInFlight <= MyFlyClient::s_MaxInFlight);
+
+		verify_test(fc.m_pDropped);
+		if (fc.m_pDropped)
+		{
+			verify_test(fc.m_DroppedInFlight);
+			verify_test(fc.m_pDropped->m_RequestsDone == fc.m_DroppedDone); // nothing more after the drop
+			verify_test(fc.m_RemainingInFlight > MyFlyClient::s_MaxInFlight);
+		}
+	}
+
+	void TestBodyCache()
+	{
+		io::Reactor::Ptr pReactor(io::Reactor::create());
+		io::Reactor::Scope scope(*pReactor);
+
+		Node node;
+		node.m_Cfg.m_sPathLocal = g_sz;
+		node.m_Cfg.m_MiningThreads = 0;
+		node.m_Cfg.m_Treasury = g_Treasury;
+		ECC::SetRandom(node);
+		node.Initialize();
+
+		RaiseHeightTo(node, 5);
+
+		Node::BodyCache& bc = node.get_BodyCache();
+		const size_t nMaxSize = 1000;
+
+		auto fnKey = [](uint64_t nRow, uint8_t nFlagP = proto::BodyBuffers::Full)
+		{
+			Node::BodyCache::Key key;
+			ZeroObject(key);
+			key.m_Row = nRow;
+			key.m_FlagP = nFlagP;
+			key.m_FlagE = proto::BodyBuffers::Full;
+			return key;
+		};
+
+		proto::BodyBuffers body, out;
+		body.m_Eternal.resize(200, 1);
+		body.m_Perishable.resize(100, 2);
+
+		for (uint64_t nRow = 1; nRow <= 3; nRow++)
+		{
+			verify_test(!bc.Find(out, fnKey(nRow)));
+			body.m_Eternal[0] = static_cast<uint8_t>(nRow);
+			bc.Insert(body, fnKey(nRow), nMaxSize);
+		}
+		verify_test(bc.m_Size == 900);
+
+		// hit, becomes the most recently used
+		verify_test(bc.Find(out, fnKey(1)));
+		verify_test((out.m_Eternal.size() == 200) && (out.m_Eternal[0] == 1) && (out.m_Perishable == body.m_Perishable));
+
+		// same block, other flags
+		verify_test(!bc.Find(out, fnKey(1, proto::BodyBuffers::Recovery1)));
+
+		// eviction of the least recently used at the byte limit
+		body.m_Eternal[0] = 4;
+		bc.Insert(body, fnKey(4), nMaxSize);
+		verify_test(bc.m_Size == 900);
+		verify_test(!bc.Find(out, fnKey(2)));
+		verify_test(bc.Find(out, fnKey(1)));
+		verify_test(bc.Find(out, fnKey(3)));
+		verify_test(bc.Find(out, fnKey(4)) && (out.m_Eternal[0] == 4));
+
+		// too large, not cached, nothing evicted
+		proto::BodyBuffers bodyBig;
+		bodyBig.m_Eternal.resize(nMaxSize + 1);
+		bc.Insert(bodyBig, fnKey(5), nMaxSize);
+		verify_test(!bc.Find(out, fnKey(5)));
+		verify_test(bc.m_Size == 900);
+
+		// invalidated on rollback
+		node.get_Processor().OnRolledBack();
+		verify_test(!bc.m_Size && bc.m_lst.empty() && bc.m_set.empty());
+		verify_test(!bc.Find(out, fnKey(1)));
+	}
+
 	void TestHalving()
 	{
 		HeightRange hr;
@@ -2982,6 +4212,9 @@ void TestAll()
 		beam::TestNodeDB();
 		beam::DeleteFile(beam::g_sz);
 
+		beam::TestBbsMemStore();
+		beam::TestMembershipFilter();
+
 		{
 			printf("NodeProcessor test1...\n");
 			fflush(stdout);
@@ -3010,7 +4243,19 @@ void TestAll()
 		fflush(stdout);
 
 		beam::TestNodeConversation();
+
+		printf("Node parallel sync test...\n");
+		fflush(stdout);
+
+		beam::TestNodeParallelSync(false);
+		beam::DeleteFile(beam::g_sz3);
+
+		printf("Node sync with a stalled peer test...\n");
+		fflush(stdout);
+
+		beam::TestNodeParallelSync(true);
 		beam::DeleteFile(beam::g_sz);
+		beam::DeleteFile(beam::g_sz3);
 		beam::DeleteFile(beam::g_sz2);
 	}
 
@@ -3024,19 +4269,31 @@ void TestAll()
 	beam::TestNodeClientProto();
 
 	{
-		// test utxo set image rebuilding with shielded in/outs
+		// test utxo set and mmr images rebuilding with shielded in/outs
 		beam::io::Reactor::Ptr pReactor(beam::io::Reactor::create());
 		beam::io::Reactor::Scope scope(*pReactor);
 
 		std::string sPath;
 		beam::NodeProcessor::get_UtxoMappingPath(sPath, beam::g_sz);
 		beam::DeleteFile(sPath.c_str());
+		beam::NodeProcessor::get_DerivedPath(sPath, beam::g_sz, "-shielded-mmr.bin");
+		beam::DeleteFile(sPath.c_str());
 
 		beam::Node node;
 		node.m_Cfg.m_sPathLocal = beam::g_sz;
 		node.Initialize();
 	}
 
+	printf("Snapshot test...\n");
+	fflush(stdout);
+
+	beam::TestSnapshot();
+
+	printf("Backup test...\n");
+	fflush(stdout);
+
+	beam::TestBackup();
+
 	beam::DeleteFile(beam::g_sz);
 	beam::DeleteFile(beam::g_sz2);
 	beam::DeleteFile(beam::g_sz3);
@@ -3046,6 +4303,18 @@ void TestAll()
 
 	beam::TestFlyClient();
 	beam::DeleteFile(beam::g_sz);
+
+	printf("Node <---> FlyClient striping test...\n");
+	fflush(stdout);
+
+	beam::TestFlyClientStriping();
+	beam::DeleteFile(beam::g_sz);
+
+	printf("Node body cache test...\n");
+	fflush(stdout);
+
+	beam::TestBodyCache();
+	beam::DeleteFile(beam::g_sz);
 }
 
 int main()
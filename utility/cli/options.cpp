@@ -176,6 +176,8 @@ namespace beam
         const char* KEY_MINE = "key_mine"; // deprecated
         const char* MINER_KEY = "miner_key";
         const char* BBS_ENABLE = "bbs_enable";
+        const char* BBS_IN_MEMORY = "bbs_in_memory";
+        const char* BBS_BUCKET_DURATION = "bbs_bucket_duration";
         const char* NEW_ADDRESS = "new_addr";
         const char* GET_TOKEN = "get_token";
         const char* NEW_ADDRESS_COMMENT = "comment";
@@ -202,6 +204,8 @@ namespace beam
         const char* LOG_VERBOSE = "verbose";
         const char* LOG_CLEANUP_DAYS = "log_cleanup_days";
         const char* LOG_UTXOS = "log_utxos";
+        const char* LOG_ASYNC = "log_async";
+        const char* LOG_ASYNC_DROP = "log_async_drop";
         const char* VERSION = "version";
         const char* VERSION_FULL = "version,v";
         const char* GIT_COMMIT_HASH = "git_commit_hash";
@@ -216,6 +220,9 @@ namespace beam
         const char* IP_WHITELIST = "ip_whitelist";
         const char* FAST_SYNC = "fast_sync";
         const char* GENERATE_RECOVERY_PATH = "generate_recovery";
+        const char* SNAPSHOT_EXPORT = "snapshot_export";
+        const char* SNAPSHOT_IMPORT = "snapshot_import";
+        const char* BACKUP_PATH = "backup_path";
         const char* RECOVERY_AUTO_PATH = "recovery_auto_path";
         const char* RECOVERY_AUTO_PERIOD = "recovery_auto_period";
         const char* SWAP_INIT = "swap_init";
@@ -228,6 +235,10 @@ namespace beam
         const char* SWAP_TX_HISTORY = "swap_tx_history";
         const char* NODE_POLL_PERIOD = "node_poll_period";
         const char* PROXY_USE = "proxy";
+        const char* BBS_TAG_OUTGOING = "bbs_tag_outgoing";
+        const char* BBS_TAG_FILTER = "bbs_tag_filter";
+        const char* BBS_DECRYPT_THREADS = "bbs_decrypt_threads";
+        const char* PROOFS_BATCH = "proofs_batch";
         const char* PROXY_ADDRESS = "proxy_addr";
         // values
         const char* EXPIRATION_TIME_24H = "24h";
@@ -338,6 +349,8 @@ namespace beam
             (cli::CHECKDB, po::value<bool>()->default_value(false), "DB integrity check")
             (cli::VACUUM, po::value<bool>()->default_value(false), "DB vacuum (compact)")
             (cli::BBS_ENABLE, po::value<bool>()->default_value(true), "Enable SBBS messaging")
+            (cli::BBS_IN_MEMORY, po::value<bool>()->default_value(false), "Keep SBBS messages in memory instead of the DB. Saves the DB writes under heavy traffic, but the messages are lost on restart")
+            (cli::BBS_BUCKET_DURATION, po::value<Positive<uint32_t>>()->default_value(Positive<uint32_t>(600)), "Expiration granularity of the in-memory SBBS store, in seconds")
             (cli::CRASH, po::value<int>()->default_value(0), "Induce crash (test proper handling)")
             (cli::OWNER_KEY, po::value<string>(), "Owner viewer key")
             (cli::KEY_OWNER, po::value<string>(), "Owner viewer key (deprecated)")
@@ -345,8 +358,13 @@ namespace beam
             (cli::KEY_MINE, po::value<string>(), "Standalone miner key (deprecated)")
             (cli::PASS, po::value<string>(), "password for keys")
             (cli::LOG_UTXOS, po::value<bool>()->default_value(false), "Log recovered UTXOs (make sure the log file is not exposed)")
+            (cli::LOG_ASYNC, po::value<bool>()->default_value(false), "Write the log asynchronously, by a background thread")
+            (cli::LOG_ASYNC_DROP, po::value<bool>()->default_value(false), "Asynchronous log: drop messages instead of blocking when the buffer is full")
 			(cli::FAST_SYNC, po::value<bool>(), "Fast sync on/off (override horizons)")
 			(cli::GENERATE_RECOVERY_PATH, po::value<string>(), "Recovery file to generate immediately after start")
+			(cli::SNAPSHOT_EXPORT, po::value<string>(), "State snapshot file to generate immediately after start")
+			(cli::SNAPSHOT_IMPORT, po::value<string>(), "State snapshot file to start from. The node data must be empty")
+			(cli::BACKUP_PATH, po::value<string>(), "DB backup file to make while running, started immediately after start (UTXO image is copied alongside)")
 			(cli::RECOVERY_AUTO_PATH, po::value<string>(), "path and file prefix for recovery auto-generation")
 			(cli::RECOVERY_AUTO_PERIOD, po::value<uint32_t>()->default_value(30), "period (in blocks) for recovery auto-generation")
             ;
@@ -383,6 +401,10 @@ namespace beam
 #endif  // BEAM_LASER_SUPPORT
             (cli::NODE_POLL_PERIOD, po::value<Nonnegative<uint32_t>>()->default_value(Nonnegative<uint32_t>(0)), "Node poll period in milliseconds. Set to 0 to keep connection. Anyway poll period would be no less than the expected rate of blocks if it is less then it will be rounded up to block rate value.")
             (cli::PROXY_USE, po::value<bool>()->default_value(false), "Use socks5 proxy server for node connection")
+            (cli::BBS_TAG_OUTGOING, po::value<bool>()->default_value(false), "Append the recipient tag to the outgoing messages. Lets the receiver skip the decryption with other addresses, but anyone who knows the address can recognize them")
+            (cli::BBS_TAG_FILTER, po::value<bool>()->default_value(false), "Skip the own addresses that don't match the recipient tag of the incoming messages. Enable if the peers tag their messages")
+            (cli::BBS_DECRYPT_THREADS, po::value<Nonnegative<uint32_t>>()->default_value(Nonnegative<uint32_t>(0)), "Threads for the trial decryption of the incoming messages, worth it for many own addresses. Set to 0 to decrypt in the main thread")
+            (cli::PROOFS_BATCH, po::value<bool>()->default_value(true), "Request the kernel and utxo proofs in batches, if the node supports it")
             (cli::PROXY_ADDRESS, po::value<string>()->default_value("127.0.0.1:9150"), "Proxy server address");
 
         po::options_description wallet_treasury_options("Wallet treasury options");
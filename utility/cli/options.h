@@ -77,6 +77,8 @@ namespace beam
         extern const char* KEY_MINE;  // deprecated
         extern const char* MINER_KEY;
         extern const char* BBS_ENABLE;
+        extern const char* BBS_IN_MEMORY;
+        extern const char* BBS_BUCKET_DURATION;
         extern const char* NEW_ADDRESS;
         extern const char* GET_TOKEN;
         extern const char* CANCEL_TX;
@@ -103,6 +105,8 @@ namespace beam
         extern const char* LOG_VERBOSE;
         extern const char* LOG_CLEANUP_DAYS;
         extern const char* LOG_UTXOS;
+        extern const char* LOG_ASYNC;
+        extern const char* LOG_ASYNC_DROP;
         extern const char* VERSION;
         extern const char* VERSION_FULL;
         extern const char* GIT_COMMIT_HASH;
@@ -119,6 +123,9 @@ namespace beam
         extern const char* IP_WHITELIST;
 		extern const char* FAST_SYNC;
 		extern const char* GENERATE_RECOVERY_PATH;
+		extern const char* SNAPSHOT_EXPORT;
+		extern const char* SNAPSHOT_IMPORT;
+		extern const char* BACKUP_PATH;
 		extern const char* RECOVERY_AUTO_PATH;
 		extern const char* RECOVERY_AUTO_PERIOD;
         extern const char* SWAP_INIT;
@@ -131,6 +138,10 @@ namespace beam
         extern const char* SWAP_TX_HISTORY;
         extern const char* NODE_POLL_PERIOD;
         extern const char* PROXY_USE;
+        extern const char* BBS_TAG_OUTGOING;
+        extern const char* BBS_TAG_FILTER;
+        extern const char* BBS_DECRYPT_THREADS;
+        extern const char* PROOFS_BATCH;
         extern const char* PROXY_ADDRESS;
         // values
         extern const char* EXPIRATION_TIME_24H;
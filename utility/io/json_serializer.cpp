@@ -38,6 +38,61 @@ namespace {
 
 } //namespace
 
+struct JsonStreamWriter::Impl {
+    explicit Impl(io::FragmentWriter& _fw) :
+        fw(_fw),
+        serializer(std::make_shared<JsonOutputAdapter>(_fw), ' ')
+    {}
+
+    io::FragmentWriter& fw;
+    nlohmann::detail::serializer<json> serializer;
+};
+
+JsonStreamWriter::JsonStreamWriter(io::FragmentWriter& fw) :
+    _impl(std::make_unique<Impl>(fw))
+{}
+
+JsonStreamWriter::~JsonStreamWriter() = default;
+
+void JsonStreamWriter::write_raw(const char* s, size_t size) {
+    _impl->fw.write(s, size);
+}
+
+void JsonStreamWriter::write_value(const nlohmann::json& o) {
+    _impl->serializer.dump(o, false, false, 0);
+}
+
+bool serialize_json_msg(io::FragmentWriter& packer, const JsonStreamFunc& func) {
+    bool result = true;
+    try {
+        JsonStreamWriter writer(packer);
+        func(writer);
+        static const char eol = 10;
+        packer.write(&eol, 1);
+    } catch (const std::exception& e) {
+        LOG_ERROR() << "dump json: " << e.what();
+        result = false;
+    }
+    packer.finalize();
+    return result;
+}
+
+bool serialize_json_msg(std::string& out, const JsonStreamFunc& func) {
+    bool result = true;
+    io::FragmentWriter fw(4096, 0, [&out](io::SharedBuffer&& fragment) {
+        out.append((const char*)fragment.data, fragment.size);
+    });
+    try {
+        JsonStreamWriter writer(fw);
+        func(writer);
+    } catch (const std::exception& e) {
+        LOG_ERROR() << "dump json: " << e.what();
+        result = false;
+    }
+    fw.finalize();
+    return result;
+}
+
 bool serialize_json_msg(io::FragmentWriter& packer, const nlohmann::json& o) {
     bool result = true;
     try {
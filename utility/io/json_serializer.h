@@ -15,11 +15,43 @@
 #pragma once
 #include "utility/io/fragment_writer.h"
 #include "nlohmann/json_fwd.hpp"
+#include <functional>
+#include <memory>
+#include <string>
 
 namespace beam {
 
 // appends json msg to out by fragment writer
 bool serialize_json_msg(io::FragmentWriter& packer, const nlohmann::json& o);
 
+// Writes a json message piece by piece, so that large arrays don't need the whole tree in memory.
+// The caller is responsible to produce exactly what nlohmann dump() would (i.e. object keys sorted)
+class JsonStreamWriter {
+public:
+    explicit JsonStreamWriter(io::FragmentWriter& fw);
+    ~JsonStreamWriter();
+
+    void write_raw(const char* s, size_t size);
+
+    template <size_t N> void write_raw(const char (&s)[N]) {
+        write_raw(s, N - 1);
+    }
+
+    // dumps value in compact form
+    void write_value(const nlohmann::json& o);
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> _impl;
+};
+
+using JsonStreamFunc = std::function<void(JsonStreamWriter&)>;
+
+// appends json msg produced by func to out by fragment writer
+bool serialize_json_msg(io::FragmentWriter& packer, const JsonStreamFunc& func);
+
+// puts json produced by func into string, same as json::dump() would (without eol)
+bool serialize_json_msg(std::string& out, const JsonStreamFunc& func);
+
 } //namespace
 
@@ -39,6 +39,14 @@ TcpServer::TcpServer(Callback&& callback, Reactor& reactor, Address bindAddress)
     IO_EXCEPTION_IF(errorCode);
 }
 
+Address TcpServer::address() const {
+    if (!_handle) return Address();
+    sockaddr_in sa;
+    int size = sizeof(sockaddr_in);
+    uv_tcp_getsockname((const uv_tcp_t*)_handle, (sockaddr*)&sa, &size);
+    return Address(sa);
+}
+
 void TcpServer::on_accept(ErrorCode errorCode) {
     if (errorCode != EC_OK) {
         _callback(TcpStream::Ptr(), errorCode);
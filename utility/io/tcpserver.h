@@ -30,6 +30,9 @@ public:
 
     virtual ~TcpServer() = default;
 
+    /// Returns the address the server listens to, the port is resolved if bound to port 0
+    Address address() const;
+
 protected:
     TcpServer(Callback&& callback, Reactor& reactor, Address bindAddress);
 
@@ -34,6 +34,9 @@
 #include <iostream>
 #include <fstream>
 #include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
 #include <algorithm>
 
 namespace beam {
@@ -42,6 +45,117 @@ using namespace std;
 
 Logger* Logger::g_logger = 0;
 
+namespace {
+
+// Single-producer single-consumer byte ring. The producer is the logging thread, the consumer is the writer thread
+struct LogRing {
+    struct Record {
+        uint32_t size; // total, aligned. 0 - padding up to the end of the ring
+        uint32_t msgSize;
+        LogMessageHeader header;
+    };
+
+    static const size_t ALIGN = 8;
+
+    static size_t aligned(size_t n) {
+        return (n + ALIGN - 1) & ~(ALIGN - 1);
+    }
+
+    std::unique_ptr<uint8_t[]> buf;
+    size_t capacity;
+    std::atomic<size_t> head; // total bytes written, modified by the producer only
+    std::atomic<size_t> tail; // total bytes read, modified by the consumer only
+    std::atomic<bool> orphan; // producer thread has exited
+
+    explicit LogRing(size_t minSize) : head(0), tail(0), orphan(false) {
+        for (capacity = 4096; capacity < minSize; capacity <<= 1)
+            ;
+        buf.reset(new uint8_t[capacity]);
+    }
+
+    bool is_empty() const {
+        return head.load() == tail.load();
+    }
+
+    size_t get_used() const {
+        return head.load(memory_order_relaxed) - tail.load(memory_order_acquire);
+    }
+
+    // returns false if there's not enough space atm
+    bool try_push(const LogMessageHeader& header, const char* msg, size_t size) {
+        size_t need = aligned(sizeof(Record) + size);
+        size_t h = head.load(memory_order_relaxed);
+        size_t pos = h & (capacity - 1);
+        size_t contiguous = capacity - pos;
+        size_t pad = (contiguous < need) ? contiguous : 0;
+
+        if (capacity - (h - tail.load(memory_order_acquire)) < need + pad)
+            return false;
+
+        if (pad) {
+            reinterpret_cast<Record*>(buf.get() + pos)->size = 0;
+            h += pad;
+            pos = 0;
+        }
+
+        Record* r = reinterpret_cast<Record*>(buf.get() + pos);
+        r->size = static_cast<uint32_t>(need);
+        r->msgSize = static_cast<uint32_t>(size);
+        r->header = header;
+        memcpy(r + 1, msg, size);
+
+        head.store(h + need, memory_order_release);
+        return true;
+    }
+
+    template <typename Func>
+    size_t drain(Func&& func) {
+        size_t t = tail.load(memory_order_relaxed);
+        size_t h = head.load(memory_order_acquire);
+        size_t count = 0;
+
+        while (t != h) {
+            size_t pos = t & (capacity - 1);
+            const Record* r = reinterpret_cast<const Record*>(buf.get() + pos);
+            if (!r->size) {
+                t += capacity - pos;
+            } else {
+                func(r->header, reinterpret_cast<const char*>(r + 1), r->msgSize);
+                t += r->size;
+                count++;
+            }
+            tail.store(t, memory_order_release);
+        }
+        return count;
+    }
+};
+
+struct LogRingSlot {
+    std::shared_ptr<LogRing> ring;
+    uint64_t writerId = 0;
+
+    ~LogRingSlot() {
+        if (ring) ring->orphan = true;
+    }
+};
+
+thread_local LogRingSlot t_ringSlot;
+
+// The seconds part of the timestamp is formatted once per second (per thread)
+struct TimestampCache {
+    const void* owner = 0;
+    uint32_t generation = 0;
+    uint64_t seconds = uint64_t(-1);
+    char buf[80];
+    size_t size = 0;
+};
+
+thread_local TimestampCache t_timestampCache;
+
+std::atomic<uint64_t> g_asyncWriterId(0);
+
+} //namespace
+
 class LoggerImpl : public Logger {
 protected:
     mutex _mutex;
@@ -54,6 +168,11 @@ protected:
     LogMessageHeaderFormatter _headerFormatter = def_header_formatter;
     std::string _timeFormat;
     bool _printMilliseconds;
+    std::atomic<uint32_t> _timeFormatGeneration;
+
+    class AsyncWriter;
+    std::unique_ptr<AsyncWriter> _async;
+    uint64_t _droppedPrev = 0;
 
     LoggerImpl(FILE* sink, int minLevel, int flushLevel) :
         _sink(sink),
@@ -61,16 +180,13 @@ protected:
         _flushLevel(flushLevel),
         _headerFormatter(def_header_formatter),
         _timeFormat("%Y-%m-%d.%T"),
-        _printMilliseconds(true)
+        _printMilliseconds(true),
+        _timeFormatGeneration(0)
     {
         if (minLevel <= 0) throw runtime_error("logger: minimal level out of range");
     }
 
-    virtual ~LoggerImpl() {
-        if (this == g_logger) {
-            g_logger = 0;
-        }
-    }
+    virtual ~LoggerImpl();
 
     void set_header_formatter(LogMessageHeaderFormatter formatter) override {
         if (formatter) _headerFormatter = formatter;
@@ -84,18 +200,54 @@ protected:
             _timeFormat.clear();
             _printMilliseconds = false;
         }
+        _timeFormatGeneration++;
     }
 
-    void write_message(const LogMessageHeader& header, const char* buf, size_t size) override {
+    void set_async(const LoggerAsyncConfig* cfg) override;
+    uint64_t get_dropped_count() override;
+
+    void write_message(const LogMessageHeader& header, const char* buf, size_t size) override;
+
+    size_t format_header(char* headerFormatted, const LogMessageHeader& header) {
         char timestampFormatted[MAX_TIMESTAMP_SIZE];
-        char headerFormatted[MAX_HEADER_SIZE];
         if (!_timeFormat.empty()) {
-            format_timestamp(timestampFormatted, MAX_TIMESTAMP_SIZE, _timeFormat.c_str(), header.timestamp, _printMilliseconds);
+            format_timestamp_cached(timestampFormatted, header.timestamp);
         } else {
             timestampFormatted[0] = 0;
         }
-        size_t headerSize = _headerFormatter(headerFormatted, MAX_HEADER_SIZE, timestampFormatted, header);
-        write_impl(header.level, headerFormatted, headerSize, buf, size);
+        return _headerFormatter(headerFormatted, MAX_HEADER_SIZE, timestampFormatted, header);
+    }
+
+    void format_timestamp_cached(char* buf, uint64_t timestamp) {
+        TimestampCache& c = t_timestampCache;
+        uint64_t seconds = timestamp / 1000;
+        uint32_t generation = _timeFormatGeneration.load(memory_order_relaxed);
+
+        if ((c.owner != this) || (c.generation != generation) || (c.seconds != seconds)) {
+            c.size = format_timestamp(c.buf, sizeof(c.buf), _timeFormat.c_str(), seconds * 1000, false);
+            c.owner = this;
+            c.generation = generation;
+            c.seconds = seconds;
+        }
+
+        memcpy(buf, c.buf, c.size);
+        size_t n = c.size;
+
+        if (_printMilliseconds && (MAX_TIMESTAMP_SIZE - n > 4)) {
+            unsigned ms = unsigned(timestamp % 1000);
+            buf[n++] = '.';
+            buf[n++] = char('0' + ms / 100);
+            buf[n++] = char('0' + (ms / 10) % 10);
+            buf[n++] = char('0' + ms % 10);
+        }
+        buf[n] = 0;
+    }
+
+    // formats the header and writes to the sink(s)
+    virtual void write_formatted(const LogMessageHeader& header, const char* buf, size_t size, bool mayFlush) {
+        char headerFormatted[MAX_HEADER_SIZE];
+        size_t headerSize = format_header(headerFormatted, header);
+        write_impl(header.level, headerFormatted, headerSize, buf, size, mayFlush);
     }
 
     const FileNameType& get_current_file_name() override {
@@ -108,22 +260,203 @@ public:
         return level >= _minLevel;
     }
 
-    void write_impl(int level, const char* header, size_t headerSize, const char* msg, size_t size) {
+    void write_impl(int level, const char* header, size_t headerSize, const char* msg, size_t size, bool mayFlush=true) {
         if (!_sink) return; 
         lock_guard<mutex> lock(_mutex);
         if (!_sink) return; // double check
         fwrite(header, 1, headerSize, _sink);
         fwrite(msg, 1, size, _sink);
-        if (level >= _flushLevel) fflush(_sink);
+        if (mayFlush && level >= _flushLevel) fflush(_sink);
+    }
+
+    virtual void flush_sinks() {
+        lock_guard<mutex> lock(_mutex);
+        if (_sink) fflush(_sink);
+    }
+
+    // stops the writer thread (if any), must be called before the sinks are closed
+    void stop_async() {
+        set_async(nullptr);
+    }
+};
+
+// Background writer. Each logging thread gets its own ring, so that the callers never contend with each other.
+// Messages are written in batches, sinks are flushed once per batch.
+// Messages of different threads are written in the order they are collected, which is roughly (not strictly) chronological.
+class LoggerImpl::AsyncWriter {
+    LoggerImpl& _owner;
+    LoggerAsyncConfig _cfg;
+    uint64_t _id;
+
+    mutex _ringsMutex;
+    vector<shared_ptr<LogRing>> _rings;
+
+    mutex _wakeMutex;
+    condition_variable _wakeCond;
+    atomic<bool> _sleeping;
+    atomic<bool> _stop;
+    thread _thread;
+
+public:
+    atomic<uint64_t> _dropped;
+
+    AsyncWriter(LoggerImpl& owner, const LoggerAsyncConfig& cfg) :
+        _owner(owner),
+        _cfg(cfg),
+        _id(++g_asyncWriterId),
+        _sleeping(false),
+        _stop(false),
+        _dropped(0)
+    {
+        _thread = thread(&AsyncWriter::run, this);
+    }
+
+    ~AsyncWriter() {
+        _stop = true;
+        wake();
+        _thread.join();
+    }
+
+    void push(const LogMessageHeader& header, const char* msg, size_t size) {
+        LogRing& ring = get_ring();
+
+        // too long messages are truncated, so that the ring never overflows with a single message
+        size_t maxSize = ring.capacity / 2 - sizeof(LogRing::Record);
+        string truncated;
+        if (size > maxSize) {
+            truncated.assign(msg, maxSize - 1);
+            truncated += '\n';
+            msg = truncated.data();
+            size = truncated.size();
+        }
+
+        while (!ring.try_push(header, msg, size)) {
+            if (LoggerAsyncConfig::Drop == _cfg.overflow) {
+                _dropped++;
+                return;
+            }
+
+            wake();
+            this_thread::yield();
+        }
+
+        // The writer wakes up on its own periodically. Wake it explicitly only if it's urgent
+        if ((header.level >= _owner._flushLevel) || (ring.get_used() > ring.capacity / 2)) {
+            atomic_thread_fence(memory_order_seq_cst);
+            if (_sleeping) wake();
+        }
+    }
+
+private:
+    LogRing& get_ring() {
+        LogRingSlot& slot = t_ringSlot;
+        if (!slot.ring || (slot.writerId != _id)) {
+            if (slot.ring) slot.ring->orphan = true;
+
+            slot.ring = make_shared<LogRing>(_cfg.bufferSize);
+            slot.writerId = _id;
+
+            lock_guard<mutex> lock(_ringsMutex);
+            _rings.push_back(slot.ring);
+        }
+        return *slot.ring;
+    }
+
+    void wake() {
+        lock_guard<mutex> lock(_wakeMutex);
+        _wakeCond.notify_one();
+    }
+
+    bool has_data() {
+        lock_guard<mutex> lock(_ringsMutex);
+        for (const auto& ring : _rings) {
+            if (!ring->is_empty()) return true;
+        }
+        return false;
+    }
+
+    size_t drain_all() {
+        vector<shared_ptr<LogRing>> rings;
+        {
+            lock_guard<mutex> lock(_ringsMutex);
+            rings = _rings;
+        }
+
+        size_t count = 0;
+        for (const auto& ring : rings) {
+            bool orphan = ring->orphan; // check before draining, the owner won't write anymore
+
+            count += ring->drain([this](const LogMessageHeader& header, const char* msg, size_t size) {
+                _owner.write_formatted(header, msg, size, false);
+            });
+
+            if (orphan) {
+                lock_guard<mutex> lock(_ringsMutex);
+                _rings.erase(std::find(_rings.begin(), _rings.end(), ring));
+            }
+        }
+        return count;
+    }
+
+    void run() {
+        while (true) {
+            bool stop = _stop;
+
+            if (drain_all()) {
+                _owner.flush_sinks();
+                continue;
+            }
+
+            if (stop) break;
+
+            unique_lock<mutex> lock(_wakeMutex);
+            _sleeping = true;
+            if (!_stop && !has_data()) {
+                _wakeCond.wait_for(lock, chrono::milliseconds(_cfg.writeInterval_ms));
+            }
+            _sleeping = false;
+        }
     }
 };
 
+LoggerImpl::~LoggerImpl() {
+    if (this == g_logger) {
+        g_logger = 0;
+    }
+}
+
+void LoggerImpl::set_async(const LoggerAsyncConfig* cfg) {
+    if (_async) {
+        _droppedPrev += _async->_dropped;
+        _async.reset(); // writes all the pending messages
+    }
+    if (cfg) {
+        _async = make_unique<AsyncWriter>(*this, *cfg);
+    }
+}
+
+uint64_t LoggerImpl::get_dropped_count() {
+    return _droppedPrev + (_async ? _async->_dropped.load() : 0);
+}
+
+void LoggerImpl::write_message(const LogMessageHeader& header, const char* buf, size_t size) {
+    if (_async) {
+        _async->push(header, buf, size);
+    } else {
+        write_formatted(header, buf, size, true);
+    }
+}
+
 class ConsoleLogger : public LoggerImpl {
 public:
     ConsoleLogger(int flushLevel, int consoleLevel) :
         LoggerImpl(stdout, consoleLevel, flushLevel)
     {}
 
+    ~ConsoleLogger() {
+        stop_async();
+    }
+
     // does nothing for console
     void rotate() override {}
 };
@@ -147,6 +480,7 @@ public:
     }
 
     ~FileLogger() {
+        stop_async();
         fclose(_sink);
     }
 
@@ -225,23 +559,26 @@ public:
         _consoleSink(flushLevel, consoleLevel)
     {}
 
-    void write_message(const LogMessageHeader& header, const char* buf, size_t size) override {
-        char timestampFormatted[MAX_TIMESTAMP_SIZE];
+    ~CombinedLogger() {
+        stop_async();
+    }
+
+    void write_formatted(const LogMessageHeader& header, const char* buf, size_t size, bool mayFlush) override {
         char headerFormatted[MAX_HEADER_SIZE];
-        if (!_timeFormat.empty()) {
-            format_timestamp(timestampFormatted, MAX_TIMESTAMP_SIZE, _timeFormat.c_str(), header.timestamp, _printMilliseconds);
-        } else {
-            timestampFormatted[0] = 0;
-        }
-        size_t headerSize = _headerFormatter(headerFormatted, MAX_HEADER_SIZE, timestampFormatted, header);
+        size_t headerSize = format_header(headerFormatted, header);
         if (_consoleSink.level_accepted(header.level)) {
-            _consoleSink.write_impl(header.level, headerFormatted, headerSize, buf, size);
+            _consoleSink.write_impl(header.level, headerFormatted, headerSize, buf, size, mayFlush);
         }
         if (_fileSink.level_accepted(header.level)) {
-            _fileSink.write_impl(header.level, headerFormatted, headerSize, buf, size);
+            _fileSink.write_impl(header.level, headerFormatted, headerSize, buf, size, mayFlush);
         }
     }
 
+    void flush_sinks() override {
+        _consoleSink.flush_sinks();
+        _fileSink.flush_sinks();
+    }
+
     const FileNameType& get_current_file_name() override {
         return _fileSink.get_current_file_name();
     }
@@ -99,6 +99,19 @@ struct LoggerConfig {
     // ~etc rotation
 };
 
+// Asynchronous mode options
+struct LoggerAsyncConfig {
+    // what to do if the calling thread's buffer is full
+    enum Overflow {
+        Block, // wait for the writer thread
+        Drop   // discard the message (counted)
+    };
+
+    size_t bufferSize=256*1024; // per calling thread, bytes. Rounded up to a power of 2
+    Overflow overflow=Block;
+    unsigned writeInterval_ms=50; // writer wakes up at least that often. Messages with level >= flushLevel wake it immediately
+};
+
 struct LogMessageHeader {
     uint64_t timestamp;
     const char* func;
@@ -167,6 +180,13 @@ public:
     /// Rotates file name, called externally
     virtual void rotate() = 0;
 
+    /// Switches to the asynchronous mode: messages are copied into per-thread lock-free buffers, and written (in batches) by a background thread.
+    /// Pass NULL to return to the synchronous mode (pending messages are written). Should not be called concurrently with logging
+    virtual void set_async(const LoggerAsyncConfig* cfg) = 0;
+
+    /// Num of messages dropped in the asynchronous mode (LoggerAsyncConfig::Drop)
+    virtual uint64_t get_dropped_count() = 0;
+
     static bool will_log(int level) {
         return g_logger && g_logger->level_accepted(level);
     }
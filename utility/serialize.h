@@ -180,6 +180,23 @@ public:
         return *this;
     }
 
+    /// Reads the size of a sequence, as serialized for the std containers
+    size_t read_seq_size() {
+        return _ia.read_seq_size();
+    }
+
+    /// Reads a byte sequence (serialized as std::vector<uint8_t>) in-place, w/o copying. The returned pointer refers to the input buffer
+    const uint8_t* read_seq(size_t& size) {
+        size = read_seq_size();
+        if (size > _is.bytes_left()) {
+            _is.raise_underflow();
+        }
+
+        const uint8_t* p = reinterpret_cast<const uint8_t*>(_is.cur);
+        _is.cur += size;
+        return p;
+    }
+
 private:
     /// Contiguous buffer istream
     using Istream = detail::SerializeIstream;
@@ -14,10 +14,33 @@
 
 #include "utility/logger_checkpoints.h"
 #include "utility/helpers.h"
+#include <boost/filesystem.hpp>
 #include <thread>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
 
 using namespace beam;
 
+int g_TestsFailed = 0;
+
+void TestFailed(const char* szExpr, uint32_t nLine)
+{
+    printf("Test failed! Line=%u, Expression: %s\n", nLine, szExpr);
+    g_TestsFailed++;
+}
+
+#define verify_test(x) \
+    do { \
+        if (!(x)) \
+            TestFailed(#x, __LINE__); \
+    } while (false)
+
 struct XXX {
     int z = 333;
 };
@@ -79,7 +102,187 @@ void test_ndc_2(bool exc)
     }
 }
 
-int main() {
+// holds the writer thread while g_blockWriter is set
+static std::atomic<bool> g_blockWriter(false);
+static std::atomic<bool> g_writerBlocked(false);
+
+static size_t blocking_header_formatter(char* buf, size_t maxSize, const char* timestampFormatted, const LogMessageHeader& header) {
+    if (g_blockWriter) {
+        g_writerBlocked = true;
+        while (g_blockWriter) std::this_thread::yield();
+    }
+    return custom_header_formatter(buf, maxSize, timestampFormatted, header);
+}
+
+static std::string read_and_remove(const Logger::FileNameType& fileName) {
+    boost::filesystem::path path(fileName);
+    std::string res;
+    {
+        std::ifstream f(path.string(), std::ios::binary);
+        std::stringstream ss;
+        ss << f.rdbuf();
+        res = ss.str();
+    }
+    boost::filesystem::remove(path);
+    return res;
+}
+
+void test_async() {
+    static const int nThreads = 4;
+    static const int nMessages = 20000;
+
+    Logger::FileNameType fileName;
+    {
+        auto logger = Logger::create(LOG_LEVEL_ERROR, 0, LOG_LEVEL_DEBUG, "async_test_");
+        logger->set_header_formatter(custom_header_formatter);
+        fileName = logger->get_current_file_name();
+
+        LoggerAsyncConfig cfg;
+        cfg.bufferSize = 4096; // small, to make the callers block
+        logger->set_async(&cfg);
+
+        std::vector<std::thread> threads;
+        for (int t = 0; t < nThreads; t++) {
+            threads.emplace_back([t]() {
+                for (int i = 0; i < nMessages; i++) {
+                    LOG_INFO() << "thread " << t << " msg " << i;
+                }
+            });
+        }
+        for (auto& th : threads) th.join();
+
+        LOG_INFO() << std::string(10000, 'x'); // gets truncated
+
+        verify_test(!logger->get_dropped_count());
+    }
+
+    // every message is written exactly once, per-thread order is preserved
+    std::istringstream is(read_and_remove(fileName));
+    std::vector<int> next(nThreads, 0);
+    std::string line;
+    int nLong = 0;
+    while (std::getline(is, line)) {
+        size_t pos = line.find("thread ");
+        if (pos == std::string::npos) {
+            verify_test(line.find("xxx") != std::string::npos);
+            nLong++;
+            continue;
+        }
+        int t = -1, i = -1;
+        verify_test(sscanf(line.c_str() + pos, "thread %d msg %d", &t, &i) == 2);
+        verify_test(t >= 0 && t < nThreads);
+        verify_test(next[t] == i);
+        next[t]++;
+    }
+    verify_test(nLong == 1);
+    for (int t = 0; t < nThreads; t++)
+        verify_test(next[t] == nMessages);
+
+    // drop policy: the writer is held on the 1st message, so the ring fills up and the rest is dropped
+    uint64_t nDropped = 0;
+    {
+        auto logger = Logger::create(LOG_LEVEL_ERROR, 0, LOG_LEVEL_DEBUG, "async_drop_test_");
+        logger->set_header_formatter(blocking_header_formatter);
+        fileName = logger->get_current_file_name();
+
+        LoggerAsyncConfig cfg;
+        cfg.bufferSize = 1024;
+        cfg.overflow = LoggerAsyncConfig::Drop;
+        cfg.writeInterval_ms = 1;
+        logger->set_async(&cfg);
+
+        g_blockWriter = true;
+        LOG_INFO() << "first";
+        while (!g_writerBlocked) std::this_thread::yield();
+
+        for (int i = 0; i < nMessages; i++) {
+            LOG_INFO() << "msg " << i;
+        }
+
+        nDropped = logger->get_dropped_count();
+        g_blockWriter = false;
+
+        logger->set_async(nullptr);
+        LOG_INFO() << "sync again";
+    }
+
+    verify_test(nDropped > 0);
+    verify_test(nDropped < uint64_t(nMessages));
+
+    // the messages that fit are written in order, all the later ones are dropped
+    is.clear();
+    is.str(read_and_remove(fileName));
+    int nWritten = 0;
+    bool bFirst = false, bSyncAgain = false;
+    while (std::getline(is, line)) {
+        int i = -1;
+        size_t pos = line.find("msg ");
+        if (pos != std::string::npos) {
+            verify_test(sscanf(line.c_str() + pos, "msg %d", &i) == 1);
+            verify_test(i == nWritten);
+            nWritten++;
+        }
+        else if (line.find("first") != std::string::npos)
+            bFirst = true;
+        else if (line.find("sync again") != std::string::npos)
+            bSyncAgain = true;
+    }
+    verify_test(bFirst && bSyncAgain);
+    verify_test(nWritten + nDropped == uint64_t(nMessages));
+}
+
+void bench_logger(bool async) {
+    static const int nThreads = 4;
+    static const int nMessages = 50000;
+
+    Logger::FileNameType fileName;
+    std::vector<uint64_t> latencies;
+    double elapsed_s = 0;
+    {
+        auto logger = Logger::create(LOG_LEVEL_ERROR, 0, LOG_LEVEL_DEBUG, async ? "bench_async_" : "bench_sync_");
+        fileName = logger->get_current_file_name();
+
+        if (async) {
+            LoggerAsyncConfig cfg;
+            cfg.bufferSize = 1024 * 1024;
+            logger->set_async(&cfg);
+        }
+
+        std::vector<std::vector<uint64_t> > vLat(nThreads);
+        auto t0 = std::chrono::steady_clock::now();
+
+        std::vector<std::thread> threads;
+        for (int t = 0; t < nThreads; t++) {
+            threads.emplace_back([t, &vLat]() {
+                auto& lat = vLat[t];
+                lat.reserve(nMessages);
+                for (int i = 0; i < nMessages; i++) {
+                    auto tm0 = std::chrono::steady_clock::now();
+                    LOG_INFO() << "bench thread " << t << " message " << i << " some payload " << 12345.678;
+                    auto tm1 = std::chrono::steady_clock::now();
+                    lat.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(tm1 - tm0).count());
+                }
+            });
+        }
+        for (auto& th : threads) th.join();
+
+        logger->set_async(nullptr); // include the time to write everything
+        elapsed_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+        for (const auto& v : vLat)
+            latencies.insert(latencies.end(), v.begin(), v.end());
+    }
+    read_and_remove(fileName);
+
+    std::sort(latencies.begin(), latencies.end());
+    printf("%s logger: %.0f msgs/sec, caller latency p50=%llu ns, p99=%llu ns\n",
+        async ? "async" : "sync",
+        latencies.size() / elapsed_s,
+        (unsigned long long) latencies[latencies.size() / 2],
+        (unsigned long long) latencies[latencies.size() * 99 / 100]);
+}
+
+int main(int argc, char* argv[]) {
     test_logger_1();
     test_ndc_1();
     test_ndc_2(false);
@@ -87,4 +290,14 @@ int main() {
         test_ndc_2(true);
     }
     catch(...) {}
+
+    test_async();
+
+    // throughput and latency, not a part of the default run: logger_test --bench
+    if ((argc > 1) && !strcmp(argv[1], "--bench")) {
+        bench_logger(false);
+        bench_logger(true);
+    }
+
+    return g_TestsFailed ? -1 : 0;
 }
@@ -42,6 +42,51 @@ json getNotImplError(const JsonRpcId& id)
     };
 }
 
+json getUtxoJson(const Coin& utxo)
+{
+    std::string createTxId = utxo.m_createTxId.is_initialized() ? TxIDToString(*utxo.m_createTxId) : "";
+    std::string spentTxId = utxo.m_spentTxId.is_initialized() ? TxIDToString(*utxo.m_spentTxId) : "";
+
+    return json
+    {
+        {"id", utxo.toStringID()},
+        {"amount", utxo.m_ID.m_Value},
+        {"type", (const char*)FourCC::Text(utxo.m_ID.m_Type)},
+        {"maturity", utxo.get_Maturity()},
+        {"createTxId", createTxId},
+        {"spentTxId", spentTxId},
+        {"status", utxo.m_status},
+        {"status_string", utxo.getStatusString()},
+        {"session", utxo.m_sessionId}
+    };
+}
+
+json getTxJson(const Status::Response& item)
+{
+    json res = {};
+    GetStatusResponseJson(item.tx, res, item.kernelProofHeight, item.systemHeight);
+    return res;
+}
+
+// Streams {"id":..., "jsonrpc":"2.0", "result":[...]} one item at a time.
+// Keys are written in the same (sorted) order as json::dump() gives for the whole tree
+template <typename T, typename Func>
+void writeArrayResponse(const JsonRpcId& id, const std::vector<T>& items, JsonStreamWriter& writer, Func&& toJson)
+{
+    writer.write_raw("{\"id\":");
+    writer.write_value(id);
+    writer.write_raw(",\"jsonrpc\":\"2.0\",\"result\":[");
+
+    for (size_t i = 0; i < items.size(); i++)
+    {
+        if (i)
+            writer.write_raw(",");
+        writer.write_value(toJson(items[i]));
+    }
+
+    writer.write_raw("]}");
+}
+
 std::string getJsonString(const char* data, size_t size)
 {
     return std::string(data, data + (size > 1024 ? 1024 : size));
@@ -1381,24 +1426,15 @@ OfferInput collectOfferInput(const JsonRpcId& id, const json& params)
 
         for (auto& utxo : res.utxos)
         {
-            std::string createTxId = utxo.m_createTxId.is_initialized() ? TxIDToString(*utxo.m_createTxId) : "";
-            std::string spentTxId = utxo.m_spentTxId.is_initialized() ? TxIDToString(*utxo.m_spentTxId) : "";
-
-            msg["result"].push_back(
-            { 
-                {"id", utxo.toStringID()},
-                {"amount", utxo.m_ID.m_Value},
-                {"type", (const char*)FourCC::Text(utxo.m_ID.m_Type)},
-                {"maturity", utxo.get_Maturity()},
-                {"createTxId", createTxId},
-                {"spentTxId", spentTxId},
-                {"status", utxo.m_status},
-                {"status_string", utxo.getStatusString()},
-                {"session", utxo.m_sessionId}
-            });
+            msg["result"].push_back(getUtxoJson(utxo));
         }
     }
 
+    void WalletApi::getResponse(const JsonRpcId& id, const GetUtxo::Response& res, JsonStreamWriter& writer)
+    {
+        writeArrayResponse(id, res.utxos, writer, getUtxoJson);
+    }
+
     void WalletApi::getResponse(const JsonRpcId& id, const Send::Response& res, json& msg)
     {
         msg = json
@@ -1485,16 +1521,15 @@ OfferInput collectOfferInput(const JsonRpcId& id, const json& params)
 
         for (const auto& resItem : res.resultList)
         {
-            json item = {};
-            GetStatusResponseJson(
-                resItem.tx,
-                item,
-                resItem.kernelProofHeight,
-                resItem.systemHeight);
-            msg["result"].push_back(item);
+            msg["result"].push_back(getTxJson(resItem));
         }
     }
 
+    void WalletApi::getResponse(const JsonRpcId& id, const TxList::Response& res, JsonStreamWriter& writer)
+    {
+        writeArrayResponse(id, res.resultList, writer, getTxJson);
+    }
+
     void WalletApi::getResponse(const JsonRpcId& id, const WalletStatus::Response& res, json& msg)
     {
         msg = json
@@ -21,6 +21,7 @@
 #include "wallet/client/extensions/offers_board/swap_offer.h"
 #endif  // BEAM_ATOMIC_SWAP_SUPPORT
 #include "nlohmann/json.hpp"
+#include "utility/io/json_serializer.h"
 
 namespace beam::wallet
 {
@@ -541,6 +542,10 @@ namespace beam::wallet
 
 #undef RESPONSE_FUNC
 
+        // streamed versions for the potentially large lists
+        void getResponse(const JsonRpcId& id, const GetUtxo::Response& data, JsonStreamWriter& writer);
+        void getResponse(const JsonRpcId& id, const TxList::Response& data, JsonStreamWriter& writer);
+
     private:
         IWalletApiHandler& getHandler() const;
 
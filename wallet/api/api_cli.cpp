@@ -477,6 +477,11 @@ private:
             serialize_json_msg(_lineProtocol, msg);
         }
 
+        void serializeStreamedMsg(const JsonStreamFunc& func) override
+        {
+            serialize_json_msg(_lineProtocol, func);
+        }
+
         void on_write(io::SharedBuffer&& msg)
         {
             _stream->write(msg);
@@ -551,6 +556,12 @@ private:
             _keepalive = send(_connection, 200, "OK");
         }
 
+        void serializeStreamedMsg(const JsonStreamFunc& func) override
+        {
+            serialize_json_msg(_body, _packer, func);
+            _keepalive = send(_connection, 200, "OK");
+        }
+
     private:
 
         bool on_request(uint64_t id, const HttpMsgReader::Message& msg)
@@ -667,6 +678,11 @@ int main(int argc, char* argv[])
             bool useHttp;
             Nonnegative<uint32_t> pollPeriod_ms;
 
+            bool bbsTagOutgoing;
+            bool bbsTagFilter;
+            Nonnegative<uint32_t> bbsDecryptThreads;
+            bool proofsBatch;
+
             bool useAcl;
             std::string aclPath;
             std::string whitelist;
@@ -695,6 +711,10 @@ int main(int argc, char* argv[])
                 (cli::IP_WHITELIST, po::value<std::string>(&options.whitelist)->default_value(""), "IP whitelist")
                 (cli::LOG_CLEANUP_DAYS, po::value<uint32_t>(&options.logCleanupPeriod)->default_value(5), "old logfiles cleanup period(days)")
                 (cli::NODE_POLL_PERIOD, po::value<Nonnegative<uint32_t>>(&options.pollPeriod_ms)->default_value(Nonnegative<uint32_t>(0)), "Node poll period in milliseconds. Set to 0 to keep connection. Anyway poll period would be no less than the expected rate of blocks if it is less then it will be rounded up to block rate value.")
+                (cli::BBS_TAG_OUTGOING, po::value<bool>(&options.bbsTagOutgoing)->default_value(false), "Append the recipient tag to the outgoing messages")
+                (cli::BBS_TAG_FILTER, po::value<bool>(&options.bbsTagFilter)->default_value(false), "Skip the own addresses that don't match the recipient tag of the incoming messages. Enable if the peers tag their messages")
+                (cli::BBS_DECRYPT_THREADS, po::value<Nonnegative<uint32_t>>(&options.bbsDecryptThreads)->default_value(Nonnegative<uint32_t>(0)), "Threads for the trial decryption of the incoming messages. Set to 0 to decrypt in the main thread")
+                (cli::PROOFS_BATCH, po::value<bool>(&options.proofsBatch)->default_value(true), "Request the kernel and utxo proofs in batches, if the node supports it")
             ;
 
             po::options_description authDesc("User authorization options");
@@ -849,8 +869,12 @@ int main(int argc, char* argv[])
         nnet->Connect();
 
         auto wnet = std::make_shared<WalletNetworkViaBbs>(wallet, nnet, walletDB);
+        wnet->m_TagOutgoing = options.bbsTagOutgoing;
+        wnet->m_TagFilterIncoming = options.bbsTagFilter;
+        wnet->SetDecryptThreads(options.bbsDecryptThreads.value);
 		wallet.AddMessageEndpoint(wnet);
         wallet.SetNodeEndpoint(nnet);
+        wallet.EnableProofBatching(options.proofsBatch);
 
         WalletApiServer server(walletDB, wallet, *reactor, 
             listenTo, options.useHttp, acl, tlsOptions, whitelist);
@@ -218,6 +218,15 @@ void WalletApiHandler::doError(const JsonRpcId& id, ApiError code, const std::st
     serializeMsg(msg);
 }
 
+void WalletApiHandler::serializeStreamedMsg(const JsonStreamFunc& func)
+{
+    std::string str;
+    if (serialize_json_msg(str, func))
+    {
+        serializeMsg(json::parse(str));
+    }
+}
+
 void WalletApiHandler::onInvalidJsonRpc(const json& msg)
 {
     LOG_DEBUG() << "onInvalidJsonRpc: " << msg;
@@ -579,15 +588,38 @@ void WalletApiHandler::onMessage(const JsonRpcId& id, const GetUtxo& data)
     LOG_DEBUG() << "GetUtxo(id = " << id << ")";
 
     GetUtxo::Response response;
-    _walletData.getWalletDB()->visitCoins([&response](const Coin& c)->bool
+    auto visitor = [&response](const Coin& c)->bool
     {
         response.utxos.push_back(c);
         return true;
-    });
+    };
+
+    auto walletDB = _walletData.getWalletDB();
+    if (data.count > 0)
+    {
+        uint64_t cursor = 0;
+        if (data.skip > 0)
+        {
+            if (data.skip == _utxoNextSkip)
+            {
+                cursor = _utxoCursor;
+            }
+            else
+            {
+                // random access, have to walk over the skipped coins once
+                walletDB->visitCoins([](const Coin&) { return true; }, cursor, data.skip);
+            }
+        }
 
-    doPagination(data.skip, data.count, response.utxos);
+        walletDB->visitCoins(visitor, cursor, data.count);
 
-    doResponse(id, response);
+        _utxoNextSkip = data.skip + static_cast<int>(response.utxos.size());
+        _utxoCursor = cursor;
+    }
+    else
+        walletDB->visitCoins(visitor);
+
+    doStreamedResponse(id, response);
 }
 
 void WalletApiHandler::onMessage(const JsonRpcId& id, const WalletStatus& data)
@@ -660,7 +692,18 @@ void WalletApiHandler::onMessage(const JsonRpcId& id, const TxList& data)
 
     {
         auto walletDB = _walletData.getWalletDB();
-        auto txList = walletDB->getTxHistory();
+
+        TxHistoryQuery query;
+        query.status = data.filter.status;
+        query.minHeight = data.filter.height;
+        query.maxHeight = data.filter.height;
+        if (data.count > 0)
+        {
+            query.skip = data.skip;
+            query.count = data.count;
+        }
+
+        auto txList = walletDB->getTxHistory(query);
 
         Block::SystemState::ID stateID = {};
         _walletData.getWalletDB()->getSystemStateID(stateID);
@@ -678,35 +721,7 @@ void WalletApiHandler::onMessage(const JsonRpcId& id, const TxList& data)
         }
     }
 
-    using Result = decltype(res.resultList);
-
-    // filter transactions by status if provided
-    if (data.filter.status)
-    {
-        Result filteredList;
-
-        for (const auto& it : res.resultList)
-            if (it.tx.m_status == *data.filter.status)
-                filteredList.push_back(it);
-
-        res.resultList = filteredList;
-    }
-
-    // filter transactions by height if provided
-    if (data.filter.height)
-    {
-        Result filteredList;
-
-        for (const auto& it : res.resultList)
-            if (it.kernelProofHeight == *data.filter.height)
-                filteredList.push_back(it);
-
-        res.resultList = filteredList;
-    }
-
-    doPagination(data.skip, data.count, res.resultList);
-
-    doResponse(id, res);
+    doStreamedResponse(id, res);
 }
 
 void WalletApiHandler::onMessage(const JsonRpcId& id, const ExportPaymentProof& data)
@@ -49,6 +49,19 @@ public:
         serializeMsg(msg);
     }
 
+    // writes the message straight into the output, without the whole json tree in memory.
+    // Default implementation falls back to serializeMsg(const json&)
+    virtual void serializeStreamedMsg(const JsonStreamFunc& func);
+
+    template<typename T>
+    void doStreamedResponse(const JsonRpcId& id, const T& response)
+    {
+        serializeStreamedMsg([&](JsonStreamWriter& writer)
+        {
+            _api.getResponse(id, response, writer);
+        });
+    }
+
     void doError(const JsonRpcId& id, ApiError code, const std::string& data = "");
 
     void onInvalidJsonRpc(const json& msg) override;
@@ -64,28 +77,13 @@ public:
 
     void doTxAlreadyExistsError(const JsonRpcId& id);
 
-    template<typename T>
-    static void doPagination(size_t skip, size_t count, std::vector<T>& res)
-    {
-        if (count > 0)
-        {
-            size_t start = skip;
-            size_t end = start + count;
-            size_t size = res.size();
-
-            if (start < size)
-            {
-                if (end > size) end = size;
-
-                res = std::vector<T>(res.begin() + start, res.begin() + end);
-            }
-            else res = {};
-        }
-    }
-
 protected:
     IWalletData& _walletData;
     WalletApi _api;
+
+    // where the last get_utxo page ended, the next sequential page continues from the cursor
+    int _utxoNextSkip = 0;
+    uint64_t _utxoCursor = 0;
 };
 } // beam::wallet
 
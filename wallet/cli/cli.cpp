@@ -2066,8 +2066,13 @@ namespace
             {
                 return -1;
             }
-            wallet.AddMessageEndpoint(make_shared<WalletNetworkViaBbs>(wallet, nnet, walletDB));
+            auto wnet = make_shared<WalletNetworkViaBbs>(wallet, nnet, walletDB);
+            wnet->m_TagOutgoing = vm[cli::BBS_TAG_OUTGOING].as<bool>();
+            wnet->m_TagFilterIncoming = vm[cli::BBS_TAG_FILTER].as<bool>();
+            wnet->SetDecryptThreads(vm[cli::BBS_DECRYPT_THREADS].as<Nonnegative<uint32_t>>().value);
+            wallet.AddMessageEndpoint(wnet);
             wallet.SetNodeEndpoint(nnet);
+            wallet.EnableProofBatching(vm[cli::PROOFS_BATCH].as<bool>());
 
             int res = func(vm, wallet, walletDB, currentTxID, isFork1);
             if (res != 0)
@@ -17,6 +17,7 @@
 
 #include "core/ecc_native.h"
 #include "core/block_crypt.h"
+#include "core/radixtree.h"
 #include "utility/logger.h"
 #include "utility/helpers.h"
 #include "simple_transaction.h"
@@ -34,6 +35,11 @@ namespace beam::wallet
 
     namespace
     {
+        // Batch sizes, such that the worst-case response still fits proto::g_MaxMsgSize.
+        // A kernel costs its proof within the block (at most 64 levels), the block header, and its part of the merged proof of the headers.
+        const uint32_t s_KernelProofSizeMax = sizeof(Merkle::Node) * 64 + sizeof(Block::SystemState::Full) + sizeof(Merkle::Hash) * 64 + sizeof(Height);
+        const uint32_t s_KernelsBatchMax = std::min(proto::g_ProofsBatchMax, proto::g_MaxMsgSize / s_KernelProofSizeMax);
+
         // Check current time with the timestamp of last received block
         // If it is more than 10 minutes, the walelt is considered not in sync
         bool IsValidTimeStamp(Timestamp currentBlockTime_s)
@@ -122,6 +128,7 @@ namespace beam::wallet
         REQUEST_TYPES_All(THE_MACRO)
 #undef THE_MACRO
 
+        m_KernelsToConfirm.clear();
         m_MessageEndpoints.clear();
         m_NodeEndpoint = nullptr;
     }
@@ -269,6 +276,8 @@ namespace beam::wallet
     {
         if (--m_AsyncUpdateCounter == 0)
         {
+            FlushKernelsToConfirm();
+
             LOG_DEBUG() << "Async update finished!";
             if (m_UpdateCompleted)
             {
@@ -337,6 +346,17 @@ namespace beam::wallet
         return false;
     }
 
+    bool Wallet::MyRequestKernels::operator < (const MyRequestKernels& x) const
+    {
+        // batches are never empty, and each kernel is included in at most one of them
+        return m_vTxs.front() < x.m_vTxs.front();
+    }
+
+    bool Wallet::MyRequestUtxos::operator < (const MyRequestUtxos& x) const
+    {
+        return false;
+    }
+
     void Wallet::RequestHandler::OnComplete(Request& r)
     {
         uint32_t n = get_ParentObj().SyncRemains();
@@ -371,16 +391,39 @@ namespace beam::wallet
     {
         if (auto it = m_ActiveTransactions.find(txID); it != m_ActiveTransactions.end())
         {
-            MyRequestKernel::Ptr pVal(new MyRequestKernel);
-            pVal->m_TxID = txID;
-            pVal->m_SubTxID = subTxID;
-            pVal->m_Msg.m_ID = kernelID;
+            if (m_AsyncUpdateCounter && IsProofBatchingActive())
+            {
+                // will be sent at the end of the current update
+                auto key = std::make_pair(txID, subTxID);
+                if (m_KernelsToConfirm.end() == m_KernelsToConfirm.find(key))
+                {
+                    KernelToConfirm& x = m_KernelsToConfirm[key];
+                    x.m_ID = kernelID;
+                    x.m_Posted = false;
+                }
+                return;
+            }
 
-            if (PostReqUnique(*pVal))
-                LOG_INFO() << txID << "[" << subTxID << "]" << " Get proof for kernel: " << pVal->m_Msg.m_ID;
+            PostKernelSingle(txID, subTxID, kernelID);
         }
     }
 
+    void Wallet::PostKernelSingle(const TxID& txID, SubTxID subTxID, const Merkle::Hash& kernelID)
+    {
+        MyRequestKernel::Ptr pVal(new MyRequestKernel);
+        pVal->m_TxID = txID;
+        pVal->m_SubTxID = subTxID;
+        pVal->m_Msg.m_ID = kernelID;
+
+        if (PostReqUnique(*pVal))
+            LOG_INFO() << txID << "[" << subTxID << "]" << " Get proof for kernel: " << pVal->m_Msg.m_ID;
+    }
+
+    bool Wallet::IsProofBatchingActive() const
+    {
+        return m_ProofBatching && m_NodeEndpoint && m_NodeEndpoint->IsProofsBatchSupported();
+    }
+
     void Wallet::confirm_asset(const TxID& txID, const Key::Index ownerIdx, const PeerID& ownerID, SubTxID subTxID)
     {
         if (auto it = m_ActiveTransactions.find(txID); it != m_ActiveTransactions.end())
@@ -590,6 +633,47 @@ namespace beam::wallet
         }
     }
 
+    void Wallet::OnRequestComplete(MyRequestKernels& r)
+    {
+        const proto::ProofKernels& res = r.m_Res;
+
+        Block::SystemState::Full sTip;
+        get_tip(sTip);
+
+        for (const auto& s : res.m_States)
+            m_WalletDB->get_History().AddStates(&s, 1);
+
+        AsyncContextHolder holder(*this);
+
+        for (size_t i = 0; i < r.m_vTxs.size(); i++)
+        {
+            const auto& [txID, subTxID] = r.m_vTxs[i];
+            m_KernelsToConfirm.erase(r.m_vTxs[i]);
+
+            auto it = m_ActiveTransactions.find(txID);
+            if (m_ActiveTransactions.end() == it)
+                continue;
+            auto tx = it->second;
+
+            Height h = res.m_Heights.empty() ? 0 : res.m_Heights[i]; // empty if the node is not ready
+            if (h)
+            {
+                if (tx->SetParameter(TxParameterID::KernelProofHeight, h, subTxID))
+                    tx->Update();
+            }
+            else
+            {
+                tx->SetParameter(TxParameterID::KernelUnconfirmedHeight, sTip.m_Height, subTxID);
+                UpdateOnNextTip(tx);
+            }
+        }
+    }
+
+    void Wallet::OnRequestComplete(MyRequestUtxos& r)
+    {
+        // Not requested, the coins are confirmed by the utxo events
+    }
+
     void Wallet::OnRequestComplete(MyRequestAsset& req)
     {
         const auto it = m_ActiveTransactions.find(req.m_TxID);
@@ -909,6 +993,55 @@ namespace beam::wallet
         PostReqUnique(*pReq);
     }
 
+    void Wallet::FlushKernelsToConfirm()
+    {
+        if (!m_NodeEndpoint)
+            return;
+
+        if (!IsProofBatchingActive())
+        {
+            // No node would answer the batches (i.e. reconnected to a node without the support). Request them one by one
+            while (!m_PendingKernels.empty())
+                DeleteReq(*m_PendingKernels.begin());
+
+            for (const auto& [key, x] : m_KernelsToConfirm)
+                PostKernelSingle(key.first, key.second, x.m_ID);
+
+            m_KernelsToConfirm.clear();
+            return;
+        }
+
+        MyRequestKernels::Ptr pReq;
+
+        for (auto& [key, x] : m_KernelsToConfirm)
+        {
+            if (x.m_Posted)
+                continue;
+
+            if (!pReq)
+                pReq.reset(new MyRequestKernels);
+
+            pReq->m_Msg.m_IDs.push_back(x.m_ID);
+            pReq->m_vTxs.push_back(key);
+            x.m_Posted = true;
+
+            if (pReq->m_vTxs.size() == s_KernelsBatchMax)
+            {
+                PostKernelsBatch(*pReq);
+                pReq.reset();
+            }
+        }
+
+        if (pReq)
+            PostKernelsBatch(*pReq);
+    }
+
+    void Wallet::PostKernelsBatch(MyRequestKernels& r)
+    {
+        LOG_INFO() << "Get proofs for kernels: " << r.m_vTxs.size();
+        PostReqUnique(r);
+    }
+
     uint32_t Wallet::SyncRemains() const
     {
         size_t val =
@@ -126,6 +126,9 @@ namespace beam::wallet
 
         bool IsWalletInSync() const;
 
+        // Collect kernel proof requests, and send them in batches. Used only while the node supports proto::LoginFlags::ProofsBatch, otherwise the proofs are requested one by one
+        void EnableProofBatching(bool bEnable) { m_ProofBatching = bEnable; }
+
         // Count of active transactions which are not in safe state, negotiation are not finished or data is not sent to node
         size_t GetUnsafeActiveTransactionsCount() const;
     protected:
@@ -204,7 +207,8 @@ namespace beam::wallet
 #define REQUEST_TYPES_Sync(macro) \
         macro(Utxo) \
         macro(Kernel) \
-        macro(Events)
+        macro(Events) \
+        macro(Kernels)
 
         struct AllTasks {
 #define THE_MACRO(type, msgOut, msgIn) struct type { static const bool b = false; };
@@ -240,6 +244,10 @@ namespace beam::wallet
                 TxID m_TxID;
                 SubTxID m_SubTxID = kDefaultSubTxID;
             };
+            struct Kernels
+            {
+                std::vector<std::pair<TxID, SubTxID> > m_vTxs; // for each requested kernel
+            };
         };
 
 #define THE_MACRO(type, msgOut, msgIn) \
@@ -284,6 +292,10 @@ namespace beam::wallet
         REQUEST_TYPES_All(THE_MACRO)
 #undef THE_MACRO
 
+        void FlushKernelsToConfirm();
+        void PostKernelsBatch(MyRequestKernels&);
+        void PostKernelSingle(const TxID&, SubTxID, const Merkle::Hash&);
+        bool IsProofBatchingActive() const;
 
         IWalletDB::Ptr m_WalletDB; 
         
@@ -320,5 +332,14 @@ namespace beam::wallet
         // Counter of running transaction updates. Used by Cold wallet
         int m_AsyncUpdateCounter = 0;
         bool m_StoredMessagesProcessed = false; // this should happen only once, but not in destructor;
+
+        // Kernels to confirm, collected during transaction updates and sent in batches
+        struct KernelToConfirm
+        {
+            Merkle::Hash m_ID;
+            bool m_Posted;
+        };
+        std::map<std::pair<TxID, SubTxID>, KernelToConfirm> m_KernelsToConfirm;
+        bool m_ProofBatching = false;
     };
 }
@@ -77,6 +77,7 @@
 #define ASSETS_NAME "Assets"
 #define NOTIFICATIONS_NAME "notifications"
 #define EXCHANGE_RATES_NAME "exchangeRates"
+#define TX_HISTORY_NAME "txhistory"
 
 #define ENUM_VARIABLES_FIELDS(each, sep, obj) \
     each(name,  name,  TEXT UNIQUE, obj) sep \
@@ -769,7 +770,8 @@ namespace beam::wallet
         const char* SystemStateIDName = "SystemStateID";
         const char* LastUpdateTimeName = "LastUpdateTime";
         const int BusyTimeoutMs = 5000;
-        const int DbVersion   = 19;
+        const int DbVersion   = 20;
+        const int DbVersion19 = 19;
         const int DbVersion18 = 18;
         const int DbVersion17 = 17;
         const int DbVersion16 = 16;
@@ -1026,6 +1028,35 @@ namespace beam::wallet
             throwIfError(ret, db);
         }
 
+        // Denormalized copy of the indexed tx parameters (default sub tx), maintained by WalletDB::setTxParameter().
+        // Deleted transactions keep their row with status NULL, like they keep the type in the parameters
+        void CreateTxHistoryTable(sqlite3* db)
+        {
+            const char* req = "CREATE TABLE " TX_HISTORY_NAME " ("
+                "txID BLOB NOT NULL PRIMARY KEY,"
+                "txType INTEGER,"
+                "status INTEGER,"
+                "assetID INTEGER NOT NULL DEFAULT 0,"
+                "peerID BLOB,"
+                "height INTEGER NOT NULL DEFAULT 0,"
+                "createTime INTEGER NOT NULL DEFAULT 0) WITHOUT ROWID;"
+                "CREATE INDEX TxHistoryTimeIndex ON " TX_HISTORY_NAME "(createTime DESC, txID);"
+                "CREATE INDEX TxHistoryStatusIndex ON " TX_HISTORY_NAME "(status);"
+                "CREATE INDEX TxHistoryAssetIndex ON " TX_HISTORY_NAME "(assetID);"
+                "CREATE INDEX TxHistoryPeerIndex ON " TX_HISTORY_NAME "(peerID);"
+                "CREATE INDEX TxHistoryHeightIndex ON " TX_HISTORY_NAME "(height);";
+            int ret = sqlite3_exec(db, req, nullptr, nullptr, nullptr);
+            throwIfError(ret, db);
+        }
+
+        template <typename T>
+        uint64_t GetTxHistoryValue(const ByteBuffer& blob)
+        {
+            T value = {};
+            fromByteBuffer(blob, value);
+            return static_cast<uint64_t>(value);
+        }
+
         void OpenAndMigrateIfNeeded(const string& path, sqlite3** db, const SecString& password)
         {
             int ret = sqlite3_open_v2(path.c_str(), db, SQLITE_OPEN_READWRITE, nullptr);
@@ -1137,6 +1168,7 @@ namespace beam::wallet
         CreateAssetsTable(db);
         CreateNotificationsTable(db);
         CreateExchangeRatesTable(db);
+        CreateTxHistoryTable(db);
     }
 
     std::shared_ptr<WalletDB>  WalletDB::initBase(const string& path, const SecString& password, bool separateDBForPrivateData)
@@ -1593,6 +1625,12 @@ namespace beam::wallet
                     LOG_INFO() << "Converting DB from format 18...";
                     CreateNotificationsTable(walletDB->_db);
                     CreateExchangeRatesTable(walletDB->_db);
+                    // no break
+
+                case DbVersion19:
+                    LOG_INFO() << "Converting DB from format 19...";
+                    CreateTxHistoryTable(walletDB->_db);
+                    walletDB->fillTxHistory();
                     storage::setVar(*walletDB, Version, DbVersion);
                     // no break
 
@@ -2296,8 +2334,17 @@ namespace beam::wallet
 
     void WalletDB::visitCoins(function<bool(const Coin& coin)> func)
     {
-        const char* req = "SELECT " STORAGE_FIELDS " FROM " STORAGE_NAME " ORDER BY ROWID;";
+        uint64_t cursor = 0;
+        visitCoins(func, cursor, std::numeric_limits<int>::max());
+    }
+
+    void WalletDB::visitCoins(function<bool(const Coin& coin)> func, uint64_t& cursor, int count)
+    {
+        // keyset pagination, the page is found by the ROWID index regardless how far it is
+        const char* req = "SELECT " STORAGE_FIELDS ", ROWID FROM " STORAGE_NAME " WHERE ROWID > ?1 ORDER BY ROWID LIMIT ?2;";
         sqlite::Statement stm(this, req);
+        stm.bind(1, cursor);
+        stm.bind(2, count);
 
         Height h = getCurrentHeight();
         while (stm.step())
@@ -2306,6 +2353,7 @@ namespace beam::wallet
 
             int colIdx = 0;
             ENUM_ALL_STORAGE_FIELDS(STM_GET_LIST, NOSEP, coin);
+            stm.get(colIdx, cursor);
 
             storage::DeduceStatus(*this, coin, h);
 
@@ -2449,62 +2497,92 @@ namespace beam::wallet
 
     vector<TxDescription> WalletDB::getTxHistory(wallet::TxType txType, uint64_t start, int count) const
     {
-        // TODO this is temporary solution
-        int txCount = 0;
+        TxHistoryQuery query;
+        query.txType = txType;
+        query.skip = start;
+        query.count = count;
+        return getTxHistory(query);
+    }
+
+    vector<TxDescription> WalletDB::getTxHistory(const TxHistoryQuery& query) const
+    {
+        // conditions are bound below in the same order
+        std::string req = "SELECT txID FROM " TX_HISTORY_NAME " WHERE status NOT NULL";
+        int iParam = 0;
+        auto addCondition = [&](const char* cond)
         {
-            std::string req = "SELECT COUNT(DISTINCT txID) FROM " TX_PARAMS_NAME " WHERE paramID = ?1";
-            req += (txType != wallet::TxType::ALL) ? " AND value = ?2 ;" : " ;";
+            req += " AND ";
+            req += cond;
+            req += std::to_string(++iParam);
+        };
 
-            sqlite::Statement stm(this, req.c_str());
-            stm.bind(1, wallet::TxParameterID::TransactionType);
+        if (query.txType != wallet::TxType::ALL)
+            addCondition("txType=?");
+        if (query.status)
+            addCondition("status=?");
+        if (query.assetId)
+            addCondition("assetID=?");
+        if (query.peerId)
+            addCondition("peerID=?");
+        if (query.minHeight)
+            addCondition("height>=?");
+        if (query.maxHeight)
+            addCondition("height<=?");
+        if (query.minCreateTime)
+            addCondition("createTime>=?");
+        if (query.maxCreateTime)
+            addCondition("createTime<=?");
+        if (query.after)
+        {
+            std::string t = "?" + std::to_string(++iParam);
+            std::string id = "?" + std::to_string(++iParam);
+            req += " AND (createTime<" + t + " OR (createTime=" + t + " AND txID>" + id + "))";
+        }
+
+        req += " ORDER BY createTime DESC, txID LIMIT ?" + std::to_string(iParam + 1) + " OFFSET ?" + std::to_string(iParam + 2) + ";";
 
-            ByteBuffer typeBlob;
-            if (txType != wallet::TxType::ALL)
-            {
-                typeBlob = toByteBuffer(txType);
-                stm.bind(2, typeBlob);
-            }
+        sqlite::Statement stm(this, req.c_str());
+        iParam = 0;
 
-            stm.step();
-            stm.get(0, txCount);
+        if (query.txType != wallet::TxType::ALL)
+            stm.bind(++iParam, query.txType);
+        if (query.status)
+            stm.bind(++iParam, *query.status);
+        if (query.assetId)
+            stm.bind(++iParam, *query.assetId);
+        ByteBuffer peerBlob;
+        if (query.peerId)
+        {
+            peerBlob = toByteBuffer(*query.peerId);
+            stm.bind(++iParam, peerBlob);
         }
-
-        vector<TxDescription> res;
-        if (txCount > 0)
+        if (query.minHeight)
+            stm.bind(++iParam, *query.minHeight);
+        if (query.maxHeight)
+            stm.bind(++iParam, *query.maxHeight);
+        if (query.minCreateTime)
+            stm.bind(++iParam, *query.minCreateTime);
+        if (query.maxCreateTime)
+            stm.bind(++iParam, *query.maxCreateTime);
+        if (query.after)
         {
-            res.reserve(static_cast<size_t>(min(txCount, count)));
-            std::string req = "SELECT DISTINCT txID FROM " TX_PARAMS_NAME;
-
-            if (txType != wallet::TxType::ALL)
-            {
-                req += " WHERE paramID = ?3 AND value = ?4";
-            }
-
-            req += " LIMIT ?1 OFFSET ?2 ;";
-
-            sqlite::Statement stm(this, req.c_str());
-            stm.bind(1, count);
-            stm.bind(2, start);
+            stm.bind(++iParam, query.after->createTime);
+            stm.bind(++iParam, query.after->txId);
+        }
 
-            ByteBuffer typeBlob;
-            if (txType != wallet::TxType::ALL)
-            {
-                stm.bind(3, wallet::TxParameterID::TransactionType);
-                typeBlob = toByteBuffer(txType);
-                stm.bind(4, typeBlob);
-            }
+        stm.bind(++iParam, query.count);
+        stm.bind(++iParam, query.skip);
 
-            while (stm.step())
+        vector<TxDescription> res;
+        while (stm.step())
+        {
+            TxID txID;
+            stm.get(0, txID);
+            auto t = getTx(txID);
+            if (t.is_initialized())
             {
-                TxID txID;
-                stm.get(0, txID);
-                auto t = getTx(txID);
-                if (t.is_initialized())
-                {
-                    res.emplace_back(*t);
-                }
+                res.emplace_back(*t);
             }
-            sort(res.begin(), res.end(), [](const auto& left, const auto& right) {return left.m_createTime > right.m_createTime; });
         }
 
         return res;
@@ -2644,6 +2722,11 @@ namespace beam::wallet
             stm.bind(2, TxParameterID::TransactionType);
 
             stm.step();
+
+            sqlite::Statement stm2(this, "UPDATE " TX_HISTORY_NAME " SET status=NULL WHERE txID=?1;");
+            stm2.bind(1, txId);
+            stm2.step();
+
             deleteParametersFromCache(txId);
             notifyTransactionChanged(ChangeAction::Removed, { *tx });
         }
@@ -3172,6 +3255,11 @@ namespace beam::wallet
                 stm2.bind(4, blob);
                 stm2.step();
 
+                if (subTxID == kDefaultSubTxID)
+                {
+                    updateTxHistory(txID, paramID, blob);
+                }
+
                 if (shouldNotifyAboutChanges)
                 {
                     auto tx = getTx(txID);
@@ -3194,6 +3282,12 @@ namespace beam::wallet
         int colIdx = 0;
         ENUM_TX_PARAMS_FIELDS(STM_BIND_LIST, NOSEP, parameter);
         stm.step();
+
+        if (subTxID == kDefaultSubTxID)
+        {
+            updateTxHistory(txID, paramID, blob);
+        }
+
         if (shouldNotifyAboutChanges)
         {
             auto tx = getTx(txID);
@@ -3206,6 +3300,78 @@ namespace beam::wallet
         return true;
     }
 
+    void WalletDB::updateTxHistory(const TxID& txID, TxParameterID paramID, const ByteBuffer& blob)
+    {
+        const char* req = nullptr;
+        uint64_t value = 0;
+
+        switch (paramID)
+        {
+        case TxParameterID::TransactionType:
+            req = "UPDATE " TX_HISTORY_NAME " SET txType=?2 WHERE txID=?1;";
+            value = GetTxHistoryValue<TxType>(blob);
+            break;
+        case TxParameterID::Status:
+            req = "UPDATE " TX_HISTORY_NAME " SET status=?2 WHERE txID=?1;";
+            value = GetTxHistoryValue<TxStatus>(blob);
+            break;
+        case TxParameterID::AssetID:
+            req = "UPDATE " TX_HISTORY_NAME " SET assetID=?2 WHERE txID=?1;";
+            value = GetTxHistoryValue<Asset::ID>(blob);
+            break;
+        case TxParameterID::PeerID:
+            req = "UPDATE " TX_HISTORY_NAME " SET peerID=?2 WHERE txID=?1;";
+            break;
+        case TxParameterID::KernelProofHeight:
+            req = "UPDATE " TX_HISTORY_NAME " SET height=?2 WHERE txID=?1;";
+            value = GetTxHistoryValue<Height>(blob);
+            break;
+        case TxParameterID::CreateTime:
+            req = "UPDATE " TX_HISTORY_NAME " SET createTime=?2 WHERE txID=?1;";
+            value = GetTxHistoryValue<Timestamp>(blob);
+            break;
+        default:
+            return; // not indexed
+        }
+
+        {
+            sqlite::Statement stm(this, "INSERT OR IGNORE INTO " TX_HISTORY_NAME " (txID) VALUES(?1);");
+            stm.bind(1, txID);
+            stm.step();
+        }
+
+        sqlite::Statement stm(this, req);
+        stm.bind(1, txID);
+        if (paramID == TxParameterID::PeerID)
+            stm.bind(2, blob); // compared as is
+        else
+            stm.bind(2, value);
+        stm.step();
+    }
+
+    void WalletDB::fillTxHistory()
+    {
+        sqlite::Statement stm(this, "SELECT txID, paramID, value FROM " TX_PARAMS_NAME " WHERE subTxID=?1 AND paramID IN (?2, ?3, ?4, ?5, ?6, ?7);");
+        stm.bind(1, kDefaultSubTxID);
+        stm.bind(2, TxParameterID::TransactionType);
+        stm.bind(3, TxParameterID::Status);
+        stm.bind(4, TxParameterID::AssetID);
+        stm.bind(5, TxParameterID::PeerID);
+        stm.bind(6, TxParameterID::KernelProofHeight);
+        stm.bind(7, TxParameterID::CreateTime);
+
+        while (stm.step())
+        {
+            TxID txID;
+            int paramID = 0;
+            ByteBuffer blob;
+            stm.get(0, txID);
+            stm.get(1, paramID);
+            stm.get(2, blob);
+            updateTxHistory(txID, static_cast<TxParameterID>(paramID), blob);
+        }
+    }
+
     bool WalletDB::getTxParameter(const TxID& txID, SubTxID subTxID, TxParameterID paramID, ByteBuffer& blob) const
     {
         if (auto txIter = m_TxParametersCache.find(txID); txIter != m_TxParametersCache.end())
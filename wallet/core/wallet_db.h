@@ -272,6 +272,38 @@ namespace beam::wallet
         }
     };
 
+    // Server-side filter for the transaction history. Results are ordered by creation time (newest first)
+    // and then by tx ID, for the next page pass the last returned transaction as a cursor
+    struct TxHistoryQuery
+    {
+        struct Cursor
+        {
+            Timestamp createTime = 0;
+            TxID txId = {};
+
+            Cursor() = default;
+            explicit Cursor(const TxDescription& tx)
+                : createTime(tx.m_createTime)
+                , txId(tx.m_txId)
+            {
+            }
+        };
+
+        wallet::TxType txType = wallet::TxType::Simple;
+        boost::optional<TxStatus> status;
+        boost::optional<Asset::ID> assetId;
+        boost::optional<WalletID> peerId;
+        // kernel proof height, 0 if not confirmed yet
+        boost::optional<Height> minHeight;
+        boost::optional<Height> maxHeight;
+        boost::optional<Timestamp> minCreateTime;
+        boost::optional<Timestamp> maxCreateTime;
+
+        boost::optional<Cursor> after; // keyset pagination
+        uint64_t skip = 0;
+        int count = std::numeric_limits<int>::max();
+    };
+
     struct IWalletDbObserver
     {
         virtual void onCoinsChanged(ChangeAction action, const std::vector<Coin>& items) {};
@@ -349,6 +381,9 @@ namespace beam::wallet
 
         // Generic visitor to iterate over coin collection
         virtual void visitCoins(std::function<bool(const Coin& coin)> func) = 0;
+        // Visits up to count coins stored after the cursor (0 - from the beginning), in the storage order.
+        // The cursor is moved to the last visited coin, so that the next call continues from there
+        virtual void visitCoins(std::function<bool(const Coin& coin)> func, uint64_t& cursor, int count) = 0;
 
         // Used in split API for session management
         virtual bool lockCoins(const CoinIDList& list, uint64_t session) = 0;
@@ -365,6 +400,7 @@ namespace beam::wallet
         // /////////////////////////////////////////////
         // Transaction management
         virtual std::vector<TxDescription> getTxHistory(wallet::TxType txType = wallet::TxType::Simple, uint64_t start = 0, int count = std::numeric_limits<int>::max()) const = 0;
+        virtual std::vector<TxDescription> getTxHistory(const TxHistoryQuery& query) const = 0;
         virtual boost::optional<TxDescription> getTx(const TxID& txId) const = 0;
         virtual void saveTx(const TxDescription& p) = 0;
         virtual void deleteTx(const TxID& txId) = 0;
@@ -474,6 +510,7 @@ namespace beam::wallet
         void clearCoins() override;
 
         void visitCoins(std::function<bool(const Coin& coin)> func) override;
+        void visitCoins(std::function<bool(const Coin& coin)> func, uint64_t& cursor, int count) override;
 
         void setVarRaw(const char* name, const void* data, size_t size) override;
         bool getVarRaw(const char* name, void* data, int size) const override;
@@ -487,6 +524,7 @@ namespace beam::wallet
         void rollbackConfirmedUtxo(Height minHeight) override;
 
         std::vector<TxDescription> getTxHistory(wallet::TxType txType, uint64_t start, int count) const override;
+        std::vector<TxDescription> getTxHistory(const TxHistoryQuery& query) const override;
         boost::optional<TxDescription> getTx(const TxID& txId) const override;
         void saveTx(const TxDescription& p) override;
         void deleteTx(const TxID& txId) override;
@@ -570,6 +608,8 @@ namespace beam::wallet
         void insertParameterToCache(const TxID& txID, SubTxID subTxID, TxParameterID paramID, const boost::optional<ByteBuffer>& blob) const;
         void deleteParametersFromCache(const TxID& txID);
         bool hasTransaction(const TxID& txID) const;
+        void updateTxHistory(const TxID& txID, TxParameterID paramID, const ByteBuffer& blob);
+        void fillTxHistory();
         void insertAddressToCache(const WalletID& id, const boost::optional<WalletAddress>& address) const;
         void deleteAddressFromCache(const WalletID& id);
         void flushDB();
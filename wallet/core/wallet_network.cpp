@@ -27,6 +27,21 @@ namespace
         walletID.m_Channel.Export(ret);
         return ret;
     }
+
+    struct DecryptExecutor
+        :public beam::ExecutorMT
+    {
+        uint32_t m_Threads;
+
+        uint32_t get_Threads() override { return m_Threads; }
+
+        void RunThread(uint32_t iThread) override
+        {
+            ExecutorMT::Context ctx;
+            ctx.m_iThread = iThread;
+            RunThreadCtx(ctx);
+        }
+    };
 }
 
 
@@ -69,35 +84,52 @@ namespace beam::wallet {
         Addr::Channel key;
         key.m_Value = channel;
 
-        for (ChannelSet::iterator it = m_Channels.lower_bound(key); ; ++it)
+        ChannelSet::iterator it0 = m_Channels.lower_bound(key);
+        if ((m_Channels.end() == it0) || (it0->m_Value != channel))
+            return;
+
+        if (!m_pKdfSbbs)
         {
-            if (m_Channels.end() == it)
-                break;
-            if (it->m_Value != channel)
-                break; // as well
+            // read-only wallet
+            m_WalletDB->saveIncomingWalletMessage(channel, msg);
+            OnIncomingMessage();
+            return;
+        }
 
+        // all own addresses on this channel are tried at once
+        std::vector<const Addr*> vAddrs;
+        m_Decryptor.m_vKeys.clear();
 
-            if (!m_pKdfSbbs)
-            {
-                // read-only wallet
-                m_WalletDB->saveIncomingWalletMessage(channel, msg);
-                OnIncomingMessage();
-                return;
-            }
+        for (ChannelSet::iterator it = it0; (m_Channels.end() != it) && (it->m_Value == channel); ++it)
+        {
+            const Addr& addr = it->get_ParentObj();
+            vAddrs.push_back(&addr);
+
+            m_Decryptor.m_vKeys.emplace_back();
+            proto::Bbs::TrialDecryptor::Key& k = m_Decryptor.m_vKeys.back();
+            k.m_sk = addr.m_sk;
+            k.m_Pk = addr.m_Pk;
+        }
 
-            ByteBuffer buf = msg; // duplicate
-            uint8_t* pMsg = &buf.front();
-            uint32_t nSize = static_cast<uint32_t>(buf.size());
+        std::unique_ptr<Executor::Scope> pScope;
+        if (m_pDecryptExecutor)
+            pScope = std::make_unique<Executor::Scope>(*m_pDecryptExecutor);
 
-            if (!proto::Bbs::Decrypt(pMsg, nSize, it->get_ParentObj().m_sk))
-                continue;
+        m_Decryptor.m_TagFilter = m_TagFilterIncoming;
+
+        ByteBuffer buf;
+        for (uint32_t iKey = 0; ; iKey++)
+        {
+            iKey = m_Decryptor.Decrypt(msg, buf, iKey);
+            if (proto::Bbs::TrialDecryptor::s_NotFound == iKey)
+                break;
 
             SetTxParameter msgWallet;
             bool bValid = false;
 
             try {
                 Deserializer der;
-                der.reset(pMsg, nSize);
+                der.reset(buf);
                 der& msgWallet;
                 bValid = true;
             }
@@ -108,11 +140,25 @@ namespace beam::wallet {
             if (bValid)
             {
                 WalletID wid;
-                wid.m_Pk = it->get_ParentObj().m_Pk;
-                wid.m_Channel = it->m_Value;
+                wid.m_Pk = vAddrs[iKey]->m_Pk;
+                wid.m_Channel = channel;
                 m_Wallet.OnWalletMessage(wid, msgWallet);
                 break;
             }
+
+            // try the next own address
+        }
+    }
+
+    void BaseMessageEndpoint::SetDecryptThreads(uint32_t nThreads)
+    {
+        m_pDecryptExecutor.reset();
+
+        if (nThreads)
+        {
+            auto pExec = std::make_unique<DecryptExecutor>();
+            pExec->m_Threads = nThreads;
+            m_pDecryptExecutor = std::move(pExec);
         }
     }
 
@@ -209,7 +255,7 @@ namespace beam::wallet {
         m_pKdfSbbs->DeriveKey(nonce, hvRandom.V);
 
         ByteBuffer encryptedMessage;
-        if (proto::Bbs::Encrypt(encryptedMessage, peerID.m_Pk, nonce, sb.first, static_cast<uint32_t>(sb.second)))
+        if (proto::Bbs::Encrypt(encryptedMessage, peerID.m_Pk, nonce, sb.first, static_cast<uint32_t>(sb.second), m_TagOutgoing))
         {
             SendRawMessage(peerID, encryptedMessage);
         }
@@ -58,6 +58,16 @@ namespace beam::wallet
         virtual ~BaseMessageEndpoint();
         void AddOwnAddress(const WalletAddress& address);
         void DeleteOwnAddress(uint64_t ownID);
+
+        // append the recipient tag to the outgoing messages, so that the receiver can skip the trial decryption with other addresses (see proto::Bbs::Tag).
+        // Off by default, since it lets anyone who knows the recipient address recognize the messages
+        bool m_TagOutgoing = false;
+
+        // skip the own addresses that don't match the tag of the incoming messages. Enable if the senders tag their messages (see proto::Bbs::TrialDecryptor::m_TagFilter)
+        bool m_TagFilterIncoming = false;
+
+        // threads for the trial decryption of the incoming messages, worth it for wallets with many addresses per channel. 0 = in the caller thread
+        void SetDecryptThreads(uint32_t);
     protected:
         void ProcessMessage(BbsChannel channel, const ByteBuffer& msg);
         void Subscribe();
@@ -84,6 +94,8 @@ namespace beam::wallet
         IWalletDB::Ptr m_WalletDB;
         Key::IKdf::Ptr m_pKdfSbbs;
         io::Timer::Ptr m_AddressExpirationTimer;
+        proto::Bbs::TrialDecryptor m_Decryptor;
+        std::unique_ptr<Executor> m_pDecryptExecutor;
     };
 
     class BbsSender
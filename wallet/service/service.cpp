@@ -226,6 +226,7 @@ namespace
         struct IApiConnectionHandler
         {
             virtual void serializeMsg(const json& msg) = 0;
+            virtual void sendRawMsg(const std::string& msg) = 0;
             using KeyKeeperFunc = std::function<void(const json&)>;
             virtual void sendAsync(const json& msg, KeyKeeperFunc func) = 0;
         };
@@ -474,6 +475,15 @@ namespace
                 _handler->serializeMsg(msg);
             }
 
+            void serializeStreamedMsg(const JsonStreamFunc& func) override
+            {
+                std::string msg;
+                if (serialize_json_msg(msg, func))
+                {
+                    _handler->sendRawMsg(msg);
+                }
+            }
+
         private:
             IApiConnectionHandler* _handler;
         };
@@ -524,6 +534,11 @@ namespace
                 _sendFunc(msg.dump());
             }
 
+            void sendRawMsg(const std::string& msg) override
+            {
+                _sendFunc(msg);
+            }
+
             void sendAsync(const json& msg, KeyKeeperFunc func) override
             {
                 _keeperCallbacks.push(std::move(func));
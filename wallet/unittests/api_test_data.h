@@ -0,0 +1,67 @@
+// Copyright 2020 The Beam Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "wallet/api/api.h"
+
+// Generated api responses for the serialization tests and benchmarks
+namespace beam::wallet
+{
+    inline GetUtxo::Response makeUtxos(int count)
+    {
+        GetUtxo::Response res;
+        for (int i = 0; i < count; i++)
+        {
+            Coin coin{ Amount(1000 + i) };
+            coin.m_ID.m_Type = (i % 3) ? Key::Type::Regular : Key::Type::Change;
+            coin.m_ID.m_Idx = i;
+            coin.m_maturity = 60 + i;
+            coin.m_confirmHeight = 60 + i;
+            coin.m_status = (i % 2) ? Coin::Status::Available : Coin::Status::Spent;
+            coin.m_sessionId = i % 5;
+            if (i % 4)
+            {
+                TxID txId = {};
+                txId[0] = static_cast<uint8_t>(i);
+                coin.m_createTxId = txId;
+            }
+            res.utxos.push_back(coin);
+        }
+        return res;
+    }
+
+    inline TxList::Response makeTxList(int count)
+    {
+        TxList::Response res;
+        for (int i = 0; i < count; i++)
+        {
+            Status::Response item;
+            item.tx.m_txId[0] = static_cast<uint8_t>(i);
+            item.tx.m_txId[1] = static_cast<uint8_t>(i >> 8);
+            item.tx.m_amount = 100000 + i;
+            item.tx.m_fee = 100;
+            item.tx.m_sender = (i % 2) != 0;
+            item.tx.m_createTime = 1590000000 + i;
+            item.tx.m_status = static_cast<TxStatus>(i % 6);
+            std::string comment = "payment #" + std::to_string(i) + " \"quoted\"\n";
+            item.tx.m_message.assign(comment.begin(), comment.end());
+            item.kernelProofHeight = (i % 3) ? i : 0;
+            item.systemHeight = count;
+            item.confirmations = 0;
+            res.resultList.push_back(item);
+        }
+        return res;
+    }
+}
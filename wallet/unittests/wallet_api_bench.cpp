@@ -0,0 +1,72 @@
+// Copyright 2020 The Beam Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <iostream>
+#include <chrono>
+
+#include "api_test_data.h"
+#include "utility/io/json_serializer.h"
+
+using namespace std;
+using namespace beam;
+using namespace beam::wallet;
+using json = nlohmann::json;
+
+// Serialization benchmarks of the large api responses, not a part of the test run
+
+namespace
+{
+    class WalletApiHandlerBase : public wallet::IWalletApiHandler
+    {
+        void onInvalidJsonRpc(const json& msg) override {}
+
+#define MESSAGE_FUNC(strct, name, _) virtual void onMessage(const JsonRpcId& id, const strct& data) override {};
+        WALLET_API_METHODS(MESSAGE_FUNC)
+#undef MESSAGE_FUNC
+    };
+
+    template<typename T>
+    void benchStreamedResponse(const char* name, const T& response)
+    {
+        WalletApiHandlerBase handler;
+        WalletApi api(handler);
+        size_t size = 0;
+        io::FragmentWriter fw(4096, 0, [&size](io::SharedBuffer&& fragment) { size += fragment.size; });
+
+        auto t0 = std::chrono::steady_clock::now();
+        {
+            json msg;
+            api.getResponse(1, response, msg);
+            serialize_json_msg(fw, msg);
+        }
+        auto t1 = std::chrono::steady_clock::now();
+        serialize_json_msg(fw, JsonStreamFunc([&](JsonStreamWriter& writer)
+        {
+            api.getResponse(1, response, writer);
+        }));
+        auto t2 = std::chrono::steady_clock::now();
+
+        using ms = std::chrono::milliseconds;
+        cout << name << ": " << size / 2 << " bytes, json tree: " << std::chrono::duration_cast<ms>(t1 - t0).count()
+            << " ms, streamed: " << std::chrono::duration_cast<ms>(t2 - t1).count() << " ms" << endl;
+    }
+}
+
+int main()
+{
+    benchStreamedResponse("get_utxo 200000", makeUtxos(200000));
+    benchStreamedResponse("tx_list 200000", makeTxList(200000));
+
+    return 0;
+}
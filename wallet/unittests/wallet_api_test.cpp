@@ -16,6 +16,7 @@
 #include <core/block_crypt.h>
 
 #include "test_helpers.h"
+#include "api_test_data.h"
 
 #include "wallet/api/api.h"
 #include "nlohmann/json.hpp"
@@ -737,6 +738,39 @@ namespace
 
         WALLET_CHECK(api.parse(msg.data(), msg.size()));
     }
+
+    template<typename T>
+    std::string getStreamed(WalletApi& api, const JsonRpcId& id, const T& response)
+    {
+        std::string res;
+        WALLET_CHECK(serialize_json_msg(res, [&](JsonStreamWriter& writer)
+        {
+            api.getResponse(id, response, writer);
+        }));
+        return res;
+    }
+
+    void testStreamedResponses()
+    {
+        WalletApiHandlerBase handler;
+        WalletApi api(handler);
+
+        for (int count : { 0, 1, 100 })
+        {
+            for (const JsonRpcId& id : { JsonRpcId(123), JsonRpcId("abc") })
+            {
+                auto utxos = makeUtxos(count);
+                json utxosRes;
+                api.getResponse(id, utxos, utxosRes);
+                WALLET_CHECK(getStreamed(api, id, utxos) == utxosRes.dump());
+
+                auto txList = makeTxList(count);
+                json txListRes;
+                api.getResponse(id, txList, txListRes);
+                WALLET_CHECK(getStreamed(api, id, txList) == txListRes.dump());
+            }
+        }
+    }
 }
 
 int main()
@@ -1225,5 +1259,7 @@ int main()
         }
     }));
 
+    testStreamedResponses();
+
     return WALLET_CHECK_RESULT;
 }
@@ -170,6 +170,35 @@ void TestStoreCoins()
         auto coins2 = walletDB->getCoinsByID(ids);
         WALLET_CHECK(coins2.size() == ids.size());
         WALLET_CHECK(equal(coins.begin(), coins.end(), coins2.begin()));
+
+        vector<Coin> page;
+        auto pageVisitor = [&page](const Coin& c)
+        {
+            page.push_back(c);
+            return true;
+        };
+
+        uint64_t cursor = 0;
+        walletDB->visitCoins(pageVisitor, cursor, 4);
+        WALLET_CHECK(page.size() == 4);
+        WALLET_CHECK(equal(page.begin(), page.end(), coins.begin()));
+
+        // the cursor isn't affected by the removal of the already visited coins
+        walletDB->removeCoin(coins[1].m_ID);
+
+        page.clear();
+        walletDB->visitCoins(pageVisitor, cursor, 4);
+        WALLET_CHECK(page.size() == 4);
+        WALLET_CHECK(equal(page.begin(), page.end(), coins.begin() + 4));
+
+        page.clear();
+        walletDB->visitCoins(pageVisitor, cursor, 4);
+        WALLET_CHECK(page.size() == 2);
+        WALLET_CHECK(equal(page.begin(), page.end(), coins.begin() + 8));
+
+        page.clear();
+        walletDB->visitCoins(pageVisitor, cursor, 4);
+        WALLET_CHECK(page.empty());
     }
 
     auto walletDB = createSqliteWalletDB();
@@ -1402,6 +1431,113 @@ void TestExchangeRates()
     }
 }
 
+void TestTxHistoryQuery()
+{
+    cout << "\nWallet database tx history query test\n";
+    auto walletDB = createSqliteWalletDB();
+
+    const int Count = 30;
+    for (int i = 0; i < Count; ++i)
+    {
+        TxID id = {};
+        id[0] = 1;
+        id[1] = static_cast<uint8_t>(i);
+        TxDescription tx(id);
+        tx.m_amount = 100 + i;
+        tx.m_peerId.m_Pk = unsigned(i % 4);
+        tx.m_peerId.m_Channel = 0U;
+        tx.m_myId.m_Pk = unsigned(42);
+        tx.m_createTime = 1000 + i / 2; // pairs with the same time
+        tx.m_assetId = i % 2;
+        tx.m_status = (i % 3) ? TxStatus::InProgress : TxStatus::Completed;
+        walletDB->saveTx(tx);
+
+        if (tx.m_status == TxStatus::Completed)
+        {
+            storage::setTxParameter(*walletDB, id, TxParameterID::KernelProofHeight, Height(100 + i), false);
+        }
+    }
+
+    auto all = walletDB->getTxHistory();
+    WALLET_CHECK(all.size() == Count);
+    for (size_t i = 1; i < all.size(); ++i)
+    {
+        WALLET_CHECK(all[i - 1].m_createTime > all[i].m_createTime
+            || (all[i - 1].m_createTime == all[i].m_createTime && all[i - 1].m_txId < all[i].m_txId));
+    }
+
+    // keyset pagination
+    {
+        TxHistoryQuery query;
+        query.count = 7;
+        std::vector<TxDescription> pages;
+        while (true)
+        {
+            auto page = walletDB->getTxHistory(query);
+            if (page.empty())
+                break;
+            pages.insert(pages.end(), page.begin(), page.end());
+            query.after = TxHistoryQuery::Cursor(page.back());
+        }
+        WALLET_CHECK(pages.size() == all.size());
+        for (size_t i = 0; i < pages.size() && i < all.size(); ++i)
+        {
+            WALLET_CHECK(pages[i].m_txId == all[i].m_txId);
+        }
+    }
+
+    auto count = [&walletDB](const TxHistoryQuery& query)
+    {
+        return walletDB->getTxHistory(query).size();
+    };
+
+    {
+        TxHistoryQuery query;
+        query.status = TxStatus::Completed;
+        WALLET_CHECK(count(query) == 10);
+    }
+    {
+        TxHistoryQuery query;
+        query.assetId = 1;
+        WALLET_CHECK(count(query) == 15);
+    }
+    {
+        TxHistoryQuery query;
+        query.peerId = WalletID();
+        query.peerId->m_Pk = unsigned(0);
+        query.peerId->m_Channel = 0U;
+        WALLET_CHECK(count(query) == 8);
+    }
+    {
+        TxHistoryQuery query;
+        query.minHeight = 110;
+        query.maxHeight = 120;
+        WALLET_CHECK(count(query) == 3);
+        query.minHeight = 0;
+        query.maxHeight = 0;
+        WALLET_CHECK(count(query) == 20);
+    }
+    {
+        TxHistoryQuery query;
+        query.minCreateTime = 1005;
+        query.maxCreateTime = 1009;
+        WALLET_CHECK(count(query) == 10);
+        query.skip = 8;
+        query.count = 5;
+        WALLET_CHECK(count(query) == 2);
+    }
+    {
+        TxHistoryQuery query;
+        query.txType = TxType::AssetIssue;
+        WALLET_CHECK(count(query) == 0);
+        query.txType = TxType::ALL;
+        WALLET_CHECK(count(query) == Count);
+    }
+
+    walletDB->deleteTx(all.front().m_txId);
+    WALLET_CHECK(walletDB->getTxHistory().size() == Count - 1);
+}
+
 }
 
 int main() 
@@ -1433,6 +1569,7 @@ int main()
     TestWalletMessages();
     TestNotifications();
     TestExchangeRates();
+    TestTxHistoryQuery();
 
     return WALLET_CHECK_RESULT;
 }
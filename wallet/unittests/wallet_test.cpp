@@ -114,9 +114,9 @@ namespace
         WALLET_CHECK(count == 2);
     }
 
-    void TestTxToHimself()
+    void TestTxToHimself(bool bNodeProofsBatch)
     {
-        cout << "\nTesting Tx to himself...\n";
+        cout << "\nTesting Tx to himself" << (bNodeProofsBatch ? "" : ", node without batched proofs") << "...\n";
 
         io::Reactor::Ptr mainReactor{ io::Reactor::create() };
         io::Reactor::Scope scope(*mainReactor);
@@ -136,7 +136,9 @@ namespace
         WALLET_CHECK(senderWalletDB->getTxHistory().empty());
 
         TestNode node;
+        node.m_ProofsBatch = bNodeProofsBatch;
         TestWalletRig sender("sender", senderWalletDB, [](auto) { io::Reactor::get_Current().stop(); });
+        sender.m_Wallet.EnableProofBatching(true); // the kernel is confirmed via proto::GetProofKernels, or via proto::GetProofKernel if the node doesn't support it
         helpers::StopWatch sw;
 
         sw.start();
@@ -153,6 +155,8 @@ namespace
 
         cout << "Transfer elapsed time: " << sw.milliseconds() << " ms\n";
 
+        WALLET_CHECK((node.m_KernelsBatches > 0) == bNodeProofsBatch);
+
         // check Tx
         auto txHistory = senderWalletDB->getTxHistory();
         WALLET_CHECK(txHistory.size() == 1);
@@ -2607,7 +2611,8 @@ int main()
    
     TestMinimalFeeTransaction();
    
-    TestTxToHimself();
+    TestTxToHimself(true);
+    TestTxToHimself(false);
     
     TestExpiredTransaction();
     
@@ -101,6 +101,7 @@ public:
     void removeCoins(const std::vector<Coin::ID>&) override {}
     void removeCoin(const Coin::ID&) override {}
     void visitCoins(std::function<bool(const Coin& coin)>) override {}
+    void visitCoins(std::function<bool(const Coin& coin)>, uint64_t&, int) override {}
     void setVarRaw(const char*, const void*, size_t) override {}
     bool getVarRaw(const char*, void*, int) const override { return false; }
     bool getBlob(const char* name, ByteBuffer& var) const override { return false; }
@@ -112,6 +113,7 @@ public:
     void Unsubscribe(IWalletDbObserver* observer) override {}
 
     std::vector<TxDescription> getTxHistory(wallet::TxType, uint64_t, int) const override { return {}; };
+    std::vector<TxDescription> getTxHistory(const TxHistoryQuery&) const override { return {}; };
     boost::optional<TxDescription> getTx(const TxID&) const override { return boost::optional<TxDescription>{}; };
     void saveTx(const TxDescription& p) override
     {
@@ -784,6 +786,64 @@ struct TestBlockchain
     }
 
 
+    void GetProof(const proto::GetProofKernels& data, proto::ProofKernels& msgOut)
+    {
+        msgOut.m_Heights.resize(data.m_IDs.size());
+        std::vector<size_t> vStates;
+
+        for (size_t iID = 0; iID < data.m_IDs.size(); iID++)
+        {
+            for (size_t iState = m_mcm.m_vStates.size(); iState--; )
+            {
+                const KrnPerBlock& kpb = m_vBlockKernels[iState];
+
+                auto it = std::find(kpb.m_vKrnIDs.begin(), kpb.m_vKrnIDs.end(), data.m_IDs[iID]);
+                if (kpb.m_vKrnIDs.end() == it)
+                    continue;
+
+                KrnPerBlock::Mmr fmmr(kpb);
+                Merkle::ProofBuilderStd bld;
+                fmmr.get_Proof(bld, it - kpb.m_vKrnIDs.begin());
+
+                msgOut.m_Proofs.push_back(std::move(bld.m_Proof));
+                msgOut.m_Heights[iID] = m_mcm.m_vStates[iState].m_Hdr.m_Height;
+                vStates.push_back(iState);
+                break;
+            }
+        }
+
+        std::sort(vStates.begin(), vStates.end());
+        vStates.erase(std::unique(vStates.begin(), vStates.end()), vStates.end());
+
+        struct Builder
+            :public Merkle::MultiProof::Builder
+        {
+            const Merkle::FixedMmr& m_Mmr;
+            Builder(Merkle::MultiProof& x, const Merkle::FixedMmr& mmr)
+                :Merkle::MultiProof::Builder(x)
+                ,m_Mmr(mmr)
+            {
+            }
+
+            virtual void get_Proof(Merkle::IProofBuilder& p, uint64_t i) override
+            {
+                m_Mmr.get_Proof(p, i);
+            }
+        } bld(msgOut.m_ProofStates, m_mcm.m_Mmr);
+
+        for (size_t iState : vStates)
+        {
+            msgOut.m_States.push_back(m_mcm.m_vStates[iState].m_Hdr);
+            if (iState + 1 != m_mcm.m_vStates.size())
+                bld.Add(iState);
+        }
+
+        msgOut.m_RootLive = m_mcm.m_hvLive;
+
+        Block::SystemState::Full state = m_mcm.m_vStates.back().m_Hdr;
+        WALLET_CHECK(state.IsValidProofStates(msgOut.m_States.empty() ? nullptr : &msgOut.m_States.front(), msgOut.m_States.size(), msgOut.m_ProofStates, msgOut.m_RootLive));
+    }
+
     void AddKernel(const TxKernel& krn)
     {
         if (m_vBlockKernels.size() <= m_mcm.m_vStates.size())
@@ -948,6 +1008,8 @@ public:
     }
 
     TestBlockchain m_Blockchain;
+    bool m_ProofsBatch = true; // announce proto::LoginFlags::ProofsBatch to the new clients
+    uint32_t m_KernelsBatches = 0; // proto::GetProofKernels received
 
     void AddBlock()
     {
@@ -1005,6 +1067,9 @@ private:
 				proto::LoginFlags::SpreadingTransactions |
 				proto::LoginFlags::Bbs |
 				proto::LoginFlags::SendPeers;
+
+			if (m_This.m_ProofsBatch)
+				msg.m_Flags |= proto::LoginFlags::ProofsBatch;
 		}
 
         void SendTip()
@@ -1046,6 +1111,15 @@ private:
             Send(msgOut);
         }
 
+        void OnMsg(proto::GetProofKernels&& data) override
+        {
+            m_This.m_KernelsBatches++;
+
+            proto::ProofKernels msgOut;
+            m_This.m_Blockchain.GetProof(data, msgOut);
+            Send(msgOut);
+        }
+
         void OnMsg(proto::GetProofState&&) override
         {
             Send(proto::ProofState{});